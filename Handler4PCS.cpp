@@ -13,6 +13,7 @@
 //! \brief 4PCS handler class
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 #include "Handler4PCS.h"
+#include "memoryledger.h"
 
 struct tripple {
 	int a;
@@ -34,6 +35,15 @@ Handler4PCS::Handler4PCS()
 	m_matObtain	= false;
 }
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Destructor
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+Handler4PCS::~Handler4PCS()
+{
+	MemoryLedger::instance()->remove(this);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Set 4pcs parameters
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -67,6 +77,7 @@ void Handler4PCS::storePoints(Vertex *v1, Vertex *v2)
 
 	for (int j = 1; j < size2 - 1; j++)
 		m_set2.push_back(Point3D((double)v2[j].location[0], (double)v2[j].location[1], (double)v2[j].location[2]));
+	account		();
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -82,10 +93,22 @@ bool Handler4PCS::run4PCS()
 	PCS4 m_matcher;
 
 	m_matObtain	= m_matcher.compute(m_set1, m_set2, m_delta, m_overlap, m_mat);
+	account		();
 
 	return m_matObtain;
 }
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Report memory
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief report the stored point clouds to the memory ledger
+void Handler4PCS::account()
+{
+	MemoryLedger *ledger	= MemoryLedger::instance();
+	ledger		->set(this, 0, MemoryLedger::PointClouds, (qint64)m_set1.capacity() * sizeof(Point3D), QString("4PCS cloud 1: %1 point(s)").arg(m_set1.size()));
+	ledger		->set(this, 1, MemoryLedger::PointClouds, (qint64)m_set2.capacity() * sizeof(Point3D), QString("4PCS cloud 2: %1 point(s)").arg(m_set2.size()));
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Return a copy of the transformed cloud
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
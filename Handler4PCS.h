@@ -36,6 +36,8 @@ class Handler4PCS
 public:
 	//! \brief Constructor
 						Handler4PCS			();
+	//! \brief Destructor
+						~Handler4PCS		();
 	//! \brief set 4pcs parameters
 	void				setParameters		(float, float);
 	//! \brief store the point clouds
@@ -50,6 +52,8 @@ public:
 	Vertex*				getCloud			();
 
 private:
+	//! \brief report the stored point clouds to the memory ledger
+	void				account				();
 	//! \brief triangulate
 	void				triang				(QVector<Point3D>&);
 	//! \brief compute face normal
@@ -14,28 +14,56 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 #include "OpenGLWidget.h"
+#include "trace.h"
+#include "memoryledger.h"
+#include "texturecache.h"
 #include <cmath>
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Constructor
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Constructor
-//! \details init opengl
+//! \details init opengl. Without a shareWidget the widget joins the context group of the texture cache, so
+//!	textures and lists are shared by every view
 //! \param[in] *p Qwidet
 //! \param[in] *shareWidget QGLWidget
 OpenGLWidget::OpenGLWidget(QWidget *p, QGLWidget *shareWidget)
-	: QGLWidget(p, shareWidget)
+	: QGLWidget(p, shareWidget ? shareWidget : TextureCache::shareWidget())
 {
+	m_vertices	= 0;
+	m_listPoints	= 0;
+	m_ptCloud	= 0;
+	m_imageTexture	= 0;
+	m_textureKey	= 0;
+	m_textureLevel	= 0;
 	initializeGL();
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Destructor
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+//! \details frees the depth points, the point list and the texture reference; the widget leaves the memory ledger
+OpenGLWidget::~OpenGLWidget()
+{
+	makeCurrent		();
+	releaseTexture	();
+	releaseCloud	();
+	delete [] m_vertices;
+	MemoryLedger::instance()->remove(this);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Initializes OpenGL settings
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Initializes OpenGL settings
 void OpenGLWidget::initializeGL()
 {
-	m_vertices	= new Vertex[17000];
+	if (!m_vertices)
+	{	// Qt initializes again when the context is made; keep the first buffer
+		m_vertices	= new Vertex[17000];
+		MemoryLedger::instance()->set(this, 3, MemoryLedger::PointClouds, 17000 * sizeof(Vertex), tr("depth point buffer"));
+	}
 	m_scale		= 1.0;
 	m_xRot		= 0;
 	m_yRot		= 0;
@@ -77,6 +105,7 @@ void OpenGLWidget::resizeGL(int width, int height)
 //! \brief displaying the image
 void OpenGLWidget::paintGL()
 {
+	TRACE("OpenGLWidget::paintGL");
 	glClear			(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	if (m_applyMatrix)
@@ -97,6 +126,8 @@ void OpenGLWidget::paintGL()
 	{
 		createTexture	();
 		loadImage	();
+		if (!m_overlay.isEmpty())
+			drawOverlay	();
 	}
 }
 
@@ -106,9 +137,11 @@ void OpenGLWidget::paintGL()
 //! \brief clears the display
 void OpenGLWidget::clear()
 {
-	deleteTexture	(m_imageTexture);
-	glDeleteLists	(m_ptCloud, 1);
+	makeCurrent		();
+	releaseTexture	();
+	releaseCloud	();
 	m_image			= QImage();
+	m_overlay		.clear();
 	m_scale			= 1.0;
 	m_xRot			= 0;
 	m_yRot			= 0;
@@ -117,6 +150,7 @@ void OpenGLWidget::clear()
 	m_translateY	= 0;
 	m_depthImg		= false;
 	m_applyMatrix	= false;
+	account			();
 
 	glDraw			();
 }
@@ -172,9 +206,13 @@ void OpenGLWidget::transformation(double *mat, Vertex *p, Vertex *q)
 	glInit			();
 	m_imageName		= QString();
 	m_image			= QImage();
+	m_overlay		.clear();
 	m_depthImg		= true;
 
+	releaseTexture	();
+	releaseCloud	();
 	m_ptCloud		= makeTransCloud(mat, p, q);
+	account			();
 
 	// initial position
 	m_yRot			= -90;
@@ -195,9 +233,13 @@ void OpenGLWidget::drawCloud(Vertex *p, Vertex *q)
 	glInit			();
 	m_imageName		= QString();
 	m_image			= QImage();
+	m_overlay		.clear();
 	m_depthImg		= true;
 
+	releaseTexture	();
+	releaseCloud	();
 	m_ptCloud		= makeCloud(p, q);
+	account			();
 
 	// initial position
 	m_yRot			= -90;
@@ -217,7 +259,9 @@ void OpenGLWidget::storeImage(QString fileName, QImage image)
 	glInit			();
 	m_imageName		= fileName;
 	m_image			= QImage(image);
+	m_overlay		.clear();
 	m_depthImg		= false;
+	account			();
 
 	glDraw			();
 }
@@ -230,9 +274,11 @@ void OpenGLWidget::storeImage(QString fileName, QImage image)
 //! \param[in] path	read vertices from file
 void OpenGLWidget::storeDepth(QString fileName, string path)
 {
+	TRACE("OpenGLWidget::storeDepth");
 	glInit			();
 	m_imageName		= fileName;
 	m_image			= QImage();
+	m_overlay		.clear();
 	m_depthImg		= true;
 	m_applyMatrix	= false;
 
@@ -260,7 +306,10 @@ void OpenGLWidget::storeDepth(QString fileName, string path)
 
 	m_vertices[0].location[0]	= (double)(index-1);
 
+	releaseTexture	();
+	releaseCloud	();
 	m_ptCloud	= makeCloud();
+	account		();
 
 	// initial position
 	m_yRot		= -90;
@@ -273,12 +322,81 @@ void OpenGLWidget::storeDepth(QString fileName, string path)
 // makes the image a texture
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief makes the image texture
+//! \details the texture comes from the shared cache, so an image already shown by another view is not uploaded
+//!	again. The reference is only swapped when the image or the level changes
+// the texture comes from the shared cache; the reference is only swapped when the image or the level changes
 void OpenGLWidget::createTexture()
 {
-	if(!m_imageName.isNull())
+	if (m_image.isNull())
 	{
-		m_imageTexture	= bindTexture(m_image, GL_TEXTURE_2D);
+		releaseTexture	();
+		return;
 	}
+
+	int level		= textureLevel();
+	if (m_imageTexture && m_textureKey == m_image.cacheKey() && m_textureLevel == level)
+		return;
+
+	GLuint texture	= TextureCache::instance()->ref(m_image, level);
+	releaseTexture	();	// after the new reference, so a texture kept by both is never evicted
+	m_imageTexture	= texture;
+	m_textureKey	= m_image.cacheKey();
+	m_textureLevel	= level;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// release the texture
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief drop the reference to the texture of the image
+//! \details the cache keeps the texture for other views; the context must be current
+void OpenGLWidget::releaseTexture()
+{
+	if (!m_imageTexture)
+		return;
+
+	TextureCache::instance()->unref(m_textureKey, m_textureLevel);
+	m_imageTexture	= 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// texture level
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief resolution level of the texture
+//! \details the image fills the widget at zoom 1, so the level is the coarsest that still has a texel for every
+//!	pixel on screen; it is raised further if the image is larger than the GL texture limit
+//! \return	level; 0 is full size, level n the image halved n times
+// the coarsest level that still has a texel for every pixel on screen
+int OpenGLWidget::textureLevel()
+{
+	GLint limit		= 0;
+	glGetIntegerv	(GL_MAX_TEXTURE_SIZE, &limit);
+
+	int w			= m_image.width();
+	int h			= m_image.height();
+	int screenW		= (int)(width() * m_scale);
+	int screenH		= (int)(height() * m_scale);
+
+	int level		= 0;
+	while ((w >> (level + 1)) >= screenW && (h >> (level + 1)) >= screenH && (w >> (level + 1)) > 0 && (h >> (level + 1)) > 0)
+		level++;
+	while (limit > 0 && ((w >> level) > limit || (h >> level) > limit))
+		level++;
+	return level;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// release the point cloud
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief delete the point cloud list
+//! \details lists live in the shared context group, so only a list this view made may be deleted; the
+//!	context must be current
+void OpenGLWidget::releaseCloud()
+{
+	if (!m_ptCloud)
+		return;
+
+	glDeleteLists	(m_ptCloud, 1);
+	m_ptCloud		= 0;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -304,6 +422,49 @@ void OpenGLWidget::loadImage()
 	glPopMatrix	();
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// overlay
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief line segments drawn over the image
+//! \details the overlay is dropped when a new image is stored
+//! \param[in] segments	segments in image coordinates
+// the overlay is dropped when a new image is stored
+void OpenGLWidget::setOverlay(QVector<QLineF> segments)
+{
+	m_overlay		= segments;
+	updateGL		();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// draws the overlay
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief draws the overlay segments over the image
+//! \details image coordinates are mapped onto the same quad as loadImage(); the segments sit just in front of it
+// image coordinates are mapped onto the same quad as loadImage(); the segments sit just in front of it
+void OpenGLWidget::drawOverlay()
+{
+	if (m_image.isNull())
+		return;
+
+	float sx		= 20.0f / m_image.width();
+	float sy		= 20.0f / m_image.height();
+
+	glDisable		(GL_TEXTURE_2D);
+	glColor3f		(1.0, 0.0, 0.0);
+
+	glBegin			(GL_LINES);
+	for (int i = 0; i < m_overlay.size(); i++)
+	{
+		const QLineF &l	= m_overlay[i];
+		glVertex3f	(-10.0f + sx * ((float)l.x1() + 0.5f), 10.0f - sy * ((float)l.y1() + 0.5f), 0.1f);
+		glVertex3f	(-10.0f + sx * ((float)l.x2() + 0.5f), 10.0f - sy * ((float)l.y2() + 0.5f), 0.1f);
+	}
+	glEnd			();
+
+	glColor3f		(1.0, 1.0, 1.0);
+	glEnable		(GL_TEXTURE_2D);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // mouse press event
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -451,6 +612,21 @@ void OpenGLWidget::setZRotation(int angle)
 	}
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// report memory
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief report the image and the point list to the memory ledger
+//! \details the point list is counted as a color and a vertex of three floats per point; textures are reported
+//!	by the texture cache, which owns them
+// the point list is counted as a color and a vertex of three floats per point
+void OpenGLWidget::account()
+{
+	MemoryLedger *ledger	= MemoryLedger::instance();
+	ledger					->set(this, 0, MemoryLedger::Frames, m_image.numBytes(), tr("view: %1").arg(m_imageName), m_image.cacheKey());
+	ledger					->set(this, 2, MemoryLedger::DisplayLists, m_depthImg ? (qint64)m_listPoints * 6 * sizeof(float) : 0,
+								  tr("point list: %1 point(s)").arg(m_listPoints));
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // make cloud list
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -465,6 +641,7 @@ GLuint OpenGLWidget::makeCloud()
 	glNewList		(list, GL_COMPILE);
 
 	int size 		= (int)m_vertices[0].location[0];
+	m_listPoints	= qMax(size - 2, 0);
 
 	glBegin			(GL_POINTS);
 	for (int i = 1; i < size-1; i++)
@@ -500,6 +677,7 @@ GLuint OpenGLWidget::makeCloud(Vertex *p, Vertex *q)
 	glNewList		(list, GL_COMPILE);
 
 	int size 		= (int)p[0].location[0];
+	m_listPoints	= qMax(size - 2, 0) + qMax((int)q[0].location[0] - 2, 0);
 	glBegin			(GL_POINTS);
 	for (int i = 1; i < size-1; i++)
 	{
@@ -546,6 +724,7 @@ GLuint OpenGLWidget::makeTransCloud(double *mat, Vertex *p, Vertex *q)
 	glNewList		(list, GL_COMPILE);
 
 	int size 		= (int)p[0].location[0];
+	m_listPoints	= qMax(size - 2, 0) + qMax((int)q[0].location[0] - 2, 0);
 	glBegin			(GL_POINTS);
 	for (int i = 1; i < size-1; i++)
 	{
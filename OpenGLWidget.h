@@ -20,6 +20,8 @@
 #include 	<QString>
 #include	<QMouseEvent>
 #include	<QPoint>
+#include	<QLineF>
+#include	<QVector>
 
 #include	<string>
 #include	<fstream>
@@ -39,6 +41,8 @@ class OpenGLWidget : public QGLWidget
 public:
 	//! \brief Constructor
 		OpenGLWidget			(QWidget *p = 0, QGLWidget *shareWidget = 0);
+	//! \brief Destructor
+		~OpenGLWidget			();
 	//! \brief stores the name of the image
 	void	storeImage			(QString, QImage);
 	//! \brief store depth image
@@ -53,6 +57,8 @@ public:
 	void	transformation		(double*, Vertex*, Vertex*);
 	//! \brief render transformed point cloud
 	void	drawCloud			(Vertex*, Vertex*);
+	//! \brief line segments (image coordinates) drawn over the image
+	void	setOverlay			(QVector<QLineF>);
 
 signals:
 	//! \brief let Frame class knows that it's dragging
@@ -77,8 +83,16 @@ protected:
 private:
 	//! \brief makes the image a texture
 	void	createTexture		();
+	//! \brief drop the reference to the texture of the image
+	void	releaseTexture		();
+	//! \brief resolution level of the texture for the current size and zoom
+	int		textureLevel		();
+	//! \brief delete the point cloud list
+	void	releaseCloud		();
 	//! \brief displays the image mapped to the rectangle
 	void	loadImage			();
+	//! \brief draws the overlay segments over the image
+	void	drawOverlay			();
 	//! \brief normalize rotation angle
 	void	normalizeAngle		(int*);
 	//! \brief set x rotation axis
@@ -87,6 +101,8 @@ private:
 	void	setYRotation		(int);
 	//! \brief set z rotation axis
 	void	setZRotation		(int);
+	//! \brief report the image and point list to the memory ledger
+	void	account				();
 	//! \brief make cloud list based on internal Vertex
 	GLuint	makeCloud			();
 	//! \brief make transformed cloud list based on inputs
@@ -94,11 +110,14 @@ private:
 	//! \brief make cloud list based on inputs
 	GLuint	makeTransCloud		(double*, Vertex*, Vertex*);
 
-	GLuint	m_imageTexture;		// texture map of the image
+	GLuint	m_imageTexture;		// texture map of the image; a reference to the shared texture cache, 0 if none
+	qint64	m_textureKey;		// cacheKey() of the image the texture was made from
+	int		m_textureLevel;		// resolution level of the texture
 	GLuint	m_ptCloud;			// opengl list for point cloud
 
 	QString	m_imageName;		// image name
 	QImage  m_image;			// the image itself
+	QVector<QLineF>	m_overlay;	// segments drawn over the image (image coordinates)
 
 	int	m_xRot;					// x-axis for rotation
 	int	m_yRot;					// y-axis for rotation
@@ -109,6 +128,7 @@ private:
 	QPoint	m_lastPt;			// last point for rotation
 
 	Vertex	*m_vertices;		// struct to store depth points
+	int		m_listPoints;		// points in m_ptCloud
 	bool	m_depthImg;			// flag to indicate whether this is a depth image or not
 	bool	m_applyMatrix;		// tell paintgl to apply the current transformation matrix
 
@@ -0,0 +1,218 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ActivityLog
+//! \brief ActivityLog implementation
+//!
+//! \file activitylog.cpp
+//! \brief ActivityLog implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QFile>
+#include			<QTextStream>
+
+#include			"activitylog.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+//! \param[in] capacity	most records kept
+ActivityLog::ActivityLog(int capacity)
+{
+	m_ring				.resize(qMax(1, capacity));
+	m_head				= 0;
+	m_count				= 0;
+	m_dropped			= 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Add
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add a record
+//! \details constant time; when the buffer is full the oldest record is overwritten
+//! \param[in] category	ActivityLog::Category
+//! \param[in] message	what happened
+//! \param[in] ms		wall time of the operation; -1 if not timed
+//! \param[in] bytes	bytes processed; -1 if not measured
+//! \return		the new record
+// constant time; when the buffer is full the oldest record is overwritten
+const LogRecord& ActivityLog::add(int category, const QString &message, int ms, qint64 bytes)
+{
+	LogRecord &record	= m_ring[m_head];
+	record.time			= QDateTime::currentDateTime();
+	record.category		= category;
+	record.message		= message;
+	record.ms			= ms;
+	record.bytes		= bytes;
+
+	m_head				= (m_head + 1) % m_ring.size();
+	if (m_count < m_ring.size())
+		m_count++;
+	else
+		m_dropped++;
+	return record;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Count
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief number of records held
+//! \return	# of records
+int ActivityLog::count()
+{
+	return m_count;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// At
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a record
+//! \param[in] i	0 is the oldest record held
+//! \return	the record
+const LogRecord& ActivityLog::at(int i)
+{
+	int oldest			= (m_head - m_count + m_ring.size()) % m_ring.size();
+	return m_ring[(oldest + i) % m_ring.size()];
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Dropped
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief number of records dropped so far
+//! \return	# of records overwritten by newer ones
+qint64 ActivityLog::dropped()
+{
+	return m_dropped;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Export
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief write the records that pass a filter as JSON lines
+//! \details one object per line, oldest first, so the file can be read by line oriented tools
+//! \param[in] path		file to write
+//! \param[in] category	category to keep; -1 for all
+//! \param[in] text		text the message has to contain; empty for all
+//! \return		false if the file could not be written
+// one object per line, oldest first, so the file can be read by line oriented tools
+bool ActivityLog::exportJson(const QString &path, int category, const QString &text)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+		return false;
+
+	QTextStream out(&file);
+	out					.setCodec("UTF-8");
+	for (int i = 0; i < m_count; i++)
+		if (matches(at(i), category, text))
+			out			<< toJson(at(i)) << "\n";
+	out					.flush();
+	return file.error() == QFile::NoError;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Matches
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief does a record pass a filter
+//! \param[in] record	the record
+//! \param[in] category	category to keep; -1 for all
+//! \param[in] text		text the message has to contain, without case; empty for all
+//! \return		true if the record is kept
+bool ActivityLog::matches(const LogRecord &record, int category, const QString &text)
+{
+	if (category >= 0 && record.category != category)
+		return false;
+	return text.isEmpty() || record.message.contains(text, Qt::CaseInsensitive);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Category name
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief display name of a category
+//! \param[in] category	ActivityLog::Category
+//! \return		the name; also used in the JSON export
+QString ActivityLog::categoryName(int category)
+{
+	static const char *names[]	= {"general", "file", "image", "registration", "error"};
+	return (category >= 0 && category < NumCategories) ? names[category] : "general";
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Format
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a record as shown in the log tab
+//! \details time, category and message; timed records add the wall time, and the throughput if bytes
+//!	were measured
+//! \param[in] record	the record
+//! \return		display text
+// time, category and message; timed records add the wall time and the throughput
+QString ActivityLog::format(const LogRecord &record)
+{
+	QString line		= QString("%1 [%2] %3").arg(record.time.toString("hh:mm:ss.zzz"))
+							.arg(categoryName(record.category)).arg(record.message);
+	if (record.ms >= 0)
+	{
+		line			+= QString(" (%1 ms").arg(record.ms);
+		if (record.bytes >= 0)
+			line		+= QString(", %1 MB/s").arg(record.bytes / (qMax(record.ms, 1) / 1000.0) / (1 << 20), 0, 'f', 1);
+		line			+= ")";
+	}
+	return line;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// JSON
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a record as one line of JSON
+//! \details fields that were not measured are left out
+//! \param[in] record	the record
+//! \return		a JSON object without line breaks
+// fields that were not measured are left out
+QString ActivityLog::toJson(const LogRecord &record)
+{
+	QString json		= QString("{\"time\":%1,\"category\":%2,\"message\":%3")
+							.arg(jsonString(record.time.toString("yyyy-MM-ddThh:mm:ss.zzz")))
+							.arg(jsonString(categoryName(record.category))).arg(jsonString(record.message));
+	if (record.ms >= 0)
+		json			+= QString(",\"ms\":%1").arg(record.ms);
+	if (record.bytes >= 0)
+		json			+= QString(",\"bytes\":%1").arg(record.bytes);
+	return json + "}";
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// JSON string
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a string as a JSON string literal
+//! \details quotes and backslashes are escaped, and so are control characters; the trace export uses it too
+//! \param[in] s	the string
+//! \return		the literal, quotes included
+// quotes, backslashes and control characters are escaped
+QString ActivityLog::jsonString(const QString &s)
+{
+	QString out("\"");
+	for (int i = 0; i < s.size(); i++)
+	{
+		ushort c		= s[i].unicode();
+		switch (c)
+		{
+			case '"':	out	+= "\\\"";	break;
+			case '\\':	out	+= "\\\\";	break;
+			case '\n':	out	+= "\\n";	break;
+			case '\r':	out	+= "\\r";	break;
+			case '\t':	out	+= "\\t";	break;
+			default:
+				if (c < 0x20)
+					out	+= QString("\\u%1").arg(c, 4, 16, QChar('0'));
+				else
+					out	+= s[i];
+		}
+	}
+	return out + "\"";
+}
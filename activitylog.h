@@ -0,0 +1,73 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ActivityLog
+//! \brief Bounded ring buffer of structured log records
+//!
+//! \file activitylog.h
+//! \brief ActivityLog class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				ACTIVITYLOG_H
+#define				ACTIVITYLOG_H
+
+#define				LOG_CAPACITY	10000	// records kept; older ones are dropped
+
+#include			<QDateTime>
+#include			<QString>
+#include			<QVector>
+
+// one entry of the log
+struct LogRecord
+{
+	QDateTime		time;			// when it was logged
+	int				category;		// ActivityLog::Category
+	QString			message;		// what happened; may span lines
+	int				ms;				// wall time of the operation; -1 if not timed
+	qint64			bytes;			// bytes processed; -1 if not measured
+};
+
+// ActivityLog class
+class ActivityLog
+{
+public:
+	//! \brief enum for ActivityLog; what a record is about
+	enum			Category		{General, File, Image, Registration, Error, NumCategories};
+
+	//! \brief Constructor
+					ActivityLog		(int capacity = LOG_CAPACITY);
+
+	//! \brief add a record; the oldest is dropped when the buffer is full
+	const LogRecord&	add			(int category, const QString &message, int ms = -1, qint64 bytes = -1);
+	//! \brief number of records held
+	int				count			();
+	//! \brief a record, oldest first
+	const LogRecord&	at			(int);
+	//! \brief number of records dropped so far
+	qint64			dropped			();
+	//! \brief write the records that pass a filter as JSON lines
+	bool			exportJson		(const QString &path, int category = -1, const QString &text = QString());
+
+	//! \brief does a record pass a filter; category -1 passes all, text is matched without case
+	static bool		matches			(const LogRecord&, int category, const QString &text);
+	//! \brief display name of a category
+	static QString	categoryName	(int);
+	//! \brief a record as shown in the log tab
+	static QString	format			(const LogRecord&);
+	//! \brief a record as one line of JSON
+	static QString	toJson			(const LogRecord&);
+	//! \brief a string as a JSON string literal, quotes included
+	static QString	jsonString		(const QString&);
+
+private:
+	QVector<LogRecord>	m_ring;		// records; m_head is the oldest once the buffer has wrapped
+	int				m_head;			// next slot to write
+	int				m_count;		// records held
+	qint64			m_dropped;		// records overwritten
+};
+#endif
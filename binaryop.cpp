@@ -0,0 +1,187 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class BinaryOp
+//! \brief Two image arithmetic implementation
+//!
+//! \file binaryop.cpp
+//! \brief Two image arithmetic implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifdef __SSE2__
+#include			<emmintrin.h>
+#endif
+
+#include			"binaryop.h"
+#include			"parallel.h"
+
+// state shared by the worker threads
+struct BinaryContext
+{
+	const QImage		*a;
+	const QImage		*b;
+	QImage				*dst;
+	BinaryOp::Op		op;
+	int					weight;			// blend weight of b (0 - 256)
+};
+
+// one color channel value; alpha is handled by the caller
+static inline int combine(BinaryOp::Op op, int a, int b, int weight)
+{
+	switch (op)
+	{
+		case BinaryOp::Difference:		return qBound(0, ((a - b) >> 1) + 128, 255);
+		case BinaryOp::AbsDifference:	return a > b ? a - b : b - a;
+		case BinaryOp::Add:				return qMin(a + b, 255);
+		case BinaryOp::Subtract:		return qMax(a - b, 0);
+		case BinaryOp::Blend:			return (a * (256 - weight) + b * weight + 128) >> 8;
+		case BinaryOp::Min:				return qMin(a, b);
+		case BinaryOp::Max:				return qMax(a, b);
+		case BinaryOp::Mask:
+		{
+			int t						= a * b + 128;
+			return (t + (t >> 8)) >> 8;	// a * b / 255, rounded
+		}
+		default:						return a;
+	}
+}
+
+#ifdef __SSE2__
+// 16 channel values at once; lo/hi halves are widened to 16 bits where 8 bits do not suffice
+static inline __m128i combineSIMD(BinaryOp::Op op, __m128i a, __m128i b, int weight)
+{
+	const __m128i zero		= _mm_setzero_si128();
+
+	switch (op)
+	{
+		case BinaryOp::Difference:
+			// (a - b) / 2 + 128 without leaving 8 bits: avg(a, 255 - b) = (a - b + 256) / 2
+			return _mm_avg_epu8(a, _mm_xor_si128(b, _mm_set1_epi8((char)0xff)));
+		case BinaryOp::AbsDifference:	return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+		case BinaryOp::Add:				return _mm_adds_epu8(a, b);
+		case BinaryOp::Subtract:		return _mm_subs_epu8(a, b);
+		case BinaryOp::Min:				return _mm_min_epu8(a, b);
+		case BinaryOp::Max:				return _mm_max_epu8(a, b);
+		case BinaryOp::Blend:
+		{
+			__m128i wa		= _mm_set1_epi16((short)(256 - weight));
+			__m128i wb		= _mm_set1_epi16((short)weight);
+			__m128i round	= _mm_set1_epi16(128);
+			__m128i lo		= _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), wa), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), wb));
+			__m128i hi		= _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), wa), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), wb));
+			lo				= _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+			hi				= _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+			return _mm_packus_epi16(lo, hi);
+		}
+		case BinaryOp::Mask:
+		{
+			__m128i round	= _mm_set1_epi16(128);
+			__m128i lo		= _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)), round);
+			__m128i hi		= _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)), round);
+			lo				= _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+			hi				= _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+			return _mm_packus_epi16(lo, hi);
+		}
+		default:						return a;
+	}
+}
+#endif
+
+// combine rows [begin, end); the alpha of a is kept
+static void combineRows(void *p, int begin, int end)
+{
+	BinaryContext *c		= (BinaryContext*)p;
+	int width				= c->dst->width();
+
+	for (int y = begin; y < end; y++)
+	{
+		const unsigned int *a	= (const unsigned int*)c->a->scanLine(y);
+		const unsigned int *b	= (const unsigned int*)c->b->scanLine(y);
+		unsigned int *d			= (unsigned int*)c->dst->scanLine(y);
+		int x					= 0;
+
+#ifdef __SSE2__
+		const __m128i alpha		= _mm_set1_epi32((int)0xff000000);
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i va			= _mm_loadu_si128((const __m128i*)(a + x));
+			__m128i vb			= _mm_loadu_si128((const __m128i*)(b + x));
+			__m128i r			= combineSIMD(c->op, va, vb, c->weight);
+			r					= _mm_or_si128(_mm_andnot_si128(alpha, r), _mm_and_si128(alpha, va));
+			_mm_storeu_si128	((__m128i*)(d + x), r);
+		}
+#endif
+
+		for (; x < width; x++)
+		{
+			unsigned int pa		= a[x];
+			unsigned int pb		= b[x];
+			unsigned int r		= pa & 0xff000000;
+			for (int shift = 0; shift < 24; shift += 8)
+				r				|= combine(c->op, (pa >> shift) & 0xff, (pb >> shift) & 0xff, c->weight) << shift;
+			d[x]				= r;
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Apply
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief combine a and b
+//! \details every color channel is combined with saturating 8 bit arithmetic (SSE2, 16 values per
+//!	instruction) and rows are spread over the threads. Difference maps a - b to (a - b) / 2 + 128 so the
+//!	sign is visible; Mask multiplies a by b / 255. The alpha channel of a is kept.
+//! \param[in] op		operation
+//! \param[in] a		first image (active frame)
+//! \param[in] b		second image (next frame)
+//! \param[in] weight	Blend only; weight of b (0 - 256)
+//! \return				the combined image; its size is the area both images share (top left aligned)
+// every color channel is combined with saturating 8 bit arithmetic and rows are spread over the threads
+QImage BinaryOp::apply(Op op, const QImage &a, const QImage &b, int weight)
+{
+	int width			= qMin(a.width(), b.width());
+	int height			= qMin(a.height(), b.height());
+	if (width <= 0 || height <= 0)
+		return QImage();
+
+	QImage srcA			= a.depth() == 32 ? a : a.convertToFormat(QImage::Format_ARGB32);
+	QImage srcB			= b.depth() == 32 ? b : b.convertToFormat(QImage::Format_ARGB32);
+	QImage dst			(width, height, srcA.format());
+
+	BinaryContext c;
+	c.a					= &srcA;
+	c.b					= &srcB;
+	c.dst				= &dst;
+	c.op				= op;
+	c.weight			= qBound(0, weight, 256);
+
+	Parallel::forRange	(height, combineRows, &c, 16);
+	return dst;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Name
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief display name of an operation
+//! \param[in] op	operation
+//! \return			name used in menus and in the image history
+QString BinaryOp::name(Op op)
+{
+	switch (op)
+	{
+		case Difference:		return QString("Difference");
+		case AbsDifference:		return QString("Absolute difference");
+		case Add:				return QString("Add");
+		case Subtract:			return QString("Subtract");
+		case Blend:				return QString("Blend");
+		case Min:				return QString("Minimum");
+		case Max:				return QString("Maximum");
+		case Mask:				return QString("Mask");
+		default:				return QString();
+	}
+}
@@ -0,0 +1,34 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class BinaryOp
+//! \brief Pixel arithmetic between two images
+//!
+//! \file binaryop.h
+//! \brief Two image arithmetic class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				BINARYOP_H
+#define				BINARYOP_H
+
+#include			<QImage>
+#include			<QString>
+
+// BinaryOp class
+class BinaryOp
+{
+public:
+	//! \brief enum for BinaryOp; every operation works per channel on 8 bit values
+	enum			Op				{Difference, AbsDifference, Add, Subtract, Blend, Min, Max, Mask, NumOps};
+
+	//! \brief combine a and b; the result covers the area both images share
+	static QImage	apply			(Op, const QImage&, const QImage&, int weight = 128);
+	//! \brief display name of an operation
+	static QString	name			(Op);
+};
+#endif
@@ -0,0 +1,554 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class FFT
+//! \brief Fast fourier transform implementation
+//!
+//! \file fft.cpp
+//! \brief Fast fourier transform implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cmath>
+
+#include			"fft.h"
+#include			"parallel.h"
+
+#ifdef __SSE2__
+#include			<emmintrin.h>
+#endif
+
+QHash<int, FFTPlan*>	FFT::s_plans;
+QMutex					FFT::s_planLock;
+
+static const double		FFT_PI		= 3.14159265358979323846;
+
+#ifdef __SSE2__
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SSE helpers; every __m128 holds two complex numbers [re0 im0 re1 im1]
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// multiply two pairs of complex numbers
+static inline __m128 cmul2(__m128 a, __m128 b)
+{
+	__m128 br		= _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));		// [br0 br0 br1 br1]
+	__m128 bi		= _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));		// [bi0 bi0 bi1 bi1]
+	__m128 as		= _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));		// [ai0 ar0 ai1 ar1]
+	__m128 sign		= _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);				// negate the real lanes
+	return _mm_add_ps(_mm_mul_ps(a, br), _mm_xor_ps(_mm_mul_ps(as, bi), sign));
+}
+
+// multiply two complex numbers by -i
+static inline __m128 mulNegI2(__m128 a)
+{
+	__m128 sign		= _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);				// negate the imaginary lanes
+	return _mm_xor_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), sign);
+}
+#endif
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Scalar complex helpers
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static inline FFTComplex cmul(FFTComplex a, FFTComplex b)
+{
+	FFTComplex r;
+	r.re			= a.re * b.re - a.im * b.im;
+	r.im			= a.re * b.im + a.im * b.re;
+	return r;
+}
+
+static inline FFTComplex cadd(FFTComplex a, FFTComplex b)
+{
+	FFTComplex r;
+	r.re			= a.re + b.re;
+	r.im			= a.im + b.im;
+	return r;
+}
+
+static inline FFTComplex csub(FFTComplex a, FFTComplex b)
+{
+	FFTComplex r;
+	r.re			= a.re - b.re;
+	r.im			= a.im - b.im;
+	return r;
+}
+
+// multiply by -i
+static inline FFTComplex cnegI(FFTComplex a)
+{
+	FFTComplex r;
+	r.re			= a.im;
+	r.im			= -a.re;
+	return r;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Small forward DFTs used as butterflies
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static inline void dft3(FFTComplex *v)
+{
+	const float c	= -0.5f;
+	const float s	= 0.86602540378443864676f;	// sin(2pi/3)
+
+	FFTComplex a	= cadd(v[1], v[2]);
+	FFTComplex b	= csub(v[1], v[2]);
+	FFTComplex m;
+	m.re			= v[0].re + c * a.re;
+	m.im			= v[0].im + c * a.im;
+
+	v[0]			= cadd(v[0], a);
+	// -i * s * b
+	v[1].re			= m.re + s * b.im;
+	v[1].im			= m.im - s * b.re;
+	v[2].re			= m.re - s * b.im;
+	v[2].im			= m.im + s * b.re;
+}
+
+static inline void dft4(FFTComplex *v)
+{
+	FFTComplex t0	= cadd(v[0], v[2]);
+	FFTComplex t1	= csub(v[0], v[2]);
+	FFTComplex t2	= cadd(v[1], v[3]);
+	FFTComplex t3	= cnegI(csub(v[1], v[3]));
+
+	v[0]			= cadd(t0, t2);
+	v[1]			= cadd(t1, t3);
+	v[2]			= csub(t0, t2);
+	v[3]			= csub(t1, t3);
+}
+
+static inline void dft5(FFTComplex *v)
+{
+	const float c1	= 0.30901699437494742410f;	// cos(2pi/5)
+	const float s1	= 0.95105651629515357212f;	// sin(2pi/5)
+	const float c2	= -0.80901699437494742410f;	// cos(4pi/5)
+	const float s2	= 0.58778525229247312917f;	// sin(4pi/5)
+
+	FFTComplex a1	= cadd(v[1], v[4]);
+	FFTComplex b1	= csub(v[1], v[4]);
+	FFTComplex a2	= cadd(v[2], v[3]);
+	FFTComplex b2	= csub(v[2], v[3]);
+
+	FFTComplex m1, m2, n1, n2;
+	m1.re			= v[0].re + c1 * a1.re + c2 * a2.re;
+	m1.im			= v[0].im + c1 * a1.im + c2 * a2.im;
+	m2.re			= v[0].re + c2 * a1.re + c1 * a2.re;
+	m2.im			= v[0].im + c2 * a1.im + c1 * a2.im;
+	n1.re			= s1 * b1.re + s2 * b2.re;
+	n1.im			= s1 * b1.im + s2 * b2.im;
+	n2.re			= s2 * b1.re - s1 * b2.re;
+	n2.im			= s2 * b1.im - s1 * b2.im;
+
+	v[0]			= cadd(v[0], cadd(a1, a2));
+	v[1]			= cadd(m1, cnegI(n1));
+	v[4]			= csub(m1, cnegI(n1));
+	v[2]			= cadd(m2, cnegI(n2));
+	v[3]			= csub(m2, cnegI(n2));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// One Stockham stage
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// x: input, y: output, R: radix of this stage, Ns: product of the radices already done
+// tw[r*Ns + k] = exp(-2*pi*i*r*k / (Ns*R))
+static void stage(const FFTComplex *x, FFTComplex *y, int n, int R, int Ns, const FFTComplex *tw)
+{
+	int stride		= n / R;
+
+	for (int base = 0; base < stride; base += Ns)
+	{
+		const FFTComplex *in	= x + base;
+		FFTComplex *out			= y + base * R;
+		int k					= 0;
+
+#ifdef __SSE2__
+		// two butterflies at a time; consecutive k are contiguous in x, y and tw
+		if (R == 2)
+		{
+			for ( ; k + 1 < Ns; k += 2)
+			{
+				__m128 a	= _mm_loadu_ps((const float*)(in + k));
+				__m128 b	= cmul2(_mm_loadu_ps((const float*)(in + k + stride)), _mm_loadu_ps((const float*)(tw + Ns + k)));
+				_mm_storeu_ps((float*)(out + k), _mm_add_ps(a, b));
+				_mm_storeu_ps((float*)(out + k + Ns), _mm_sub_ps(a, b));
+			}
+		}
+		else if (R == 4)
+		{
+			for ( ; k + 1 < Ns; k += 2)
+			{
+				__m128 v0	= _mm_loadu_ps((const float*)(in + k));
+				__m128 v1	= cmul2(_mm_loadu_ps((const float*)(in + k + stride)), _mm_loadu_ps((const float*)(tw + Ns + k)));
+				__m128 v2	= cmul2(_mm_loadu_ps((const float*)(in + k + 2 * stride)), _mm_loadu_ps((const float*)(tw + 2 * Ns + k)));
+				__m128 v3	= cmul2(_mm_loadu_ps((const float*)(in + k + 3 * stride)), _mm_loadu_ps((const float*)(tw + 3 * Ns + k)));
+
+				__m128 t0	= _mm_add_ps(v0, v2);
+				__m128 t1	= _mm_sub_ps(v0, v2);
+				__m128 t2	= _mm_add_ps(v1, v3);
+				__m128 t3	= mulNegI2(_mm_sub_ps(v1, v3));
+
+				_mm_storeu_ps((float*)(out + k), _mm_add_ps(t0, t2));
+				_mm_storeu_ps((float*)(out + k + Ns), _mm_add_ps(t1, t3));
+				_mm_storeu_ps((float*)(out + k + 2 * Ns), _mm_sub_ps(t0, t2));
+				_mm_storeu_ps((float*)(out + k + 3 * Ns), _mm_sub_ps(t1, t3));
+			}
+		}
+#endif
+
+		for ( ; k < Ns; k++)
+		{
+			FFTComplex v[5];
+			v[0]			= in[k];
+			for (int r = 1; r < R; r++)
+				v[r]		= cmul(in[k + r * stride], tw[r * Ns + k]);
+
+			switch (R)
+			{
+				case 2:
+				{
+					FFTComplex t	= v[0];
+					v[0]			= cadd(t, v[1]);
+					v[1]			= csub(t, v[1]);
+				}
+				break;
+				case 3:
+					dft3(v);
+				break;
+				case 4:
+					dft4(v);
+				break;
+				case 5:
+					dft5(v);
+				break;
+			}
+
+			for (int r = 0; r < R; r++)
+				out[k + r * Ns]	= v[r];
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Good size
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief smallest size >= n that only has 2, 3 and 5 as factors
+//! \param[in] n	minimum size
+//! \return		transform length to pad to
+int FFT::goodSize(int n)
+{
+	if (n <= 1)
+		return 1;
+
+	for (int m = n; ; m++)
+	{
+		int r		= m;
+		while (r % 2 == 0)	r /= 2;
+		while (r % 3 == 0)	r /= 3;
+		while (r % 5 == 0)	r /= 5;
+		if (r == 1)
+			return m;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Plan
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief cached plan for length n
+//! \details factor n and precompute the twiddles of every stage; plans are kept for the session
+//! \param[in] n	transform length (a good size)
+//! \return		plan for n
+// factor n and precompute the twiddles of every stage; plans are kept for the session
+const FFTPlan* FFT::plan(int n)
+{
+	QMutexLocker locker(&s_planLock);
+
+	FFTPlan *p			= s_plans.value(n, 0);
+	if (p)
+		return p;
+
+	p					= new FFTPlan;
+	p->n				= n;
+
+	// radix 4 first; it is the cheapest per point
+	int r				= n;
+	while (r % 4 == 0)	{ p->radix.append(4); r /= 4; }
+	while (r % 2 == 0)	{ p->radix.append(2); r /= 2; }
+	while (r % 3 == 0)	{ p->radix.append(3); r /= 3; }
+	while (r % 5 == 0)	{ p->radix.append(5); r /= 5; }
+
+	// every stage needs R*Ns twiddles
+	int total			= 0;
+	int Ns				= 1;
+	for (int s = 0; s < p->radix.size(); s++)
+	{
+		total			+= p->radix[s] * Ns;
+		Ns				*= p->radix[s];
+	}
+	p->table.resize		(total);
+
+	int offset			= 0;
+	Ns					= 1;
+	for (int s = 0; s < p->radix.size(); s++)
+	{
+		int R			= p->radix[s];
+		FFTComplex *tw	= p->table.data() + offset;
+		for (int q = 0; q < R; q++)
+		{
+			for (int k = 0; k < Ns; k++)
+			{
+				double a			= -2.0 * FFT_PI * q * k / (double)(Ns * R);
+				tw[q * Ns + k].re	= (float)cos(a);
+				tw[q * Ns + k].im	= (float)sin(a);
+			}
+		}
+		offset			+= R * Ns;
+		Ns				*= R;
+	}
+
+	// table no longer grows, so the stage pointers stay valid
+	offset				= 0;
+	Ns					= 1;
+	for (int s = 0; s < p->radix.size(); s++)
+	{
+		p->twiddle.append(p->table.data() + offset);
+		offset			+= p->radix[s] * Ns;
+		Ns				*= p->radix[s];
+	}
+
+	s_plans.insert		(n, p);
+	return p;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// 1D transform
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief 1D complex transform in place
+//! \details Stockham autosort; no bit reversal pass. The inverse is computed as conj(FFT(conj(x))) and is not scaled
+//! \param[in, out] data	n complex samples
+//! \param[in] work		scratch buffer of n complex samples
+//! \param[in] n		transform length; must be a good size
+//! \param[in] inverse	true for the inverse transform
+// Stockham autosort; no bit reversal pass. The inverse is computed as conj(FFT(conj(x))) and is not scaled
+void FFT::transform(FFTComplex *data, FFTComplex *work, int n, bool inverse)
+{
+	if (n <= 1)
+		return;
+
+	const FFTPlan *p	= plan(n);
+
+	if (inverse)
+		for (int i = 0; i < n; i++)
+			data[i].im	= -data[i].im;
+
+	FFTComplex *x		= data;
+	FFTComplex *y		= work;
+	int Ns				= 1;
+	for (int s = 0; s < p->radix.size(); s++)
+	{
+		stage			(x, y, n, p->radix[s], Ns, p->twiddle[s]);
+		Ns				*= p->radix[s];
+		FFTComplex *t	= x;
+		x				= y;
+		y				= t;
+	}
+
+	// result ends in x; copy back when it landed in the scratch buffer
+	if (x != data)
+		for (int i = 0; i < n; i++)
+			data[i]		= x[i];
+
+	if (inverse)
+		for (int i = 0; i < n; i++)
+			data[i].im	= -data[i].im;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// 2D helpers; each runs over a chunk of rows or columns on a worker thread
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+struct FFT2DContext
+{
+	const float		*src;			// real input (forward rows)
+	float			*dst;			// real output (inverse rows)
+	FFTComplex		*spec;			// half spectrum, height x (width/2+1)
+	int				width;
+	int				height;
+	bool			inverse;
+};
+
+// forward transform of row pairs [begin, end); two real rows share one complex transform
+static void forwardRows(void *p, int begin, int end)
+{
+	FFT2DContext *c		= (FFT2DContext*)p;
+	int w				= c->width;
+	int half			= w / 2 + 1;
+
+	QVector<FFTComplex> z(w), work(w);
+
+	for (int pair = begin; pair < end; pair++)
+	{
+		int y			= pair * 2;
+		bool two		= (y + 1) < c->height;
+		const float *a	= c->src + y * w;
+		const float *b	= two ? a + w : 0;
+
+		for (int x = 0; x < w; x++)
+		{
+			z[x].re		= a[x];
+			z[x].im		= two ? b[x] : 0.0f;
+		}
+
+		FFT::transform	(z.data(), work.data(), w, false);
+
+		FFTComplex *A	= c->spec + y * half;
+		FFTComplex *B	= two ? A + half : 0;
+		for (int k = 0; k < half; k++)
+		{	// A = (Z[k] + conj(Z[-k]))/2, B = (Z[k] - conj(Z[-k]))/2i
+			FFTComplex zk	= z[k];
+			FFTComplex zn	= z[(w - k) % w];
+
+			A[k].re		= 0.5f * (zk.re + zn.re);
+			A[k].im		= 0.5f * (zk.im - zn.im);
+			if (two)
+			{
+				B[k].re	= 0.5f * (zk.im + zn.im);
+				B[k].im	= -0.5f * (zk.re - zn.re);
+			}
+		}
+	}
+}
+
+// inverse transform of row pairs [begin, end); rebuilds the full row spectrum from the half one
+static void inverseRows(void *p, int begin, int end)
+{
+	FFT2DContext *c		= (FFT2DContext*)p;
+	int w				= c->width;
+	int half			= w / 2 + 1;
+	float scale			= 1.0f / ((float)w * (float)c->height);
+
+	QVector<FFTComplex> z(w), work(w);
+
+	for (int pair = begin; pair < end; pair++)
+	{
+		int y			= pair * 2;
+		bool two		= (y + 1) < c->height;
+		const FFTComplex *A	= c->spec + y * half;
+		const FFTComplex *B	= two ? A + half : 0;
+
+		for (int k = 0; k < w; k++)
+		{	// Z = A + iB, with A[k] = conj(A[w-k]) above the half
+			FFTComplex a, b;
+			if (k < half)
+			{
+				a		= A[k];
+				if (two)	b	= B[k];
+			}
+			else
+			{
+				a		= A[w - k];
+				a.im	= -a.im;
+				if (two)
+				{
+					b		= B[w - k];
+					b.im	= -b.im;
+				}
+			}
+			if (!two)
+				b.re	= b.im	= 0.0f;
+
+			z[k].re		= a.re - b.im;
+			z[k].im		= a.im + b.re;
+		}
+
+		FFT::transform	(z.data(), work.data(), w, true);
+
+		float *ra		= c->dst + y * w;
+		for (int x = 0; x < w; x++)
+			ra[x]		= z[x].re * scale;
+		if (two)
+		{
+			float *rb	= ra + w;
+			for (int x = 0; x < w; x++)
+				rb[x]	= z[x].im * scale;
+		}
+	}
+}
+
+// transform columns [begin, end) of the half spectrum in place
+static void columns(void *p, int begin, int end)
+{
+	FFT2DContext *c		= (FFT2DContext*)p;
+	int h				= c->height;
+	int half			= c->width / 2 + 1;
+
+	QVector<FFTComplex> z(h), work(h);
+
+	for (int col = begin; col < end; col++)
+	{
+		FFTComplex *s	= c->spec + col;
+		for (int y = 0; y < h; y++)
+			z[y]		= s[y * half];
+
+		FFT::transform	(z.data(), work.data(), h, c->inverse);
+
+		for (int y = 0; y < h; y++)
+			s[y * half]	= z[y];
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// 2D forward transform
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief 2D real to complex transform
+//! \details rows first (two real rows per complex transform), then the width/2+1 columns; both passes are multi-threaded
+//! \param[in] src		width x height real samples
+//! \param[in] width	good size
+//! \param[in] height	good size
+//! \param[out] dst		height x (width/2 + 1) complex bins
+// rows first (two real rows per complex transform), then the width/2+1 columns; both passes are multi-threaded
+void FFT::forward2D(const float *src, int width, int height, FFTComplex *dst)
+{
+	FFT2DContext c;
+	c.src				= src;
+	c.dst				= 0;
+	c.spec				= dst;
+	c.width				= width;
+	c.height			= height;
+	c.inverse			= false;
+
+	// warm the plan cache before the workers start
+	plan				(width);
+	plan				(height);
+
+	Parallel::forRange	((height + 1) / 2, forwardRows, &c, 8);
+	Parallel::forRange	(width / 2 + 1, columns, &c, 8);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// 2D inverse transform
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief 2D complex to real transform
+//! \details columns first, then two rows per complex transform; output is scaled by 1/(width*height)
+//! \param[in, out] src	height x (width/2 + 1) complex bins; overwritten
+//! \param[in] width	good size
+//! \param[in] height	good size
+//! \param[out] dst		width x height real samples
+// columns first, then two rows per complex transform; output is scaled by 1/(width*height)
+void FFT::inverse2D(FFTComplex *src, int width, int height, float *dst)
+{
+	FFT2DContext c;
+	c.src				= 0;
+	c.dst				= dst;
+	c.spec				= src;
+	c.width				= width;
+	c.height			= height;
+	c.inverse			= true;
+
+	plan				(width);
+	plan				(height);
+
+	Parallel::forRange	(width / 2 + 1, columns, &c, 8);
+	Parallel::forRange	((height + 1) / 2, inverseRows, &c, 8);
+}
@@ -0,0 +1,59 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class FFT
+//! \brief Mixed radix (2, 3, 5) fast fourier transform
+//!
+//! \file fft.h
+//! \brief Fast fourier transform class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				FFT_H
+#define				FFT_H
+
+#include			<QVector>
+#include			<QHash>
+#include			<QMutex>
+
+// single precision complex number; re and im are interleaved so SSE can load two at once
+struct FFTComplex
+{
+	float			re;
+	float			im;
+};
+
+// precomputed factors and twiddles for one transform length
+struct FFTPlan
+{
+	int						n;			// transform length
+	QVector<int>			radix;		// radix of every stage
+	QVector<FFTComplex*>	twiddle;	// twiddles of every stage (points into table)
+	QVector<FFTComplex>		table;		// storage for all twiddles
+};
+
+// FFT class
+class FFT
+{
+public:
+	//! \brief smallest size >= n that only has 2, 3 and 5 as factors
+	static int		goodSize		(int n);
+	//! \brief 1D complex transform in place; n must be a good size; inverse is not scaled
+	static void		transform		(FFTComplex *data, FFTComplex *work, int n, bool inverse);
+	//! \brief 2D real to complex transform; output is height rows of (width/2 + 1) bins
+	static void		forward2D		(const float *src, int width, int height, FFTComplex *dst);
+	//! \brief 2D complex to real transform; src is overwritten; output is scaled by 1/(width*height)
+	static void		inverse2D		(FFTComplex *src, int width, int height, float *dst);
+
+private:
+	//! \brief cached plan for length n
+	static const FFTPlan*	plan	(int n);
+
+	static QHash<int, FFTPlan*>	s_plans;	// plan cache, keyed by length
+	static QMutex				s_planLock;	// guards s_plans
+};
+#endif
@@ -14,6 +14,7 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 #include		"frame.h"
+#include		"memoryledger.h"
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // CONSTRUCTOR
@@ -90,6 +91,28 @@ Frame::Frame(int id, QWidget * parent)
 	setMouseTracking(true);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DESTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+//! \details the image of the frame leaves the memory ledger
+Frame::~Frame()
+{
+	MemoryLedger::instance()->remove(this);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Account image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief report the image of the frame to the memory ledger
+//! \details called whenever m_img changes; the cache key shows whether the pixels are shared with the store
+// called whenever m_img changes; the cache key shows whether the pixels are shared with the store
+void Frame::accountImage()
+{
+	MemoryLedger::instance()->set(this, 0, MemoryLedger::Frames, m_img.numBytes(),
+								  tr("frame %1: %2").arg(m_id).arg(m_imgName), m_img.cacheKey());
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Default frame
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -198,39 +221,45 @@ bool Frame::isOccupied()
 // display the new image and update the title bar
 void Frame::open(QString title, QString name, QImage img)
 {
+	m_history	.record(m_img, m_imgName, img);
 	updateTitleBar	(title);
 	m_isOccupied	= true;
 	m_img		= img;
 	m_imgName	= name;
+	accountImage	();
 	m_imgWid	->storeImage(name, m_img);
 
 	m_actCut	->setEnabled(true);
 	m_actCopy	->setEnabled(true);
 	m_actPaste	->setEnabled(true);
 	m_actClose	->setEnabled(true);
+	updateUndoActions();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Open depth file
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief open new depth file
-//! \details display the new depth model and update the title bar
+//! \details display the new depth model and update the title bar; a depth model is not an image, so the undo history starts over
 //! \param[in] title	frame's title
 //! \param[in] name	file's name
 //! \param[in] path	file's path
-// display the new depth model and update the title bar
+// display the new depth model and update the title bar; a depth model is not an image, so the undo history starts over
 void Frame::openDepth(QString title, QString name, string path)
 {
+	m_history	.clear();
 	updateTitleBar	(title);
 	m_isOccupied	= true;
 	m_imgName	= name;
 	m_img		= QImage();
+	accountImage	();
 	m_imgWid	->storeDepth(name, path);
 
 	m_actCut	->setEnabled(false);
 	m_actCopy	->setEnabled(false);
 	m_actPaste	->setEnabled(false);
 	m_actClose	->setEnabled(true);
+	updateUndoActions();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -253,10 +282,25 @@ void Frame::updateTitleBar(QString title)
 //! \param[in] name	image's name
 void Frame::setImage(QImage img, QString name)
 {
+	m_history	.record(m_img, m_imgName, img);
 	m_img		= img;
 	m_isOccupied= true;
 	m_imgName	= name;
+	accountImage	();
 	m_imgWid	->storeImage(name, m_img);
+	updateUndoActions();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set overlay
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief draw line segments over the image
+//! \details the overlay stays until another image is set
+//! \param[in] segments	segments in image coordinates
+// the overlay stays until another image is set
+void Frame::setOverlay(QVector<QLineF> segments)
+{
+	m_imgWid	->setOverlay(segments);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -306,20 +350,16 @@ bool Frame::eventFilter(QObject *obj, QEvent *e)
 // Drag
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief initialize drag
-//! \details drag the image and its title
-// drag the image and its title
+//! \details drag the image and its title. The data refers to the shared pixels; they are only encoded if the
+//!	image is dropped on another application
+// drag the image and its title; the data refers to the shared pixels
 void Frame::makeDrag()
 {
 	// drag the image and its title
 	if (m_isOccupied)
 	{
-		QMimeData *mData	= new QMimeData;
-		mData			->setImageData(m_img);
-		mData			->setText(m_title);
-		mData			->setData("text", m_imgName.toAscii());
-
 		QDrag *drag		= new QDrag(this);
-		drag			->setMimeData(mData);
+		drag			->setMimeData(new ImageMime(clip()));
 		drag			->setPixmap(QPixmap(":/images/drag_image.xpm"));
 		drag			->start();
 	}
@@ -345,7 +385,7 @@ void Frame::setZoom(float scale)
 //! \param[in] e	pointer to the drag enter event
 void Frame::dragEnterEvent(QDragEnterEvent *e)
 {
-	if ((e->mimeData()->hasImage()) && (e->source() != this))
+	if (ImageMime::canDecode(e->mimeData()) && (e->source() != this))
 	{	// only accept if it's not dragging back into itself and it has image
 		e			->acceptProposedAction();
 
@@ -366,17 +406,17 @@ void Frame::dragEnterEvent(QDragEnterEvent *e)
 // drop data into the target frame
 void Frame::dropEvent(QDropEvent *e)
 {
-	QImage imgDrag	= qvariant_cast<QImage>(e->mimeData()->imageData());
-	if(!imgDrag.isNull())
+	ImageClip drag	= ImageMime::clip(e->mimeData());	// shares the pixels if the drag started in IManip
+	if(!drag.img.isNull())
 	{
-		m_img		= imgDrag;
+		m_history	.record(m_img, m_imgName, drag.img);
+		m_img		= drag.img;
 		m_isOccupied	= true;
 
-		QString title	= qvariant_cast<QString>(e->mimeData()->text());
-		updateTitleBar	(title);
+		updateTitleBar	(drag.title);
 
-		QString temp	(qvariant_cast<QByteArray>(e->mimeData()->data("text")));
-		m_imgName	= temp;
+		m_imgName	= drag.name;
+		accountImage	();
 		m_imgWid	->storeImage(m_imgName, m_img);
 
 		emit frameChangedActive(m_id);
@@ -385,6 +425,7 @@ void Frame::dropEvent(QDropEvent *e)
 		m_actCopy	->setEnabled(true);
 		m_actPaste	->setEnabled(true);
 		m_actClose	->setEnabled(true);
+		updateUndoActions();
 
 		e		->acceptProposedAction();
 	}
@@ -397,12 +438,107 @@ void Frame::dropEvent(QDropEvent *e)
 // clear image and reset title bar to default
 void Frame::clear()
 {
+	m_history	.record(m_img, m_imgName, QImage());
 	m_title		= tr("Untitled @ 0% 0x0");
 	updateTitleBar	(m_title);
 	m_isOccupied	= false;
 	m_img		= QImage();
 	m_imgName	= QString();
+	accountImage	();
 	m_imgWid	->clear();
+	updateUndoActions();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Undo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief restore the image before the last edit
+// restore the image before the last edit
+void Frame::undo()
+{
+	QImage img		= m_img;
+	QString name	= m_imgName;
+	if (m_history.undo(img, name))
+		restore(img, name);
+	updateUndoActions();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Redo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief restore the image the last undo took back
+// restore the image the last undo took back
+void Frame::redo()
+{
+	QImage img		= m_img;
+	QString name	= m_imgName;
+	if (m_history.redo(img, name))
+		restore(img, name);
+	updateUndoActions();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Can undo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief is there an edit to undo
+//! \return	whether undo() would change the image
+bool Frame::canUndo() const
+{
+	return m_history.canUndo();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Can redo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief is there an edit to redo
+//! \return	whether redo() would change the image
+bool Frame::canRedo() const
+{
+	return m_history.canRedo();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Restore
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief display a restored image without recording it
+//! \details the frame becomes active so the navigator and info tab follow the restored image
+//! \param[in] img	restored image; null for an empty frame
+//! \param[in] name	restored image name
+// the frame becomes active so the navigator and info tab follow the restored image
+void Frame::restore(QImage img, QString name)
+{
+	m_img		= img;
+	m_imgName	= name;
+	m_isOccupied	= !m_img.isNull();
+	accountImage	();
+
+	if (m_isOccupied)
+	{
+		updateTitleBar	(tr("%1 @ 100% %2x%3").arg(name).arg(img.width()).arg(img.height()));
+		m_imgWid	->storeImage(name, m_img);
+	}
+	else
+	{
+		updateTitleBar	(tr("Untitled @ 0% 0x0"));
+		m_imgWid	->clear();
+	}
+
+	m_actCut	->setEnabled(true);
+	m_actCopy	->setEnabled(true);
+	m_actPaste	->setEnabled(true);
+	m_actClose	->setEnabled(true);
+
+	emit frameChangedActive(m_id);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Undo actions
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief enable undo and redo to match the history
+void Frame::updateUndoActions()
+{
+	m_actUndo	->setEnabled(m_history.canUndo());
+	m_actRedo	->setEnabled(m_history.canRedo());
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -457,6 +593,21 @@ Vertex* Frame::getVertex(bool &success)
 	return vertices;
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Return clip
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief return image, image name and title
+//! \details the pixels are shared with the frame, not copied
+// the pixels are shared with the frame, not copied
+ImageClip Frame::clip()
+{
+	ImageClip clip;
+	clip.img		= m_img;
+	clip.name		= m_imgName;
+	clip.title		= m_title;
+	return clip;
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Apply transformation matrix
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -472,11 +623,14 @@ void Frame::applyTransform(double *mat, Vertex *p, Vertex *q)
 	m_isOccupied	= true;
 	m_imgName		= tr("Untitled");
 	m_img			= QImage();
+	m_history		.clear();
+	accountImage	();
 
 	m_actCut		->setEnabled(false);
 	m_actCopy		->setEnabled(false);
 	m_actPaste		->setEnabled(false);
 	m_actClose		->setEnabled(true);
+	updateUndoActions();
 
 	m_imgWid		->transformation(mat, p, q);
 }
@@ -493,11 +647,14 @@ void Frame::drawTransCloud(Vertex *p, Vertex *q)
 	m_isOccupied	= true;
 	m_imgName		= tr("Untitled");
 	m_img			= QImage();
+	m_history		.clear();
+	accountImage	();
 
 	m_actCut		->setEnabled(false);
 	m_actCopy		->setEnabled(false);
 	m_actPaste		->setEnabled(false);
 	m_actClose		->setEnabled(true);
+	updateUndoActions();
 
 	m_imgWid		->drawCloud(p, q);
 }
@@ -512,16 +669,22 @@ void Frame::createActions()
 	m_actCopy	= new QAction(QIcon(":/images/edit_copy.xpm"), tr("Copy"), this);
 	m_actPaste	= new QAction(QIcon(":/images/edit_paste.xpm"), tr("Paste"), this);
 	m_actClose	= new QAction(QIcon(":/images/file_close.xpm"), tr("Close"), this);
+	m_actUndo	= new QAction(tr("Undo"), this);
+	m_actRedo	= new QAction(tr("Redo"), this);
 
 	m_actCut	->setEnabled(true);
 	m_actCopy	->setEnabled(true);
 	m_actPaste	->setEnabled(true);
 	m_actClose	->setEnabled(true);
+	m_actUndo	->setEnabled(false);
+	m_actRedo	->setEnabled(false);
 
 	connect(m_actCut,	SIGNAL(triggered()), 		this, SLOT(cut()));
 	connect(m_actCopy,	SIGNAL(triggered()), 		this, SLOT(copy()));
 	connect(m_actPaste,	SIGNAL(triggered()), 		this, SLOT(paste()));
 	connect(m_actClose,	SIGNAL(triggered()), 		this, SLOT(close()));
+	connect(m_actUndo,	SIGNAL(triggered()), 		this, SLOT(undo()));
+	connect(m_actRedo,	SIGNAL(triggered()), 		this, SLOT(redo()));
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -534,7 +697,46 @@ void Frame::createMenu()
 	m_popUpMenu	->addAction(m_actCut);
 	m_popUpMenu	->addAction(m_actCopy);
 	m_popUpMenu	->addAction(m_actPaste);
+	m_pasteMenu	= m_popUpMenu->addMenu(tr("Paste From"));
 	m_popUpMenu	->addAction(m_actClose);
+	m_popUpMenu	->addSeparator();
+	m_popUpMenu	->addAction(m_actUndo);
+	m_popUpMenu	->addAction(m_actRedo);
+
+	m_pasteMenu	->setEnabled(false);
+	connect(m_pasteMenu, SIGNAL(triggered(QAction*)),	this, SLOT(pasteFrom(QAction*)));
+	connect(m_actPaste,	SIGNAL(changed()),				this, SLOT(updatePastePicker()));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set clips
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief list the clipboard entries in the paste picker
+//! \details called by LayoutWindow whenever the clipboard changes
+//! \param[in] labels	label of every entry, newest first
+// called by LayoutWindow whenever the clipboard changes
+void Frame::setClips(const QStringList &labels)
+{
+	m_pasteMenu	->clear();
+	for (int i = 0; i < labels.size(); i++)
+	{
+		QAction *act	= m_pasteMenu->addAction(tr("&%1 %2").arg(i + 1).arg(labels[i]));
+		act		->setData(i);
+	}
+	updatePastePicker();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Update paste picker
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief enable the paste picker
+//! \details it follows the paste action, which is disabled while the frame shows a depth image or a point
+//!	cloud, so an entry cannot be pasted where Paste is not allowed. Called when the clipboard or the
+//!	paste action changes
+// it follows the paste action, so an entry cannot be pasted where Paste is not allowed
+void Frame::updatePastePicker()
+{
+	m_pasteMenu	->setEnabled(!m_pasteMenu->actions().isEmpty() && m_actPaste->isEnabled());
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -575,6 +777,16 @@ void Frame::paste()
 	emit imgPaste(m_id);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Paste from
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief paste the clipboard entry picked in the paste picker
+//! \param[in] act	picked action; its data is the entry, 0 being the newest
+void Frame::pasteFrom(QAction *act)
+{
+	emit imgPasteFrom(m_id, act->data().toInt());
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Close
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
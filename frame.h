@@ -18,6 +18,8 @@
 
 #include			<QtGui>
 #include			"OpenGLWidget.h"
+#include			"undostack.h"
+#include			"imagemime.h"
 
 // Frame class
 class Frame: public QWidget
@@ -27,6 +29,8 @@ class Frame: public QWidget
 	public:
 	//! \brief Constructor
 					Frame				(int id = -1, QWidget * parent = 0);
+	//! \brief Destructor
+					~Frame				();
 	//! \brief set frame to be default
 	void			setDefaultFrame		();
 	//! \brief set frame to be active
@@ -49,6 +53,10 @@ class Frame: public QWidget
 	void			createMenu			();
 	//! \brief clear image and reset title bar to default
 	void			clear				();
+	//! \brief is there an edit to undo
+	bool			canUndo				() const;
+	//! \brief is there an edit to redo
+	bool			canRedo				() const;
 	//! \brief frame is active or not
 	bool			isActive			();
 	//! \brief frame is next or not
@@ -61,12 +69,18 @@ class Frame: public QWidget
 	QString			name				();
 	//! \brief return title of the frame
 	QString			title				();
+	//! \brief return image, image name and title; the pixels are shared
+	ImageClip		clip				();
 	//! \brief retrieve vertex
 	Vertex*			getVertex			(bool&);
 	//! \brief apply transformation matrix
 	void			applyTransform		(double*, Vertex*, Vertex*);
 	//! \brief render the transformed cloud
 	void			drawTransCloud		(Vertex*, Vertex*);
+	//! \brief draw line segments (image coordinates) over the image
+	void			setOverlay			(QVector<QLineF>);
+	//! \brief list the clipboard entries in the paste picker, newest first
+	void			setClips			(const QStringList&);
 
 protected:
 	//! \brief filter event
@@ -85,6 +99,14 @@ signals:
 	void			imgCopy				(int id);
 	//! \brief paste image to this frame
 	void			imgPaste			(int id);
+	//! \brief paste the image of a clipboard entry to this frame
+	void			imgPasteFrom		(int id, int slot);
+
+public slots:
+	//! \brief restore the image before the last edit
+	void			undo				();
+	//! \brief restore the image the last undo took back
+	void			redo				();
 
 private slots:
 	//! \brief cut this frame image
@@ -93,6 +115,10 @@ private slots:
 	void			copy				();
 	//! \brief paste image into this frame
 	void			paste				();
+	//! \brief paste the clipboard entry picked in the paste picker
+	void			pasteFrom			(QAction*);
+	//! \brief the paste picker is enabled when there are entries and pasting is allowed
+	void			updatePastePicker	();
 	//! \brief close image in this frame
 	void			close				();
 	//! \brief initialize drag
@@ -101,6 +127,13 @@ private slots:
 	void			setZoom			(float);
 
 private:
+	//! \brief display a restored image without recording it
+	void			restore				(QImage, QString);
+	//! \brief enable undo and redo to match the history
+	void			updateUndoActions	();
+	//! \brief report the image of the frame to the memory ledger
+	void			accountImage		();
+
 	QVBoxLayout		*m_lay;				// Frame layout manager.
 	QLabel			*m_barTitle;		// Frame title bar.
 	QString			m_title;			// String that holds the frame title.
@@ -109,15 +142,19 @@ private:
 	OpenGLWidget	*m_imgWid;			// Display image.
 	QImage			m_img;				// Current image.
 	int				m_id;				// Frame id.
+	UndoStack		m_history;			// Undo/redo history of m_img.
 
 	bool			m_isActive;			// Active state of frame.
 	bool			m_isNext;			// Next state of frame.
 	bool			m_isOccupied;		// Whether this frame is holding an image or not.
 
 	QMenu			*m_popUpMenu;		// Pop up menu on top left corner.
+	QMenu			*m_pasteMenu;		// Picker of the clipboard entries.
 	QAction			*m_actCut;			// Cut
 	QAction			*m_actCopy;			// Copy
 	QAction			*m_actPaste;		// Paste
 	QAction			*m_actClose;		// Close image
+	QAction			*m_actUndo;			// Undo last edit
+	QAction			*m_actRedo;			// Redo last undo
 };
 #endif
@@ -14,66 +14,325 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 #include 	"historyManager.h"
+#include	"imagestore.h"
+#include	"imagehash.h"
+#include	<QSet>
+#include	<QPair>
+#include	<QStringList>
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// Finds the image in the linked list and returns an iterator
+// Constructor
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief Finds the image in the linked list and returns an iterator
-//! \details Returns an iterator for an image being searched for
-//! \param[in] *id
-//! \return Returns an iterator for an image being searched for
-// Returns an iterator for an image being searched for
-QLinkedList<imageInfo*>::iterator historyManager::findImage(QImage* id)
+//! \brief Constructor
+historyManager::historyManager()
 {
-	QLinkedList<imageInfo*>::iterator i,j;
+	m_nextId	= 1;
+	m_count		= 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Destructor
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+//! \details Deletes every record still in the table
+// Deletes every record still in the table
+historyManager::~historyManager()
+{
+	for (int i = 0; i < m_nodes.size(); i++)
+		delete m_nodes[i].info;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Finds a record by its id
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Finds the record with the given history id
+//! \param[in] id	history id returned by addImageHistory
+//! \return Returns the record; 0 if there is none
+// Finds the record with the given history id
+imageInfo* historyManager::find(int id)
+{
+	QHash<int, int>::const_iterator i = m_byId.constFind(id);
+	return i == m_byId.constEnd() ? 0 : m_nodes[*i].info;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Finds the record of an image in the store
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Finds the most recent record of a stored image
+//! \details Handles are stable for the life of the image, unlike pointers to QImage copies
+//! \param[in] handle	store handle of the image
+//! \return Returns the record; 0 if there is none
+// Handles are stable for the life of the image, unlike pointers to QImage copies
+imageInfo* historyManager::findImage(ImageHandle handle)
+{
+	QHash<ImageHandle, int>::const_iterator i = m_byHandle.constFind(handle);
+	return i == m_byHandle.constEnd() ? 0 : m_nodes[*i].info;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Finds the record of an image by its data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Finds the record of the image data with the given cache key
+//! \details Frames hand out shallow copies of their image, which keep the cache key of the original
+//! \param[in] cacheKey	QImage::cacheKey() of the image
+//! \return Returns the most recent record with that key; 0 if there is none
+// Frames hand out shallow copies of their image, which keep the cache key of the original
+imageInfo* historyManager::findInfo(qint64 cacheKey)
+{
+	QHash<qint64, int>::const_iterator i = m_byCacheKey.constFind(cacheKey);
+	return i == m_byCacheKey.constEnd() ? 0 : m_nodes[*i].info;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Finds the record of an image by its data or its content
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Finds the record of an image
+//! \details The cache key is tried first; an image rebuilt by undo or read back from the disk cache
+//! has a new cache key but the same content, so the content hash finds its record in the image store
+//! \param[in] img	the image
+//! \return Returns the most recent record of the image; 0 if there is none
+// The cache key is tried first; an image rebuilt by undo or read back from the disk cache
+imageInfo* historyManager::findInfo(const QImage& img)
+{
+	if (img.isNull())
+		return 0;
+
+	imageInfo *info		= findInfo(img.cacheKey());
+	if (info)
+		return info;
+
+	ImageHandle handle	= ImageStore::instance()->find(ImageHasher::compute(img));
+	return handle ? findImage(handle) : 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot of a record
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Slot of the record with the given id
+//! \param[in] id	history id
+//! \return Returns the slot in the node table; -1 if there is none
+// Returns the slot in the node table; -1 if there is none
+int historyManager::slotOf(int id)
+{
+	return m_byId.value(id, -1);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Summary of one image
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief One line describing how the image was made
+//! \details The line names the image, the operation and every parent; it does not expand the parents,
+//! so it is built once and kept in the node. Records are never removed, so every parent it names is in the
+//! table; replacing the image of a parent clears the lines that name it
+//! \param[in] id	history id of the image
+//! \return Returns the summary; empty if there is no such record
+// The line names the image, the operation and every parent; it does not expand the parents,
+QString historyManager::summary(int id)
+{
+	int slot				= slotOf(id);
+	if (slot < 0)
+		return QString();
+
+	HistoryNode &node		= m_nodes[slot];
+	if (!node.summary.isEmpty())
+		return node.summary;
 
-	for (i = m_listImagesHistory.begin(); i != m_listImagesHistory.end(); ++i)
-	if((**i).getImagePointer() == id)
+	imageInfo *info			= node.info;
+	QString line			= QString("#%1 %2").arg(id).arg(info->getImageName());
+	if (node.parents.isEmpty())
 	{
-			j = i;
-			i = m_listImagesHistory.end();
+		if (info->getOperation() == "New File")
+			line			+= QString(" <- %1").arg(info->getimagePath());
+		else
+			line			+= QString(" <- %1").arg(info->getOperation());
 	}
-	return j;
+	else
+	{
+		QStringList names;
+		for (int i = 0; i < node.parents.size(); i++)
+			names			<< QString("#%1 %2").arg(node.parents[i]).arg(find(node.parents[i])->getImageName());
+		line				+= QString(" <- %1 (%2)").arg(info->getOperation()).arg(names.join(", "));
+	}
+
+	node.summary			= line;
+	return line;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Returns a string with description of image derivation
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Returns a string with description of image derivation
-//! \details Traverses the list from a given image to the beginning and creates a derivation of the image
-//! \param[in] i
-//! \return Returns a string with description of image derivation
-// Traverses the list from a given image to the beginning and creates a derivation of the image
-QString historyManager::prepareHistory(QLinkedList<imageInfo*>::iterator i)
+//! \details Walks the ancestors of the image depth first without recursion and lists the summary of each
+//! one once, after all of its parents; an ancestor shared by several paths is not expanded again,
+//! so the cost is linear in the number of ancestors
+//! \param[in] id	history id of the image
+//! \return Returns one summary line per ancestor, sources first and the image last
+// Walks the ancestors of the image depth first without recursion and lists the summary of each
+QString historyManager::prepareHistory(int id)
+{
+	QStringList lines;
+	if (slotOf(id) < 0)
+		return QString();
+
+	QSet<int> visited;
+	QVector< QPair<int, int> > stack;	// (id, next parent to visit)
+	stack					.append(qMakePair(id, 0));
+	visited					.insert(id);
+
+	while (!stack.isEmpty())
+	{
+		QPair<int, int> &top	= stack.last();
+		const QVector<int> &parents	= m_nodes[slotOf(top.first)].parents;
+
+		if (top.second < parents.size())
+		{
+			int parent		= parents[top.second++];
+			if (!visited.contains(parent) && slotOf(parent) >= 0)
+			{
+				visited		.insert(parent);
+				stack		.append(qMakePair(parent, 0));
+			}
+		}
+		else
+		{	// every parent is listed; list the node itself
+			lines			<< summary(top.first);
+			stack			.pop_back();
+		}
+	}
+
+	return lines.join("\n");
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Parents of an image
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief History ids of the images an image was made from
+//! \param[in] id	history id of the image
+//! \return Returns the parent ids in operand order; empty for a source image
+// Returns the parent ids in operand order; empty for a source image
+QVector<int> historyManager::parents(int id)
+{
+	int slot				= slotOf(id);
+	return slot < 0 ? QVector<int>() : m_nodes[slot].parents;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Children of an image
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief History ids of the images made from an image
+//! \param[in] id	history id of the image
+//! \return Returns the child ids in the order they were made
+// Returns the child ids in the order they were made
+QVector<int> historyManager::children(int id)
 {
-	m_historyReport.append((**i).getImageName());
-	m_historyReport.append(" ");
+	int slot				= slotOf(id);
+	return slot < 0 ? QVector<int>() : m_nodes[slot].children;
+}
 
-	if((**i).getParents().isEmpty())
-			return m_historyReport;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Adds new imageInfo object to the table
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Adds new imageInfo object to the table
+//! \details The record is appended to the table, gets a new id and is indexed
+//! by id, store handle and cache key; set the handle before adding the record. The parents of
+//! the record must already be in the table; they become the edges of the derivation graph
+//! \param[in] *newImageHistory	the record; the manager owns it from now on
+//! \return Returns the history id of the record
+// The record is appended to the table, gets a new id and is indexed
+int historyManager::addImageHistory (imageInfo* newImageHistory)
+{
+	int slot					= m_nodes.size();
+	m_nodes						.resize(slot + 1);
 
-	m_historyReport.append((**i).getOperation());
-	m_historyReport.append(" ");
-	m_historyReport.append("(");
+	HistoryNode &node			= m_nodes[slot];
+	node.info					= newImageHistory;
+	node.parents				.clear();
+	node.children				.clear();
+	node.summary				.clear();
 
-	for(QLinkedList<imageInfo*>::iterator j = (**i).getParents().begin(); j!=(**i).getParents().end(); j++)
+	int id						= m_nextId++;
+	QLinkedList<imageInfo*> sources	= newImageHistory->getParents();
+	for (QLinkedList<imageInfo*>::iterator j = sources.begin(); j != sources.end(); j++)
 	{
-			m_historyReport.append(prepareHistory(j));
+		int parentSlot			= slotOf((*j)->getId());
+		if (parentSlot < 0)
+			continue;			// not in the history; nothing to link
+		node.parents			.append((*j)->getId());
+		m_nodes[parentSlot].children.append(id);
 	}
 
-	m_historyReport.append(")");
+	newImageHistory				->setId(id);
+	m_byId.insert				(id, slot);
+	if (newImageHistory->getHandle())
+		m_byHandle.insert		(newImageHistory->getHandle(), slot);
+	if (newImageHistory->getCacheKey())			// records loaded from a project have no image data yet
+		m_byCacheKey.insert		(newImageHistory->getCacheKey(), slot);
+	m_count++;
+
+	return id;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Replaces the image of a record
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Points a record at a recomputed image
+//! \details The record keeps its id and its edges; the handle and cache key indexes move to the new image
+//! and the image data shown on the information tab is measured again. The summaries of the record
+//! and its children are rebuilt on demand, since the operation may have new parameters
+//! \param[in] id		history id of the record
+//! \param[in] handle	store handle of the new image
+//! \param[in] img		the new image
+// The record keeps its id and its edges; the handle and cache key indexes move to the new image
+void historyManager::replaceImage(int id, ImageHandle handle, QImage& img)
+{
+	int slot					= slotOf(id);
+	if (slot < 0)
+		return;
 
-	return m_historyReport;
+	HistoryNode &node			= m_nodes[slot];
+	imageInfo *info				= node.info;
+	if (m_byHandle.value(info->getHandle(), -1) == slot)
+		m_byHandle.remove		(info->getHandle());
+	if (m_byCacheKey.value(info->getCacheKey(), -1) == slot)
+		m_byCacheKey.remove		(info->getCacheKey());
+
+	info						->setHandle(handle);
+	info						->initializeImageInfoData(&img);
+	if (handle)
+		m_byHandle.insert		(handle, slot);
+	m_byCacheKey.insert			(info->getCacheKey(), slot);
+
+	node.summary				.clear();
+	for (int i = 0; i < node.children.size(); i++)
+	{
+		int childSlot			= slotOf(node.children[i]);
+		if (childSlot >= 0)
+			m_nodes[childSlot].summary.clear();
+	}
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Number of records
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Number of records
+//! \return Returns the number of records in the table
+// Returns the number of records in the table
+int historyManager::count()
+{
+	return m_count;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// Adds new imageInfo object to the list
+// Ids of all records
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief Adds new imageInfo object to the list
-//! \details Adds the imageHistory object to the list of all imageHistory in the thumbnail bar
-//! \param[in] *newImageHistory
-// Adds the imageHistory object to the list of all imageHistory in the thumbnail bar
-void historyManager::addImageHistory (imageInfo* newImageHistory)
+//! \brief History ids of all records
+//! \return Returns the ids in ascending order; a source always comes before what was made from it
+// Returns the ids in ascending order; a source always comes before what was made from it
+QVector<int> historyManager::ids()
 {
-	m_listImagesHistory.append(newImageHistory);
+	QVector<int> result;
+	result						.reserve(m_count);
+	for (int i = 0; i < m_nodes.size(); i++)	// slots are in order of addition, so ids ascend
+		result					.append(m_nodes[i].info->getId());
+	return result;
 }
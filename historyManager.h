@@ -17,22 +17,61 @@
 #define 	HISTORYMANAGER_H
 
 #include 	"imageInfo.h"
-#include	<QLinkedList>
+#include	<QVector>
+#include	<QHash>
 #include	<QString>
+#include	<QtAlgorithms>
 
 class historyManager
 {
 public:
-	//! \brief Traverses the list from a given image to the beginning and creates a derivation of the image
-	QString prepareHistory(QLinkedList<imageInfo*>::iterator i);
-	//! \brief Finds the image in the linked list and returns an iterator.
-	QLinkedList<imageInfo*>::iterator findImage(QImage* id);
-	//! \brief Adds the imageHistory object to the list of all imageHistory in the thumbnail bar
-	void addImageHistory(imageInfo* newImageHistory);
+	//! \brief Constructor
+	historyManager();
+	//! \brief Destructor; deletes all records
+	~historyManager();
+	//! \brief Derivation of an image: one summary line per ancestor, each once, sources first
+	QString prepareHistory(int id);
+	//! \brief One line describing how the image was made; built once and kept
+	QString summary(int id);
+	//! \brief History ids of the images an image was made from
+	QVector<int> parents(int id);
+	//! \brief History ids of the images made from an image
+	QVector<int> children(int id);
+	//! \brief Finds the record with the given history id; 0 if there is none
+	imageInfo* find(int id);
+	//! \brief Finds the most recent record of the image with the given store handle; 0 if there is none
+	imageInfo* findImage(ImageHandle handle);
+	//! \brief Finds the record of the image data with the given cache key; 0 if there is none
+	imageInfo* findInfo(qint64 cacheKey);
+	//! \brief Finds the record of an image, by its cache key or else by its content; 0 if there is none
+	imageInfo* findInfo(const QImage& img);
+	//! \brief Adds the imageHistory object to the history; the manager owns it and returns its id
+	int addImageHistory(imageInfo* newImageHistory);
+	//! \brief Points a record at a recomputed image and reindexes it
+	void replaceImage(int id, ImageHandle handle, QImage& img);
+	//! \brief Number of records
+	int count();
+	//! \brief History ids of all records, oldest first
+	QVector<int> ids();
 
 private:
-	QLinkedList<imageInfo*>		m_listImagesHistory;		// All images in the thumbnail bar
-	QString				m_historyReport;					// Image derivation
+	//! \brief one slot of the record table; a node of the derivation graph
+	struct HistoryNode
+	{
+		imageInfo*	info;				// the record
+		QVector<int>	parents;		// ids of the source images, in operand order
+		QVector<int>	children;		// ids of the images made from this one
+		QString		summary;			// memoized summary line; empty until asked for
+	};
 
+	//! \brief slot of the record with the given id; -1 if there is none
+	int			slotOf(int id);
+
+	QVector<HistoryNode>	m_nodes;			// contiguous record table, in order of addition
+	int						m_nextId;			// next history id
+	int						m_count;			// records in the table
+	QHash<int, int>			m_byId;				// history id -> slot
+	QHash<ImageHandle, int>	m_byHandle;			// store handle -> slot of its most recent record
+	QHash<qint64, int>		m_byCacheKey;		// QImage::cacheKey() -> slot of its most recent record
 };
 #endif
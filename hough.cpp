@@ -0,0 +1,509 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Hough
+//! \brief Hough transform implementation
+//!
+//! \file hough.cpp
+//! \brief Hough transform implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cmath>
+#include			<QtAlgorithms>
+
+#include			"hough.h"
+#include			"parallel.h"
+
+static const double	HOUGH_PI		= 3.14159265358979323846;
+static const int	THETA_BINS		= 180;		// one degree per bin
+static const int	THETA_SPREAD	= 3;		// votes on each side of the gradient direction
+static const int	CENTER_CELL		= 2;		// circle centers are voted in 2x2 pixel cells
+
+// edge pixel with its unit gradient
+struct EdgePoint
+{
+	int				x;
+	int				y;
+	float			nx;
+	float			ny;
+};
+
+// state shared by the worker threads; every band of rows has its own edge list and accumulator
+struct HoughContext
+{
+	QVector<float>			gray;		// gray level of every pixel
+	int						width;
+	int						height;
+	int						level;		// sobel magnitude threshold
+	int						bands;		// number of row bands (one per thread)
+
+	QVector< QVector<EdgePoint> >	edges;	// edge pixels of every band
+	QVector< QVector<int> >			acc;	// accumulator of every band; merged into acc[0]
+	int						accSize;	// bins per accumulator
+
+	// lines
+	float					cosT[THETA_BINS];
+	float					sinT[THETA_BINS];
+	int						diag;		// rho offset
+	int						nRho;		// rho bins
+
+	// circles
+	int						minR;
+	int						maxR;
+	int						aw;			// center accumulator width (cells)
+	int						ah;			// center accumulator height (cells)
+	QVector<HoughCircle>	candidates;	// circle candidates; radius filled in by fitRadius
+};
+
+// sobel gradient of the rows of bands [begin, end); keeps the pixels above the level
+static void findEdges(void *p, int begin, int end)
+{
+	HoughContext *c		= (HoughContext*)p;
+	int w				= c->width;
+	int h				= c->height;
+
+	for (int b = begin; b < end; b++)
+	{
+		QVector<EdgePoint> &list	= c->edges[b];
+		int y0			= qMax(1, b * h / c->bands);
+		int y1			= qMin(h - 1, (b + 1) * h / c->bands);
+
+		for (int y = y0; y < y1; y++)
+		{
+			const float *r1	= c->gray.data() + (y - 1) * w;
+			const float *r2	= r1 + w;
+			const float *r3	= r2 + w;
+
+			for (int x = 1; x < w - 1; x++)
+			{	// same masks as IP::sobelMask
+				float gx	= (r1[x-1] - r1[x+1]) + 2.0f * (r2[x-1] - r2[x+1]) + (r3[x-1] - r3[x+1]);
+				float gy	= (r1[x-1] + 2.0f * r1[x] + r1[x+1]) - (r3[x-1] + 2.0f * r3[x] + r3[x+1]);
+				float mag	= sqrt(gx * gx + gy * gy);
+
+				if (mag > c->level)
+				{
+					EdgePoint e;
+					e.x		= x;
+					e.y		= y;
+					e.nx	= gx / mag;			// both masks point against the gradient; only the direction matters
+					e.ny	= gy / mag;
+					list.append(e);
+				}
+			}
+		}
+	}
+}
+
+// line votes of bands [begin, end); every edge pixel only votes near its gradient direction
+static void voteLines(void *p, int begin, int end)
+{
+	HoughContext *c		= (HoughContext*)p;
+
+	for (int b = begin; b < end; b++)
+	{
+		QVector<int> &acc				= c->acc[b];
+		const QVector<EdgePoint> &list	= c->edges[b];
+		acc.fill	(0, c->accSize);
+
+		for (int i = 0; i < list.size(); i++)
+		{
+			const EdgePoint &e	= list[i];
+
+			// the line normal is the gradient; fold it to 0 - pi
+			double phi	= atan2((double)e.ny, (double)e.nx);
+			if (phi < 0.0)
+				phi		+= HOUGH_PI;
+			int t0		= (int)(phi / HOUGH_PI * THETA_BINS + 0.5);
+
+			for (int dt = -THETA_SPREAD; dt <= THETA_SPREAD; dt++)
+			{
+				int t	= (t0 + dt + THETA_BINS) % THETA_BINS;
+				float rho	= e.x * c->cosT[t] + e.y * c->sinT[t];
+				int r	= (int)floor(rho + 0.5f) + c->diag;
+				acc[t * c->nRho + r]++;
+			}
+		}
+	}
+}
+
+// center votes of bands [begin, end); every edge pixel votes along its gradient on both sides
+static void voteCenters(void *p, int begin, int end)
+{
+	HoughContext *c		= (HoughContext*)p;
+
+	for (int b = begin; b < end; b++)
+	{
+		QVector<int> &acc				= c->acc[b];
+		const QVector<EdgePoint> &list	= c->edges[b];
+		acc.fill	(0, c->accSize);
+
+		for (int i = 0; i < list.size(); i++)
+		{
+			const EdgePoint &e	= list[i];
+
+			for (int r = c->minR; r <= c->maxR; r++)
+			{
+				for (int s = -1; s <= 1; s += 2)
+				{
+					int cx	= (int)(e.x + s * r * e.nx + 0.5f);
+					int cy	= (int)(e.y + s * r * e.ny + 0.5f);
+					if (cx < 0 || cy < 0 || cx >= c->width || cy >= c->height)
+						continue;
+					acc[(cy / CENTER_CELL) * c->aw + cx / CENTER_CELL]++;
+				}
+			}
+		}
+	}
+}
+
+// sum the band accumulators into acc[0] for bins [begin, end)
+static void mergeAcc(void *p, int begin, int end)
+{
+	HoughContext *c		= (HoughContext*)p;
+	int *dst			= c->acc[0].data();
+
+	for (int b = 1; b < c->bands; b++)
+	{
+		const int *src	= c->acc[b].data();
+		for (int i = begin; i < end; i++)
+			dst[i]		+= src[i];
+	}
+}
+
+// find the radius of candidates [begin, end) from the distance histogram of the edge pixels
+static void fitRadius(void *p, int begin, int end)
+{
+	HoughContext *c		= (HoughContext*)p;
+	QVector<int> hist(c->maxR + 2);
+
+	for (int k = begin; k < end; k++)
+	{
+		HoughCircle &cand	= c->candidates[k];
+		hist.fill		(0);
+
+		for (int b = 0; b < c->bands; b++)
+		{
+			const QVector<EdgePoint> &list	= c->edges[b];
+			for (int i = 0; i < list.size(); i++)
+			{
+				const EdgePoint &e	= list[i];
+				double dx	= e.x - cand.cx;
+				double dy	= e.y - cand.cy;
+				double d	= sqrt(dx * dx + dy * dy);
+				if (d < c->minR - 0.5 || d > c->maxR + 0.5)
+					continue;
+
+				// the gradient of a circle edge points through the center
+				if (fabs(dx * e.nx + dy * e.ny) < 0.9 * d)
+					continue;
+				hist[(int)(d + 0.5)]++;
+			}
+		}
+
+		// best radius by coverage of its circumference
+		double best		= 0.0;
+		cand.votes		= 0;
+		for (int r = qMax(c->minR, 1); r <= c->maxR; r++)
+		{
+			int votes	= hist[r - 1] + hist[r] + hist[r + 1];
+			double cov	= votes / (2.0 * HOUGH_PI * r);
+			if (cov > best)
+			{
+				best		= cov;
+				cand.r		= r;
+				cand.votes	= votes;
+			}
+		}
+		if (best < 0.35)
+			cand.votes	= 0;		// rejected
+	}
+}
+
+// sort helpers; strongest first
+static bool lineGreater(const HoughLine &a, const HoughLine &b)
+{
+	return a.votes > b.votes;
+}
+
+static bool circleGreater(const HoughCircle &a, const HoughCircle &b)
+{
+	return a.votes > b.votes;
+}
+
+// gray plane, edge lists and band layout common to both transforms
+static void prepare(HoughContext &c, const QImage &img, int level)
+{
+	c.width				= img.width();
+	c.height			= img.height();
+	c.level				= level;
+	c.bands				= qMin(Parallel::numThreads(), qMax(1, c.height));
+
+	c.gray.resize		(c.width * c.height);
+	for (int y = 0; y < c.height; y++)
+	{
+		const unsigned char *pixData	= img.scanLine(y);
+		float *row						= c.gray.data() + y * c.width;
+		for (int x = 0; x < c.width; x++, pixData += 4)
+			row[x]		= (float)(0.3 * pixData[2] + 0.59 * pixData[1] + 0.11 * pixData[0]);
+	}
+
+	c.edges.resize		(c.bands);
+	c.acc.resize		(c.bands);
+	Parallel::forRange	(c.bands, findEdges, &c, 1);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Lines
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief detect lines
+//! \details edge pixels are those that IP::sobelMask would keep at the same level. Each one votes only for
+//!	the few angles around its gradient direction, into an accumulator of its own thread; the accumulators
+//!	are summed and the peaks are kept by non-maximum suppression
+//! \param[in] img		source image (original or edge map)
+//! \param[in] level	sobel magnitude threshold
+//! \param[in] minVotes	minimum accumulator value of a line
+//! \param[in] maxLines	maximum number of lines returned
+//! \param[out] result	lines, strongest first
+// each edge pixel votes only for the few angles around its gradient direction
+void Hough::lines(const QImage &img, int level, int minVotes, int maxLines, QVector<HoughLine> &result)
+{
+	result.clear		();
+	if (img.width() < 3 || img.height() < 3)
+		return;
+
+	HoughContext c;
+	prepare				(c, img, level);
+
+	for (int t = 0; t < THETA_BINS; t++)
+	{
+		c.cosT[t]		= (float)cos(t * HOUGH_PI / THETA_BINS);
+		c.sinT[t]		= (float)sin(t * HOUGH_PI / THETA_BINS);
+	}
+	c.diag				= (int)ceil(sqrt((double)c.width * c.width + (double)c.height * c.height)) + 1;
+	c.nRho				= 2 * c.diag + 1;
+	c.accSize			= THETA_BINS * c.nRho;
+
+	Parallel::forRange	(c.bands, voteLines, &c, 1);
+	Parallel::forRange	(c.accSize, mergeAcc, &c, 4096);
+
+	// 3x3 non-maximum suppression; theta wraps around with rho mirrored
+	QVector<HoughLine> peaks;
+	const int *acc		= c.acc[0].data();
+	for (int t = 0; t < THETA_BINS; t++)
+	{
+		for (int r = 1; r < c.nRho - 1; r++)
+		{
+			int v		= acc[t * c.nRho + r];
+			if (v < minVotes || v < 1)
+				continue;
+
+			bool peak	= true;
+			for (int dt = -1; dt <= 1 && peak; dt++)
+			{
+				int tt		= t + dt;
+				bool wrap	= tt < 0 || tt >= THETA_BINS;
+				tt			= (tt + THETA_BINS) % THETA_BINS;
+
+				for (int dr = -1; dr <= 1 && peak; dr++)
+				{
+					if (dt == 0 && dr == 0)
+						continue;
+					int rr	= wrap ? c.nRho - 1 - (r + dr) : r + dr;
+					int n	= acc[tt * c.nRho + rr];
+					// ties go to the first bin in scan order
+					if (n > v || (n == v && (dt < 0 || (dt == 0 && dr < 0))))
+						peak	= false;
+				}
+			}
+			if (!peak)
+				continue;
+
+			HoughLine line;
+			line.rho	= r - c.diag;
+			line.theta	= t * HOUGH_PI / THETA_BINS;
+			line.votes	= v;
+			peaks.append(line);
+		}
+	}
+
+	qSort				(peaks.begin(), peaks.end(), lineGreater);
+
+	// thick edges leave a second peak a few bins away; drop lines that repeat a stronger one
+	for (int i = 0; i < peaks.size() && result.size() < maxLines; i++)
+	{
+		bool repeat	= false;
+		for (int j = 0; j < result.size() && !repeat; j++)
+		{
+			double dt	= fabs(peaks[i].theta - result[j].theta) * THETA_BINS / HOUGH_PI;
+			double dr	= fabs(peaks[i].rho - result[j].rho);
+			if (dt > THETA_BINS / 2)
+			{	// the same line seen across the wrap has its rho mirrored
+				dt		= THETA_BINS - dt;
+				dr		= fabs(peaks[i].rho + result[j].rho);
+			}
+			repeat		= dt <= THETA_SPREAD && dr <= THETA_SPREAD;
+		}
+		if (!repeat)
+			result.append(peaks[i]);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Circles
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief detect circles with a radius in [minRadius, maxRadius]
+//! \details two stage transform: edge pixels vote for centers along their gradient (per thread accumulators),
+//!	center peaks are kept by non-maximum suppression and the radius of each one is read from the histogram
+//!	of edge distances. A circle is kept when at least 35% of its circumference is covered
+//! \param[in] img			source image (original or edge map)
+//! \param[in] level		sobel magnitude threshold
+//! \param[in] minRadius	smallest radius in pixels
+//! \param[in] maxRadius	largest radius in pixels
+//! \param[in] maxCircles	maximum number of circles returned
+//! \param[out] result		circles, strongest first
+// two stage transform: centers first, then the radius of each center
+void Hough::circles(const QImage &img, int level, int minRadius, int maxRadius, int maxCircles, QVector<HoughCircle> &result)
+{
+	result.clear		();
+	if (img.width() < 3 || img.height() < 3)
+		return;
+
+	HoughContext c;
+	prepare				(c, img, level);
+
+	c.minR				= qMax(1, minRadius);
+	c.maxR				= qMax(c.minR, maxRadius);
+	c.aw				= (c.width + CENTER_CELL - 1) / CENTER_CELL;
+	c.ah				= (c.height + CENTER_CELL - 1) / CENTER_CELL;
+	c.accSize			= c.aw * c.ah;
+
+	Parallel::forRange	(c.bands, voteCenters, &c, 1);
+	Parallel::forRange	(c.accSize, mergeAcc, &c, 4096);
+
+	// a full circle of radius r puts about 2*pi*r votes on its center; ask for half of the smallest one
+	int minVotes		= qMax(8, (int)(HOUGH_PI * c.minR));
+	const int *acc		= c.acc[0].data();
+
+	for (int y = 0; y < c.ah; y++)
+	{
+		for (int x = 0; x < c.aw; x++)
+		{
+			int v		= acc[y * c.aw + x];
+			if (v < minVotes)
+				continue;
+
+			// 5x5 non-maximum suppression; ties go to the first cell in scan order
+			bool peak	= true;
+			for (int dy = -2; dy <= 2 && peak; dy++)
+				for (int dx = -2; dx <= 2 && peak; dx++)
+				{
+					int xx	= x + dx;
+					int yy	= y + dy;
+					if ((dx == 0 && dy == 0) || xx < 0 || yy < 0 || xx >= c.aw || yy >= c.ah)
+						continue;
+					int n	= acc[yy * c.aw + xx];
+					if (n > v || (n == v && (dy < 0 || (dy == 0 && dx < 0))))
+						peak	= false;
+				}
+			if (!peak)
+				continue;
+
+			// refine the center with the weighted mean of the 3x3 cells
+			double sx = 0.0, sy = 0.0, sw = 0.0;
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					int xx	= x + dx;
+					int yy	= y + dy;
+					if (xx < 0 || yy < 0 || xx >= c.aw || yy >= c.ah)
+						continue;
+					double n	= acc[yy * c.aw + xx];
+					sx			+= n * (xx * CENTER_CELL + 0.5 * (CENTER_CELL - 1));
+					sy			+= n * (yy * CENTER_CELL + 0.5 * (CENTER_CELL - 1));
+					sw			+= n;
+				}
+
+			HoughCircle cand;
+			cand.cx		= sx / sw;
+			cand.cy		= sy / sw;
+			cand.r		= 0.0;
+			cand.votes	= v;
+			c.candidates.append(cand);
+		}
+	}
+
+	// only the strongest centers are worth a radius search
+	qSort				(c.candidates.begin(), c.candidates.end(), circleGreater);
+	if (c.candidates.size() > 4 * maxCircles)
+		c.candidates.resize(4 * maxCircles);
+
+	Parallel::forRange	(c.candidates.size(), fitRadius, &c, 1);
+	qSort				(c.candidates.begin(), c.candidates.end(), circleGreater);
+
+	// drop circles that repeat a stronger one
+	for (int i = 0; i < c.candidates.size() && result.size() < maxCircles; i++)
+	{
+		const HoughCircle &cand	= c.candidates[i];
+		if (cand.votes == 0)
+			break;
+
+		bool repeat	= false;
+		for (int j = 0; j < result.size() && !repeat; j++)
+		{
+			double tol	= qMax(2.0, 0.2 * result[j].r);
+			double dx	= cand.cx - result[j].cx;
+			double dy	= cand.cy - result[j].cy;
+			repeat		= sqrt(dx * dx + dy * dy) < tol && fabs(cand.r - result[j].r) < tol;
+		}
+		if (!repeat)
+			result.append(cand);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Overlay
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief line segments that draw the results over a w x h image
+//! \details lines are cut at the image border; circles are drawn with 48 segments
+//! \param[in] lines	detected lines
+//! \param[in] circles	detected circles
+//! \param[in] width	image width
+//! \param[in] height	image height
+//! \return				segments in image coordinates
+// lines are cut at the image border; circles are drawn with 48 segments
+QVector<QLineF> Hough::overlay(const QVector<HoughLine> &lines, const QVector<HoughCircle> &circles, int width, int height)
+{
+	QVector<QLineF> segments;
+
+	for (int i = 0; i < lines.size(); i++)
+	{
+		double c	= cos(lines[i].theta);
+		double s	= sin(lines[i].theta);
+		double rho	= lines[i].rho;
+
+		if (fabs(s) > fabs(c))		// closer to horizontal; walk along x
+			segments.append(QLineF(0.0, rho / s, width - 1, (rho - (width - 1) * c) / s));
+		else						// closer to vertical; walk along y
+			segments.append(QLineF(rho / c, 0.0, (rho - (height - 1) * s) / c, height - 1));
+	}
+
+	const int steps	= 48;
+	for (int i = 0; i < circles.size(); i++)
+	{
+		const HoughCircle &k	= circles[i];
+		for (int j = 0; j < steps; j++)
+		{
+			double a0	= 2.0 * HOUGH_PI * j / steps;
+			double a1	= 2.0 * HOUGH_PI * (j + 1) / steps;
+			segments.append(QLineF(k.cx + k.r * cos(a0), k.cy + k.r * sin(a0),
+								   k.cx + k.r * cos(a1), k.cy + k.r * sin(a1)));
+		}
+	}
+
+	return segments;
+}
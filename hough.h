@@ -0,0 +1,51 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Hough
+//! \brief Hough transform for lines and circles
+//!
+//! \file hough.h
+//! \brief Hough transform class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				HOUGH_H
+#define				HOUGH_H
+
+#include			<QImage>
+#include			<QLineF>
+#include			<QVector>
+
+// line x*cos(theta) + y*sin(theta) = rho
+struct HoughLine
+{
+	double			rho;			// distance from the origin (top left pixel)
+	double			theta;			// angle of the normal in radians (0 - pi)
+	int				votes;			// accumulator value
+};
+
+// circle found by the transform
+struct HoughCircle
+{
+	double			cx;				// center x
+	double			cy;				// center y
+	double			r;				// radius
+	int				votes;			// edge pixels on the circle
+};
+
+// Hough class
+class Hough
+{
+public:
+	//! \brief detect lines; edge pixels are those whose sobel magnitude is above level
+	static void		lines			(const QImage&, int, int, int, QVector<HoughLine>&);
+	//! \brief detect circles with a radius in [minRadius, maxRadius]
+	static void		circles			(const QImage&, int, int, int, int, QVector<HoughCircle>&);
+	//! \brief line segments (image coordinates) that draw the results over a w x h image
+	static QVector<QLineF>	overlay	(const QVector<HoughLine>&, const QVector<HoughCircle>&, int, int);
+};
+#endif
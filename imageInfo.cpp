@@ -26,7 +26,8 @@
 // Initialize all variables when new image is created
 imageInfo::imageInfo(QImage* pointerImage, QString imgName)
 {
-	m_imagePointer	= pointerImage;
+	m_handle		= 0;
+	m_id			= 0;
 	m_imageName		= imgName;
 	m_operation		= "New Image";
 	m_imagePath		= imgName.append(" : Image is in memory.");
@@ -44,7 +45,8 @@ imageInfo::imageInfo(QImage* pointerImage, QString imgName)
 // Initialize all variables when opening new file
 imageInfo::imageInfo(QImage* pointerImage, QFileInfo pathInfo, QString filePath)
 {
-	m_imagePointer	= pointerImage;
+	m_handle		= 0;
+	m_id			= 0;
 	m_imageName		= pathInfo.fileName();
 	m_operation		= "New File";
 	m_imagePath		= filePath;
@@ -63,7 +65,8 @@ imageInfo::imageInfo(QImage* pointerImage, QFileInfo pathInfo, QString filePath)
 //Initialize all variables when using some operation
 imageInfo::imageInfo(QFileInfo pathInfo, QImage* pointerImage, QLinkedList<imageInfo*> parentslst, QString op)
 {
-	m_imagePointer 	= pointerImage;
+	m_handle		= 0;
+	m_id			= 0;
 	m_imageName		= pathInfo.fileName().append("~2");
 	m_operation		= op;
 	m_listParents	= parentslst;
@@ -72,6 +75,59 @@ imageInfo::imageInfo(QFileInfo pathInfo, QImage* pointerImage, QLinkedList<image
 	initializeImageInfoData(pointerImage);
 }
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor when an operation creates an image in memory
+//! \details Initialize all variables when an operation combines or derives images that are already open
+//! \param[in] *pointerImage
+//! \param[in] imgName
+//! \param[in] parentslst
+//! \param[in] op
+// Initialize all variables when an operation combines or derives images that are already open
+imageInfo::imageInfo(QImage* pointerImage, QString imgName, QLinkedList<imageInfo*> parentslst, QString op)
+{
+	m_handle		= 0;
+	m_id			= 0;
+	m_imageName		= imgName;
+	m_operation		= op;
+	m_listParents	= parentslst;
+	m_imagePath		= imgName.append(" : Image is in memory.");
+	m_fileSize		= 0;
+
+	initializeImageInfoData(pointerImage);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor when a project is opened
+//! \details Reads everything write() wrote; the image itself stays in the project until it is shown,
+//! so the cache key is unknown and the record is found by the content hash instead
+//! \param[in] in			stream positioned at the record
+//! \param[in] parentslst	records of the source images, already read
+// Reads everything write() wrote; the image itself stays in the project until it is shown,
+imageInfo::imageInfo(QDataStream& in, QLinkedList<imageInfo*> parentslst)
+{
+	m_handle		= 0;
+	m_id			= 0;
+	m_listParents	= parentslst;
+	m_cacheKey		= 0;
+
+	in	>> m_imageName >> m_operation >> m_imagePath >> m_fileSize
+		>> m_imageHeight >> m_imageWidth >> m_dotsPerMeterY >> m_dotsPerMeterX
+		>> m_sizeOfColorTable >> m_imageDepth >> m_bytesPerScanLine >> m_numberOfBytes
+		>> m_imageFormat >> m_hasAlphaChannel >> m_isGrayScale
+		>> m_params.kind >> m_params.values;
+	in.readRawData	((char*)&m_statistics, sizeof(m_statistics));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+//! \details Releases the reference on the image in the store
+// Releases the reference on the image in the store
+imageInfo::~imageInfo()
+{
+	if (m_handle)
+		ImageStore::instance()->unref(m_handle);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Initializes image data
 //! \param[in] *pointerImage
@@ -107,12 +163,31 @@ void imageInfo::initializeImageInfoData(QImage* pointerImage)
 	else
 			m_hasAlphaChannel = "No";
 
-	if (pointerImage->isGrayscale())
+	// one pass over the pixels; the gray verdict comes from it instead of a second scan
+	ImageStats::compute(*pointerImage, m_statistics);
+	m_cacheKey			= pointerImage->cacheKey();
+
+	if (m_statistics.grayscale)
 			m_isGrayScale = "Yes";
 	else
 			m_isGrayScale = "No";
 }
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Writes the record for a project file
+//! \details The image and the parents are written by the project, which knows their numbers in the file
+//! \param[in] out	stream to write to
+// The image and the parents are written by the project, which knows their numbers in the file
+void imageInfo::write(QDataStream& out)
+{
+	out	<< m_imageName << m_operation << m_imagePath << m_fileSize
+		<< m_imageHeight << m_imageWidth << m_dotsPerMeterY << m_dotsPerMeterX
+		<< m_sizeOfColorTable << m_imageDepth << m_bytesPerScanLine << m_numberOfBytes
+		<< m_imageFormat << m_hasAlphaChannel << m_isGrayScale
+		<< m_params.kind << m_params.values;
+	out.writeRawData	((const char*)&m_statistics, sizeof(m_statistics));
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Returns a linked list of image's parents
 //! \return Returns a linked list of image's parents
@@ -131,6 +206,33 @@ QString imageInfo::getOperation()
 	return m_operation;
 }
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Sets the operation used in creating current image
+//! \param[in] op	name of the operation
+// Sets the operation used in creating current image
+void imageInfo::setOperation(QString op)
+{
+	m_operation		= op;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Returns the parameters of the operation
+//! \return Returns everything needed to run the operation again; kind None if it cannot be
+// Returns everything needed to run the operation again; kind None if it cannot be
+const OpParams& imageInfo::getParams()
+{
+	return m_params;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Sets the parameters of the operation
+//! \param[in] params	everything needed to run the operation again
+// Sets the parameters of the operation
+void imageInfo::setParams(const OpParams& params)
+{
+	m_params		= params;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Returns image's name
 //! \return Returns image's name
@@ -141,12 +243,43 @@ QString imageInfo::getImageName()
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief Returns pointer to the image
-//! \return Returns pointer to the image
-// Returns pointer to the image
-QImage* imageInfo::getImagePointer()
+//! \brief Returns the store handle of the image
+//! \return Returns the store handle of the image; 0 if it was never stored
+// Returns the store handle of the image
+ImageHandle imageInfo::getHandle()
+{
+	return m_handle;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Returns the history id of the record
+//! \return Returns the id given by historyManager; 0 if the record is not in the history
+// Returns the history id of the record
+int imageInfo::getId()
 {
-	return m_imagePointer;
+	return m_id;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Sets the history id of the record
+//! \param[in] id	id given by historyManager
+// Sets the history id of the record
+void imageInfo::setId(int id)
+{
+	m_id			= id;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Refers to the image in the store
+//! \details The record holds its own reference, so the pixels live as long as the history needs them
+//! \param[in] handle	store handle of the image
+// The record holds its own reference, so the pixels live as long as the history needs them
+void imageInfo::setHandle(ImageHandle handle)
+{
+	ImageStore::instance()->ref(handle);
+	if (m_handle)
+		ImageStore::instance()->unref(m_handle);
+	m_handle		= handle;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -265,3 +398,21 @@ quint64 imageInfo::getfileSize()
 {
 	return m_fileSize;
 }
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Returns the per channel statistics of the image
+//! \return Returns the statistics measured when the record was created
+// Returns the statistics measured when the record was created
+const ImageStatistics& imageInfo::getStatistics()
+{
+	return m_statistics;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Returns the cache key of the image data
+//! \return Returns QImage::cacheKey() of the image; shallow copies of the image share it
+// Returns QImage::cacheKey() of the image; shallow copies of the image share it
+qint64 imageInfo::getCacheKey()
+{
+	return m_cacheKey;
+}
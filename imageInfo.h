@@ -20,6 +20,10 @@
 #include	<QImage>
 #include	<QFileInfo>
 #include	<QString>
+#include	<QDataStream>
+#include	"imagestats.h"
+#include	"imagestore.h"
+#include	"operation.h"
 
 class imageInfo
 {
@@ -30,14 +34,32 @@ public:
 	imageInfo									(QImage* pointerImage, QFileInfo pathInfo, QString filePath);
 	//! \brief Constructor
 	imageInfo									(QFileInfo pathInfo, QImage* pointerImage, QLinkedList<imageInfo*> listParents, QString operation);
+	//! \brief Constructor
+	imageInfo									(QImage* pointerImage, QString imgName, QLinkedList<imageInfo*> listParents, QString operation);
+	//! \brief Constructor; reads a record written by write(), without touching the image
+	imageInfo									(QDataStream& in, QLinkedList<imageInfo*> listParents);
+	//! \brief Destructor; releases the image in the store
+	~imageInfo									();
 	//! \brief Initializes image information data for the use in constructor.
 	void			initializeImageInfoData		(QImage* pointerImage);
-	//! \brief Gets the pointer to the image image.
-	QImage*			getImagePointer				();
+	//! \brief Gets the store handle of the image.
+	ImageHandle		getHandle					();
+	//! \brief Refers to the image in the store; the record holds a reference.
+	void			setHandle					(ImageHandle);
+	//! \brief Gets the history id of the record; 0 until it is added to the history.
+	int				getId						();
+	//! \brief Sets the history id of the record.
+	void			setId						(int);
 	//! \brief Gets the name of the images used in creating current image.
 	QLinkedList<imageInfo*>	getParents			();
 	//! \brief Gets the name of the operation used in creating current images.
 	QString			getOperation				();
+	//! \brief Sets the name of the operation, after it was run again with new parameters.
+	void			setOperation				(QString);
+	//! \brief Gets the parameters to run the operation again.
+	const OpParams&	getParams					();
+	//! \brief Sets the parameters to run the operation again.
+	void			setParams					(const OpParams&);
 	//! \brief Gets the size of the image file.
 	quint64			getFileSize					();
 	//! \brief Gets the name of the image.
@@ -68,11 +90,19 @@ public:
 	QString			getimagePath				();
 	//! \brief Returns the size of the image file
 	quint64			getfileSize					();
+	//! \brief Returns the per channel statistics measured when the record was created
+	const ImageStatistics&	getStatistics		();
+	//! \brief Returns the cache key of the image data the record describes
+	qint64			getCacheKey					();
+	//! \brief Writes the record, except the image and the parents, for a project file
+	void			write						(QDataStream& out);
 
 private:
-	QImage*			m_imagePointer;				// pointer to the image
+	ImageHandle		m_handle;					// the image in the store; 0 until set
+	int				m_id;						// stable history id; 0 until added to the history
 	QString			m_imageName;				// image name
 	QString     	m_operation;				// operation used to create image
+	OpParams		m_params;					// parameters of the operation; kind None if it cannot be run again
 
 	QLinkedList<imageInfo*>		m_listParents;	// names of images used in creating given image
 
@@ -89,5 +119,7 @@ private:
 	QString			m_isGrayScale;				// Checks if image is greyscale
 	QString			m_imagePath;				// Stores the path of the image on the disk
 	quint64			m_fileSize;					// Stores the size of the image file
+	ImageStatistics	m_statistics;				// Per channel statistics; measured once so the UI never rescans
+	qint64			m_cacheKey;					// QImage::cacheKey() of the image data
 };
 #endif
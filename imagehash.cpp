@@ -0,0 +1,154 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageHasher
+//! \brief Image hash implementation
+//!
+//! \file imagehash.cpp
+//! \brief Image hash implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cstring>
+#include			<QVector>
+
+#include			"imagehash.h"
+#include			"parallel.h"
+
+#define				BAND_ROWS		64				// rows hashed by one task
+
+// The 128 bit MurmurHash3 mix (x64 variant). Each scan line is one message,
+// so the padding at the end of a line never enters the hash.
+
+#define				C1				Q_UINT64_C(0x87c37b91114253d5)
+#define				C2				Q_UINT64_C(0x4cf5ad432745937f)
+
+static inline quint64 rotl(quint64 x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64 fmix(quint64 k)
+{
+	k	^= k >> 33;
+	k	*= Q_UINT64_C(0xff51afd7ed558ccd);
+	k	^= k >> 33;
+	k	*= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+	k	^= k >> 33;
+	return k;
+}
+
+// hash len bytes, continuing from the state in h
+static void murmur(const uchar *data, int len, ImageHash &h)
+{
+	quint64 h1		= h.lo;
+	quint64 h2		= h.hi;
+	int blocks		= len / 16;
+
+	for (int i = 0; i < blocks; i++)
+	{
+		quint64 k1, k2;
+		memcpy(&k1, data + i * 16, 8);
+		memcpy(&k2, data + i * 16 + 8, 8);
+
+		k1	*= C1; k1 = rotl(k1, 31); k1 *= C2; h1 ^= k1;
+		h1	= rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+		k2	*= C2; k2 = rotl(k2, 33); k2 *= C1; h2 ^= k2;
+		h2	= rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const uchar *tail	= data + blocks * 16;
+	quint64 k1		= 0;
+	quint64 k2		= 0;
+	for (int i = (len & 15) - 1; i >= 8; i--)
+		k2			= (k2 << 8) | tail[i];
+	for (int i = qMin(len & 15, 8) - 1; i >= 0; i--)
+		k1			= (k1 << 8) | tail[i];
+	if (len & 15)
+	{
+		k2	*= C2; k2 = rotl(k2, 33); k2 *= C1; h2 ^= k2;
+		k1	*= C1; k1 = rotl(k1, 31); k1 *= C2; h1 ^= k1;
+	}
+
+	h1		^= (quint64)len;
+	h2		^= (quint64)len;
+	h1		+= h2;
+	h2		+= h1;
+	h1		= fmix(h1);
+	h2		= fmix(h2);
+	h1		+= h2;
+	h2		+= h1;
+
+	h.lo	= h1;
+	h.hi	= h2;
+}
+
+// state shared by the worker threads
+struct HashContext
+{
+	const QImage		*img;
+	int					rowBytes;		// used bytes per scan line
+	QVector<ImageHash>	bands;			// hash of every band of rows
+};
+
+// hash a range of bands
+static void hashBands(void *ctx, int begin, int end)
+{
+	HashContext *c		= (HashContext*)ctx;
+	for (int b = begin; b < end; b++)
+	{
+		ImageHash h;
+		h.lo			= (quint64)b;	// seed with the band index so equal bands in different places differ
+		int last		= qMin((b + 1) * BAND_ROWS, c->img->height());
+		for (int y = b * BAND_ROWS; y < last; y++)
+			murmur(c->img->scanLine(y), c->rowBytes, h);
+		c->bands[b]		= h;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Compute
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief 128 bit content hash of an image
+//! \details bands of 64 rows are hashed in parallel; the band hashes, the geometry and the color table are hashed together at the end
+//! \param[in] img	image to hash
+//! \return		the hash; null for a null image
+// bands of 64 rows are hashed in parallel; the band hashes, the geometry and the color table are hashed together at the end
+ImageHash ImageHasher::compute(const QImage &img)
+{
+	if (img.isNull())
+		return ImageHash();
+
+	HashContext c;
+	c.img			= &img;
+	c.rowBytes		= (img.width() * img.depth() + 7) / 8;
+	c.bands			.resize((img.height() + BAND_ROWS - 1) / BAND_ROWS);
+	Parallel::forRange(c.bands.size(), hashBands, &c, 1);
+
+	quint32 header[3]	= {(quint32)img.width(), (quint32)img.height(), (quint32)img.format()};
+	ImageHash h;
+	murmur((const uchar*)header, sizeof(header), h);
+
+	QVector<QRgb> colors	= img.colorTable();
+	if (!colors.isEmpty())
+		murmur((const uchar*)colors.constData(), colors.size() * sizeof(QRgb), h);
+	murmur((const uchar*)c.bands.constData(), c.bands.size() * sizeof(ImageHash), h);
+
+	if (h.isNull())
+		h.lo		= 1;		// null is reserved for no image
+	return h;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// To string
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief hash as text
+//! \return		32 hex digits, high half first
+QString ImageHash::toString() const
+{
+	return QString("%1%2").arg(hi, 16, 16, QChar('0')).arg(lo, 16, 16, QChar('0'));
+}
@@ -0,0 +1,47 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageHasher
+//! \brief 128 bit content hash of an image
+//!
+//! \file imagehash.h
+//! \brief Image hash class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				IMAGEHASH_H
+#define				IMAGEHASH_H
+
+#include			<QImage>
+#include			<QString>
+
+// content hash; equal images (size, format, color table and pixels) have equal hashes
+struct ImageHash
+{
+	quint64			lo;					// first half
+	quint64			hi;					// second half
+
+	ImageHash		() : lo(0), hi(0) {}
+
+	bool			isNull			() const					{ return !lo && !hi; }
+	bool			operator==		(const ImageHash &o) const	{ return lo == o.lo && hi == o.hi; }
+	bool			operator!=		(const ImageHash &o) const	{ return !(*this == o); }
+	//! \brief 32 hex digits
+	QString			toString		() const;
+};
+
+//! \brief lets ImageHash be a QHash key
+inline uint			qHash			(const ImageHash &h)		{ return (uint)h.lo; }
+
+// ImageHasher class
+class ImageHasher
+{
+public:
+	//! \brief hash of img; bands of rows are hashed in parallel, the result does not depend on the thread count
+	static ImageHash	compute		(const QImage&);
+};
+#endif
@@ -0,0 +1,191 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageLoader
+//! \brief ImageLoader implementation
+//!
+//! \file imageloader.cpp
+//! \brief ImageLoader implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QDir>
+#include			<QFileInfo>
+#include			<QImageReader>
+#include			<QRunnable>
+#include			<QThread>
+
+#include			"imageloader.h"
+#include			"trace.h"
+
+// decode one file and hand the result back to the loader's thread
+class LoadJob : public QRunnable
+{
+public:
+	LoadJob(ImageLoader *owner, const QString &path) : m_owner(owner), m_path(path) {}
+
+	void run()
+	{
+		TRACE("ImageLoader::decode");
+		QImageReader reader(m_path);
+		QImage img		= reader.read();
+		QString error	= img.isNull() ? reader.errorString() : QString();
+		QMetaObject::invokeMethod(m_owner, "done", Qt::QueuedConnection,
+								  Q_ARG(QString, m_path), Q_ARG(QImage, img), Q_ARG(QString, error));
+	}
+
+private:
+	ImageLoader		*m_owner;		// gets the result
+	QString			m_path;			// file to decode
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+//! \details one decode per core; twice as many may be in flight, so a worker always has a file to go on
+//!	with while the user interface takes in the last result
+//! \param[in] parent	parent object
+// one decode per core; twice as many may be in flight
+ImageLoader::ImageLoader(QObject *parent) : QObject(parent)
+{
+	m_pool				.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+	m_limit				= 2 * m_pool.maxThreadCount();
+	m_inFlight			= 0;
+	m_total				= 0;
+	m_loaded			= 0;
+	m_failed			= 0;
+	m_bytes				= 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DESTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+//! \details jobs refer to the loader, so the running ones are finished first; their results are dropped
+// jobs refer to the loader, so the running ones are finished first
+ImageLoader::~ImageLoader()
+{
+	m_queue				.clear();
+	m_pool				.waitForDone();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Load
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief decode files in the background
+//! \details files requested while a run is going on join it
+//! \param[in] files	paths of the files
+// files requested while a run is going on join it
+void ImageLoader::load(const QStringList &files)
+{
+	if (files.isEmpty())
+		return;
+	if (!m_total)
+		m_timer			.start();
+
+	m_total				+= files.size();
+	m_queue				+= files;
+	startJobs			();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Total
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief files requested since the loader was last idle
+//! \return	# of files in this run
+int ImageLoader::total()
+{
+	return m_total;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pending
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief files not delivered yet
+//! \return	# of files waiting or being decoded
+int ImageLoader::pending()
+{
+	return m_queue.size() + m_inFlight;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Image files of a directory
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief image files in a directory
+//! \details files are chosen by the suffixes of the installed image plugins
+//! \param[in] dir	the directory; not searched recursively
+//! \return	absolute paths sorted by name
+// files are chosen by the suffixes of the installed image plugins
+QStringList ImageLoader::imageFiles(const QString &dir)
+{
+	QStringList filters;
+	QList<QByteArray> formats	= QImageReader::supportedImageFormats();
+	for (int i = 0; i < formats.size(); i++)
+		filters			<< QString("*.%1").arg(QString(formats[i]));
+
+	QDir directory(dir);
+	QStringList names	= directory.entryList(filters, QDir::Files | QDir::Readable, QDir::Name | QDir::IgnoreCase);
+	QStringList files;
+	for (int i = 0; i < names.size(); i++)
+		files			<< directory.absoluteFilePath(names[i]);
+	return files;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Start decodes
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief start decodes while under the limit
+//! \details a decode counts until its result has been delivered; a slow receiver holds back new decodes
+//!	instead of letting decoded images pile up in the event queue
+// a decode counts until its result has been delivered; a slow receiver holds back new decodes
+void ImageLoader::startJobs()
+{
+	while (m_inFlight < m_limit && !m_queue.isEmpty())
+	{
+		m_inFlight++;
+		m_pool			.start(new LoadJob(this, m_queue.takeFirst()));
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Decode done
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a decode has finished
+//! \details the result is delivered before the slot is given back, then the next file is started.
+//!	The run ends when nothing is left
+//! \param[in] path	the file
+//! \param[in] img	the image; null on failure
+//! \param[in] error	why the file could not be decoded
+// the result is delivered before the slot is given back, then the next file is started
+void ImageLoader::done(QString path, QImage img, QString error)
+{
+	if (img.isNull())
+	{
+		m_failed++;
+		emit failed		(path, error);
+	}
+	else
+	{
+		m_loaded++;
+		m_bytes			+= QFileInfo(path).size();
+		emit loaded		(path, img);
+	}
+
+	m_inFlight--;
+	startJobs			();
+
+	if (!m_inFlight && m_queue.isEmpty())
+	{
+		int loaded		= m_loaded;
+		int failures	= m_failed;
+		qint64 bytes	= m_bytes;
+		m_total			= m_loaded = m_failed = 0;
+		m_bytes			= 0;
+		emit finished	(loaded, failures, bytes, m_timer.elapsed());
+	}
+}
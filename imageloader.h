@@ -0,0 +1,71 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageLoader
+//! \brief Decodes image files on a bounded pool of worker threads
+//!
+//! \file imageloader.h
+//! \brief ImageLoader class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				IMAGELOADER_H
+#define				IMAGELOADER_H
+
+#include			<QObject>
+#include			<QImage>
+#include			<QStringList>
+#include			<QThreadPool>
+#include			<QTime>
+
+// ImageLoader class
+class ImageLoader : public QObject
+{
+			Q_OBJECT
+
+public:
+	//! \brief Constructor
+					ImageLoader		(QObject *parent = 0);
+	//! \brief Destructor; files not started are dropped, running decodes are waited for
+					~ImageLoader	();
+
+	//! \brief decode files in the background; loaded() or failed() is emitted for each, in the order they finish
+	void			load			(const QStringList&);
+	//! \brief files requested since the loader was last idle
+	int				total			();
+	//! \brief files not delivered yet
+	int				pending			();
+	//! \brief image files in a directory that a decoder is installed for, sorted by name
+	static QStringList	imageFiles	(const QString &dir);
+
+signals:
+	//! \brief a file has been decoded
+	void			loaded			(QString, QImage);
+	//! \brief a file could not be decoded; path and reason
+	void			failed			(QString, QString);
+	//! \brief every requested file is done: # loaded, # failed, file bytes decoded, milliseconds
+	void			finished		(int, int, qint64, int);
+
+private slots:
+	//! \brief a decode has finished; called on the thread of the loader
+	void			done			(QString, QImage, QString);
+
+private:
+	//! \brief start decodes while under the limit
+	void			startJobs		();
+
+	QThreadPool		m_pool;			// decode threads
+	QStringList		m_queue;		// files not started yet
+	int				m_inFlight;		// decodes running or waiting to be delivered
+	int				m_limit;		// most decodes in flight; bounds the decoded images held in memory
+	int				m_total;		// files requested in this run
+	int				m_loaded;		// files decoded in this run
+	int				m_failed;		// files that failed in this run
+	qint64			m_bytes;		// file bytes decoded in this run
+	QTime			m_timer;		// started with the run
+};
+#endif
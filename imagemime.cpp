@@ -0,0 +1,160 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageMime
+//! \brief ImageMime implementation
+//!
+//! \file imagemime.cpp
+//! \brief ImageMime implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QCoreApplication>
+#include			<QHash>
+
+#include			"imagemime.h"
+
+#define				QT_IMAGE_MIME	"application/x-qt-image"	// Qt's image format; expanded to image/* for other applications
+
+static QHash<int, const ImageMime*>	mimeLive;	// drags of this process that have not been deleted, by number
+static int							mimeNext;	// number of the next drag
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+//! \details the data holds a reference to the pixels, so the source may clear its image while the drag runs
+//! \param[in] clip	image, name and title of the frame
+ImageMime::ImageMime(const ImageClip &clip)
+{
+	m_clip				= clip;
+	m_handle			= 0;
+	m_id				= ++mimeNext;
+	mimeLive			.insert(m_id, this);
+}
+
+//! \brief Constructor
+//! \details the data holds a reference to the stored image; a spilled image is only read back on drop
+//! \param[in] handle	stored image
+//! \param[in] name		image name
+ImageMime::ImageMime(ImageHandle handle, const QString &name)
+{
+	QSize size			= ImageStore::instance()->size(handle);
+	m_clip.name			= name;
+	m_clip.title		= QObject::tr("%1 @ 100% %2x%3").arg(name).arg(size.width()).arg(size.height());
+	m_handle			= handle;
+	m_id				= ++mimeNext;
+	mimeLive			.insert(m_id, this);
+	ImageStore::instance()->ref(m_handle);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DESTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+//! \details drops the references to the pixels
+ImageMime::~ImageMime()
+{
+	mimeLive			.remove(m_id);
+	if (m_handle)
+		ImageStore::instance()->unref(m_handle);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Can decode
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief does the data hold an image
+//! \param[in] data	data of a drag
+//! \return		true for drags of this process and for images of other applications
+bool ImageMime::canDecode(const QMimeData *data)
+{
+	return data->hasFormat(IMAGE_MIME) || data->hasImage();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Clip
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the image of the data
+//! \details a drag of this process carries only a token naming it; the token is looked up and the image is
+//!	shared, so no pixel is encoded or copied. Anything else is decoded from its image data
+//! \param[in] data	data of a drag
+//! \return		the image; null pixels if there is none
+// a drag of this process carries only a token naming it; anything else is decoded from its image data
+ImageClip ImageMime::clip(const QMimeData *data)
+{
+	QList<QByteArray> token	= data->data(IMAGE_MIME).split(':');
+	if (token.size() == 2 && token[0].toLongLong() == QCoreApplication::applicationPid())
+	{
+		const ImageMime *mime	= mimeLive.value(token[1].toInt());
+		if (mime)
+			return mime->resolve();
+	}
+
+	ImageClip clip;
+	clip.img			= qvariant_cast<QImage>(data->imageData());
+	clip.title			= data->text();
+	clip.name			= QString(data->data("text"));
+	return clip;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Formats
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief formats offered
+//! \details Qt offers the image to other applications as image/* and asks retrieveData() for it only when one
+//!	of them accepts the drop
+//! \return		the token, the image, the title and the image name
+QStringList ImageMime::formats() const
+{
+	return QStringList() << IMAGE_MIME << QT_IMAGE_MIME << "text/plain" << "text";
+}
+
+//! \brief is a format offered
+//! \param[in] mimetype	format
+//! \return		true if formats() has it
+bool ImageMime::hasFormat(const QString &mimetype) const
+{
+	return formats().contains(mimetype);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Retrieve data
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief data of one format
+//! \details nothing is made up front; the pixels are only handed out, and encoded by Qt, when the image format
+//!	itself is asked for
+//! \param[in] mimetype	format
+//! \param[in] type		type wanted
+//! \return		the data
+// nothing is made up front; the pixels are only handed out when the image format itself is asked for
+QVariant ImageMime::retrieveData(const QString &mimetype, QVariant::Type type) const
+{
+	if (mimetype == IMAGE_MIME)
+		return QByteArray::number(QCoreApplication::applicationPid()) + ':' + QByteArray::number(m_id);
+	if (mimetype == QT_IMAGE_MIME)
+		return resolve().img;
+	if (mimetype == "text/plain")
+		return m_clip.title;
+	if (mimetype == "text")
+		return m_clip.name.toAscii();
+	return QMimeData::retrieveData(mimetype, type);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Resolve
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the image
+//! \return		the pixels of the frame, or the stored image read back if it was spilled
+ImageClip ImageMime::resolve() const
+{
+	if (!m_handle)
+		return m_clip;
+
+	ImageClip clip		= m_clip;
+	clip.img			= ImageStore::instance()->image(m_handle);
+	return clip;
+}
@@ -0,0 +1,67 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageMime
+//! \brief Drag data that hands the shared pixels of an image to frames of the same process
+//!
+//! \file imagemime.h
+//! \brief ImageClip and ImageMime classes
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				IMAGEMIME_H
+#define				IMAGEMIME_H
+
+#define				IMAGE_MIME		"application/x-imanip-image"	// token of a drag started in this process
+
+#include			<QImage>
+#include			<QMimeData>
+#include			<QStringList>
+#include			"imagestore.h"
+
+// an image with the name and frame title it is shown under. Copying it shares the pixels
+struct ImageClip
+{
+	QImage			img;			// pixels
+	QString			name;			// image name
+	QString			title;			// frame title
+};
+
+// ImageMime class
+class ImageMime : public QMimeData
+{
+public:
+	//! \brief Constructor; drag the pixels of a frame
+					ImageMime		(const ImageClip&);
+	//! \brief Constructor; drag a stored image, read back only if it is dropped
+					ImageMime		(ImageHandle, const QString &name);
+	//! \brief Destructor
+					~ImageMime		();
+
+	//! \brief does the data hold an image, from this process or another
+	static bool		canDecode		(const QMimeData*);
+	//! \brief the image of the data; shared pixels if the drag started in this process
+	static ImageClip	clip		(const QMimeData*);
+
+	//! \brief formats offered; image data is only made if another application asks for it
+	QStringList		formats			() const;
+	//! \brief is a format offered
+	bool			hasFormat		(const QString&) const;
+
+protected:
+	//! \brief data of one format, made on request
+	QVariant		retrieveData	(const QString&, QVariant::Type) const;
+
+private:
+	//! \brief the image, read back from the store for a stored image
+	ImageClip		resolve			() const;
+
+	ImageClip		m_clip;			// dragged image; null pixels for a stored image
+	ImageHandle		m_handle;		// dragged stored image; 0 for the pixels of a frame
+	int				m_id;			// number of the drag in this process
+};
+#endif
@@ -0,0 +1,181 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageStats
+//! \brief Image statistics implementation
+//!
+//! \file imagestats.cpp
+//! \brief Image statistics implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cstring>
+#include			<QVector>
+
+#ifdef __SSE2__
+#include			<emmintrin.h>
+#endif
+
+#include			"imagestats.h"
+#include			"parallel.h"
+
+// histograms of one band of rows; one per thread so no locking is needed
+struct StatsBand
+{
+	int				hist[ImageStatistics::Channels][256];
+	unsigned int	colorBits;			// OR of (R ^ G) | (G ^ B) over the band; zero when gray
+};
+
+// state shared by the worker threads
+struct StatsContext
+{
+	const QImage		*img;
+	QVector<StatsBand>	bands;
+	int					rowsPerBand;
+};
+
+// luminance with integer weights 77/151/28 (0.3/0.59/0.11 scaled by 256)
+static inline int luminance(unsigned int p)
+{
+	return (77 * ((p >> 16) & 0xff) + 151 * ((p >> 8) & 0xff) + 28 * (p & 0xff) + 128) >> 8;
+}
+
+// histogram a run of pixels
+static void scanRow(const unsigned int *pix, int width, StatsBand &b)
+{
+	int x				= 0;
+
+#ifdef __SSE2__
+	// four pixels at a time: luminance and the gray verdict in SIMD, histogram increments scalar
+	const __m128i lowMask	= _mm_set1_epi32(0x00ff00ff);
+	const __m128i wBR		= _mm_set1_epi32((77 << 16) | 28);		// B in the low half, R in the high half
+	const __m128i wG		= _mm_set1_epi32(151);					// G in the low half, A ignored
+	const __m128i round		= _mm_set1_epi32(128);
+	__m128i diff			= _mm_setzero_si128();
+	int gray[4];
+
+	for (; x + 4 <= width; x += 4)
+	{
+		__m128i v		= _mm_loadu_si128((const __m128i*)(pix + x));
+		__m128i br		= _mm_and_si128(v, lowMask);
+		__m128i ga		= _mm_and_si128(_mm_srli_epi32(v, 8), lowMask);
+		__m128i lum		= _mm_add_epi32(_mm_madd_epi16(br, wBR), _mm_madd_epi16(ga, wG));
+		lum				= _mm_srli_epi32(_mm_add_epi32(lum, round), 8);
+		_mm_storeu_si128((__m128i*)gray, lum);
+
+		// (R ^ G) | (G ^ B) lands in bits 8-15 and 0-7 of every lane
+		__m128i rg		= _mm_xor_si128(_mm_srli_epi32(v, 8), v);
+		diff			= _mm_or_si128(diff, _mm_and_si128(rg, _mm_set1_epi32(0x0000ffff)));
+
+		for (int k = 0; k < 4; k++)
+		{
+			unsigned int p	= pix[x + k];
+			b.hist[ImageStatistics::Blue] [p & 0xff]++;
+			b.hist[ImageStatistics::Green][(p >> 8) & 0xff]++;
+			b.hist[ImageStatistics::Red]  [(p >> 16) & 0xff]++;
+			b.hist[ImageStatistics::Alpha][p >> 24]++;
+			b.hist[ImageStatistics::Gray] [gray[k]]++;
+		}
+	}
+
+	int lanes[4];
+	_mm_storeu_si128	((__m128i*)lanes, diff);
+	b.colorBits			|= lanes[0] | lanes[1] | lanes[2] | lanes[3];
+#endif
+
+	for (; x < width; x++)
+	{
+		unsigned int p	= pix[x];
+		b.hist[ImageStatistics::Blue] [p & 0xff]++;
+		b.hist[ImageStatistics::Green][(p >> 8) & 0xff]++;
+		b.hist[ImageStatistics::Red]  [(p >> 16) & 0xff]++;
+		b.hist[ImageStatistics::Alpha][p >> 24]++;
+		b.hist[ImageStatistics::Gray] [luminance(p)]++;
+		b.colorBits		|= ((p >> 8) ^ p) & 0xffff;
+	}
+}
+
+// every band scans its own rows into its own histograms
+static void scanBands(void *p, int begin, int end)
+{
+	StatsContext *c		= (StatsContext*)p;
+	int height			= c->img->height();
+	int width			= c->img->width();
+
+	for (int band = begin; band < end; band++)
+	{
+		StatsBand &b	= c->bands[band];
+		int y1			= qMin(height, (band + 1) * c->rowsPerBand);
+		for (int y = band * c->rowsPerBand; y < y1; y++)
+			scanRow		((const unsigned int*)c->img->scanLine(y), width, b);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Compute statistics
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief measure every channel of img in one pass
+//! \details the rows are split into one band per thread and every band builds its own histograms of R, G, B,
+//!	alpha and luminance while it checks R == G == B. Min, max, mean and variance are exact and follow from
+//!	the merged histograms, so the pixels are read only once
+//! \param[in] img		image to measure; formats other than 32 bit are converted first
+//! \param[out] stats	result
+// rows are split into one band per thread; min, max, mean and variance follow from the merged histograms
+void ImageStats::compute(const QImage &img, ImageStatistics &stats)
+{
+	memset				(&stats, 0, sizeof(stats));
+	if (img.isNull())
+		return;
+
+	QImage src			= img;
+	if (src.depth() != 32)
+		src				= img.convertToFormat(QImage::Format_ARGB32);
+
+	StatsContext c;
+	c.img				= &src;
+	int bands			= qMin(Parallel::numThreads(), src.height());
+	c.rowsPerBand		= (src.height() + bands - 1) / bands;
+	c.bands.resize		(bands);
+	memset				(c.bands.data(), 0, bands * sizeof(StatsBand));
+
+	Parallel::forRange	(bands, scanBands, &c, 1);
+
+	stats.pixels		= (qint64)src.width() * src.height();
+	unsigned int colorBits	= 0;
+	for (int band = 0; band < bands; band++)
+	{
+		colorBits		|= c.bands[band].colorBits;
+		for (int ch = 0; ch < ImageStatistics::Channels; ch++)
+			for (int v = 0; v < 256; v++)
+				stats.channel[ch].histogram[v]	+= c.bands[band].hist[ch][v];
+	}
+
+	for (int ch = 0; ch < ImageStatistics::Channels; ch++)
+	{
+		ChannelStats &s	= stats.channel[ch];
+		double sum		= 0.0;
+		double sum2		= 0.0;
+		s.min			= -1;
+		for (int v = 0; v < 256; v++)
+		{
+			if (s.histogram[v] == 0)
+				continue;
+			if (s.min < 0)
+				s.min	= v;
+			s.max		= v;
+			sum			+= (double)v * s.histogram[v];
+			sum2		+= (double)v * v * s.histogram[v];
+		}
+		s.mean			= sum / stats.pixels;
+		s.variance		= sum2 / stats.pixels - s.mean * s.mean;
+		if (s.variance < 0.0)
+			s.variance	= 0.0;	// rounding
+	}
+
+	stats.grayscale		= colorBits == 0;
+	stats.usesAlpha		= src.hasAlphaChannel() && stats.channel[ImageStatistics::Alpha].min < 255;
+}
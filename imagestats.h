@@ -0,0 +1,50 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageStats
+//! \brief Per channel statistics of an image in one pass
+//!
+//! \file imagestats.h
+//! \brief Image statistics class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				IMAGESTATS_H
+#define				IMAGESTATS_H
+
+#include			<QImage>
+
+// statistics of one channel
+struct ChannelStats
+{
+	int				min;				// smallest value
+	int				max;				// largest value
+	double			mean;				// average value
+	double			variance;			// population variance
+	int				histogram[256];		// number of pixels at every value
+};
+
+// statistics of a whole image
+struct ImageStatistics
+{
+	//! \brief channel index; Gray is the luminance (0.3R + 0.59G + 0.11B)
+	enum			Channel			{Red, Green, Blue, Alpha, Gray, Channels};
+
+	ChannelStats	channel[Channels];	// statistics of every channel
+	qint64			pixels;				// number of pixels measured
+	bool			grayscale;			// every pixel has R == G == B
+	bool			usesAlpha;			// the format has alpha and some pixel is not opaque
+};
+
+// ImageStats class
+class ImageStats
+{
+public:
+	//! \brief measure every channel of img in one pass
+	static void		compute			(const QImage&, ImageStatistics&);
+};
+#endif
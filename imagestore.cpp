@@ -0,0 +1,680 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageStore
+//! \brief Image store implementation
+//!
+//! \file imagestore.cpp
+//! \brief Image store implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QTemporaryFile>
+#include			<QFile>
+#include			<QMutexLocker>
+
+#include			"imagestore.h"
+#include			"lzcodec.h"
+#include			"parallel.h"
+#include			"memoryledger.h"
+
+#define				BAND_ROWS		64				// rows compressed together when spilling
+
+// state shared by the band workers
+struct BandContext
+{
+	const uchar			*src;			// pixels to compress
+	uchar				*dst;			// pixels to rebuild
+	int					bpl;
+	int					height;
+	QVector<QByteArray>	*out;			// compressed bands
+	const char			*data;			// compressed bands back to back
+	const int			*sizes;			// size of every compressed band
+	QVector<int>		offsets;		// start of every compressed band in data
+	int					failed;			// a band did not decompress
+};
+
+// compress a range of bands
+static void compressBands(void *ctx, int begin, int end)
+{
+	BandContext *c		= (BandContext*)ctx;
+	for (int b = begin; b < end; b++)
+	{
+		int rows		= qMin(BAND_ROWS, c->height - b * BAND_ROWS);
+		(*c->out)[b]	= LZ::compress((const char*)c->src + b * BAND_ROWS * c->bpl, rows * c->bpl);
+	}
+}
+
+// decompress a range of bands
+static void expandBands(void *ctx, int begin, int end)
+{
+	BandContext *c		= (BandContext*)ctx;
+	for (int b = begin; b < end; b++)
+	{
+		int rows		= qMin(BAND_ROWS, c->height - b * BAND_ROWS);
+		if (!LZ::decompress(c->data + c->offsets[b], c->sizes[b], (char*)c->dst + b * BAND_ROWS * c->bpl, rows * c->bpl))
+			c->failed	= 1;
+	}
+}
+
+// compress img in bands of rows; sizes gets the size of every band, data the bands back to back
+static void compressImage(const QImage &img, QVector<int> &sizes, QByteArray &data)
+{
+	int bands		= (img.height() + BAND_ROWS - 1) / BAND_ROWS;
+	QVector<QByteArray> out(bands);
+
+	BandContext c;
+	c.src			= img.bits();
+	c.dst			= 0;
+	c.bpl			= img.bytesPerLine();
+	c.height		= img.height();
+	c.out			= &out;
+	c.data			= 0;
+	c.sizes			= 0;
+	c.failed		= 0;
+	Parallel::forRange(bands, compressBands, &c, 1);
+
+	sizes			.resize(bands);
+	data			.clear();
+	for (int b = 0; b < bands; b++)
+	{
+		sizes[b]	= out[b].size();
+		data		.append(out[b]);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the store shared by the whole application
+//! \return		the store
+ImageStore* ImageStore::instance()
+{
+	static ImageStore store;
+	return &store;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+ImageStore::ImageStore()
+{
+	m_nextHandle	= 1;
+	m_lruOldest		= 0;
+	m_lruNewest		= 0;
+	m_budget		= qint64(1024) << 20;
+	m_resident		= 0;
+	m_cached		= 0;
+	m_cache			= 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Insert
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add an image
+//! \details the store keeps a shallow copy, so adding an image that is on screen costs no memory.
+//! An image whose content is already stored gets the existing handle; callers that display
+//! image(handle) instead of their own copy then share one pixel buffer.
+//! \param[in] img	image to add
+//! \return		handle with one more reference; 0 for a null image
+// the store keeps a shallow copy, so adding an image that is on screen costs no memory.
+ImageHandle ImageStore::insert(const QImage &img)
+{
+	if (img.isNull())
+		return 0;
+
+	ImageHash hash		= ImageHasher::compute(img);	// outside the lock; it reads every pixel
+
+	QMutexLocker lock(&m_mutex);
+	ImageHandle handle	= m_byHash.value(hash, 0);
+	if (handle)
+	{
+		m_entries[handle].refs++;
+		return handle;
+	}
+	handle				= m_nextHandle++;
+
+	Entry e;
+	e.img			= img;
+	e.refs			= 1;
+	e.hash			= hash;
+	e.width			= img.width();
+	e.height		= img.height();
+	e.format		= img.format();
+	e.colors		= img.colorTable();
+	e.bytes			= img.numBytes();
+	e.filePos		= -1;
+	e.fileLen		= 0;
+	e.prev			= e.next	= 0;
+
+	m_entries.insert(handle, e);
+	m_byHash.insert	(hash, handle);
+	link			(handle, m_entries[handle]);
+	m_resident		+= e.bytes;
+	account			(handle, e.bytes);
+	enforceBudget	();
+	return handle;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Reference
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add a reference
+//! \param[in] handle	image handle
+void ImageStore::ref(ImageHandle handle)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::iterator it	= m_entries.find(handle);
+	if (it != m_entries.end())
+		it->refs++;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Unreference
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief drop a reference
+//! \details the last reference frees the pixels and the disk copy
+//! \param[in] handle	image handle
+// the last reference frees the pixels and the disk copy
+void ImageStore::unref(ImageHandle handle)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::iterator it	= m_entries.find(handle);
+	if (it == m_entries.end() || --it->refs > 0)
+		return;
+
+	if (!it->img.isNull())
+	{
+		unlink		(*it);
+		m_resident	-= it->bytes;
+		account		(handle, 0);
+	}
+	if (it->filePos >= 0 && it->file.isEmpty())
+		release		(it->filePos, it->fileLen);
+	m_byHash.remove	(it->hash);
+	m_entries.erase(it);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the image of a handle
+//! \details a spilled image is read back; either way it becomes the most recently used
+//! \param[in] handle	image handle
+//! \return		the image; null if the handle is unknown or the disk cache failed
+// a spilled image is read back; either way it becomes the most recently used
+QImage ImageStore::image(ImageHandle handle)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::iterator it	= m_entries.find(handle);
+	if (it == m_entries.end())
+		return QImage();
+
+	if (it->img.isNull())
+	{
+		if (!readCache(*it))
+			return QImage();
+		m_resident	+= it->bytes;
+		account		(handle, it->bytes);
+	}
+	else
+		unlink		(*it);
+	link			(handle, *it);
+
+	QImage img		= it->img;
+	enforceBudget	();			// img is shared now, so this entry stays
+	return img;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Find
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the image with the given content
+//! \param[in] hash	content hash
+//! \return		its handle, without a new reference; 0 if there is none
+ImageHandle ImageStore::find(const ImageHash &hash)
+{
+	QMutexLocker lock(&m_mutex);
+	return m_byHash.value(hash, 0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Hash
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief content hash of the image
+//! \details computed once on insert; it stays valid while the image is on disk
+//! \param[in] handle	image handle
+//! \return		the hash; null if the handle is unknown
+// computed once on insert; it stays valid while the image is on disk
+ImageHash ImageStore::hash(ImageHandle handle)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::const_iterator it	= m_entries.constFind(handle);
+	if (it == m_entries.constEnd())
+		return ImageHash();
+	return it->hash;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Size
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief size of the image without reading it back
+//! \param[in] handle	image handle
+//! \return		image size; empty if the handle is unknown
+QSize ImageStore::size(ImageHandle handle)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::const_iterator it	= m_entries.constFind(handle);
+	if (it == m_entries.constEnd())
+		return QSize();
+	return QSize(it->width, it->height);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Resident
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief is the image in memory
+//! \param[in] handle	image handle
+//! \return		false if the image was spilled or the handle is unknown
+bool ImageStore::isResident(ImageHandle handle)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::const_iterator it	= m_entries.constFind(handle);
+	return it != m_entries.constEnd() && !it->img.isNull();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Compressed
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the image as compressed bands of rows
+//! \details an image with a disk copy is copied as it is, so saving a project does not expand spilled images;
+//! a resident image without one is compressed in parallel
+//! \param[in] handle	image handle
+//! \param[out] info	geometry, hash and band sizes
+//! \param[out] data	the bands back to back
+//! \return		false if the handle is unknown or the disk copy could not be read
+// an image with a disk copy is copied as it is, so saving a project does not expand spilled images
+bool ImageStore::compressed(ImageHandle handle, StoredImage &info, QByteArray &data)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::iterator it	= m_entries.find(handle);
+	if (it == m_entries.end())
+		return false;
+
+	info.hash		= it->hash;
+	info.width		= it->width;
+	info.height		= it->height;
+	info.format		= it->format;
+	info.colors		= it->colors;
+
+	if (it->filePos >= 0)
+	{
+		info.bands	= it->bands;
+		return readBands(*it, data);
+	}
+	compressImage	(it->img, info.bands, data);
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Insert stored
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add an image that is in a file as compressed bands
+//! \details the entry starts out spilled, with the file as its disk copy; the pixels are read by the first image()
+//! \param[in] info	geometry, hash and band sizes
+//! \param[in] file	file with the bands
+//! \param[in] pos		offset of the first band
+//! \return		handle with one more reference; an image with the same content that is already stored is reused
+// the entry starts out spilled, with the file as its disk copy; the pixels are read by the first image()
+ImageHandle ImageStore::insertStored(const StoredImage &info, const QString &file, qint64 pos)
+{
+	QMutexLocker lock(&m_mutex);
+	ImageHandle handle	= m_byHash.value(info.hash, 0);
+	if (handle)
+	{
+		m_entries[handle].refs++;
+		return handle;
+	}
+	handle				= m_nextHandle++;
+
+	Entry e;
+	e.refs			= 1;
+	e.hash			= info.hash;
+	e.width			= info.width;
+	e.height		= info.height;
+	e.format		= info.format;
+	e.colors		= info.colors;
+	e.bytes			= qint64((info.width * QImage(1, 1, (QImage::Format)info.format).depth() + 31) / 32) * 4 * info.height;
+	e.file			= file;
+	e.filePos		= pos;
+	e.fileLen		= 0;
+	e.bands			= info.bands;
+	for (int b = 0; b < info.bands.size(); b++)
+		e.fileLen	+= info.bands[b];
+	e.prev			= e.next	= 0;
+
+	m_entries.insert(handle, e);
+	m_byHash.insert	(info.hash, handle);
+	return handle;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set stored
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the disk copy of an image is now in a file
+//! \details called after a project is saved; the space in the disk cache is given back and the image
+//! can be spilled without writing it again
+//! \param[in] handle	image handle
+//! \param[in] info	band sizes as written
+//! \param[in] file	file with the bands
+//! \param[in] pos		offset of the first band
+// called after a project is saved; the space in the disk cache is given back
+void ImageStore::setStored(ImageHandle handle, const StoredImage &info, const QString &file, qint64 pos)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<ImageHandle, Entry>::iterator it	= m_entries.find(handle);
+	if (it == m_entries.end())
+		return;
+
+	if (it->filePos >= 0 && it->file.isEmpty())
+		release		(it->filePos, it->fileLen);
+
+	it->file		= file;
+	it->filePos		= pos;
+	it->fileLen		= 0;
+	it->bands		= info.bands;
+	for (int b = 0; b < info.bands.size(); b++)
+		it->fileLen	+= info.bands[b];
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Budget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set the bytes of pixels the store may keep in memory
+//! \param[in] bytes	new budget; images over it are spilled right away
+void ImageStore::setBudget(qint64 bytes)
+{
+	QMutexLocker lock(&m_mutex);
+	m_budget		= bytes;
+	enforceBudget	();
+}
+
+//! \brief bytes of pixels the store may keep in memory
+//! \return		the budget
+qint64 ImageStore::budget()
+{
+	QMutexLocker lock(&m_mutex);
+	return m_budget;
+}
+
+//! \brief bytes of pixels in memory
+//! \return		resident bytes, including images that are also on screen
+qint64 ImageStore::residentBytes()
+{
+	QMutexLocker lock(&m_mutex);
+	return m_resident;
+}
+
+//! \brief bytes in the disk cache
+//! \return		compressed bytes on disk
+qint64 ImageStore::cachedBytes()
+{
+	QMutexLocker lock(&m_mutex);
+	return m_cached;
+}
+
+//! \brief number of live images
+//! \return		images with at least one reference
+int ImageStore::count()
+{
+	QMutexLocker lock(&m_mutex);
+	return m_entries.size();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LRU list
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief put a resident entry at the recently used end
+//! \param[in] handle	its handle
+//! \param[in, out] e	the entry
+void ImageStore::link(ImageHandle handle, Entry &e)
+{
+	e.prev			= m_lruNewest;
+	e.next			= 0;
+	if (m_lruNewest)
+		m_entries[m_lruNewest].next	= handle;
+	else
+		m_lruOldest	= handle;
+	m_lruNewest		= handle;
+}
+
+//! \brief take a resident entry out of the LRU list
+//! \param[in, out] e	the entry
+void ImageStore::unlink(Entry &e)
+{
+	if (e.prev)
+		m_entries[e.prev].next	= e.next;
+	else
+		m_lruOldest	= e.next;
+	if (e.next)
+		m_entries[e.next].prev	= e.prev;
+	else
+		m_lruNewest	= e.prev;
+	e.prev			= e.next	= 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Enforce budget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief spill least recently used images until under budget
+//! \details an image still shared with a frame or dialog is skipped: dropping the store's copy would free nothing.
+//! Images are never modified in the store, so one that was read back keeps its disk copy and spills again for free.
+// an image still shared with a frame or dialog is skipped: dropping the store's copy would free nothing.
+void ImageStore::enforceBudget()
+{
+	ImageHandle handle	= m_lruOldest;
+	while (m_resident > m_budget && handle)
+	{
+		Entry &e		= m_entries[handle];
+		ImageHandle next	= e.next;
+
+		if (e.img.isDetached() && (e.filePos >= 0 || writeCache(e)))
+		{
+			unlink		(e);
+			e.img		= QImage();
+			m_resident	-= e.bytes;
+			account		(handle, 0);
+		}
+		handle			= next;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Account
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief report the pixels of an entry to the memory ledger
+//! \details the cache key lets the ledger tell frames and dialogs that share these pixels from real copies
+//! \param[in] handle	image handle
+//! \param[in] bytes	pixel bytes in memory; 0 once the entry is spilled or freed
+// the cache key lets the ledger tell frames and dialogs that share these pixels from real copies
+void ImageStore::account(ImageHandle handle, qint64 bytes)
+{
+	qint64 key			= bytes ? m_entries[handle].img.cacheKey() : 0;
+	MemoryLedger::instance()->set(this, handle, MemoryLedger::StoredImages, bytes, QString("image %1").arg(handle), key);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Write disk cache
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief write an entry to the disk cache
+//! \details bands of rows are compressed in parallel and written back to back
+//! \param[in, out] e	resident entry
+//! \return		false if the cache could not be written; the image then stays in memory
+// bands of rows are compressed in parallel and written back to back
+bool ImageStore::writeCache(Entry &e)
+{
+	if (!m_cache)
+	{
+		m_cache		= new QTemporaryFile;
+		if (!m_cache->open())
+		{
+			delete m_cache;
+			m_cache	= 0;
+			return false;
+		}
+	}
+
+	QByteArray data;
+	compressImage	(e.img, e.bands, data);
+
+	qint64 pos		= allocate(data.size());
+	if (!m_cache->seek(pos) || m_cache->write(data) != data.size())
+	{
+		release		(pos, data.size());
+		return false;
+	}
+
+	e.file			= QString();
+	e.filePos		= pos;
+	e.fileLen		= data.size();
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Read disk cache
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief read an entry back from the disk cache
+//! \param[in, out] e	spilled entry
+//! \return		false if the cache could not be read
+bool ImageStore::readCache(Entry &e)
+{
+	QByteArray data;
+	if (!readBands(e, data))
+		return false;
+
+	QImage img		(e.width, e.height, (QImage::Format)e.format);
+	if (img.isNull())
+		return false;
+	img				.setColorTable(e.colors);
+
+	BandContext c;
+	c.src			= 0;
+	c.dst			= img.bits();
+	c.bpl			= img.bytesPerLine();
+	c.height		= e.height;
+	c.out			= 0;
+	c.data			= data.constData();
+	c.sizes			= e.bands.constData();
+	c.failed		= 0;
+	c.offsets		.resize(e.bands.size());
+
+	int offset		= 0;
+	for (int b = 0; b < e.bands.size(); b++)
+	{
+		c.offsets[b]	= offset;
+		offset			+= e.bands[b];
+	}
+	Parallel::forRange(e.bands.size(), expandBands, &c, 1);
+	if (c.failed)
+		return false;
+
+	e.img			= img;
+	return true;
+}
+
+//! \brief compressed bands of an entry from its disk copy
+//! \details the copy is in the disk cache or, for an image of a project, in the project file
+//! \param[in] e		entry with a disk copy
+//! \param[out] data	the bands back to back
+//! \return		false if there is no disk copy or it could not be read
+// the copy is in the disk cache or, for an image of a project, in the project file
+bool ImageStore::readBands(const Entry &e, QByteArray &data)
+{
+	if (e.filePos < 0)
+		return false;
+
+	if (e.file.isEmpty())
+	{
+		if (!m_cache || !m_cache->seek(e.filePos))
+			return false;
+		data		= m_cache->read(e.fileLen);
+	}
+	else
+	{
+		QFile file	(e.file);
+		if (!file.open(QIODevice::ReadOnly) || !file.seek(e.filePos))
+			return false;
+		data		= file.read(e.fileLen);
+	}
+	return data.size() == e.fileLen;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Disk cache space
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief reserve len bytes of the disk cache
+//! \details first fit in the holes left by freed images; otherwise the file grows
+//! \param[in] len	bytes needed
+//! \return		offset of the range
+// first fit in the holes left by freed images; otherwise the file grows
+qint64 ImageStore::allocate(qint64 len)
+{
+	m_cached		+= len;
+	for (int i = 0; i < m_holes.size(); i++)
+	{
+		if (m_holes[i].second < len)
+			continue;
+		qint64 pos			= m_holes[i].first;
+		m_holes[i].first	+= len;
+		m_holes[i].second	-= len;
+		if (m_holes[i].second == 0)
+			m_holes.removeAt(i);
+		return pos;
+	}
+
+	qint64 end		= m_cache->size();
+	if (!m_holes.isEmpty() && m_holes.last().first + m_holes.last().second == end)
+	{	// a hole at the end of the file only needs to grow
+		qint64 pos	= m_holes.last().first;
+		m_holes.removeLast();
+		return pos;
+	}
+	return end;
+}
+
+//! \brief give a range of the disk cache back
+//! \details holes are kept sorted and merged with their neighbours; the file is emptied when nothing is left in it
+//! \param[in] pos	offset of the range
+//! \param[in] len	its length
+// holes are kept sorted and merged with their neighbours; the file is emptied when nothing is left in it
+void ImageStore::release(qint64 pos, qint64 len)
+{
+	m_cached		-= len;
+	if (m_cached == 0)
+	{
+		m_holes		.clear();
+		m_cache		->resize(0);
+		return;
+	}
+
+	int i			= 0;
+	while (i < m_holes.size() && m_holes[i].first < pos)
+		i++;
+	m_holes.insert(i, qMakePair(pos, len));
+
+	if (i + 1 < m_holes.size() && m_holes[i].first + m_holes[i].second == m_holes[i + 1].first)
+	{
+		m_holes[i].second	+= m_holes[i + 1].second;
+		m_holes.removeAt(i + 1);
+	}
+	if (i > 0 && m_holes[i - 1].first + m_holes[i - 1].second == m_holes[i].first)
+	{
+		m_holes[i - 1].second	+= m_holes[i].second;
+		m_holes.removeAt(i);
+	}
+}
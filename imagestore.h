@@ -0,0 +1,138 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ImageStore
+//! \brief Reference counted home of every image in the session
+//!
+//! \file imagestore.h
+//! \brief Image store class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				IMAGESTORE_H
+#define				IMAGESTORE_H
+
+#include			<QImage>
+#include			<QHash>
+#include			<QList>
+#include			<QPair>
+#include			<QVector>
+#include			<QMutex>
+#include			"imagehash.h"
+
+class				QTemporaryFile;
+
+//! \brief stable id of an image in the store; 0 is no image
+typedef int			ImageHandle;
+
+// an image as compressed bands of rows, the way the store keeps it on disk
+struct StoredImage
+{
+	ImageHash		hash;			// content hash
+	int				width;			// geometry
+	int				height;
+	int				format;
+	QVector<QRgb>	colors;
+	QVector<int>	bands;			// compressed size of every band of rows, back to back in the file
+};
+
+// ImageStore class
+class ImageStore
+{
+public:
+	//! \brief the store shared by the whole application
+	static ImageStore*	instance		();
+
+	//! \brief add an image, or refer to the stored image with the same content; the caller owns one reference
+	ImageHandle		insert			(const QImage&);
+	//! \brief the image with the given content; 0 if there is none
+	ImageHandle		find			(const ImageHash&);
+	//! \brief content hash of the image; the key for caches of anything derived from it
+	ImageHash		hash			(ImageHandle);
+	//! \brief add a reference
+	void			ref				(ImageHandle);
+	//! \brief drop a reference; the image is freed with the last one
+	void			unref			(ImageHandle);
+	//! \brief the image, read back from the disk cache if it was spilled
+	QImage			image			(ImageHandle);
+	//! \brief size of the image without reading it back
+	QSize			size			(ImageHandle);
+	//! \brief is the image in memory
+	bool			isResident		(ImageHandle);
+	//! \brief the image as compressed bands; a disk copy is copied as it is, without expanding it
+	bool			compressed		(ImageHandle, StoredImage&, QByteArray&);
+	//! \brief add an image whose compressed bands are at pos in a file; nothing is read until image() is called
+	ImageHandle		insertStored	(const StoredImage&, const QString &file, qint64 pos);
+	//! \brief the disk copy of the image is now at pos in a file; the old copy is dropped
+	void			setStored		(ImageHandle, const StoredImage&, const QString &file, qint64 pos);
+
+	//! \brief bytes of pixels the store may keep in memory
+	void			setBudget		(qint64);
+	//! \brief bytes of pixels the store may keep in memory
+	qint64			budget			();
+	//! \brief bytes of pixels in memory
+	qint64			residentBytes	();
+	//! \brief bytes in the disk cache
+	qint64			cachedBytes		();
+	//! \brief number of live images
+	int				count			();
+
+private:
+	//! \brief Constructor
+					ImageStore		();
+
+	//! \brief one image
+	struct Entry
+	{
+		QImage			img;			// pixels; null while spilled
+		int				refs;			// references held by the application
+		ImageHash		hash;			// content hash
+		int				width;			// geometry to rebuild a spilled image
+		int				height;
+		int				format;
+		QVector<QRgb>	colors;
+		qint64			bytes;			// pixel bytes while resident
+		QString			file;			// file of the disk copy; empty for the disk cache
+		qint64			filePos;		// disk copy; -1 if there is none
+		qint64			fileLen;
+		QVector<int>	bands;			// compressed size of every band of rows on disk
+		ImageHandle		prev;			// neighbours in the LRU list of resident images
+		ImageHandle		next;
+	};
+
+	//! \brief put a resident entry at the recently used end
+	void			link			(ImageHandle, Entry&);
+	//! \brief take a resident entry out of the LRU list
+	void			unlink			(Entry&);
+	//! \brief spill least recently used images until under budget
+	void			enforceBudget	();
+	//! \brief report the pixels of an entry to the memory ledger
+	void			account			(ImageHandle, qint64 bytes);
+	//! \brief write an entry to the disk cache
+	bool			writeCache		(Entry&);
+	//! \brief read an entry back from the disk cache
+	bool			readCache		(Entry&);
+	//! \brief compressed bands of an entry from its disk copy
+	bool			readBands		(const Entry&, QByteArray&);
+	//! \brief reserve len bytes of the disk cache
+	qint64			allocate		(qint64 len);
+	//! \brief give a range of the disk cache back
+	void			release			(qint64 pos, qint64 len);
+
+	QMutex							m_mutex;		// the store is shared with worker threads
+	QHash<ImageHandle, Entry>		m_entries;		// every live image
+	QHash<ImageHash, ImageHandle>	m_byHash;		// content index; identical images share one entry
+	ImageHandle						m_nextHandle;	// next handle to hand out
+	ImageHandle						m_lruOldest;	// least recently used resident image
+	ImageHandle						m_lruNewest;	// most recently used resident image
+	qint64							m_budget;		// memory budget in bytes
+	qint64							m_resident;		// pixel bytes in memory
+	qint64							m_cached;		// bytes in the disk cache
+	QTemporaryFile					*m_cache;		// disk cache; created on first spill
+	QList< QPair<qint64, qint64> >	m_holes;		// free ranges of the disk cache (offset, length)
+};
+#endif
@@ -12,7 +12,12 @@
 //! \file ip.cpp
 //! \brief Image Processing class
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#include	<cstring>
+
 #include	"ip.h"
+#include	"fft.h"
+#include	"parallel.h"
+#include	"trace.h"
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Constructor
@@ -51,6 +56,7 @@ void IP::lookUpTable(int thresLevel)
 // process image based on funct
 void IP::processImg(IP_FUNCT funct, QImage &img)
 {
+	TRACE("IP::processImg");
 	int col;
 	int width 	= img.width();
 	int height	= img.height();
@@ -130,6 +136,7 @@ void IP::processImg(IP_FUNCT funct, QImage &img)
 //! \param[in]		thresLevel	threshold level
 void IP::prewittMask(QImage& img, QImage orig, int thresLevel)
 {
+	TRACE("IP::prewittMask");
 	// Prewitt operator:
 	//	Gx =	|	-1	0	1 	|
 	//			|	-1	0	1	|
@@ -194,6 +201,7 @@ void IP::prewittMask(QImage& img, QImage orig, int thresLevel)
 //! \param[in]		thresLevel	threshold level
 void IP::sobelMask(QImage& img, QImage orig, int thresLevel)
 {
+	TRACE("IP::sobelMask");
 	// Sobel operator:
 	//	Gx =	|	1	0	-1 	|
 	//			|	2	0	-2	|
@@ -258,6 +266,7 @@ void IP::sobelMask(QImage& img, QImage orig, int thresLevel)
 //! \param[in]		thresLevel	threshold level
 void IP::LoGMask(QImage& img, QImage orig, int thresLevel)
 {
+	TRACE("IP::LoGMask");
 	// LoG operator:
 	//	LoG =	|	0	0	1	0	0 	|
 	//			|	0	1	2	1	0	|
@@ -323,6 +332,804 @@ void IP::LoGMask(QImage& img, QImage orig, int thresLevel)
 	}
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Frequency domain helpers
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// padded coordinate to image coordinate; the first half of the padding repeats the
+// far edge and the second half the near edge, so the circular wrap stays continuous
+static inline int padIndex(int i, int size, int padded)
+{
+	if (i < size)
+		return i;
+	return (i - size) < (padded - size) / 2 ? size - 1 : 0;
+}
+
+// copy one channel (0 = blue, 1 = green, 2 = red, -1 = gray) into a padded plane
+static void toPlane(const QImage &img, int channel, int pw, int ph, float *plane)
+{
+	int width	= img.width();
+	int height	= img.height();
+
+	for (int y = 0; y < ph; y++)
+	{
+		const unsigned char *pixData	= img.scanLine(padIndex(y, height, ph));
+		float *row						= plane + y * pw;
+
+		for (int x = 0; x < pw; x++)
+		{
+			const unsigned char *p	= pixData + 4 * padIndex(x, width, pw);
+			if (channel < 0)
+				row[x]	= (float)(0.3 * p[2] + 0.59 * p[1] + 0.11 * p[0]);
+			else
+				row[x]	= p[channel];
+		}
+	}
+}
+
+// write the image area of a plane back into one channel, clamped to 0 - 255
+static void fromPlane(QImage &img, int channel, int pw, const float *plane)
+{
+	int width	= img.width();
+	int height	= img.height();
+
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char *pixData	= img.scanLine(y) + channel;
+		const float *row		= plane + y * pw;
+
+		for (int x = 0; x < width; x++)
+		{
+			float v		= row[x] + 0.5f;
+			*pixData	= v < 0.0f ? 0 : (v > 255.0f ? 255 : (unsigned char)v);
+			pixData		+= 4;
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Frequency domain filter
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief frequency domain filter
+//! \details every channel is padded to an FFT friendly size, transformed, multiplied by the transfer function and transformed back
+//! \param[in] funct	enum; filter type
+//! \param[in, out] img	address of the image to be process
+//! \param[in] cutoff	cutoff frequency in cycles per pixel (0 - 0.5)
+//! \param[in] order	order of the butterworth filter
+// every channel is padded to an FFT friendly size, transformed, multiplied by the transfer function and transformed back
+void IP::freqFilter(IP_FREQ funct, QImage &img, double cutoff, int order)
+{
+	TRACE("IP::freqFilter");
+	int width	= img.width();
+	int height	= img.height();
+	if (width == 0 || height == 0)
+		return;
+
+	int pw		= FFT::goodSize(width);
+	int ph		= FFT::goodSize(height);
+	int half	= pw / 2 + 1;
+
+	double d0	= cutoff > 1e-6 ? cutoff : 1e-6;
+
+	// transfer function is shared by the three channels
+	QVector<float> transfer(ph * half);
+	for (int v = 0; v < ph; v++)
+	{
+		double fv	= (v <= ph / 2 ? v : v - ph) / (double)ph;
+		for (int u = 0; u < half; u++)
+		{
+			double fu	= u / (double)pw;
+			double d	= sqrt(fu * fu + fv * fv);
+			double h	= 0.0;
+
+			switch (funct)
+			{
+				case IdealLow:
+				case IdealHigh:
+					h	= d <= d0 ? 1.0 : 0.0;
+				break;
+				case ButterLow:
+				case ButterHigh:
+					h	= 1.0 / (1.0 + pow(d / d0, 2.0 * order));
+				break;
+				case GaussLow:
+				case GaussHigh:
+					h	= exp(-(d * d) / (2.0 * d0 * d0));
+				break;
+			}
+			if (funct == IdealHigh || funct == ButterHigh || funct == GaussHigh)
+				h		= 1.0 - h;
+
+			transfer[v * half + u]	= (float)h;
+		}
+	}
+
+	QVector<float> plane(pw * ph);
+	QVector<FFTComplex> spec(ph * half);
+
+	for (int channel = 0; channel < 3; channel++)
+	{
+		toPlane				(img, channel, pw, ph, plane.data());
+		FFT::forward2D		(plane.data(), pw, ph, spec.data());
+
+		for (int i = 0; i < ph * half; i++)
+		{
+			spec[i].re		*= transfer[i];
+			spec[i].im		*= transfer[i];
+		}
+
+		FFT::inverse2D		(spec.data(), pw, ph, plane.data());
+		fromPlane			(img, channel, pw, plane.data());
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Spectrum
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief log magnitude spectrum of the gray image, centered
+//! \details log(1 + |F|) scaled to 0 - 255 with the zero frequency in the middle of the image
+//! \param[in, out] img	address of the image to be process
+// log(1 + |F|) scaled to 0 - 255 with the zero frequency in the middle of the image
+void IP::spectrum(QImage &img)
+{
+	TRACE("IP::spectrum");
+	int width	= img.width();
+	int height	= img.height();
+	if (width == 0 || height == 0)
+		return;
+
+	int pw		= FFT::goodSize(width);
+	int ph		= FFT::goodSize(height);
+	int half	= pw / 2 + 1;
+
+	QVector<float> plane(pw * ph);
+	QVector<FFTComplex> spec(ph * half);
+
+	toPlane			(img, -1, pw, ph, plane.data());
+	FFT::forward2D	(plane.data(), pw, ph, spec.data());
+
+	QVector<float> mag(ph * half);
+	float maxMag	= 0.0f;
+	for (int i = 0; i < ph * half; i++)
+	{
+		mag[i]		= log(1.0f + sqrt(spec[i].re * spec[i].re + spec[i].im * spec[i].im));
+		if (mag[i] > maxMag)
+			maxMag	= mag[i];
+	}
+	float scale		= maxMag > 0.0f ? 255.0f / maxMag : 0.0f;
+
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char *pixData	= img.scanLine(y);
+		int v					= ((y - height / 2) * ph / height + ph) % ph;
+
+		for (int x = 0; x < width; x++)
+		{	// the right half mirrors the left one: |F(u, v)| = |F(-u, -v)|
+			int u		= ((x - width / 2) * pw / width + pw) % pw;
+			int col		= u < half ? (int)(mag[v * half + u] * scale)
+								   : (int)(mag[((ph - v) % ph) * half + (pw - u)] * scale);
+
+			*pixData++	= col;
+			*pixData++	= col;
+			*pixData++	= col;
+			*pixData++;
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Convolution
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief convolution with a kw x kh kernel through the FFT
+//! \details the kernel is centered on its middle element; the padding holds replicated edges so the wrap around never mixes opposite borders
+//! \param[in, out] img	address of the image to be process
+//! \param[in] kernel	kw x kh weights, row major
+//! \param[in] kw		kernel width
+//! \param[in] kh		kernel height
+// the kernel is centered on its middle element; the padding holds replicated edges so the wrap around never mixes opposite borders
+void IP::convolve(QImage &img, const float *kernel, int kw, int kh)
+{
+	TRACE("IP::convolve");
+	int width	= img.width();
+	int height	= img.height();
+	if (width == 0 || height == 0 || kw <= 0 || kh <= 0)
+		return;
+
+	int pw		= FFT::goodSize(width + kw - 1);
+	int ph		= FFT::goodSize(height + kh - 1);
+	int half	= pw / 2 + 1;
+
+	// kernel wrapped so its center sits at the origin
+	QVector<float> plane(pw * ph, 0.0f);
+	for (int ky = 0; ky < kh; ky++)
+		for (int kx = 0; kx < kw; kx++)
+		{
+			int x	= (kx - kw / 2 + pw) % pw;
+			int y	= (ky - kh / 2 + ph) % ph;
+			plane[y * pw + x]	= kernel[ky * kw + kx];
+		}
+
+	QVector<FFTComplex> kspec(ph * half);
+	FFT::forward2D	(plane.data(), pw, ph, kspec.data());
+
+	QVector<FFTComplex> spec(ph * half);
+	for (int channel = 0; channel < 3; channel++)
+	{
+		toPlane				(img, channel, pw, ph, plane.data());
+		FFT::forward2D		(plane.data(), pw, ph, spec.data());
+
+		for (int i = 0; i < ph * half; i++)
+		{
+			float re		= spec[i].re * kspec[i].re - spec[i].im * kspec[i].im;
+			float im		= spec[i].re * kspec[i].im + spec[i].im * kspec[i].re;
+			spec[i].re		= re;
+			spec[i].im		= im;
+		}
+
+		FFT::inverse2D		(spec.data(), pw, ph, plane.data());
+		fromPlane			(img, channel, pw, plane.data());
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Gaussian blur
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief gaussian blur of any sigma
+//! \details the kernel reaches 3 sigma each way and is applied by convolve(), so a blur of tens of pixels
+//!	costs the same as a small one; a sigma below half a pixel leaves the image as it is
+//! \param[in, out] img	address of the image to be process
+//! \param[in] sigma	standard deviation in pixels
+// the kernel reaches 3 sigma each way and is applied through the FFT, so its size does not affect the cost
+void IP::gaussianBlur(QImage &img, double sigma)
+{
+	TRACE("IP::gaussianBlur");
+	if (sigma < 0.5)
+		return;
+
+	int radius	= (int)ceil(3.0 * sigma);
+	int size	= 2 * radius + 1;
+	QVector<float> kernel(size * size);
+	double sum	= 0.0;
+	for (int y = 0; y < size; y++)
+		for (int x = 0; x < size; x++)
+		{
+			double d2	= (x - radius) * (x - radius) + (y - radius) * (y - radius);
+			kernel[y * size + x]	= (float)exp(-d2 / (2.0 * sigma * sigma));
+			sum		+= kernel[y * size + x];
+		}
+	for (int i = 0; i < size * size; i++)
+		kernel[i]	= (float)(kernel[i] / sum);
+
+	convolve	(img, kernel.data(), size, size);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Edge preserving smoothing helpers
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// bilateral grid shared by the worker threads; a cell holds the blue, green and red sums and the weight
+struct BilateralGrid
+{
+	const QImage	*img;			// image being filtered; read only, so no worker detaches it
+	unsigned char	*bits;			// pixels written by the slice pass; detached before the workers start
+	int				bytesPerLine;	// stride of bits
+	const float		*lum;			// luminance of every pixel (range axis)
+	float			*src;			// grid read by the current pass
+	float			*dst;			// grid written by the current pass
+	const int		*firstRow;		// first image row that falls in every grid row
+	int				gw, gh, gd;		// grid size: x, y, range
+	double			sigmaS;			// spatial sampling rate (pixels per cell)
+	double			sigmaR;			// range sampling rate (intensity per cell)
+	int				axis;			// blur axis: 0 = x, 1 = y, 2 = range
+};
+
+static const int	GRID_PAD	= 1;	// empty cells around the grid so blur and slicing never leave it
+
+// splat the pixels of grid rows [begin, end); every grid row owns a band of image rows so no cell is shared
+static void gridSplat(void *p, int begin, int end)
+{
+	BilateralGrid *g	= (BilateralGrid*)p;
+	int width			= g->img->width();
+
+	for (int gy = begin; gy < end; gy++)
+	{
+		for (int y = g->firstRow[gy]; y < g->firstRow[gy + 1]; y++)
+		{
+			const unsigned char *pixData	= g->img->scanLine(y);
+			const float *lum				= g->lum + y * width;
+
+			for (int x = 0; x < width; x++)
+			{
+				int gx		= (int)(x / g->sigmaS + 0.5) + GRID_PAD;
+				int gz		= (int)(lum[x] / g->sigmaR + 0.5) + GRID_PAD;
+				float *cell	= g->dst + 4 * ((gy * g->gw + gx) * g->gd + gz);
+
+				cell[0]		+= pixData[0];
+				cell[1]		+= pixData[1];
+				cell[2]		+= pixData[2];
+				cell[3]		+= 1.0f;
+				pixData		+= 4;
+			}
+		}
+	}
+}
+
+// [1 2 1] blur of grid rows [begin, end) along g->axis
+static void gridBlur(void *p, int begin, int end)
+{
+	BilateralGrid *g	= (BilateralGrid*)p;
+	int step			= g->axis == 0 ? 4 * g->gd : (g->axis == 1 ? 4 * g->gd * g->gw : 4);
+
+	for (int gy = begin; gy < end; gy++)
+	{
+		for (int gx = 0; gx < g->gw; gx++)
+		{
+			for (int gz = 0; gz < g->gd; gz++)
+			{
+				int i				= 4 * ((gy * g->gw + gx) * g->gd + gz);
+				int pos				= g->axis == 0 ? gx : (g->axis == 1 ? gy : gz);
+				int size			= g->axis == 0 ? g->gw : (g->axis == 1 ? g->gh : g->gd);
+				const float *c		= g->src + i;
+				const float *prev	= pos > 0 ? c - step : 0;
+				const float *next	= pos < size - 1 ? c + step : 0;
+
+				for (int k = 0; k < 4; k++)
+					g->dst[i + k]	= 0.5f * c[k] + 0.25f * ((prev ? prev[k] : 0.0f) + (next ? next[k] : 0.0f));
+			}
+		}
+	}
+}
+
+// slice image rows [begin, end) out of the blurred grid with trilinear interpolation
+static void gridSlice(void *p, int begin, int end)
+{
+	BilateralGrid *g	= (BilateralGrid*)p;
+	int width			= g->img->width();
+
+	for (int y = begin; y < end; y++)
+	{
+		unsigned char *pixData	= g->bits + y * g->bytesPerLine;
+		const float *lum		= g->lum + y * width;
+
+		float fy		= (float)(y / g->sigmaS) + GRID_PAD;
+		int y0			= (int)fy;
+		float wy		= fy - y0;
+
+		for (int x = 0; x < width; x++)
+		{
+			float fx	= (float)(x / g->sigmaS) + GRID_PAD;
+			float fz	= (float)(lum[x] / g->sigmaR) + GRID_PAD;
+			int x0		= (int)fx;
+			int z0		= (int)fz;
+			float wx	= fx - x0;
+			float wz	= fz - z0;
+
+			float acc[4]	= {0.0f, 0.0f, 0.0f, 0.0f};
+			for (int dy = 0; dy < 2; dy++)
+				for (int dx = 0; dx < 2; dx++)
+					for (int dz = 0; dz < 2; dz++)
+					{
+						float w			= (dy ? wy : 1.0f - wy) * (dx ? wx : 1.0f - wx) * (dz ? wz : 1.0f - wz);
+						const float *c	= g->src + 4 * (((y0 + dy) * g->gw + x0 + dx) * g->gd + z0 + dz);
+						for (int k = 0; k < 4; k++)
+							acc[k]		+= w * c[k];
+					}
+
+			if (acc[3] > 0.0f)
+				for (int k = 0; k < 3; k++)
+				{
+					float v		= acc[k] / acc[3] + 0.5f;
+					pixData[k]	= v > 255.0f ? 255 : (unsigned char)v;
+				}
+			pixData		+= 4;
+		}
+	}
+}
+
+// box mean shared by the worker threads
+struct BoxMean
+{
+	const float		*src;			// input plane
+	float			*dst;			// output plane
+	float			*tmp;			// horizontal pass result
+	int				width;
+	int				height;
+	int				radius;
+};
+
+// horizontal running mean of rows [begin, end); the window is clipped at the border
+static void boxRows(void *p, int begin, int end)
+{
+	BoxMean *b			= (BoxMean*)p;
+	int w				= b->width;
+	int r				= b->radius;
+
+	for (int y = begin; y < end; y++)
+	{
+		const float *in	= b->src + y * w;
+		float *out		= b->tmp + y * w;
+
+		double sum		= 0.0;
+		for (int x = 0; x <= r && x < w; x++)
+			sum			+= in[x];
+
+		for (int x = 0; x < w; x++)
+		{
+			int lo		= x - r < 0 ? 0 : x - r;
+			int hi		= x + r >= w ? w - 1 : x + r;
+			out[x]		= (float)(sum / (hi - lo + 1));
+
+			if (x + r + 1 < w)	sum	+= in[x + r + 1];
+			if (x - r >= 0)		sum	-= in[x - r];
+		}
+	}
+}
+
+// vertical running mean of columns [begin, end); walks down the rows so memory access stays sequential
+static void boxColumns(void *p, int begin, int end)
+{
+	BoxMean *b			= (BoxMean*)p;
+	int w				= b->width;
+	int h				= b->height;
+	int r				= b->radius;
+
+	QVector<double> sum(end - begin, 0.0);
+	for (int y = 0; y <= r && y < h; y++)
+		for (int x = begin; x < end; x++)
+			sum[x - begin]	+= b->tmp[y * w + x];
+
+	for (int y = 0; y < h; y++)
+	{
+		int lo			= y - r < 0 ? 0 : y - r;
+		int hi			= y + r >= h ? h - 1 : y + r;
+		double inv		= 1.0 / (hi - lo + 1);
+		const float *add	= y + r + 1 < h ? b->tmp + (y + r + 1) * w : 0;
+		const float *sub	= y - r >= 0 ? b->tmp + (y - r) * w : 0;
+
+		for (int x = begin; x < end; x++)
+		{
+			b->dst[y * w + x]	= (float)(sum[x - begin] * inv);
+			if (add)	sum[x - begin]	+= add[x];
+			if (sub)	sum[x - begin]	-= sub[x];
+		}
+	}
+}
+
+// mean over a (2r+1) x (2r+1) window in O(1) per pixel
+static void boxMean(const float *src, float *dst, float *tmp, int width, int height, int radius)
+{
+	BoxMean b;
+	b.src			= src;
+	b.dst			= dst;
+	b.tmp			= tmp;
+	b.width			= width;
+	b.height		= height;
+	b.radius		= radius;
+
+	Parallel::forRange(height, boxRows, &b, 16);
+	Parallel::forRange(width, boxColumns, &b, 64);
+}
+
+// luminance of every pixel
+static void lumPlane(const QImage &img, float *plane)
+{
+	int width	= img.width();
+	int height	= img.height();
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *pixData	= img.scanLine(y);
+		for (int x = 0; x < width; x++, pixData += 4)
+			plane[y * width + x]	= (float)(0.3 * pixData[2] + 0.59 * pixData[1] + 0.11 * pixData[0]);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Bilateral filter
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief edge preserving smoothing (bilateral grid)
+//! \details pixels are splatted into a grid downsampled by sigmaS in space and sigmaR in luminance,
+//!	the grid is blurred along each axis and the result is sliced back with trilinear interpolation.
+//!	Cost per pixel does not depend on the filter size.
+//! \param[in, out] img	address of the image to be process
+//! \param[in] sigmaS	spatial extent in pixels
+//! \param[in] sigmaR	range extent in intensity levels (0 - 255)
+// cost per pixel does not depend on the filter size
+void IP::bilateral(QImage &img, double sigmaS, double sigmaR)
+{
+	TRACE("IP::bilateral");
+	int width	= img.width();
+	int height	= img.height();
+	if (width == 0 || height == 0)
+		return;
+
+	if (sigmaS < 1.0)	sigmaS	= 1.0;
+	if (sigmaR < 1.0)	sigmaR	= 1.0;
+
+	BilateralGrid g;
+	g.bits			= img.bits();	// detach here, once; the image may share its pixels with the caller's copies
+	g.bytesPerLine	= img.bytesPerLine();
+	g.img			= &img;
+
+	QVector<float> lum(width * height);
+	lumPlane		(img, lum.data());
+
+	g.lum			= lum.data();
+	g.sigmaS		= sigmaS;
+	g.sigmaR		= sigmaR;
+	g.gw			= (int)((width - 1) / sigmaS) + 1 + 2 * GRID_PAD;
+	g.gh			= (int)((height - 1) / sigmaS) + 1 + 2 * GRID_PAD;
+	g.gd			= (int)(255.0 / sigmaR) + 1 + 2 * GRID_PAD;
+
+	// image rows owned by every grid row
+	QVector<int> firstRow(g.gh + 1, height);
+	for (int y = height - 1; y >= 0; y--)
+		firstRow[(int)(y / sigmaS + 0.5) + GRID_PAD]	= y;
+	for (int gy = g.gh - 1; gy >= 0; gy--)
+		if (firstRow[gy] > firstRow[gy + 1])
+			firstRow[gy]	= firstRow[gy + 1];
+	g.firstRow		= firstRow.data();
+
+	QVector<float> grid(4 * g.gw * g.gh * g.gd, 0.0f);
+	QVector<float> temp(grid.size());
+
+	g.dst			= grid.data();
+	Parallel::forRange(g.gh, gridSplat, &g, 1);
+
+	// separable blur; ping-pong between the two grids
+	g.src			= grid.data();
+	g.dst			= temp.data();
+	for (g.axis = 0; g.axis < 3; g.axis++)
+	{
+		Parallel::forRange(g.gh, gridBlur, &g, 1);
+		float *t	= g.src;
+		g.src		= g.dst;
+		g.dst		= t;
+	}
+
+	Parallel::forRange(height, gridSlice, &g, 16);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Guided filter
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief edge preserving smoothing (guided filter, He et al.)
+//! \details the luminance is the guide; every channel is fitted as a local linear function of it.
+//!	Built only from box means, so cost per pixel does not depend on the radius.
+//! \param[in, out] img	address of the image to be process
+//! \param[in] radius	window radius in pixels
+//! \param[in] eps		regularization on 0 - 1 intensities; larger smooths across weaker edges
+// built only from box means, so cost per pixel does not depend on the radius
+void IP::guidedFilter(QImage &img, int radius, double eps)
+{
+	TRACE("IP::guidedFilter");
+	int width	= img.width();
+	int height	= img.height();
+	if (width == 0 || height == 0)
+		return;
+
+	if (radius < 1)
+		radius	= 1;
+
+	int n		= width * height;
+	float e		= (float)(eps * 255.0 * 255.0);
+
+	QVector<float> guide(n), meanI(n), varI(n), tmp(n);
+	QVector<float> chan(n), meanP(n), prod(n), a(n), b(n);
+
+	lumPlane		(img, guide.data());
+	boxMean			(guide.data(), meanI.data(), tmp.data(), width, height, radius);
+	for (int i = 0; i < n; i++)
+		prod[i]		= guide[i] * guide[i];
+	boxMean			(prod.data(), varI.data(), tmp.data(), width, height, radius);
+	for (int i = 0; i < n; i++)
+		varI[i]		-= meanI[i] * meanI[i];
+
+	for (int channel = 0; channel < 3; channel++)
+	{
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned char *pixData	= img.scanLine(y) + channel;
+			for (int x = 0; x < width; x++, pixData += 4)
+				chan[y * width + x]	= *pixData;
+		}
+
+		boxMean		(chan.data(), meanP.data(), tmp.data(), width, height, radius);
+		for (int i = 0; i < n; i++)
+			prod[i]	= guide[i] * chan[i];
+		boxMean		(prod.data(), a.data(), tmp.data(), width, height, radius);
+
+		// a = cov(I, p) / (var(I) + eps); b = mean(p) - a * mean(I)
+		for (int i = 0; i < n; i++)
+		{
+			a[i]	= (a[i] - meanI[i] * meanP[i]) / (varI[i] + e);
+			b[i]	= meanP[i] - a[i] * meanI[i];
+		}
+
+		boxMean		(a.data(), chan.data(), tmp.data(), width, height, radius);
+		boxMean		(b.data(), meanP.data(), tmp.data(), width, height, radius);
+
+		for (int y = 0; y < height; y++)
+		{
+			unsigned char *pixData	= img.scanLine(y) + channel;
+			for (int x = 0; x < width; x++, pixData += 4)
+			{
+				int i		= y * width + x;
+				float v		= chan[i] * guide[i] + meanP[i] + 0.5f;
+				*pixData	= v < 0.0f ? 0 : (v > 255.0f ? 255 : (unsigned char)v);
+			}
+		}
+	}
+}
+
+static const double	EDT_INF		= 1e20;		// squared distance of a line with no feature
+
+// distance transform shared by the worker threads
+struct DistancePass
+{
+	double			*sq;			// squared distances; input and output of every pass
+	float			*dist;			// final distances, written by the column pass
+	int				*nearest;		// row pass: feature column; column pass: feature index (may be 0)
+	int				width;
+	int				height;
+};
+
+// 1D squared distance transform of f (Felzenszwalb & Huttenlocher lower envelope of parabolas)
+// d[q] = min over p of (q - p)^2 + f[p]; arg[q] is the minimizing p
+static void envelope1D(const double *f, int n, double *d, int *arg, int *v, double *z)
+{
+	int k		= 0;
+	v[0]		= 0;
+	z[0]		= -EDT_INF;
+	z[1]		= EDT_INF;
+
+	for (int q = 1; q < n; q++)
+	{	// intersection of the parabola at q with the rightmost one in the envelope
+		double s	= ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+		while (s <= z[k])
+		{
+			k--;
+			s		= ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+		}
+		k++;
+		v[k]		= q;
+		z[k]		= s;
+		z[k+1]		= EDT_INF;
+	}
+
+	k			= 0;
+	for (int q = 0; q < n; q++)
+	{
+		while (z[k+1] < q)
+			k++;
+		double dq	= q - v[k];
+		d[q]		= dq * dq + f[v[k]];
+		arg[q]		= v[k];
+	}
+}
+
+// transform rows [begin, end) in place; nearest receives the feature column
+static void distanceRows(void *p, int begin, int end)
+{
+	DistancePass *c		= (DistancePass*)p;
+	int n				= c->width;
+
+	QVector<double> f(n), z(n + 1);
+	QVector<int> v(n), arg(n);
+
+	for (int y = begin; y < end; y++)
+	{
+		double *row		= c->sq + y * n;
+		memcpy			(f.data(), row, n * sizeof(double));
+		envelope1D		(f.data(), n, row, arg.data(), v.data(), z.data());
+
+		if (c->nearest)
+			memcpy		(c->nearest + y * n, arg.data(), n * sizeof(int));
+	}
+}
+
+// transform columns [begin, end); nearest turns into the feature index y * width + x
+static void distanceColumns(void *p, int begin, int end)
+{
+	DistancePass *c		= (DistancePass*)p;
+	int w				= c->width;
+	int n				= c->height;
+
+	QVector<double> f(n), d(n), z(n + 1);
+	QVector<int> v(n), arg(n), col(n);
+
+	for (int x = begin; x < end; x++)
+	{
+		for (int y = 0; y < n; y++)
+			f[y]		= c->sq[y * w + x];
+		envelope1D		(f.data(), n, d.data(), arg.data(), v.data(), z.data());
+
+		if (c->nearest)
+		{	// the row pass left the feature column of every pixel; pick it up from the chosen row
+			for (int y = 0; y < n; y++)
+				col[y]	= c->nearest[y * w + x];
+			for (int y = 0; y < n; y++)
+				c->nearest[y * w + x]	= d[y] < 0.5 * EDT_INF ? arg[y] * w + col[arg[y]] : -1;
+		}
+		for (int y = 0; y < n; y++)
+			c->dist[y * w + x]	= d[y] < 0.5 * EDT_INF ? (float)sqrt(d[y]) : -1.0f;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Distance field
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief exact euclidean distance to the nearest feature pixel
+//! \details Felzenszwalb & Huttenlocher: a 1D lower envelope pass along every row followed by one along
+//!	every column, linear in the number of pixels. Rows (then columns) are spread over the threads.
+//! \param[in] img			source image; features are pixels whose gray level is above level
+//! \param[in] level		feature threshold (0 - 255)
+//! \param[in] inside		measure the distance to the nearest non feature pixel instead
+//! \param[out] dist		distance of every pixel (row major); -1 when there is no feature at all
+//! \param[out] nearest		optional; index (y * width + x) of the nearest feature, -1 when there is none
+// a 1D lower envelope pass along every row followed by one along every column; linear in the number of pixels
+void IP::distanceField(const QImage &img, int level, bool inside, QVector<float> &dist, QVector<int> *nearest)
+{
+	TRACE("IP::distanceField");
+	int width	= img.width();
+	int height	= img.height();
+	int n		= width * height;
+
+	dist.resize		(n);
+	if (nearest)
+		nearest		->resize(n);
+	if (n == 0)
+		return;
+
+	QVector<double> sq(n);
+	lumPlane		(img, dist.data());
+	for (int i = 0; i < n; i++)
+		sq[i]		= (dist[i] > level) != inside ? 0.0 : EDT_INF;
+
+	DistancePass c;
+	c.sq			= sq.data();
+	c.dist			= dist.data();
+	c.nearest		= nearest ? nearest->data() : 0;
+	c.width			= width;
+	c.height		= height;
+
+	Parallel::forRange(height, distanceRows, &c, 8);
+	Parallel::forRange(width, distanceColumns, &c, 8);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Distance transform
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief distance field of the image shown as gray levels
+//! \details the largest distance maps to white; features (distance 0) are black
+//! \param[in, out] img	address of the image to be process
+//! \param[in] level	feature threshold (0 - 255)
+//! \param[in] inside	measure the distance to the nearest non feature pixel instead
+// the largest distance maps to white; features (distance 0) are black
+void IP::distanceTransform(QImage &img, int level, bool inside)
+{
+	TRACE("IP::distanceTransform");
+	QVector<float> dist;
+	distanceField	(img, level, inside, dist);
+
+	float maxDist	= 0.0f;
+	for (int i = 0; i < dist.size(); i++)
+		maxDist		= qMax(maxDist, dist[i]);
+	float scale		= maxDist > 0.0f ? 255.0f / maxDist : 0.0f;
+
+	int width		= img.width();
+	for (int y = 0; y < img.height(); y++)
+	{
+		unsigned char *pixData	= img.scanLine(y);
+		for (int x = 0; x < width; x++, pixData += 4)
+		{
+			float d		= dist[y * width + x];
+			int v		= d < 0.0f ? 0 : (int)(d * scale + 0.5f);
+			pixData[0]	= v;
+			pixData[1]	= v;
+			pixData[2]	= v;
+		}
+	}
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // gray image
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
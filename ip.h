@@ -17,6 +17,7 @@
 #define         	IP_H
 
 #include			<QImage>
+#include			<QVector>
 #include			<cmath>
 
 // IP class
@@ -25,6 +26,8 @@ class IP
 public:
 	//! \brief enum for IP class
 	enum		IP_FUNCT	{Red, Green, Blue, Gray, AllThres, IndThres};
+	//! \brief enum for frequency domain filters
+	enum		IP_FREQ		{IdealLow, ButterLow, GaussLow, IdealHigh, ButterHigh, GaussHigh};
 	//! \brief Constructor
 				IP		();
 	//! \brief look up table for thresholding
@@ -37,6 +40,22 @@ public:
 	void		sobelMask	(QImage&, QImage, int);
 	//! \brief edge detection (laplacian of gaussian mask)
 	void		LoGMask		(QImage&, QImage, int);
+	//! \brief frequency domain filter; cutoff in cycles per pixel (0 - 0.5)
+	void		freqFilter	(IP_FREQ, QImage&, double, int order = 2);
+	//! \brief log magnitude spectrum of the gray image, centered
+	void		spectrum	(QImage&);
+	//! \brief convolution with a kw x kh kernel through the FFT
+	void		convolve	(QImage&, const float*, int, int);
+	//! \brief gaussian blur of any sigma (pixels); the cost does not grow with sigma
+	void		gaussianBlur	(QImage&, double);
+	//! \brief edge preserving smoothing (bilateral grid)
+	void		bilateral	(QImage&, double, double);
+	//! \brief edge preserving smoothing (guided filter)
+	void		guidedFilter	(QImage&, int, double);
+	//! \brief exact euclidean distance to the nearest feature; optional nearest feature index
+	void		distanceField	(const QImage&, int, bool, QVector<float>&, QVector<int> *nearest = 0);
+	//! \brief distance field of the image shown as gray levels
+	void		distanceTransform	(QImage&, int, bool);
 
 private:
 	//! \brief gray image
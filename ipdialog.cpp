@@ -13,6 +13,7 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 #include 			"ipdialog.h"
+#include			"memoryledger.h"
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // CONSTRUCTOR
@@ -23,6 +24,7 @@ IPDialog::IPDialog(QWidget *p, Qt::WindowFlags f)
 {
 	// initialize image processing class
 	m_ip			= new IP();
+	m_hasStats		= false;
 
 	// create display layout
 	QGridLayout *dispLay	= new QGridLayout;
@@ -60,6 +62,22 @@ IPDialog::IPDialog(QWidget *p, Qt::WindowFlags f)
 	m_edgePrewitt	= new QRadioButton(tr("Prewitt"));
 	m_edgeSobel		= new QRadioButton(tr("Sobel"));
 	m_edgeLoG		= new QRadioButton(tr("LoG"));
+	m_freqIdealLow	= new QRadioButton(tr("Ideal LP"));
+	m_freqButterLow	= new QRadioButton(tr("Butterworth LP"));
+	m_freqGaussLow	= new QRadioButton(tr("Gaussian LP"));
+	m_freqIdealHigh	= new QRadioButton(tr("Ideal HP"));
+	m_freqButterHigh	= new QRadioButton(tr("Butterworth HP"));
+	m_freqGaussHigh	= new QRadioButton(tr("Gaussian HP"));
+	m_freqSpectrum	= new QRadioButton(tr("Spectrum"));
+	m_freqBlur		= new QRadioButton(tr("Gaussian blur"));
+	m_smoothBilateral	= new QRadioButton(tr("Bilateral"));
+	m_smoothGuided	= new QRadioButton(tr("Guided"));
+	m_region4		= new QRadioButton(tr("4-connected"));
+	m_region8		= new QRadioButton(tr("8-connected"));
+	m_houghLines	= new QRadioButton(tr("Lines"));
+	m_houghCircles	= new QRadioButton(tr("Circles"));
+	m_distOutside	= new QRadioButton(tr("To features"));
+	m_distInside	= new QRadioButton(tr("Inside features"));
 
 	// dynamic layout depends on function selected
 	m_optLay		= new QGridLayout;
@@ -106,6 +124,22 @@ IPDialog::IPDialog(QWidget *p, Qt::WindowFlags f)
 	connect(m_edgePrewitt,	SIGNAL(released()),			this, 			SLOT(processEdge()));
 	connect(m_edgeSobel,	SIGNAL(released()),			this, 			SLOT(processEdge()));
 	connect(m_edgeLoG,		SIGNAL(released()),			this, 			SLOT(processEdge()));
+	connect(m_freqIdealLow,	SIGNAL(released()),			this, 			SLOT(processFrequency()));
+	connect(m_freqButterLow,	SIGNAL(released()),		this, 			SLOT(processFrequency()));
+	connect(m_freqGaussLow,	SIGNAL(released()),			this, 			SLOT(processFrequency()));
+	connect(m_freqIdealHigh,	SIGNAL(released()),		this, 			SLOT(processFrequency()));
+	connect(m_freqButterHigh,	SIGNAL(released()),		this, 			SLOT(processFrequency()));
+	connect(m_freqGaussHigh,	SIGNAL(released()),		this, 			SLOT(processFrequency()));
+	connect(m_freqSpectrum,	SIGNAL(released()),			this, 			SLOT(processFrequency()));
+	connect(m_freqBlur,		SIGNAL(released()),			this, 			SLOT(processFrequency()));
+	connect(m_smoothBilateral,	SIGNAL(released()),		this, 			SLOT(processSmooth()));
+	connect(m_smoothGuided,	SIGNAL(released()),			this, 			SLOT(processSmooth()));
+	connect(m_region4,		SIGNAL(released()),			this, 			SLOT(processRegions()));
+	connect(m_region8,		SIGNAL(released()),			this, 			SLOT(processRegions()));
+	connect(m_houghLines,	SIGNAL(released()),			this, 			SLOT(processHough()));
+	connect(m_houghCircles,	SIGNAL(released()),			this, 			SLOT(processHough()));
+	connect(m_distOutside,	SIGNAL(released()),			this, 			SLOT(processDistance()));
+	connect(m_distInside,	SIGNAL(released()),			this, 			SLOT(processDistance()));
 	connect(m_butOk,		SIGNAL(clicked()),			m_signalMap, 	SLOT(map()));
 	connect(m_butCancel,	SIGNAL(clicked()),			m_signalMap, 	SLOT(map()));
 	connect(m_butApply,		SIGNAL(clicked()),			m_signalMap, 	SLOT(map()));
@@ -124,6 +158,7 @@ void IPDialog::setup(IP_Function f, QImage img)
 	m_origImg			= img.scaled(128, 128,  Qt::KeepAspectRatio);	// for display purpose; show original
 	m_resultImg			= img.scaled(128, 128,  Qt::KeepAspectRatio);	// for display purpose; show result
 	m_currentFuct		= f;											// current processing function
+	accountImages		();
 
 	clearOptLay						();									// clear IP options layout
 	m_dispResult		->setChecked(true);
@@ -138,7 +173,7 @@ void IPDialog::setup(IP_Function f, QImage img)
 		case THRESHOLD:
 			m_boxOpt->setTitle(tr("Threshold"));
 			setupThres();
-			m_ip	->lookUpTable(128);									// default threshold level is 128
+			m_ip	->lookUpTable(m_thresSpin->value());				// default threshold level is the mean gray level
 			m_ip	->processImg(IP::IndThres, m_resultImg);			// default is threshold individual band
 			break;
 		case EDGE:
@@ -146,6 +181,34 @@ void IPDialog::setup(IP_Function f, QImage img)
 			setupEdge();
 			m_ip	->prewittMask(m_resultImg, m_origImg, 128);			// default is prewitt mask with threshold level = 128
 			break;
+		case FREQUENCY:
+			m_boxOpt->setTitle(tr("Frequency filter"));
+			setupFreq();
+			applyFreq(m_resultImg);										// default is butterworth low pass
+			break;
+		case SMOOTH:
+			m_boxOpt->setTitle(tr("Edge preserving smoothing"));
+			setupSmooth();
+			applySmooth(m_resultImg);									// default is bilateral
+			break;
+		case REGIONS:
+		{
+			m_boxOpt->setTitle(tr("Connected regions"));
+			setupRegions();
+			QVector<RegionInfo> regions;
+			applyRegions(m_resultImg, regions);							// default is 8 connectivity
+		}
+			break;
+		case HOUGH:
+			m_boxOpt->setTitle(tr("Hough transform"));
+			setupHough();
+			processHough();												// default is lines
+			break;
+		case DISTANCE:
+			m_boxOpt->setTitle(tr("Distance transform"));
+			setupDistance();
+			m_ip	->distanceTransform(m_resultImg, 128, false);		// default is distance to features above 128
+			break;
 		default:
 			break;
 	}
@@ -159,6 +222,9 @@ void IPDialog::setup(IP_Function f, QImage img)
 //! \return	processed image
 QImage IPDialog::retrieveProcImg()
 {
+	m_report			= QString();
+	m_overlay			.clear();
+
 	if (m_currentFuct == COLOR)
 	{
 		if (m_colorRed		->isChecked())			// Red channel
@@ -191,10 +257,192 @@ QImage IPDialog::retrieveProcImg()
 		else if (m_edgeLoG	->isChecked())						// log edge detection
 			m_ip				->LoGMask(m_retProcImg, refImg, thresVal);
 	}
+	else if (m_currentFuct == FREQUENCY)
+		applyFreq				(m_retProcImg);
+	else if (m_currentFuct == SMOOTH)
+		applySmooth				(m_retProcImg);
+	else if (m_currentFuct == REGIONS)
+	{	// the region table goes to the log
+		QVector<RegionInfo> regions;
+		int count				= applyRegions(m_retProcImg, regions);
+
+		m_report				= tr("%1 regions (%2-connected, level %3)\n")
+									.arg(count).arg(m_region4->isChecked() ? 4 : 8).arg(m_thresSpin->value());
+		m_report				+= tr("id\tarea\tbox (x, y, w, h)\tcentroid\tmean\n");
+
+		int shown				= qMin(count, 100);		// keep the log readable
+		for (int i = 0; i < shown; i++)
+		{
+			const RegionInfo &r	= regions[i];
+			m_report			+= QString("%1\t%2\t%3, %4, %5, %6\t%7, %8\t%9\n")
+									.arg(i + 1).arg(r.area)
+									.arg(r.box.x()).arg(r.box.y()).arg(r.box.width()).arg(r.box.height())
+									.arg(r.cx, 0, 'f', 1).arg(r.cy, 0, 'f', 1).arg(r.mean, 0, 'f', 1);
+		}
+		if (count > shown)
+			m_report			+= tr("... %1 more\n").arg(count - shown);
+	}
+	else if (m_currentFuct == HOUGH)
+	{	// the image is left alone; results are drawn over it
+		QVector<HoughLine> lines;
+		QVector<HoughCircle> circles;
+		m_overlay				= applyHough(m_retProcImg, lines, circles);
+
+		for (int i = 0; i < lines.size(); i++)
+			m_report			+= tr("line %1: rho %2, theta %3 deg, %4 votes\n").arg(i + 1)
+									.arg(lines[i].rho, 0, 'f', 1).arg(lines[i].theta * 180.0 / 3.14159265358979, 0, 'f', 1).arg(lines[i].votes);
+		for (int i = 0; i < circles.size(); i++)
+			m_report			+= tr("circle %1: center (%2, %3), radius %4, %5 votes\n").arg(i + 1)
+									.arg(circles[i].cx, 0, 'f', 1).arg(circles[i].cy, 0, 'f', 1).arg(circles[i].r, 0, 'f', 1).arg(circles[i].votes);
+		if (lines.isEmpty() && circles.isEmpty())
+			m_report			= tr("Hough transform: nothing found\n");
+	}
+	else if (m_currentFuct == DISTANCE)
+		m_ip					->distanceTransform(m_retProcImg, m_thresSpin->value(), m_distInside->isChecked());
 
+	accountImages		();		// processing detached the result from the active image
 	return m_retProcImg;
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Account images
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief report the images of the dialog to the memory ledger
+//! \details the full size image shares the pixels of the active image until it is processed; the previews are
+//!	always copies
+// the full size image shares the pixels of the active image until it is processed
+void IPDialog::accountImages()
+{
+	MemoryLedger *ledger	= MemoryLedger::instance();
+	ledger				->set(this, 0, MemoryLedger::Dialogs, m_retProcImg.numBytes(), tr("IP dialog: image"), m_retProcImg.cacheKey());
+	ledger				->set(this, 1, MemoryLedger::Dialogs, m_origImg.numBytes(), tr("IP dialog: original preview"));
+	ledger				->set(this, 2, MemoryLedger::Dialogs, m_resultImg.numBytes(), tr("IP dialog: result preview"));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Statistics of the image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief cached statistics of the image given to setup()/imageChanged()
+//! \details the threshold options start at the mean gray level and show the gray range without scanning the image again
+//! \param[in] stats	statistics kept on the image record; 0 if unknown
+void IPDialog::setStatistics(const ImageStatistics *stats)
+{
+	m_hasStats			= stats != 0;
+	if (m_hasStats)
+		m_stats			= *stats;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Report of the last retrieved image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief text report of the last retrieved image
+//! \return	measurements made by retrieveProcImg(); empty if the function has none
+QString IPDialog::report()
+{
+	return m_report;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Operation of the last retrieved image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief name of the current function with the chosen options
+//! \details the title of the option box, the checked option and the threshold level when it is shown
+//! \return	e.g. "Edge detection Sobel 128"
+// the title of the option box, the checked option and the threshold level when it is shown
+QString IPDialog::operation()
+{
+	QString op			= m_boxOpt->title();
+
+	QList<QRadioButton*> options	= m_boxOpt->findChildren<QRadioButton*>();
+	for (int i = 0; i < options.size(); i++)
+		if (!options[i]->isHidden() && options[i]->isChecked())
+			op			+= " " + options[i]->text().remove('&');
+
+	if (!m_thresSpin	->isHidden())
+		op				+= QString(" %1").arg(m_thresSpin->value());
+
+	return op;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Parameters of the last retrieved image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief parameters of the current function
+//! \details Operation::run() with these parameters on the full size image gives what retrieveProcImg() gives
+//! \return	the operation; kind None for the hough transform, which draws over the image instead
+// Operation::run() with these parameters on the full size image gives what retrieveProcImg() gives
+OpParams IPDialog::params()
+{
+	OpParams p;
+	QMap<QString, double> &v	= p.values;
+
+	switch (m_currentFuct)
+	{
+		case COLOR:
+			p.kind				= Operation::Color;
+			v["channel"]		= m_colorRed->isChecked() ? IP::Red : m_colorGreen->isChecked() ? IP::Green
+								: m_colorBlue->isChecked() ? IP::Blue : IP::Gray;
+			break;
+		case THRESHOLD:
+			p.kind				= Operation::Threshold;
+			v["level"]			= m_thresSpin->value();
+			v["all"]			= m_thresAll->isChecked();
+			break;
+		case EDGE:
+			p.kind				= Operation::Edge;
+			v["mask"]			= m_edgePrewitt->isChecked() ? 0 : m_edgeSobel->isChecked() ? 1 : 2;
+			v["level"]			= m_thresSpin->value();
+			break;
+		case FREQUENCY:
+			p.kind				= Operation::Frequency;
+			v["filter"]			= m_freqIdealLow->isChecked() ? IP::IdealLow : m_freqButterLow->isChecked() ? IP::ButterLow
+								: m_freqGaussLow->isChecked() ? IP::GaussLow : m_freqIdealHigh->isChecked() ? IP::IdealHigh
+								: m_freqButterHigh->isChecked() ? IP::ButterHigh : m_freqGaussHigh->isChecked() ? IP::GaussHigh
+								: m_freqBlur->isChecked() ? 7 : 6;
+			v["level"]			= m_thresSpin->value();
+			break;
+		case SMOOTH:
+			p.kind				= Operation::Smooth;
+			v["method"]			= m_smoothBilateral->isChecked() ? 0 : 1;
+			v["level"]			= m_thresSpin->value();
+			break;
+		case REGIONS:
+			p.kind				= Operation::Regions;
+			v["connectivity"]	= m_region4->isChecked() ? 4 : 8;
+			v["level"]			= m_thresSpin->value();
+			break;
+		case DISTANCE:
+			p.kind				= Operation::Distance;
+			v["level"]			= m_thresSpin->value();
+			v["inside"]			= m_distInside->isChecked();
+			break;
+		default:
+			break;
+	}
+
+	return p;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Does the current function draw over the active image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the current function draws over the active image instead of creating a new one
+//! \return	true if the result is overlay()
+bool IPDialog::isOverlay()
+{
+	return m_currentFuct == HOUGH;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Overlay of the last retrieved image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief segments found by the last retrieveProcImg()
+//! \return	segments in image coordinates
+QVector<QLineF> IPDialog::overlay()
+{
+	return m_overlay;
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Notify this dialog box that the active image has changed
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -205,6 +453,7 @@ void IPDialog::imageChanged(QImage img)
 	m_retProcImg		= img;
 	m_origImg			= img.scaled(128, 128,  Qt::KeepAspectRatio);
 	m_resultImg			= img.scaled(128, 128,  Qt::KeepAspectRatio);
+	accountImages		();
 
 	// reprocess with the new image (same parameters)
 	switch(m_currentFuct)
@@ -218,6 +467,21 @@ void IPDialog::imageChanged(QImage img)
 		case EDGE:
 			processEdge();
 			break;
+		case FREQUENCY:
+			processFrequency();
+			break;
+		case SMOOTH:
+			processSmooth();
+			break;
+		case REGIONS:
+			processRegions();
+			break;
+		case HOUGH:
+			processHough();
+			break;
+		case DISTANCE:
+			processDistance();
+			break;
 		default:
 			break;
 	}
@@ -243,6 +507,16 @@ void IPDialog::sliderChanged(int num)
 		processThreshold();
 	else if (m_currentFuct == EDGE)
 		processEdge();
+	else if (m_currentFuct == FREQUENCY)
+		processFrequency();
+	else if (m_currentFuct == SMOOTH)
+		processSmooth();
+	else if (m_currentFuct == REGIONS)
+		processRegions();
+	else if (m_currentFuct == HOUGH)
+		processHough();
+	else if (m_currentFuct == DISTANCE)
+		processDistance();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -259,6 +533,16 @@ void IPDialog::spinChanged(int num)
 		processThreshold();
 	else if (m_currentFuct == EDGE)
 		processEdge();
+	else if (m_currentFuct == FREQUENCY)
+		processFrequency();
+	else if (m_currentFuct == SMOOTH)
+		processSmooth();
+	else if (m_currentFuct == REGIONS)
+		processRegions();
+	else if (m_currentFuct == HOUGH)
+		processHough();
+	else if (m_currentFuct == DISTANCE)
+		processDistance();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -332,6 +616,182 @@ void IPDialog::processEdge()
 	m_ipDisplay				->storeImage(tr("Result"), m_resultImg); // display the new image
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP frequency domain options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP frequency domain options
+void IPDialog::processFrequency()
+{	// one of the frequency options has been checked; process the appropriate one
+	m_resultImg				= m_origImg;					// make a copy of the original and process it
+
+	applyFreq				(m_resultImg);
+
+	m_ipDisplay				->storeImage(tr("Result"), m_resultImg); // display the new image
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Run the checked frequency domain option
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief run the checked frequency domain option on img
+//! \details the slider maps to 0 - 0.5 cycles per pixel of the full size image, or to a blur of 0 - 32
+//!	pixels; both are scaled for the preview so it removes the same detail as the final result
+//! \param[in, out] img	preview or full size image
+// the slider maps to 0 - 0.5 cycles per pixel, or a blur of 0 - 32 pixels, of the full size image
+void IPDialog::applyFreq(QImage &img)
+{
+	double cutoff			= m_thresSpin->value() / 255.0 * 0.5;
+	double sigma			= m_thresSpin->value() / 255.0 * 32.0;
+	if (img.width() > 0 && img.width() < m_retProcImg.width())
+	{
+		cutoff				*= (double)m_retProcImg.width() / img.width();
+		sigma				*= (double)img.width() / m_retProcImg.width();
+	}
+
+	if (m_freqIdealLow		->isChecked())					// ideal low pass
+		m_ip				->freqFilter(IP::IdealLow, img, cutoff);
+	else if (m_freqButterLow	->isChecked())				// butterworth low pass
+		m_ip				->freqFilter(IP::ButterLow, img, cutoff);
+	else if (m_freqGaussLow	->isChecked())					// gaussian low pass
+		m_ip				->freqFilter(IP::GaussLow, img, cutoff);
+	else if (m_freqIdealHigh	->isChecked())				// ideal high pass
+		m_ip				->freqFilter(IP::IdealHigh, img, cutoff);
+	else if (m_freqButterHigh	->isChecked())				// butterworth high pass
+		m_ip				->freqFilter(IP::ButterHigh, img, cutoff);
+	else if (m_freqGaussHigh	->isChecked())				// gaussian high pass
+		m_ip				->freqFilter(IP::GaussHigh, img, cutoff);
+	else if (m_freqSpectrum	->isChecked())					// magnitude spectrum
+		m_ip				->spectrum(img);
+	else if (m_freqBlur		->isChecked())					// gaussian blur
+		m_ip				->gaussianBlur(img, sigma);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP edge preserving smoothing options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP edge preserving smoothing options
+void IPDialog::processSmooth()
+{	// one of the smoothing options has been checked; process the appropriate one
+	m_resultImg				= m_origImg;					// make a copy of the original and process it
+
+	applySmooth				(m_resultImg);
+
+	m_ipDisplay				->storeImage(tr("Result"), m_resultImg); // display the new image
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Run the checked smoothing option
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief run the checked smoothing option on img
+//! \details the slider is the edge strength to keep (range sigma for bilateral, eps for guided);
+//!	the spatial extent is 8 pixels of the full size image and shrinks with the preview
+//! \param[in, out] img	preview or full size image
+// the spatial extent is 8 pixels of the full size image and shrinks with the preview
+void IPDialog::applySmooth(QImage &img)
+{
+	double spatial			= 8.0;
+	if (img.width() > 0 && img.width() < m_retProcImg.width())
+		spatial				*= (double)img.width() / m_retProcImg.width();
+
+	int level				= m_thresSpin->value();
+
+	if (m_smoothBilateral	->isChecked())					// bilateral grid
+		m_ip				->bilateral(img, spatial, level);
+	else if (m_smoothGuided	->isChecked())					// guided filter
+		m_ip				->guidedFilter(img, (int)(spatial + 0.5), (level / 255.0) * (level / 255.0));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP connected region options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP connected region options
+void IPDialog::processRegions()
+{	// one of the connectivity options has been checked; process the appropriate one
+	m_resultImg				= m_origImg;					// make a copy of the original and process it
+
+	QVector<RegionInfo> regions;
+	applyRegions			(m_resultImg, regions);
+
+	m_ipDisplay				->storeImage(tr("Result"), m_resultImg); // display the new image
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Label connected regions
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief label img with the checked connectivity
+//! \details pixels at or above the slider level are foreground, so threshold and edge results can be used directly
+//! \param[in, out] img	preview or full size image; replaced by the false color label map
+//! \param[out] regions	statistics of every region
+//! \return				number of regions
+// pixels at or above the slider level are foreground, so threshold and edge results can be used directly
+int IPDialog::applyRegions(QImage &img, QVector<RegionInfo> &regions)
+{
+	Labeling::Connectivity conn	= m_region4->isChecked() ? Labeling::Four : Labeling::Eight;
+
+	QVector<int> labels;
+	int count				= Labeling::label(img, m_thresSpin->value(), conn, labels, regions);
+	img						= Labeling::colorize(labels, img.width(), img.height());
+
+	return count;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP hough transform options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP hough transform options
+void IPDialog::processHough()
+{	// one of the hough options has been checked; draw the results over a copy of the original
+	m_resultImg				= m_origImg;
+
+	QVector<HoughLine> lines;
+	QVector<HoughCircle> circles;
+	QVector<QLineF> segments	= applyHough(m_resultImg, lines, circles);
+
+	QPainter painter		(&m_resultImg);
+	painter					.setPen(Qt::red);
+	painter					.drawLines(segments);
+	painter					.end();
+
+	m_ipDisplay				->storeImage(tr("Result"), m_resultImg); // display the new image
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP distance transform options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP distance transform options
+//! \details the field is scaled to its own maximum, so the preview looks like the full size result
+void IPDialog::processDistance()
+{	// one of the distance options has been checked; process the appropriate one
+	m_resultImg				= m_origImg;					// make a copy of the original and process it
+
+	m_ip					->distanceTransform(m_resultImg, m_thresSpin->value(), m_distInside->isChecked());
+
+	m_ipDisplay				->storeImage(tr("Result"), m_resultImg); // display the new image
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Hough transform
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief run the checked hough transform on img
+//! \details the slider is the sobel threshold. Lines must be at least a quarter of the smaller image side;
+//!	circle radii go from 1/40 to 1/2 of it, so the preview finds the same shapes as the full size image
+//! \param[in] img		preview or full size image
+//! \param[out] lines	detected lines
+//! \param[out] circles	detected circles
+//! \return				overlay segments in image coordinates
+// the slider is the sobel threshold; limits follow the image size so the preview finds the same shapes
+QVector<QLineF> IPDialog::applyHough(const QImage &img, QVector<HoughLine> &lines, QVector<HoughCircle> &circles)
+{
+	int side				= qMin(img.width(), img.height());
+	int level				= m_thresSpin->value();
+
+	if (m_houghLines		->isChecked())					// lines
+		Hough::lines		(img, level, qMax(10, side / 4), 20, lines);
+	else if (m_houghCircles	->isChecked())					// circles
+		Hough::circles		(img, level, qMax(3, side / 40), qMax(4, side / 2), 10, circles);
+
+	return Hough::overlay(lines, circles, img.width(), img.height());
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Set up the dialog box with IP color options
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -357,9 +817,18 @@ void IPDialog::setupColor()
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief set up the dialog box with IP threshold options
 void IPDialog::setupThres()
-{	// default threshold value is 128
-	m_thresSlider			->setValue(128);
-	m_thresSpin				->setValue(128);
+{	// default threshold value is the mean gray level when known, otherwise 128
+	int level				= 128;
+	QString range;
+	if (m_hasStats)
+	{
+		const ChannelStats &gray	= m_stats.channel[ImageStatistics::Gray];
+		level				= qRound(gray.mean);
+		range				= tr("Gray %1 - %2, mean %3").arg(gray.min).arg(gray.max).arg(gray.mean, 0, 'f', 1);
+	}
+	m_thresSlider			->setValue(level);
+	m_thresSpin				->setValue(level);
+	m_thresSlider			->setToolTip(range);
 
 	// layout the threshold radio button
 	m_optLay				->addWidget(m_thresInd, 0, 0, 1, 2, Qt::AlignCenter);
@@ -402,12 +871,145 @@ void IPDialog::setupEdge()
 	m_boxOpt				->setLayout(m_optLay);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set up the dialog box with IP frequency domain options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set up the dialog box with IP frequency domain options
+void IPDialog::setupFreq()
+{	// slider is the cutoff; default is a quarter of the band
+	m_thresSlider			->setValue(128);
+	m_thresSpin				->setValue(128);
+
+	// layout the frequency radio buttons; low pass on top, high pass below
+	m_optLay				->addWidget(m_freqIdealLow, 0, 0);
+	m_optLay				->addWidget(m_freqButterLow, 0, 1);
+	m_optLay				->addWidget(m_freqGaussLow, 0, 2);
+	m_optLay				->addWidget(m_freqIdealHigh, 1, 0);
+	m_optLay				->addWidget(m_freqButterHigh, 1, 1);
+	m_optLay				->addWidget(m_freqGaussHigh, 1, 2);
+	m_optLay				->addWidget(m_freqSpectrum, 2, 0);
+	m_optLay				->addWidget(m_freqBlur, 2, 1);
+	m_optLay				->addWidget(m_thresSlider, 3, 0, 1, 2);
+	m_optLay				->addWidget(m_thresSpin, 3, 2);
+
+	m_freqButterLow			->setChecked(true);	// by default, butterworth low pass is checked
+	m_freqIdealLow			->setVisible(true);
+	m_freqButterLow			->setVisible(true);
+	m_freqGaussLow			->setVisible(true);
+	m_freqIdealHigh			->setVisible(true);
+	m_freqButterHigh		->setVisible(true);
+	m_freqGaussHigh			->setVisible(true);
+	m_freqSpectrum			->setVisible(true);
+	m_freqBlur				->setVisible(true);
+	m_thresSlider			->setVisible(true);
+	m_thresSpin				->setVisible(true);
+
+	m_boxOpt				->setLayout(m_optLay);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set up the dialog box with IP edge preserving smoothing options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set up the dialog box with IP edge preserving smoothing options
+void IPDialog::setupSmooth()
+{	// slider is the edge strength; default keeps edges stronger than 32 levels
+	m_thresSlider			->setValue(32);
+	m_thresSpin				->setValue(32);
+
+	// layout the smoothing radio buttons
+	m_optLay				->addWidget(m_smoothBilateral, 0, 0, 1, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_smoothGuided, 0, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_thresSlider, 1, 0, 1, 2);
+	m_optLay				->addWidget(m_thresSpin, 1, 2);
+
+	m_smoothBilateral		->setChecked(true);	// by default, bilateral is checked
+	m_smoothBilateral		->setVisible(true);
+	m_smoothGuided			->setVisible(true);
+	m_thresSlider			->setVisible(true);
+	m_thresSpin				->setVisible(true);
+
+	m_boxOpt				->setLayout(m_optLay);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set up the dialog box with IP connected region options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set up the dialog box with IP connected region options
+void IPDialog::setupRegions()
+{	// default foreground level is 128
+	m_thresSlider			->setValue(128);
+	m_thresSpin				->setValue(128);
+
+	// layout the connectivity radio buttons
+	m_optLay				->addWidget(m_region4, 0, 0, 1, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_region8, 0, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_thresSlider, 1, 0, 1, 2);
+	m_optLay				->addWidget(m_thresSpin, 1, 2);
+
+	m_region8				->setChecked(true);	// by default, 8 connectivity is checked
+	m_region4				->setVisible(true);
+	m_region8				->setVisible(true);
+	m_thresSlider			->setVisible(true);
+	m_thresSpin				->setVisible(true);
+
+	m_boxOpt				->setLayout(m_optLay);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set up the dialog box with IP hough transform options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set up the dialog box with IP hough transform options
+void IPDialog::setupHough()
+{	// default edge threshold is 128
+	m_thresSlider			->setValue(128);
+	m_thresSpin				->setValue(128);
+
+	// layout the hough radio buttons
+	m_optLay				->addWidget(m_houghLines, 0, 0, 1, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_houghCircles, 0, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_thresSlider, 1, 0, 1, 2);
+	m_optLay				->addWidget(m_thresSpin, 1, 2);
+
+	m_houghLines			->setChecked(true);	// by default, lines is checked
+	m_houghLines			->setVisible(true);
+	m_houghCircles			->setVisible(true);
+	m_thresSlider			->setVisible(true);
+	m_thresSpin				->setVisible(true);
+
+	m_boxOpt				->setLayout(m_optLay);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set up the dialog box with IP distance transform options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set up the dialog box with IP distance transform options
+void IPDialog::setupDistance()
+{	// default feature level is 128
+	m_thresSlider			->setValue(128);
+	m_thresSpin				->setValue(128);
+
+	// layout the distance radio buttons
+	m_optLay				->addWidget(m_distOutside, 0, 0, 1, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_distInside, 0, 2, Qt::AlignCenter);
+	m_optLay				->addWidget(m_thresSlider, 1, 0, 1, 2);
+	m_optLay				->addWidget(m_thresSpin, 1, 2);
+
+	m_distOutside			->setChecked(true);	// by default, distance to features is checked
+	m_distOutside			->setVisible(true);
+	m_distInside			->setVisible(true);
+	m_thresSlider			->setVisible(true);
+	m_thresSpin				->setVisible(true);
+
+	m_boxOpt				->setLayout(m_optLay);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Clear the IP options layout; preparing for a new one
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief clear the IP options layout; preparing for a new one
 void IPDialog::clearOptLay()
 {	// hide all radio buttons
+	m_thresSlider			->setToolTip(QString());
 	m_thresSlider			->setVisible(false);
 	m_thresSpin				->setVisible(false);
 	m_colorRed				->setVisible(false);
@@ -419,4 +1021,20 @@ void IPDialog::clearOptLay()
 	m_edgePrewitt			->setVisible(false);
 	m_edgeSobel				->setVisible(false);
 	m_edgeLoG				->setVisible(false);
+	m_freqIdealLow			->setVisible(false);
+	m_freqButterLow			->setVisible(false);
+	m_freqGaussLow			->setVisible(false);
+	m_freqIdealHigh			->setVisible(false);
+	m_freqButterHigh		->setVisible(false);
+	m_freqGaussHigh			->setVisible(false);
+	m_freqSpectrum			->setVisible(false);
+	m_freqBlur				->setVisible(false);
+	m_smoothBilateral		->setVisible(false);
+	m_smoothGuided			->setVisible(false);
+	m_region4				->setVisible(false);
+	m_region8				->setVisible(false);
+	m_houghLines			->setVisible(false);
+	m_houghCircles			->setVisible(false);
+	m_distOutside			->setVisible(false);
+	m_distInside			->setVisible(false);
 }
@@ -18,7 +18,11 @@
 
 #include		<QtGui>
 #include		"ip.h"
+#include		"labeling.h"
+#include		"hough.h"
+#include		"imagestats.h"
 #include		"OpenGLWidget.h"
+#include		"operation.h"
 
 class IPDialog : public QWidget
 {
@@ -26,7 +30,7 @@ class IPDialog : public QWidget
 
 public:
 	//! \brief enum for IPDialog; specifying the processing function
-	enum		IP_Function		{COLOR, THRESHOLD, EDGE};
+	enum		IP_Function		{COLOR, THRESHOLD, EDGE, FREQUENCY, SMOOTH, REGIONS, HOUGH, DISTANCE};
 	//! \brief Constructor
 			IPDialog		(QWidget *p = 0, Qt::WindowFlags f = 0);
 	//! \brief set up the dialog box to reflect the appropriate processing function
@@ -35,6 +39,18 @@ public:
 	QImage		retrieveProcImg		();
 	//! \brief notify this dialog box that the active image has changed
 	void		imageChanged		(QImage);
+	//! \brief cached statistics of the image given to setup()/imageChanged(); 0 if unknown
+	void		setStatistics		(const ImageStatistics*);
+	//! \brief text report of the last retrieved image (region table...); empty if the function has none
+	QString		report			();
+	//! \brief name of the current function with the chosen options, for the image history
+	QString		operation		();
+	//! \brief parameters of the current function, to run it again on a changed source
+	OpParams	params			();
+	//! \brief the current function draws over the active image instead of creating a new one
+	bool		isOverlay		();
+	//! \brief segments (image coordinates) found by the last retrieveProcImg()
+	QVector<QLineF>	overlay		();
 
 signals:
 	//! \brief notify MainWindow that user has clicked one fo the three confirmation buttons
@@ -53,14 +69,44 @@ private slots:
 	void		processThreshold	();
 	//! \brief slot for IP edge detection options
 	void		processEdge		();
+	//! \brief slot for IP frequency domain options
+	void		processFrequency	();
+	//! \brief slot for IP edge preserving smoothing options
+	void		processSmooth		();
+	//! \brief slot for IP connected region options
+	void		processRegions		();
+	//! \brief slot for IP hough transform options
+	void		processHough		();
+	//! \brief slot for IP distance transform options
+	void		processDistance		();
 
 private:
+	//! \brief report the images of the dialog to the memory ledger
+	void		accountImages	();
 	//! \brief set up the dialog box with IP color options
 	void		setupColor		();
 	//! \brief set up the dialog box with IP threshold options
 	void		setupThres		();
 	//! \brief set up the dialog box with IP edge detection options
 	void		setupEdge		();
+	//! \brief set up the dialog box with IP frequency domain options
+	void		setupFreq		();
+	//! \brief run the checked frequency domain option on img
+	void		applyFreq		(QImage&);
+	//! \brief set up the dialog box with IP edge preserving smoothing options
+	void		setupSmooth		();
+	//! \brief run the checked smoothing option on img
+	void		applySmooth		(QImage&);
+	//! \brief set up the dialog box with IP connected region options
+	void		setupRegions		();
+	//! \brief label img with the checked connectivity; img becomes the false color label map
+	int			applyRegions		(QImage&, QVector<RegionInfo>&);
+	//! \brief set up the dialog box with IP hough transform options
+	void		setupHough		();
+	//! \brief run the checked hough transform on img; returns the overlay segments
+	QVector<QLineF>	applyHough	(const QImage&, QVector<HoughLine>&, QVector<HoughCircle>&);
+	//! \brief set up the dialog box with IP distance transform options
+	void		setupDistance		();
 	//! \brief clear the IP options layout; preparing for a new one
 	void		clearOptLay		();
 
@@ -71,6 +117,10 @@ private:
 	QImage		m_origImg;				// original image
 	QImage		m_resultImg;			// result image
 	QImage		m_retProcImg;			// return processed image
+	QString		m_report;				// report of the last retrieved image
+	ImageStatistics	m_stats;			// statistics of m_retProcImg (valid when m_hasStats)
+	bool		m_hasStats;				// m_stats is known
+	QVector<QLineF>	m_overlay;			// overlay of the last retrieved image
 	OpenGLWidget	*m_ipDisplay;		// ip OpenGL disply
 
 	QGridLayout	*m_optLay;				// layout for various options
@@ -96,6 +146,22 @@ private:
 	QRadioButton	*m_edgePrewitt;		// radio button to perform prewitt edge detection
 	QRadioButton	*m_edgeSobel;		// radio button to perform sobel edge detection
 	QRadioButton	*m_edgeLoG;			// radio button to perform LoG edge detection
+	QRadioButton	*m_freqIdealLow;	// radio button to perform ideal low pass filter
+	QRadioButton	*m_freqButterLow;	// radio button to perform butterworth low pass filter
+	QRadioButton	*m_freqGaussLow;	// radio button to perform gaussian low pass filter
+	QRadioButton	*m_freqIdealHigh;	// radio button to perform ideal high pass filter
+	QRadioButton	*m_freqButterHigh;	// radio button to perform butterworth high pass filter
+	QRadioButton	*m_freqGaussHigh;	// radio button to perform gaussian high pass filter
+	QRadioButton	*m_freqSpectrum;	// radio button to display the magnitude spectrum
+	QRadioButton	*m_freqBlur;		// radio button to perform gaussian blur through the FFT
+	QRadioButton	*m_smoothBilateral;	// radio button to perform bilateral grid smoothing
+	QRadioButton	*m_smoothGuided;	// radio button to perform guided filter smoothing
+	QRadioButton	*m_region4;			// radio button to label with 4 connectivity
+	QRadioButton	*m_region8;			// radio button to label with 8 connectivity
+	QRadioButton	*m_houghLines;		// radio button to detect lines
+	QRadioButton	*m_houghCircles;	// radio button to detect circles
+	QRadioButton	*m_distOutside;		// radio button to measure the distance to the nearest feature
+	QRadioButton	*m_distInside;		// radio button to measure the distance inside features to the background
 
 	//QPushButton for ip
 	QPushButton	*m_butOk;				// apply the procedure and destroy the widget
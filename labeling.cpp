@@ -0,0 +1,389 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Labeling
+//! \brief Connected component labeling implementation
+//!
+//! \file labeling.cpp
+//! \brief Connected component labeling implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			"labeling.h"
+#include			"parallel.h"
+
+// statistics of one provisional label; merged into RegionInfo at the end
+struct ProvStats
+{
+	int				area;
+	int				minX, minY, maxX, maxY;
+	double			sumX, sumY, sumI;
+};
+
+// band of rows labeled by one thread
+struct Stripe
+{
+	int					y0;			// first row (inclusive)
+	int					y1;			// last row (exclusive)
+	int					base;		// first provisional label of this stripe
+	int					roots;		// number of final regions rooted in this stripe
+	int					firstId;	// id of the first of those regions
+	QVector<ProvStats>	stats;		// statistics of every provisional label
+	QVector<int>		root;		// root label of every provisional label
+};
+
+// state shared by the worker threads
+struct LabelContext
+{
+	const QImage		*img;
+	int					level;		// foreground is gray >= level
+	int					conn;		// 4 or 8
+	int					width;
+	int					height;
+	int					*labels;	// width x height; 0 is background
+	int					*parent;	// union-find forest over provisional labels
+	QVector<Stripe>		stripes;
+};
+
+// root of l; compresses the path. Only used where no other thread touches the same labels
+static int findRoot(int *parent, int l)
+{
+	int r		= l;
+	while (parent[r] != r)
+		r		= parent[r];
+
+	while (parent[l] != r)
+	{
+		int next	= parent[l];
+		parent[l]	= r;
+		l			= next;
+	}
+	return r;
+}
+
+// root of l without writing; safe while other threads read the forest
+static int findRootConst(const int *parent, int l)
+{
+	while (parent[l] != l)
+		l		= parent[l];
+	return l;
+}
+
+// merge the trees of a and b; the smaller label becomes the root so ids follow raster order
+static void unite(int *parent, int a, int b)
+{
+	a			= findRoot(parent, a);
+	b			= findRoot(parent, b);
+	if (a < b)
+		parent[b]	= a;
+	else if (b < a)
+		parent[a]	= b;
+}
+
+// first pass over stripes [begin, end): provisional labels and their statistics
+static void labelStripes(void *p, int begin, int end)
+{
+	LabelContext *c		= (LabelContext*)p;
+	int w				= c->width;
+
+	for (int s = begin; s < end; s++)
+	{
+		Stripe &st		= c->stripes[s];
+
+		for (int y = st.y0; y < st.y1; y++)
+		{
+			const unsigned char *pixData	= c->img->scanLine(y);
+			int *row						= c->labels + y * w;
+			const int *up					= y > st.y0 ? row - w : 0;	// rows above the stripe are merged later
+
+			for (int x = 0; x < w; x++, pixData += 4)
+			{
+				int gray	= (int)(0.3 * pixData[2] + 0.59 * pixData[1] + 0.11 * pixData[0]);
+				if (gray < c->level)
+				{
+					row[x]	= 0;
+					continue;
+				}
+
+				// gather the labelled neighbours that were already visited
+				int nb[4];
+				int n		= 0;
+				if (x > 0 && row[x - 1])							nb[n++]	= row[x - 1];
+				if (up && up[x])									nb[n++]	= up[x];
+				if (c->conn == 8 && up && x > 0 && up[x - 1])		nb[n++]	= up[x - 1];
+				if (c->conn == 8 && up && x + 1 < w && up[x + 1])	nb[n++]	= up[x + 1];
+
+				int l;
+				if (n == 0)
+				{	// new provisional label
+					l				= st.base + st.stats.size();
+					c->parent[l]	= l;
+
+					ProvStats ps;
+					ps.area			= 0;
+					ps.minX			= ps.maxX	= x;
+					ps.minY			= ps.maxY	= y;
+					ps.sumX			= ps.sumY	= ps.sumI	= 0.0;
+					st.stats.append	(ps);
+				}
+				else
+				{
+					l				= nb[0];
+					for (int i = 1; i < n; i++)
+						if (nb[i] != l)
+							unite	(c->parent, l, nb[i]);
+				}
+				row[x]		= l;
+
+				ProvStats &ps	= st.stats[l - st.base];
+				ps.area			++;
+				if (x < ps.minX)	ps.minX	= x;
+				if (x > ps.maxX)	ps.maxX	= x;
+				if (y > ps.maxY)	ps.maxY	= y;
+				ps.sumX			+= x;
+				ps.sumY			+= y;
+				ps.sumI			+= gray;
+			}
+		}
+	}
+}
+
+// resolve the root of every provisional label in stripes [begin, end) and count the roots
+static void resolveStripes(void *p, int begin, int end)
+{
+	LabelContext *c		= (LabelContext*)p;
+
+	for (int s = begin; s < end; s++)
+	{
+		Stripe &st		= c->stripes[s];
+		int count		= st.stats.size();
+
+		st.root.resize	(count);
+		st.roots		= 0;
+		for (int k = 0; k < count; k++)
+		{
+			st.root[k]	= findRootConst(c->parent, st.base + k);
+			if (st.root[k] == st.base + k)
+				st.roots++;
+		}
+	}
+}
+
+// give the roots of stripes [begin, end) their final id; roots are only written by their own stripe
+static void numberStripes(void *p, int begin, int end)
+{
+	LabelContext *c		= (LabelContext*)p;
+
+	for (int s = begin; s < end; s++)
+	{
+		Stripe &st		= c->stripes[s];
+		int id			= st.firstId;
+
+		for (int k = 0; k < st.root.size(); k++)
+			if (st.root[k] == st.base + k)
+				c->parent[st.base + k]	= id++;
+	}
+}
+
+// replace the provisional labels of stripes [begin, end) by the final ids
+static void relabelStripes(void *p, int begin, int end)
+{
+	LabelContext *c		= (LabelContext*)p;
+	int w				= c->width;
+
+	for (int s = begin; s < end; s++)
+	{
+		Stripe &st		= c->stripes[s];
+		int *row		= c->labels + st.y0 * w;
+		int *last		= c->labels + st.y1 * w;
+
+		for ( ; row < last; row++)
+			if (*row)
+				*row	= c->parent[st.root[*row - st.base]];
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Label
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief label the pixels whose gray level is >= level
+//! \details block based two pass labeling. Every thread labels a band of rows with its own union-find
+//!	labels, the bands are stitched along their borders and the labels are then resolved in parallel.
+//!	Statistics are gathered per provisional label in the first pass and merged per region.
+//!	Region ids follow the raster order of their first pixel.
+//! \param[in] img		source image; gray levels are used for the mean intensity
+//! \param[in] level	threshold level; everything below is background
+//! \param[in] conn		4 or 8 connectivity
+//! \param[out] labels	width x height region ids; 0 is background, regions start at 1
+//! \param[out] regions	statistics; regions[i] describes id i + 1
+//! \return				number of regions
+// block based two pass labeling; region ids follow the raster order of their first pixel
+int Labeling::label(const QImage &img, int level, Connectivity conn, QVector<int> &labels, QVector<RegionInfo> &regions)
+{
+	int width			= img.width();
+	int height			= img.height();
+
+	regions.clear		();
+	labels.resize		(width * height);
+	if (width == 0 || height == 0)
+		return 0;
+
+	LabelContext c;
+	c.img				= &img;
+	c.level				= level;
+	c.conn				= conn;
+	c.width				= width;
+	c.height			= height;
+	c.labels			= labels.data();
+
+	QVector<int> parent(width * height + 1);
+	c.parent			= parent.data();
+
+	// a few stripes per thread; each owns the label range of its pixels
+	int count			= qMin(Parallel::numThreads() * 4, height);
+	int rows			= (height + count - 1) / count;
+	for (int y = 0; y < height; y += rows)
+	{
+		Stripe st;
+		st.y0			= y;
+		st.y1			= qMin(y + rows, height);
+		st.base			= y * width + 1;
+		st.roots		= 0;
+		st.firstId		= 0;
+		c.stripes.append(st);
+	}
+
+	Parallel::forRange	(c.stripes.size(), labelStripes, &c, 1);
+
+	// stitch every stripe to the one above
+	for (int s = 1; s < c.stripes.size(); s++)
+	{
+		int y			= c.stripes[s].y0;
+		const int *row	= c.labels + y * width;
+		const int *up	= row - width;
+
+		for (int x = 0; x < width; x++)
+		{
+			if (!row[x])
+				continue;
+
+			if (up[x])
+				unite	(c.parent, row[x], up[x]);
+			if (conn == Eight && x > 0 && up[x - 1])
+				unite	(c.parent, row[x], up[x - 1]);
+			if (conn == Eight && x + 1 < width && up[x + 1])
+				unite	(c.parent, row[x], up[x + 1]);
+		}
+	}
+
+	Parallel::forRange	(c.stripes.size(), resolveStripes, &c, 1);
+
+	int total			= 0;
+	for (int s = 0; s < c.stripes.size(); s++)
+	{
+		c.stripes[s].firstId	= total + 1;
+		total					+= c.stripes[s].roots;
+	}
+
+	Parallel::forRange	(c.stripes.size(), numberStripes, &c, 1);
+	Parallel::forRange	(c.stripes.size(), relabelStripes, &c, 1);
+
+	// merge the provisional statistics into the region table
+	QVector<ProvStats> merged(total);
+	for (int i = 0; i < total; i++)
+	{
+		merged[i].area	= 0;
+		merged[i].minX	= merged[i].minY	= 0x7fffffff;
+		merged[i].maxX	= merged[i].maxY	= -1;
+		merged[i].sumX	= merged[i].sumY	= merged[i].sumI	= 0.0;
+	}
+
+	for (int s = 0; s < c.stripes.size(); s++)
+	{
+		const Stripe &st	= c.stripes[s];
+		for (int k = 0; k < st.stats.size(); k++)
+		{
+			const ProvStats &ps	= st.stats[k];
+			ProvStats &m		= merged[c.parent[st.root[k]] - 1];
+
+			m.area		+= ps.area;
+			m.minX		= qMin(m.minX, ps.minX);
+			m.minY		= qMin(m.minY, ps.minY);
+			m.maxX		= qMax(m.maxX, ps.maxX);
+			m.maxY		= qMax(m.maxY, ps.maxY);
+			m.sumX		+= ps.sumX;
+			m.sumY		+= ps.sumY;
+			m.sumI		+= ps.sumI;
+		}
+	}
+
+	regions.resize		(total);
+	for (int i = 0; i < total; i++)
+	{
+		const ProvStats &m	= merged[i];
+		regions[i].area		= m.area;
+		regions[i].box		= QRect(m.minX, m.minY, m.maxX - m.minX + 1, m.maxY - m.minY + 1);
+		regions[i].cx		= m.sumX / m.area;
+		regions[i].cy		= m.sumY / m.area;
+		regions[i].mean		= m.sumI / m.area;
+	}
+
+	return total;
+}
+
+// label map and size handed to the colorize workers
+struct ColorContext
+{
+	const int		*labels;
+	QImage			*img;
+	int				width;
+};
+
+// paint rows [begin, end); neighbouring ids get very different colors
+static void colorRows(void *p, int begin, int end)
+{
+	ColorContext *c		= (ColorContext*)p;
+
+	for (int y = begin; y < end; y++)
+	{
+		QRgb *line		= (QRgb*)c->img->scanLine(y);
+		const int *row	= c->labels + y * c->width;
+
+		for (int x = 0; x < c->width; x++)
+		{
+			if (!row[x])
+			{
+				line[x]	= qRgb(0, 0, 0);
+				continue;
+			}
+
+			unsigned int h	= (unsigned int)row[x] * 2654435761u;	// multiplicative hash
+			line[x]	= qRgb(64 + (h >> 24) % 192, 64 + (h >> 16) % 192, 64 + (h >> 8) % 192);
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Colorize
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief false color image of a label map; background is black
+//! \param[in] labels	width x height region ids
+//! \param[in] width	width of the label map
+//! \param[in] height	height of the label map
+//! \return				RGB32 image
+QImage Labeling::colorize(const QVector<int> &labels, int width, int height)
+{
+	QImage result(width, height, QImage::Format_RGB32);
+
+	ColorContext c;
+	c.labels			= labels.data();
+	c.img				= &result;
+	c.width				= width;
+
+	Parallel::forRange	(height, colorRows, &c, 16);
+	return result;
+}
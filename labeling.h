@@ -0,0 +1,45 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Labeling
+//! \brief Connected component labeling with per region statistics
+//!
+//! \file labeling.h
+//! \brief Connected component labeling class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				LABELING_H
+#define				LABELING_H
+
+#include			<QImage>
+#include			<QRect>
+#include			<QVector>
+
+// statistics of one connected region
+struct RegionInfo
+{
+	int				area;			// number of pixels
+	QRect			box;			// bounding box
+	double			cx;				// centroid x
+	double			cy;				// centroid y
+	double			mean;			// mean gray intensity of the original image
+};
+
+// Labeling class
+class Labeling
+{
+public:
+	//! \brief enum for Labeling class
+	enum			Connectivity	{Four = 4, Eight = 8};
+
+	//! \brief label the pixels whose gray level is >= level; returns the number of regions
+	static int		label			(const QImage&, int, Connectivity, QVector<int>&, QVector<RegionInfo>&);
+	//! \brief false color image of a label map; background is black
+	static QImage	colorize		(const QVector<int>&, int, int);
+};
+#endif
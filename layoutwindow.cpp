@@ -14,6 +14,7 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 #include		"layoutwindow.h"
+#include		"memoryledger.h"
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // CONSTRUCTOR
@@ -46,6 +47,7 @@ LayoutWindow::LayoutWindow(QWidget *parent)
 		// establish edit connection
 		connect(m_wid[i], SIGNAL(imgCopy(int)),		this, SLOT(copy(int)));
 		connect(m_wid[i], SIGNAL(imgPaste(int)),	this, SLOT(paste(int)));
+		connect(m_wid[i], SIGNAL(imgPasteFrom(int, int)),	this, SLOT(pasteFrom(int, int)));
 
 		// init splitters
 		m_hSplit[i]			= new Splitter(Qt::Horizontal);
@@ -125,6 +127,8 @@ void LayoutWindow::applyTrans(double *mat, int pid, int qid)
 	Vertex *p				= m_wid[pid]->getVertex(success);
 	Vertex *q				= m_wid[qid]->getVertex(success);
 	m_wid[m_idNext]			->applyTransform(mat, p, q);
+	delete [] p;			// the points are compiled into the frame's display list
+	delete [] q;
 	m_idActive				= m_idNext;
 
 	// figure out which is the next frame
@@ -221,6 +225,30 @@ void LayoutWindow::open(QString imgName, QImage img)
 	frameUpdate();
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Open image in a free frame
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief open new image in a free frame
+//! \details the search starts at the next frame; nothing on screen is replaced
+//! \param[in] imgName	image name
+//! \param[in] img	image
+//! \return		false if every frame holds an image
+// the search starts at the next frame; nothing on screen is replaced
+bool LayoutWindow::openFree(QString imgName, QImage img)
+{
+	for (int i = 0; i < m_visWin; i++)
+	{
+		int id			= (m_idNext + i) % m_visWin;
+		if (!m_wid[id]->isOccupied())
+		{
+			m_idNext	= id;
+			open		(imgName, img);
+			return true;
+		}
+	}
+	return false;
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Open depth file
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -380,6 +408,165 @@ QImage LayoutWindow::activeImage()
 	return m_wid[m_idActive]	->image();
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Return next frame's image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief return next frame's image
+//! \details operations on two images take the second one from the next frame
+//! \return	next frame's image; null when the next frame is the active frame
+QImage LayoutWindow::nextImage()
+{
+	if (m_idNext == m_idActive)
+		return QImage();
+	return m_wid[m_idNext]		->image();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Layout specification
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief current layout, in the form custLayout() takes
+//! \param[out] rows	# of rows
+//! \param[out] cols	# of cols
+//! \param[out] orientation	orientation of the layout
+//! \param[out] spec	windows in each column (horizontal) or row (vertical); empty for grid
+void LayoutWindow::layoutSpec(int &rows, int &cols, int &orientation, QVector<int> &spec)
+{
+	rows		= m_rows;
+	cols		= m_cols;
+	orientation	= m_layout;
+	spec		.clear();
+	int n		= m_layout == HORIZONTAL ? m_cols : (m_layout == VERTICAL ? m_rows : 0);
+	for (int i = 0; i < n; i++)
+		spec	.append(m_spec[i]);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Frame count
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief # of visible frames
+//! \return	# of visible frames
+int LayoutWindow::frameCount()
+{
+	return m_visWin;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Frame image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief image held by a frame
+//! \param[in] id frame id
+//! \return	the image; null if the frame is empty
+QImage LayoutWindow::frameImage(int id)
+{
+	if (id < 0 || id >= m_visWin || !m_wid[id]->isOccupied())
+		return QImage();
+	return m_wid[id]	->image();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Frame name
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief name of the image held by a frame
+//! \param[in] id frame id
+//! \return	image name
+QString LayoutWindow::frameName(int id)
+{
+	if (id < 0 || id >= m_visWin)
+		return QString();
+	return m_wid[id]	->name();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set frame image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief show an image in a given frame
+//! \details unlike open(), the active and next frames are left alone
+//! \param[in] id frame id
+//! \param[in] imgName	image name
+//! \param[in] img	image
+// unlike open(), the active and next frames are left alone
+void LayoutWindow::setFrameImage(int id, QString imgName, QImage img)
+{
+	if (id < 0 || id >= m_visWin || img.isNull())
+		return;
+	m_wid[id]		->open(tr("%1 @ 100% %2x%3").arg(imgName).arg(img.width()).arg(img.height()), imgName, img);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Active frame id
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief active frame id
+//! \return	active frame id
+int LayoutWindow::activeFrame()
+{
+	return m_idActive;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Next frame id
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief next frame id
+//! \return	next frame id
+int LayoutWindow::nextFrame()
+{
+	return m_idNext;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set frames
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set active and next frames
+//! \details ids outside the layout fall back to the first frame
+//! \param[in] active	active frame id
+//! \param[in] next		next frame id
+// ids outside the layout fall back to the first frame
+void LayoutWindow::setFrames(int active, int next)
+{
+	m_idActive		= (active >= 0 && active < m_visWin) ? active : 0;
+	m_idNext		= (next >= 0 && next < m_visWin) ? next : 0;
+	frameActive(m_idActive);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Undo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief undo the last edit of the active frame
+//! \details every frame keeps its own history; the frame reports the restored image through frameActive
+// every frame keeps its own history; the frame reports the restored image through frameActive
+void LayoutWindow::undo()
+{
+	if (!m_wid[m_idActive]->canUndo())
+	{
+		emit changeMsg	(tr("Nothing to undo in Frame #%1").arg(m_idActive));
+		return;
+	}
+	m_wid[m_idActive]	->undo();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Redo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief redo the last undone edit of the active frame
+void LayoutWindow::redo()
+{
+	if (!m_wid[m_idActive]->canRedo())
+	{
+		emit changeMsg	(tr("Nothing to redo in Frame #%1").arg(m_idActive));
+		return;
+	}
+	m_wid[m_idActive]	->redo();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Overlay on the active frame
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief draw line segments over the active frame's image
+//! \param[in] segments	segments in image coordinates
+void LayoutWindow::setActiveOverlay(QVector<QLineF> segments)
+{
+	m_wid[m_idActive]	->setOverlay(segments);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Customize layout
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -560,14 +747,17 @@ void LayoutWindow::reset()
 // Cut or Copy image
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief copy item to clipboard
-//! \details copy the image and its title to clipboard
+//! \details copy the image and its title to clipboard, and list the clipboard in the picker of every frame
 //! \param[in] id frame id
 // copy the image and its title to clipboard
 void LayoutWindow::copy(int id)
 {
 	if(m_wid[id]->isOccupied())
 	{
-		m_clipBoard	->setItem(m_wid[id]->image(), m_wid[id]->name(), m_wid[id]->title());
+		m_clipBoard	->setItem(m_wid[id]->clip());
+		QStringList labels	= m_clipBoard->labels();
+		for (int i = 0; i < MAX_SPLIT; i++)
+			m_wid[i]	->setClips(labels);
 		emit changeMsg	(tr("Image cut or copy from Frame #%1").arg(id));
 	}
 }
@@ -581,11 +771,24 @@ void LayoutWindow::copy(int id)
 // retrieve image and its title from clipboard
 void LayoutWindow::paste(int id)
 {
-	QString title	= m_clipBoard->clipFrameTitle();
-	if (!title.isNull())
+	pasteFrom		(id, 0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Paste older image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief paste an older item from clipboard
+//! \details retrieve an item picked in the paste picker of a frame
+//! \param[in] id frame id
+//! \param[in] slot clipboard item; 0 is the newest
+// retrieve an item picked in the paste picker of a frame
+void LayoutWindow::pasteFrom(int id, int slot)
+{
+	ImageClip clip	= m_clipBoard->item(slot);
+	if (!clip.title.isNull())
 	{
-		m_wid[id]	->updateTitleBar(title);
-		m_wid[id]	->setImage(m_clipBoard->clipImage(), m_clipBoard->clipImageName());
+		m_wid[id]	->updateTitleBar(clip.title);
+		m_wid[id]	->setImage(clip.img, clip.name);
 		emit changeMsg	(tr("Image paste to Frame #%1").arg(id));
 	}
 }
@@ -638,46 +841,76 @@ void Splitter::splitterChanged(int pos, int index)
 // ================================== ClipBoard class ============================================
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DESTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+ClipBoard::~ClipBoard()
+{
+	MemoryLedger::instance()->remove(this);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // set item onto clipboard
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief set items in clipboard (image and title)
-//! \param[in] img	clipped image
-//! \param[in] name	clipped image's name
-//! \param[in] title	clipped frame's title
-void ClipBoard::setItem(QImage img, QString name, QString title)
+//! \brief add item to clipboard (image and title)
+//! \details the item becomes the newest. An item with the same pixels moves to the front instead of being
+//!	kept twice, and the oldest item beyond CLIP_SLOTS is dropped along with its reference to the pixels
+//! \param[in] clip	clipped image, its name and the frame's title
+// the item becomes the newest; the oldest beyond CLIP_SLOTS is dropped with its reference to the pixels
+void ClipBoard::setItem(const ImageClip &clip)
 {
-	m_imgClip	= img;
-	m_imgName	= name;
-	m_frameTitle	= title;
+	for (int i = 0; i < m_ring.size(); i++)
+		if (m_ring[i].img.cacheKey() == clip.img.cacheKey() && m_ring[i].name == clip.name)
+		{
+			m_ring	.removeAt(i);
+			break;
+		}
+
+	m_ring		.prepend(clip);
+	while (m_ring.size() > CLIP_SLOTS)
+		m_ring	.removeLast();
+	account		();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// retrieve image from clipboard
+// retrieve item from clipboard
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief retrieve image from clipboard
-// retrieve image from clipboard
-QImage ClipBoard::clipImage()
+//! \brief retrieve item from clipboard
+//! \param[in] slot	item; 0 is the newest
+//! \return	image, image name and frame title; a null title if there is no such item
+// retrieve item from clipboard
+ImageClip ClipBoard::item(int slot)
 {
-	return m_imgClip;
+	return (slot >= 0 && slot < m_ring.size()) ? m_ring[slot] : ImageClip();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// retrieve image name from clipboard
+// labels of the clipboard
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief retrieve image name from clipboard
-// retrieve image name from clipboard
-QString ClipBoard::clipImageName()
+//! \brief label of every item, newest first
+//! \return	image name and size of every item
+QStringList ClipBoard::labels()
 {
-	return m_imgName;
+	QStringList list;
+	for (int i = 0; i < m_ring.size(); i++)
+		list	.append(QObject::tr("%1 (%2x%3)").arg(m_ring[i].name).arg(m_ring[i].img.width()).arg(m_ring[i].img.height()));
+	return list;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// retrieve frame title from clipboard
+// account the clipboard
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief retrieve frame title from clipboard
-// retrieve frame title from clipboard
-QString ClipBoard::clipFrameTitle()
+//! \brief report the items to the memory ledger
+//! \details one allocation per slot; slots past the end of the ring are reported empty
+void ClipBoard::account()
 {
-	return m_frameTitle;
+	for (int i = 0; i < CLIP_SLOTS; i++)
+	{
+		if (i < m_ring.size())
+			MemoryLedger::instance()->set(this, i, MemoryLedger::Clipboard, m_ring[i].img.numBytes(),
+										  QObject::tr("clip %1: %2").arg(i + 1).arg(m_ring[i].name), m_ring[i].img.cacheKey());
+		else
+			MemoryLedger::instance()->set(this, i, MemoryLedger::Clipboard, 0);
+	}
 }
@@ -19,6 +19,7 @@
 #define 		MAX_ROWS 		4
 #define 		MAX_COLS 		4
 #define 		MAX_SPLIT 		MAX_ROWS*MAX_COLS
+#define 		CLIP_SLOTS 		8			// entries kept by the clipboard; the oldest is dropped
 
 #include		"frame.h"
 
@@ -37,6 +38,8 @@ public:
 				LayoutWindow		(QWidget* parent=0);
 	//! \brief open new image
 	void		open				(QString, QImage);
+	//! \brief open new image in a free frame; false if every frame is taken
+	bool		openFree			(QString, QImage);
 	//! \brief open depth image
 	void		openDepthImg		(QString, string);
 	//! \brief customized function to generate grid layout
@@ -47,6 +50,10 @@ public:
 	void		splitCustV			();
 	//! \brief return active frame's image
 	QImage		activeImage			();
+	//! \brief return next frame's image; null when the next frame is the active frame
+	QImage		nextImage			();
+	//! \brief draw line segments over the active frame's image
+	void		setActiveOverlay	(QVector<QLineF>);
 	//! \brief generate a name for a processed image from the original image (active frame)
 	QString		deriveName			();
 	//! \brief retrieve Vertex based on ID specified
@@ -55,6 +62,22 @@ public:
 	void		applyTrans			(double*, int, int);
 	//! \brief render the cloud in a specified frame
 	void		drawCloud			(Vertex*, int, int);
+	//! \brief current layout: rows, cols, orientation and per row/column window counts
+	void		layoutSpec			(int&, int&, int&, QVector<int>&);
+	//! \brief # of visible frames
+	int			frameCount			();
+	//! \brief image held by a frame; null if the frame is empty
+	QImage		frameImage			(int);
+	//! \brief name of the image held by a frame
+	QString		frameName			(int);
+	//! \brief show an image in a given frame
+	void		setFrameImage		(int, QString, QImage);
+	//! \brief active frame id
+	int			activeFrame			();
+	//! \brief next frame id
+	int			nextFrame			();
+	//! \brief set active and next frames
+	void		setFrames			(int, int);
 
 protected:
 	//! \brief handles resizing
@@ -73,6 +96,10 @@ signals:
 public slots:
 	//! \brief received a new order to generate a new layout with the given parameters
 	void		custLayout			(int, int, int, int*);
+	//! \brief undo the last edit of the active frame
+	void		undo				();
+	//! \brief redo the last undone edit of the active frame
+	void		redo				();
 
 private slots:
 	//! \brief set active frame
@@ -89,6 +116,8 @@ private slots:
 	void		copy				(int);
 	//! \brief paste item from clipboard
 	void		paste				(int);
+	//! \brief paste an older item from clipboard
+	void		pasteFrom			(int, int);
 
 private:
 	//! \brief a function that reset all splitters and widgets
@@ -135,22 +164,23 @@ private slots:
 	void		splitterChanged		(int, int);
 };
 
-// clipboard class -- store one item
+// clipboard class -- a ring of the last CLIP_SLOTS items, newest first
 class ClipBoard
 {
 public:
-	//! \brief set items in clipboard (image and its name and frame's title)
-	void		setItem				(QImage, QString, QString);
-	//! \brief retrieve image from clipboard
-	QImage		clipImage			();
-	//! \brief retrieve image name from clipboard
-	QString		clipImageName		();
-	//! \brief retrieve frame title from clipboard
-	QString		clipFrameTitle		();
+	//! \brief Destructor
+				~ClipBoard			();
+	//! \brief add item to clipboard (image, its name and frame's title); the pixels are shared
+	void		setItem				(const ImageClip&);
+	//! \brief retrieve item from clipboard; 0 is the newest
+	ImageClip	item				(int = 0);
+	//! \brief label of every item, newest first
+	QStringList	labels				();
 
 private:
-	QImage		m_imgClip;			// image
-	QString		m_imgName;			// image name
-	QString		m_frameTitle;		// frame title
+	//! \brief report the items to the memory ledger
+	void		account				();
+
+	QList<ImageClip>	m_ring;		// items, newest first; each holds a reference to its pixels
 };
 #endif
@@ -0,0 +1,189 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class LZ
+//! \brief LZ codec implementation
+//!
+//! \file lzcodec.cpp
+//! \brief LZ codec implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cstring>
+
+#include			"lzcodec.h"
+
+// The stream is a list of sequences. Each sequence starts with a token byte:
+// the high nibble is the literal count, the low nibble the match length - MIN_MATCH.
+// A nibble of 15 is followed by extra bytes that are added to it until one is < 255.
+// Literals follow, then a 2 byte little endian offset back into the output.
+// The last sequence carries literals only and ends the stream.
+
+#define				MIN_MATCH		4
+#define				MAX_OFFSET		65535
+#define				HASH_BITS		12
+
+// hash of 4 bytes at p
+static inline unsigned int hash4(const unsigned char *p)
+{
+	unsigned int v;
+	memcpy(&v, p, 4);
+	return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// write a length that did not fit in its nibble
+static inline void putLength(QByteArray &out, int len)
+{
+	while (len >= 255)
+	{
+		out.append((char)255);
+		len -= 255;
+	}
+	out.append((char)len);
+}
+
+// read a length extension; false if the stream ends first
+static inline bool getLength(const unsigned char *&p, const unsigned char *end, int &len)
+{
+	unsigned char b;
+	do
+	{
+		if (p >= end)
+			return false;
+		b	= *p++;
+		len	+= b;
+	} while (b == 255);
+	return true;
+}
+
+// one sequence: literals [lit, lit + litLen) then a match of matchLen at offset (none if matchLen is 0)
+static void putSequence(QByteArray &out, const unsigned char *lit, int litLen, int matchLen, int offset)
+{
+	int mCode		= matchLen ? matchLen - MIN_MATCH : 0;
+	out.append((char)(((litLen < 15 ? litLen : 15) << 4) | (mCode < 15 ? mCode : 15)));
+	if (litLen >= 15)
+		putLength(out, litLen - 15);
+	out.append((const char*)lit, litLen);
+
+	if (matchLen)
+	{
+		out.append((char)(offset & 0xff));
+		out.append((char)(offset >> 8));
+		if (mCode >= 15)
+			putLength(out, mCode - 15);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Compress
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief compress a block of bytes
+//! \details greedy single probe match finder; the hash table keeps the last position of every 4 byte hash
+//! \param[in] data	bytes to compress
+//! \param[in] len	number of bytes
+//! \return		compressed stream
+// greedy single probe match finder; the hash table keeps the last position of every 4 byte hash
+QByteArray LZ::compress(const char *data, int len)
+{
+	const unsigned char *src	= (const unsigned char*)data;
+	QByteArray out;
+	out.reserve(len / 2 + 16);
+
+	int table[1 << HASH_BITS];
+	for (int i = 0; i < (1 << HASH_BITS); i++)
+		table[i]	= -1;
+
+	int anchor		= 0;				// first literal not yet written
+	int pos			= 0;
+	int limit		= len - MIN_MATCH;	// last position a 4 byte probe can read
+
+	while (pos <= limit)
+	{
+		unsigned int h	= hash4(src + pos);
+		int cand		= table[h];
+		table[h]		= pos;
+
+		if (cand < 0 || pos - cand > MAX_OFFSET || memcmp(src + cand, src + pos, MIN_MATCH) != 0)
+		{
+			pos++;
+			continue;
+		}
+
+		// extend the match forward; it may overlap the current position (runs)
+		int matchLen	= MIN_MATCH;
+		while (pos + matchLen < len && src[cand + matchLen] == src[pos + matchLen])
+			matchLen++;
+
+		putSequence(out, src + anchor, pos - anchor, matchLen, pos - cand);
+
+		pos				+= matchLen;
+		anchor			= pos;
+		if (pos - 2 >= 0 && pos - 2 <= limit)
+			table[hash4(src + pos - 2)]	= pos - 2;
+	}
+
+	putSequence(out, src + anchor, len - anchor, 0, 0);
+	return out;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Decompress
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief decompress a stream made by compress()
+//! \details every read and write is bounds checked, so a damaged stream fails instead of overrunning
+//! \param[in] data	compressed stream
+//! \param[in] size	stream size in bytes
+//! \param[out] dst	output buffer
+//! \param[in] len	expected output size
+//! \return		true if exactly len bytes were produced
+// every read and write is bounds checked, so a damaged stream fails instead of overrunning
+bool LZ::decompress(const char *data, int size, char *dst, int len)
+{
+	const unsigned char *p		= (const unsigned char*)data;
+	const unsigned char *end	= p + size;
+	unsigned char *out			= (unsigned char*)dst;
+	unsigned char *outEnd		= out + len;
+
+	while (p < end)
+	{
+		int token		= *p++;
+		int litLen		= token >> 4;
+		if (litLen == 15 && !getLength(p, end, litLen))
+			return false;
+		if (litLen > end - p || litLen > outEnd - out)
+			return false;
+		memcpy(out, p, litLen);
+		out				+= litLen;
+		p				+= litLen;
+
+		if (p == end)
+			break;		// last sequence
+
+		if (end - p < 2)
+			return false;
+		int offset		= p[0] | (p[1] << 8);
+		p				+= 2;
+		int matchLen	= token & 15;
+		if (matchLen == 15 && !getLength(p, end, matchLen))
+			return false;
+		matchLen		+= MIN_MATCH;
+
+		if (offset == 0 || offset > out - (unsigned char*)dst || matchLen > outEnd - out)
+			return false;
+
+		const unsigned char *ref	= out - offset;
+		if (offset >= matchLen)
+			memcpy(out, ref, matchLen);
+		else
+		{	// overlapping copy repeats the last offset bytes
+			for (int i = 0; i < matchLen; i++)
+				out[i]	= ref[i];
+		}
+		out				+= matchLen;
+	}
+	return out == outEnd;
+}
@@ -0,0 +1,30 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class LZ
+//! \brief Fast byte oriented LZ77 codec
+//!
+//! \file lzcodec.h
+//! \brief LZ codec class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				LZCODEC_H
+#define				LZCODEC_H
+
+#include			<QByteArray>
+
+// LZ class
+class LZ
+{
+public:
+	//! \brief compress len bytes; the output never grows by more than len / 255 + 16 bytes
+	static QByteArray	compress		(const char*, int len);
+	//! \brief decompress into exactly len bytes; false if the data is corrupt
+	static bool			decompress		(const char*, int size, char*, int len);
+};
+#endif
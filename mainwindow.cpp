@@ -12,7 +12,10 @@
 //! \brief Mainwindow implementation.
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+#include			<cmath>
+
 #include 			"mainwindow.h"
+#include			"trace.h"
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // CONSTRUCTOR
@@ -29,6 +32,9 @@ MainWindow::MainWindow()
 	setCentralWidget		(mainSplit);
 	setWindowTitle			(tr("Version 2.0 IManip"));
 
+	// init thumbnail pipeline
+	m_thumbnailer			= new Thumbnailer(this);
+
 	// init groupBox
 	createGroupBoxImages	();
 
@@ -82,9 +88,14 @@ MainWindow::MainWindow()
 	// init history manager
 	m_thumbnailManager 	= new historyManager();
 
+	// init background decoding of opened files
+	m_loader			= new ImageLoader(this);
+	connect(m_loader, SIGNAL(loaded(QString, QImage)),			this, SLOT(imageLoaded(QString, QImage)));
+	connect(m_loader, SIGNAL(failed(QString, QString)),			this, SLOT(imageFailed(QString, QString)));
+	connect(m_loader, SIGNAL(finished(int, int, qint64, int)),	this, SLOT(imagesOpened(int, int, qint64, int)));
+
 	statusBar()			->showMessage(tr("Ready"), 2000);
-	m_logTabText		->append(tr("Ready\n"));
-	m_logTabTextEdit	->setText((*m_logTabText));
+	log					(ActivityLog::General, tr("Ready"));
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -101,12 +112,43 @@ void MainWindow::createActions()
 {
 	m_actOpen				= new QAction	(QIcon(":/images/file_open.xpm"), tr("&Open"), this);
 	m_actOpen				->setShortcut	(tr("Ctrl+O"));
-	m_actOpen				->setStatusTip	(tr("Open new image"));
+	m_actOpen				->setStatusTip	(tr("Open new images"));
+
+	m_actOpenFolder			= new QAction	(tr("Open &folder..."), this);
+	m_actOpenFolder			->setStatusTip	(tr("Open every image of a folder"));
+
+	m_actOpenProject		= new QAction	(tr("Open &project..."), this);
+	m_actOpenProject		->setStatusTip	(tr("Add the images, history and layout of a project to the session"));
+
+	m_actSaveProject		= new QAction	(tr("&Save project..."), this);
+	m_actSaveProject		->setShortcut	(tr("Ctrl+S"));
+	m_actSaveProject		->setStatusTip	(tr("Save the images, history and layout of the session"));
 
 	m_actExit				= new QAction	(QIcon(":/images/file_quit.xpm"), tr("E&xit"), this);
 	m_actExit				->setShortcut	(tr("Ctrl+Q"));
 	m_actExit				->setStatusTip	(tr("Exit the program"));
 
+	m_actUndo				= new QAction	(tr("&Undo"), this);
+	m_actUndo				->setShortcut	(tr("Ctrl+Z"));
+	m_actUndo				->setStatusTip	(tr("Undo the last edit of the active frame"));
+
+	m_actRedo				= new QAction	(tr("&Redo"), this);
+	m_actRedo				->setShortcut	(tr("Ctrl+Y"));
+	m_actRedo				->setStatusTip	(tr("Redo the last undone edit of the active frame"));
+
+	m_actBudget				= new QAction	(tr("Memory &budget..."), this);
+	m_actBudget				->setStatusTip	(tr("Memory for images that are not on screen; the rest is cached on disk"));
+
+	m_actTexBudget			= new QAction	(tr("Te&xture budget..."), this);
+	m_actTexBudget			->setStatusTip	(tr("Video memory for textures; textures of images that are not on screen are deleted first"));
+
+	m_actTrace				= new QAction	(tr("Record &trace"), this);
+	m_actTrace				->setCheckable	(true);
+	m_actTrace				->setStatusTip	(tr("Time opening, image processing, drawing and 4PCS; the trace is saved when recording stops"));
+
+	m_actRerun				= new QAction	(tr("Re-run from &here..."), this);
+	m_actRerun				->setStatusTip	(tr("Change the parameters of the active image and recompute everything derived from it"));
+
 	m_customize				= new QAction	(tr("Customize"), this);
 	m_customize				->setStatusTip	(tr("Customize the windows layout"));
 
@@ -132,6 +174,25 @@ void MainWindow::createActions()
 	m_IPColor				= new QAction	(QIcon(":/images/pt_lut.xpm"), tr("Color"), ipGroup);
 	m_IPThres				= new QAction	(QIcon(":/images/pt_thr.xpm"), tr("Threshold"), ipGroup);
 	m_IPEdge				= new QAction	(QIcon(":/images/nbr_edge.xpm"), tr("Edge detection"), ipGroup);
+	m_IPFreq				= new QAction	(tr("Frequency filter"), ipGroup);
+	m_IPSmooth				= new QAction	(tr("Edge preserving smoothing"), ipGroup);
+	m_IPRegions				= new QAction	(tr("Connected regions"), ipGroup);
+	m_IPHough				= new QAction	(tr("Hough transform"), ipGroup);
+	m_IPDistance			= new QAction	(tr("Distance transform"), ipGroup);
+	m_IPMatch				= new QAction	(tr("Template matching"), ipGroup);
+	m_IPWarp				= new QAction	(tr("Warp"), ipGroup);
+	m_IPWarp				->setStatusTip	(tr("Resample the active image through a 3x3 matrix"));
+
+	// two image arithmetic; every action carries its BinaryOp::Op through the mapper
+	m_combineMap			= new QSignalMapper(this);
+	for (int op = 0; op < BinaryOp::NumOps; op++)
+	{
+		m_IPCombine[op]		= new QAction	(BinaryOp::name((BinaryOp::Op)op), this);
+		m_IPCombine[op]		->setStatusTip	(tr("Combine the active frame with the next frame"));
+		m_combineMap		->setMapping	(m_IPCombine[op], op);
+		connect(m_IPCombine[op],	SIGNAL(triggered()), m_combineMap, SLOT(map()));
+	}
+	connect(m_combineMap,		SIGNAL(mapped(int)), this, SLOT(ipCombine(int)));
 
 	ipGroup					->setExclusive	(true);
 	ipGroup					->setVisible	(true);
@@ -143,7 +204,16 @@ void MainWindow::createActions()
 	m_act4PCSmultiple		= new QAction	(tr("Multiple registrations"),	this);
 
 	connect(m_actOpen,			SIGNAL(triggered()), this, SLOT(open()));
+	connect(m_actOpenFolder,	SIGNAL(triggered()), this, SLOT(openFolder()));
+	connect(m_actOpenProject,	SIGNAL(triggered()), this, SLOT(openProject()));
+	connect(m_actSaveProject,	SIGNAL(triggered()), this, SLOT(saveProject()));
 	connect(m_actExit,			SIGNAL(triggered()), qApp, SLOT(quit()));
+	connect(m_actUndo,			SIGNAL(triggered()), m_lay1, SLOT(undo()));
+	connect(m_actRedo,			SIGNAL(triggered()), m_lay1, SLOT(redo()));
+	connect(m_actBudget,		SIGNAL(triggered()), this, SLOT(memoryBudget()));
+	connect(m_actTexBudget,		SIGNAL(triggered()), this, SLOT(textureBudget()));
+	connect(m_actTrace,			SIGNAL(toggled(bool)), this, SLOT(trace(bool)));
+	connect(m_actRerun,			SIGNAL(triggered()), this, SLOT(rerun()));
 	connect(m_customize,		SIGNAL(triggered()), this, SLOT(customize()));
 	connect(m_actLay0,			SIGNAL(triggered()), this, SLOT(layout0())); // layout 1x1
 	connect(m_actLay1,			SIGNAL(triggered()), this, SLOT(layout1())); // layout 1 top, 1 bottom
@@ -153,6 +223,13 @@ void MainWindow::createActions()
 	connect(m_IPColor,			SIGNAL(triggered()), this, SLOT(ipColor()));
 	connect(m_IPThres,			SIGNAL(triggered()), this, SLOT(ipThreshold()));
 	connect(m_IPEdge,			SIGNAL(triggered()), this, SLOT(ipEdgeDet()));
+	connect(m_IPFreq,			SIGNAL(triggered()), this, SLOT(ipFrequency()));
+	connect(m_IPSmooth,			SIGNAL(triggered()), this, SLOT(ipSmooth()));
+	connect(m_IPRegions,		SIGNAL(triggered()), this, SLOT(ipRegions()));
+	connect(m_IPHough,			SIGNAL(triggered()), this, SLOT(ipHough()));
+	connect(m_IPDistance,		SIGNAL(triggered()), this, SLOT(ipDistance()));
+	connect(m_IPMatch,			SIGNAL(triggered()), this, SLOT(ipMatch()));
+	connect(m_IPWarp,			SIGNAL(triggered()), this, SLOT(ipWarp()));
 	connect(m_actOpenDepth,		SIGNAL(triggered()), this, SLOT(openDepth()));
 	connect(m_act4PCSsingle,	SIGNAL(triggered()), this, SLOT(single4PCS()));
 	connect(m_act4PCSmultiple,	SIGNAL(triggered()), this, SLOT(multiple4PCS()));
@@ -167,10 +244,25 @@ void MainWindow::createMenus()
 	// File menu
 	m_menuFile		= new QMenu	(tr("&File"), this);
 	m_menuFile		->addAction	(m_actOpen);
+	m_menuFile		->addAction	(m_actOpenFolder);
 	m_menuFile		->addAction	(m_actOpenDepth);
 	m_menuFile		->addSeparator	();
+	m_menuFile		->addAction	(m_actOpenProject);
+	m_menuFile		->addAction	(m_actSaveProject);
+	m_menuFile		->addSeparator	();
 	m_menuFile		->addAction	(m_actExit);
 
+	// Edit menu
+	m_menuEdit		= new QMenu	(tr("&Edit"), this);
+	m_menuEdit		->addAction	(m_actUndo);
+	m_menuEdit		->addAction	(m_actRedo);
+	m_menuEdit		->addSeparator	();
+	m_menuEdit		->addAction	(m_actRerun);
+	m_menuEdit		->addSeparator	();
+	m_menuEdit		->addAction	(m_actBudget);
+	m_menuEdit		->addAction	(m_actTexBudget);
+	m_menuEdit		->addAction	(m_actTrace);
+
 	// Recent layout menu
 	m_recentLayout	= new QMenu	(tr("Recently Customized Layout"), this);
 	m_recentLayout	->setIcon	(QIcon(":/images/file_recent.xpm"));
@@ -192,6 +284,17 @@ void MainWindow::createMenus()
 	m_menuIP		->addAction	(m_IPColor);
 	m_menuIP		->addAction	(m_IPThres);
 	m_menuIP		->addAction	(m_IPEdge);
+	m_menuIP		->addAction	(m_IPFreq);
+	m_menuIP		->addAction	(m_IPSmooth);
+	m_menuIP		->addAction	(m_IPRegions);
+	m_menuIP		->addAction	(m_IPHough);
+	m_menuIP		->addAction	(m_IPDistance);
+	m_menuIP		->addAction	(m_IPMatch);
+	m_menuIP		->addAction	(m_IPWarp);
+
+	m_menuCombine	= m_menuIP->addMenu(tr("Combine frames"));
+	for (int op = 0; op < BinaryOp::NumOps; op++)
+		m_menuCombine	->addAction	(m_IPCombine[op]);
 
 	// 4PCS menu
 	m_menu4PCS		= new QMenu	(tr("4PCS"), this);
@@ -199,6 +302,7 @@ void MainWindow::createMenus()
 	m_menu4PCS		->addAction	(m_act4PCSmultiple);
 
 	menuBar()		->addMenu	(m_menuFile);
+	menuBar()		->addMenu	(m_menuEdit);
 	menuBar()		->addMenu	(m_menuLayout);
 	menuBar()		->addMenu	(m_menuIP);
 	menuBar()		->addMenu	(m_menu4PCS);
@@ -233,44 +337,132 @@ void MainWindow::createToolBars()
 //	Slot for opening images
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Open slot
-//! \details open images
+//! \details open images; any number of files can be selected
 void MainWindow::open()
 {
-	QString filePath = QFileDialog::getOpenFileName(this, tr("Open Image File"), QDir::currentPath());
-	QFileInfo pathInfo (filePath);
+	QStringList files	= QFileDialog::getOpenFileNames(this, tr("Open Image Files"), QDir::currentPath());
+	openFiles			(files);
+}
 
-	if(!filePath.isEmpty())
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for opening folders
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Open folder slot
+//! \details open every image file of a folder that a decoder is installed for
+// open every image file of a folder that a decoder is installed for
+void MainWindow::openFolder()
+{
+	QString dir			= QFileDialog::getExistingDirectory(this, tr("Open Folder"), QDir::currentPath());
+	if (dir.isEmpty())
+		return;
+
+	QStringList files	= ImageLoader::imageFiles(dir);
+	if (files.isEmpty())
 	{
-		QImage img (filePath);
-		if (img.isNull())
-		{
-			QMessageBox::information(this, tr("Open"), tr("Cannot open %1.").arg(filePath));
-			m_logTabText		->append(tr("Could not open file: "));
-			m_logTabText		->append(tr(((pathInfo.fileName()).toAscii())));
-			m_logTabText		->append("\n");
-			m_logTabTextEdit	->setText((*m_logTabText));
-			return;
-		}
+		statusBar()		->showMessage(tr("There are no image files in %1").arg(dir), 2000);
+		return;
+	}
+	openFiles			(files);
+}
 
-		// Pass image's name and the image itself to layoutwindow
-		m_lay1 				->open(pathInfo.fileName(), img);
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Open image files
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief decode image files in the background
+//! \details the files are decoded on the loader's workers; every image is added by imageLoaded() as soon as
+//!	it is ready, so the window stays responsive
+//! \param[in] files	paths of the files
+// the files are decoded on the loader's workers; every image is added as soon as it is ready
+void MainWindow::openFiles(const QStringList &files)
+{
+	if (files.isEmpty())
+		return;
 
-		m_imageManager		= new imageInfo(&img, pathInfo, filePath);
-		(*m_thumbnailManager).addImageHistory(m_imageManager);
-		addImage(pathInfo.fileName(), img);
+	log					(ActivityLog::File, tr("Opening %1 file(s)").arg(files.size()));
+	m_loader			->load(files);
+}
 
-		// Display image in a preview
-		m_OpenGLWidget		->storeImage(pathInfo.fileName(), img);
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for a decoded image file
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief an image file has been decoded
+//! \details the image goes to the list and the history, and into the next free frame. A single file takes
+//!	the next frame even if it holds an image, as opening always did; a batch never replaces what is shown
+//! \param[in] filePath	the file
+//! \param[in] img		the image
+// a single file takes the next frame even if it holds an image; a batch never replaces what is shown
+void MainWindow::imageLoaded(QString filePath, QImage img)
+{
+	TRACE("MainWindow::imageLoaded");
+	QFileInfo pathInfo (filePath);
 
-		setInformationTabWidgetLabels(m_imageManager);
+	// a file that is already open shares the stored pixels instead of loading them twice
+	ImageHandle handle	= addImage(pathInfo.fileName(), img, filePath);
+	img					= ImageStore::instance()->image(handle);
+
+	// Pass image's name and the image itself to layoutwindow
+	bool shown			= m_lay1->openFree(pathInfo.fileName(), img);
+	if (!shown && m_loader->total() == 1)
+	{
+		m_lay1			->open(pathInfo.fileName(), img);
+		shown			= true;
+	}
 
-		// record the history
-		m_logTabText		->append(tr(((pathInfo.fileName()).toAscii())));
-		m_logTabText		->append(tr(" has been opened\n"));
-		m_logTabTextEdit	->setText((*m_logTabText));
+	m_imageManager		= new imageInfo(&img, pathInfo, filePath);
+	m_imageManager		->setHandle(handle);
+	recordHistory		(m_imageManager);
 
-		statusBar()			->showMessage(tr("%1 has been opened").arg(pathInfo.fileName()), 2000);
+	if (shown)
+	{	// Display image in a preview
+		m_OpenGLWidget	->storeImage(pathInfo.fileName(), img);
+		setInformationTabWidgetLabels(m_imageManager);
 	}
+
+	// record the history
+	log					(ActivityLog::File, tr("%1 has been opened").arg(pathInfo.fileName()), -1, img.numBytes());
+
+	int left			= m_loader->pending() - 1;
+	if (left)
+		statusBar()		->showMessage(tr("%1 has been opened; %2 to go").arg(pathInfo.fileName()).arg(left));
+	else
+		statusBar()		->showMessage(tr("%1 has been opened").arg(pathInfo.fileName()), 2000);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for an image file that could not be decoded
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief an image file could not be decoded
+//! \details a single file is reported in a message box; failures of a batch only go to the log
+//! \param[in] filePath	the file
+//! \param[in] error	why it could not be decoded
+// a single file is reported in a message box; failures of a batch only go to the log
+void MainWindow::imageFailed(QString filePath, QString error)
+{
+	QFileInfo pathInfo (filePath);
+	if (m_loader->total() == 1)
+		QMessageBox::information(this, tr("Open"), tr("Cannot open %1.").arg(filePath));
+
+	log					(ActivityLog::Error, tr("Could not open file: %1 (%2)").arg(pathInfo.fileName()).arg(error));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for the end of a batch of image files
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief every requested image file is done
+//! \details the decode throughput goes to the log
+//! \param[in] loaded	# of files opened
+//! \param[in] failed	# of files that could not be decoded
+//! \param[in] bytes	size of the opened files
+//! \param[in] ms		time from the first request
+// the decode throughput goes to the log
+void MainWindow::imagesOpened(int loaded, int failed, qint64 bytes, int ms)
+{
+	double seconds		= qMax(ms, 1) / 1000.0;
+	log					(ActivityLog::File, tr("Opened %1 of %2 file(s): %3 images/s")
+							.arg(loaded).arg(loaded + failed).arg(loaded / seconds, 0, 'f', 1), ms, bytes);
+
+	if (failed)
+		statusBar()		->showMessage(tr("%1 file(s) could not be opened; see the log").arg(failed), 2000);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -288,22 +480,290 @@ void MainWindow::openDepth()
 		if (pathInfo.completeSuffix() != "ptx")
 		{
 			QMessageBox::information(this, tr("Open Depth file"), tr("%1 is not a depth file (.ptx)").arg(filePath));
-			m_logTabText		->append(tr(((pathInfo.fileName()).toAscii())));
-			m_logTabText		->append(tr(" is not a depth file (.ptx)\n"));
-			m_logTabTextEdit	->setText((*m_logTabText));
+			log					(ActivityLog::Error, tr("%1 is not a depth file (.ptx)").arg(pathInfo.fileName()));
 			return;
 		}
 
 		string temp				= filePath.toStdString();
 		m_lay1					->openDepthImg(pathInfo.fileName(), temp);
 
-		m_logTabText			->append(tr(((pathInfo.baseName()).toAscii())));
-		m_logTabText			->append(tr(" has been opened\n"));
-		m_logTabTextEdit		->setText((*m_logTabText));
+		log						(ActivityLog::File, tr("%1 has been opened").arg(pathInfo.baseName()));
 		statusBar()				->showMessage(tr("%1 has been opened").arg(pathInfo.baseName()), 2000);
 	}
 }
 
+// index of an image in the project being saved; the image gets the next index on first use, -1 for none
+static int projectIndex(ImageHandle handle, QVector<ImageHandle> &handles, QHash<ImageHandle, int> &index)
+{
+	if (!handle)
+		return -1;
+	QHash<ImageHandle, int>::const_iterator i	= index.constFind(handle);
+	if (i != index.constEnd())
+		return *i;
+	index				.insert(handle, handles.size());
+	handles				.append(handle);
+	return handles.size() - 1;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for saving projects
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief save the session to a project file
+//! \details every image of the list, the history and the frames is written once as the compressed bands
+//!	of the image store; an image that is already on disk is copied without expanding it. The image table
+//!	with the thumbnail list, the history and the layout follow as small chunks. The file is written
+//!	next to the old one and only replaces it when complete. Afterwards the store reads spilled images
+//!	back from the project, so the disk cache copies are given up
+// every image is written once as compressed bands; the file only replaces the old one when complete
+void MainWindow::saveProject()
+{
+	QString path		= QFileDialog::getSaveFileName(this, tr("Save Project"), QDir::currentPath(), tr("IManip projects (*.imp)"));
+	if (path.isEmpty())
+		return;
+
+	ImageStore *store	= ImageStore::instance();
+	QTime timer;
+	timer				.start();
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+
+	QVector<ImageHandle> handles;			// images in project order
+	QHash<ImageHandle, int> index;			// handle -> project index
+	QVector<ImageHandle> frameRefs;			// references held on the frame images while saving
+
+	// thumbnail list
+	QByteArray list;
+	QDataStream listOut(&list, QIODevice::WriteOnly);
+	listOut				.setVersion(QDataStream::Qt_4_0);
+	listOut				<< (quint32)m_thumbModel->rowCount();
+	for (int row = 0; row < m_thumbModel->rowCount(); row++)
+	{
+		listOut			<< (qint32)projectIndex(m_thumbModel->handle(row), handles, index)
+						<< m_thumbModel->name(row) << m_thumbModel->thumbnail(row);
+	}
+
+	// history, sources first; parents are referred to by their ids in the file
+	QByteArray history;
+	QDataStream historyOut(&history, QIODevice::WriteOnly);
+	historyOut			.setVersion(QDataStream::Qt_4_0);
+	QVector<int> ids	= m_thumbnailManager->ids();
+	historyOut			<< (quint32)ids.size();
+	for (int i = 0; i < ids.size(); i++)
+	{
+		imageInfo *info	= m_thumbnailManager->find(ids[i]);
+		historyOut		<< (qint32)ids[i] << (qint32)projectIndex(info->getHandle(), handles, index)
+						<< m_thumbnailManager->parents(ids[i]);
+		info			->write(historyOut);
+	}
+
+	// layout and frame contents; edits made in a frame are images of their own
+	QByteArray layout;
+	QDataStream layoutOut(&layout, QIODevice::WriteOnly);
+	layoutOut			.setVersion(QDataStream::Qt_4_0);
+	int rows, cols, orient;
+	QVector<int> spec;
+	m_lay1				->layoutSpec(rows, cols, orient, spec);
+	layoutOut			<< (qint32)rows << (qint32)cols << (qint32)orient << spec << (qint32)m_lay1->frameCount();
+	for (int i = 0; i < m_lay1->frameCount(); i++)
+	{
+		QImage img		= m_lay1->frameImage(i);
+		ImageHandle handle	= 0;
+		if (!img.isNull())
+		{
+			handle		= store->insert(img);
+			frameRefs	<< handle;
+		}
+		layoutOut		<< (qint32)projectIndex(handle, handles, index) << m_lay1->frameName(i);
+	}
+	layoutOut			<< (qint32)m_lay1->activeFrame() << (qint32)m_lay1->nextFrame();
+
+	// compressed bands, one chunk per image
+	ProjectFile project;
+	bool ok				= project.create(path);
+	QVector<StoredImage> stored(handles.size());
+	QVector<qint64> offsets(handles.size(), -1);
+	qint64 bytes		= 0;
+	for (int i = 0; i < handles.size() && ok; i++)
+	{
+		QByteArray data;
+		ok				= store->compressed(handles[i], stored[i], data);
+		if (ok)
+			offsets[i]	= project.write(ProjectFile::Bands, i, data);
+		ok				= ok && offsets[i] >= 0;
+		bytes			+= data.size();
+	}
+
+	// image table, then the thumbnail list
+	QByteArray images;
+	QDataStream imagesOut(&images, QIODevice::WriteOnly);
+	imagesOut			.setVersion(QDataStream::Qt_4_0);
+	imagesOut			<< (quint32)handles.size();
+	for (int i = 0; i < stored.size(); i++)
+	{
+		imagesOut		<< stored[i].hash.lo << stored[i].hash.hi
+						<< (qint32)stored[i].width << (qint32)stored[i].height << (qint32)stored[i].format
+						<< stored[i].colors << stored[i].bands;
+	}
+	images				.append(list);
+
+	ok					= ok && project.write(ProjectFile::Images, 0, images) >= 0
+							 && project.write(ProjectFile::History, 0, history) >= 0
+							 && project.write(ProjectFile::Layout, 0, layout) >= 0
+							 && project.finish();
+	if (ok)
+	{	// the project is the disk copy from now on
+		for (int i = 0; i < handles.size(); i++)
+			store		->setStored(handles[i], stored[i], path, offsets[i]);
+	}
+	for (int i = 0; i < frameRefs.size(); i++)
+		store			->unref(frameRefs[i]);
+	QApplication::restoreOverrideCursor();
+
+	if (!ok)
+	{
+		QMessageBox::information(this, tr("Save project"), tr("Cannot save %1: %2").arg(path).arg(project.errorString()));
+		log				(ActivityLog::Error, tr("Could not save project %1: %2").arg(path).arg(project.errorString()));
+		return;
+	}
+
+	log					(ActivityLog::File, tr("Saved project %1: %2 image(s), %3 record(s), %4 KB of bands")
+							.arg(path).arg(handles.size()).arg(ids.size()).arg(bytes >> 10), timer.elapsed(), bytes);
+	statusBar()			->showMessage(tr("%1 has been saved").arg(QFileInfo(path).fileName()), 2000);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for opening projects
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add a project to the session
+//! \details only the table of contents and the small chunks are read. The images go to the image store
+//!	as spilled entries that point into the project; the list shows the saved thumbnails, so the only
+//!	pixels read now are those of the frames on screen. Everything else is read on first use
+// only the table of contents and the small chunks are read; only the images in the frames are decoded
+void MainWindow::openProject()
+{
+	QString path		= QFileDialog::getOpenFileName(this, tr("Open Project"), QDir::currentPath(), tr("IManip projects (*.imp)"));
+	if (path.isEmpty())
+		return;
+
+	QTime timer;
+	timer				.start();
+	ProjectFile project;
+	QByteArray images	= project.open(path) ? project.read(ProjectFile::Images) : QByteArray();
+	if (images.isEmpty())
+	{
+		QMessageBox::information(this, tr("Open project"), tr("Cannot open %1: %2").arg(path).arg(project.errorString()));
+		log				(ActivityLog::Error, tr("Could not open project %1: %2").arg(path).arg(project.errorString()));
+		return;
+	}
+
+	// image table; the store holds one reference per image until the end
+	ImageStore *store	= ImageStore::instance();
+	QVector<ImageHandle> handles;
+	QDataStream in(images);
+	in					.setVersion(QDataStream::Qt_4_0);
+	quint32 count		= 0;
+	in					>> count;
+	for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+	{
+		StoredImage info;
+		qint32 width, height, format;
+		in				>> info.hash.lo >> info.hash.hi >> width >> height >> format >> info.colors >> info.bands;
+		info.width		= width;
+		info.height		= height;
+		info.format		= format;
+		qint64 pos		= project.offset(ProjectFile::Bands, i);
+		handles			<< (in.status() == QDataStream::Ok && pos >= 0 ? store->insertStored(info, path, pos) : 0);
+	}
+
+	// thumbnail list
+	quint32 rows		= 0;
+	in					>> rows;
+	for (quint32 row = 0; row < rows && in.status() == QDataStream::Ok; row++)
+	{
+		qint32 image;
+		QString name;
+		QImage thumb;
+		in				>> image >> name >> thumb;
+		ImageHandle handle	= handles.value(image);
+		if (!handle || in.status() != QDataStream::Ok)
+			continue;
+		store			->ref(handle);
+		m_thumbModel	->addImage(name, handle, QString(), thumb);
+	}
+
+	// history; ids in the file map to the new records
+	QByteArray history	= project.read(ProjectFile::History);
+	QDataStream historyIn(history);
+	historyIn			.setVersion(QDataStream::Qt_4_0);
+	QHash<int, imageInfo*> records;
+	quint32 recordCount	= 0;
+	historyIn			>> recordCount;
+	for (quint32 i = 0; i < recordCount && historyIn.status() == QDataStream::Ok; i++)
+	{
+		qint32 id, image;
+		QVector<int> parents;
+		historyIn		>> id >> image >> parents;
+
+		QLinkedList<imageInfo*> parentList;
+		for (int j = 0; j < parents.size(); j++)
+			if (records.contains(parents[j]))
+				parentList	<< records.value(parents[j]);
+
+		imageInfo *info	= new imageInfo(historyIn, parentList);
+		if (historyIn.status() != QDataStream::Ok)
+		{
+			delete info;
+			break;
+		}
+		info			->setHandle(handles.value(image));
+		recordHistory	(info);
+		records			.insert(id, info);
+	}
+
+	// layout; the frames are the only images read now
+	QByteArray layout	= project.read(ProjectFile::Layout);
+	QDataStream layoutIn(layout);
+	layoutIn			.setVersion(QDataStream::Qt_4_0);
+	qint32 layRows = 0, layCols = 0, orient = 0, frames = 0;
+	QVector<int> spec;
+	layoutIn			>> layRows >> layCols >> orient >> spec >> frames;
+
+	bool valid			= layoutIn.status() == QDataStream::Ok && layRows > 0 && layRows <= MAX_ROWS
+							&& layCols > 0 && layCols <= MAX_COLS && orient >= LayoutWindow::GRID
+							&& orient <= LayoutWindow::VERTICAL && frames <= MAX_SPLIT;
+	valid				= valid && spec.size() == (orient == LayoutWindow::HORIZONTAL ? layCols
+							: (orient == LayoutWindow::VERTICAL ? layRows : 0));
+	for (int i = 0; i < spec.size(); i++)
+		valid			= valid && spec[i] > 0 && spec[i] <= MAX;
+	int loaded			= 0;
+	if (valid)
+	{
+		spec			.append(-1);		// grid layouts have no spec
+		m_lay1			->custLayout(layRows, layCols, orient, spec.data());
+		for (int i = 0; i < frames && layoutIn.status() == QDataStream::Ok; i++)
+		{
+			qint32 image;
+			QString name;
+			layoutIn	>> image >> name;
+			ImageHandle handle	= handles.value(image);
+			if (!handle)
+				continue;
+			m_lay1		->setFrameImage(i, name, store->image(handle));
+			loaded++;
+		}
+		qint32 active = 0, next = 0;
+		layoutIn		>> active >> next;
+		m_lay1			->setFrames(active, next);
+	}
+
+	for (int i = 0; i < handles.size(); i++)
+		if (handles[i])
+			store		->unref(handles[i]);
+
+	log					(ActivityLog::File, tr("Opened project %1: %2 image(s), %3 record(s), %4 read")
+							.arg(path).arg(handles.size()).arg(records.size()).arg(loaded), timer.elapsed());
+	statusBar()			->showMessage(tr("%1 has been opened").arg(QFileInfo(path).fileName()), 2000);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Customize layout
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -488,8 +948,7 @@ void MainWindow::layout0()
 	m_lay1					->custLayout(1, 1, LayoutWindow::GRID, m_spec);
 	statusBar()				->showMessage(tr("Layout changed: 1x1"), 2000);
 
-	m_logTabText			->append(tr("Layout changed: 1x1\n"));
-	m_logTabTextEdit		->setText((*m_logTabText));
+	log						(ActivityLog::General, tr("Layout changed: 1x1"));
 
 	update					();
 }
@@ -506,8 +965,7 @@ void MainWindow::layout1()
 	m_lay1				->custLayout(2, 1, LayoutWindow::GRID, m_spec);
 	statusBar()			->showMessage(tr("Layout changed: 2x1"), 2000);
 
-	m_logTabText		->append(tr("Layout changed: 2x1\n"));
-	m_logTabTextEdit	->setText((*m_logTabText));
+	log					(ActivityLog::General, tr("Layout changed: 2x1"));
 
 	update				();
 }
@@ -525,8 +983,7 @@ void MainWindow::layout2()
 	m_lay1				->custLayout(2, 2, LayoutWindow::VERTICAL, m_spec);
 	statusBar()			->showMessage(tr("Layout changed: 1 top, 2 bottom"), 2000);
 
-	m_logTabText		->append(tr("Layout changed: 1 top, 2 bottom\n"));
-	m_logTabTextEdit	->setText((*m_logTabText));
+	log					(ActivityLog::General, tr("Layout changed: 1 top, 2 bottom"));
 
 	update				();
 }
@@ -544,8 +1001,7 @@ void MainWindow::layout3()
 	m_lay1				->custLayout(2, 2, LayoutWindow::HORIZONTAL, m_spec);
 	statusBar()			->showMessage(tr("Layout changed: 1 left, 2 right"), 2000);
 
-	m_logTabText		->append(tr("Layout changed: 1 left, 2 right\n"));
-	m_logTabTextEdit	->setText((*m_logTabText));
+	log					(ActivityLog::General, tr("Layout changed: 1 left, 2 right"));
 
 	update				();
 }
@@ -562,8 +1018,7 @@ void MainWindow::layout4()
 	m_lay1				->custLayout(2, 2, LayoutWindow::GRID, m_spec);
 	statusBar()			->showMessage(tr("Layout changed: 2x2"), 2000);
 
-	m_logTabText		->append(tr("Layout changed: 2x2\n"));
-	m_logTabTextEdit	->setText((*m_logTabText));
+	log					(ActivityLog::General, tr("Layout changed: 2x2"));
 
 	update				();
 }
@@ -590,22 +1045,68 @@ void MainWindow::message(QString msg)
 // pass image pointer to navigator's class
 void MainWindow::imageCreated(QImage *img, QString name)
 {
-	m_imageManager		= new imageInfo(img, name);	// generate the image info
-	(*m_thumbnailManager).addImageHistory(m_imageManager);	// add the info to history table
-	addImage(name, *img);
+	imageDerived		(img, name, QLinkedList<imageInfo*>(), "New Image");
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// New image derived from open images
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief record an image created by an operation on other images
+//! \details same as imageCreated(), but the history keeps the source images and the operation
+//! \param[in] img		Image pointer of the image.
+//! \param[in] name		the image name
+//! \param[in] parents	records of the source images
+//! \param[in] op		the operation
+//! \param[in] params	parameters to run the operation again; kind None if it cannot be
+// same as imageCreated(), but the history keeps the source images and the operation
+void MainWindow::imageDerived(QImage *img, QString name, QLinkedList<imageInfo*> parents, QString op, const OpParams &params)
+{
+	m_imageManager		= new imageInfo(img, name, parents, op);	// generate the image info
+	m_imageManager		->setParams(params);
+	m_imageManager		->setHandle(addImage(name, *img));
+	recordHistory		(m_imageManager);			// add the info to history table
 
 	m_OpenGLWidget		->storeImage(name, *img);	// display the image in navigator
 
 	setInformationTabWidgetLabels(m_imageManager);
 
 	// record history
-	m_logTabText		->append(tr(((name).toAscii())));
-	m_logTabText		->append(tr(" has been created\n"));
-	m_logTabTextEdit	->setText((*m_logTabText));
+	log					(ActivityLog::Image, tr("%1 has been created").arg(name));
 
 	statusBar()			->showMessage(tr("%1 has been createed").arg(name), 2000);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Record an image in the history
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add a record to the history table and to the history tab
+//! \details only the summary line of the new image is appended to the tab; nothing already shown is rebuilt
+//! \param[in] info	record of the image; the history table owns it
+// only the summary line of the new image is appended to the tab; nothing already shown is rebuilt
+void MainWindow::recordHistory(imageInfo *info)
+{
+	int id					= m_thumbnailManager->addImageHistory(info);
+	m_imageHistoryTabTextEdit	->append(m_thumbnailManager->summary(id));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Add a record to the activity log
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add a record to the activity log
+//! \details the record goes to the ring; if it passes the filter of the log tab its line is appended to the
+//!	view, so nothing already shown is rebuilt
+//! \param[in] category	ActivityLog::Category
+//! \param[in] message	what happened
+//! \param[in] ms			wall time of the operation; -1 if not timed
+//! \param[in] bytes		bytes processed; -1 if not measured
+// if the record passes the filter of the log tab its line is appended to the view
+void MainWindow::log(int category, const QString &message, int ms, qint64 bytes)
+{
+	const LogRecord &record	= m_log.add(category, message, ms, bytes);
+	if (ActivityLog::matches(record, m_logCategory->currentIndex() - 1, m_logFilter->text()))
+		m_logView			->appendPlainText(ActivityLog::format(record));
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Current frame changed
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -627,10 +1128,17 @@ void MainWindow::frameChanged(QImage *img, QString name)
 		if((*img).isNull())
 			ipDone(2);	// cannot process null image; as if "Cancel" button has been clicked.
 		else
+		{
+			imageInfo *record	= m_thumbnailManager->findInfo(*img);
+			m_ipWidget	->setStatistics(record ? &record->getStatistics() : 0);
 			m_ipWidget	->imageChanged(*img);
+		}
 	}
 
-	// change image info to reflect current image.
+	// change image info to reflect current image; the record keeps the statistics so nothing is rescanned
+	imageInfo *info		= (*img).isNull() ? 0 : m_thumbnailManager->findInfo(*img);
+	if (info)
+		setInformationTabWidgetLabels(info);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -676,6 +1184,9 @@ void MainWindow::ipThreshold()
 	if (m_tabWidget		->indexOf(m_ipWidget) != -1)
 		m_tabWidget		->removeTab(m_ipTabWidIndex);
 
+	imageInfo *info		= m_thumbnailManager->findInfo(temp);
+	m_ipWidget			->setStatistics(info ? &info->getStatistics() : 0);	// threshold starts at the mean gray level
+
 	m_lay1				->releaseKeyboard();
 	m_ipWidget			->setup(IPDialog::THRESHOLD, temp);
 	m_ipTabWidIndex		= m_tabWidget->addTab(m_ipWidget, tr("IP"));
@@ -706,6 +1217,301 @@ void MainWindow::ipEdgeDet()
 	m_tabWidget			->setCurrentIndex(m_ipTabWidIndex);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP frequency domain filter
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP frequency domain filter
+//! \details brings up the IP dialog box with frequency filter option setup
+// brings up the IP dialog box with frequency filter option setup
+void MainWindow::ipFrequency()
+{	// similar to ipColor()
+	QImage temp			= m_lay1->activeImage();
+	if (temp.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: There is no image to process"), 2000);
+		return;
+	}
+
+	if (m_tabWidget		->indexOf(m_ipWidget) != -1)
+		m_tabWidget		->removeTab(m_ipTabWidIndex);
+
+	m_lay1				->releaseKeyboard();
+	m_ipWidget			->setup(IPDialog::FREQUENCY, temp);
+	m_ipTabWidIndex		= m_tabWidget->addTab(m_ipWidget, tr("IP"));
+	m_tabWidget			->setCurrentIndex(m_ipTabWidIndex);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP edge preserving smoothing
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP edge preserving smoothing
+//! \details brings up the IP dialog box with smoothing option setup
+// brings up the IP dialog box with smoothing option setup
+void MainWindow::ipSmooth()
+{	// similar to ipColor()
+	QImage temp			= m_lay1->activeImage();
+	if (temp.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: There is no image to process"), 2000);
+		return;
+	}
+
+	if (m_tabWidget		->indexOf(m_ipWidget) != -1)
+		m_tabWidget		->removeTab(m_ipTabWidIndex);
+
+	m_lay1				->releaseKeyboard();
+	m_ipWidget			->setup(IPDialog::SMOOTH, temp);
+	m_ipTabWidIndex		= m_tabWidget->addTab(m_ipWidget, tr("IP"));
+	m_tabWidget			->setCurrentIndex(m_ipTabWidIndex);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP connected regions
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP connected regions
+//! \details brings up the IP dialog box with connected region option setup
+// brings up the IP dialog box with connected region option setup
+void MainWindow::ipRegions()
+{	// similar to ipColor()
+	QImage temp			= m_lay1->activeImage();
+	if (temp.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: There is no image to process"), 2000);
+		return;
+	}
+
+	if (m_tabWidget		->indexOf(m_ipWidget) != -1)
+		m_tabWidget		->removeTab(m_ipTabWidIndex);
+
+	m_lay1				->releaseKeyboard();
+	m_ipWidget			->setup(IPDialog::REGIONS, temp);
+	m_ipTabWidIndex		= m_tabWidget->addTab(m_ipWidget, tr("IP"));
+	m_tabWidget			->setCurrentIndex(m_ipTabWidIndex);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP hough transform
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP hough transform
+//! \details brings up the IP dialog box with hough transform option setup
+// brings up the IP dialog box with hough transform option setup
+void MainWindow::ipHough()
+{	// similar to ipColor()
+	QImage temp			= m_lay1->activeImage();
+	if (temp.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: There is no image to process"), 2000);
+		return;
+	}
+
+	if (m_tabWidget		->indexOf(m_ipWidget) != -1)
+		m_tabWidget		->removeTab(m_ipTabWidIndex);
+
+	m_lay1				->releaseKeyboard();
+	m_ipWidget			->setup(IPDialog::HOUGH, temp);
+	m_ipTabWidIndex		= m_tabWidget->addTab(m_ipWidget, tr("IP"));
+	m_tabWidget			->setCurrentIndex(m_ipTabWidIndex);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP distance transform
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP distance transform
+//! \details brings up the IP dialog box with distance transform option setup
+// brings up the IP dialog box with distance transform option setup
+void MainWindow::ipDistance()
+{	// similar to ipColor()
+	QImage temp			= m_lay1->activeImage();
+	if (temp.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: There is no image to process"), 2000);
+		return;
+	}
+
+	if (m_tabWidget		->indexOf(m_ipWidget) != -1)
+		m_tabWidget		->removeTab(m_ipTabWidIndex);
+
+	m_lay1				->releaseKeyboard();
+	m_ipWidget			->setup(IPDialog::DISTANCE, temp);
+	m_ipTabWidIndex		= m_tabWidget->addTab(m_ipWidget, tr("IP"));
+	m_tabWidget			->setCurrentIndex(m_ipTabWidIndex);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP template matching
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP template matching
+//! \details searches the active frame's image for the next frame's image. Matches are outlined on
+//!	the active frame, listed in the log, and the score map is opened as a new image
+// searches the active frame's image for the next frame's image
+void MainWindow::ipMatch()
+{
+	QImage img			= m_lay1->activeImage();
+	QImage templ		= m_lay1->nextImage();
+	if (img.isNull() || templ.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: Open the image in the active frame and the template in the next frame"), 2000);
+		return;
+	}
+	if (templ.width() > img.width() || templ.height() > img.height())
+	{
+		statusBar()		->showMessage(tr("Error: The template is larger than the image"), 2000);
+		return;
+	}
+
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	QVector<MatchResult> result;
+	bool pyramid		= img.width() * img.height() > 1024 * 1024;	// coarse to fine only pays off on large images
+	QTime timer;
+	timer				.start();
+	QImage scoreMap		= TemplateMatch::match(img, templ, 0.8, 10, pyramid, result);
+	int ms				= timer.elapsed();
+	QApplication::restoreOverrideCursor();
+
+	// outline the matches on the searched image before the score map takes over the active frame
+	QVector<QLineF> segments;
+	QString report		= tr("Template matching: %1 match(es)").arg(result.size());
+	for (int i = 0; i < result.size(); i++)
+	{
+		QRectF r		= result[i].rect;
+		segments		<< QLineF(r.left(), r.top(), r.right() + 1, r.top())
+						<< QLineF(r.right() + 1, r.top(), r.right() + 1, r.bottom() + 1)
+						<< QLineF(r.right() + 1, r.bottom() + 1, r.left(), r.bottom() + 1)
+						<< QLineF(r.left(), r.bottom() + 1, r.left(), r.top());
+		report			+= tr("\n  (%1, %2) %3x%4 score %5").arg(result[i].rect.x()).arg(result[i].rect.y())
+							.arg(result[i].rect.width()).arg(result[i].rect.height()).arg(result[i].score, 0, 'f', 3);
+	}
+	m_lay1				->setActiveOverlay(segments);
+
+	QLinkedList<imageInfo*> parents;
+	imageInfo *info		= m_thumbnailManager->findInfo(img);
+	if (info)
+		parents			<< info;
+	info				= m_thumbnailManager->findInfo(templ);
+	if (info)
+		parents			<< info;
+
+	QString newName		= m_lay1->deriveName();
+	m_lay1 				->open(newName, scoreMap);
+	OpParams params;
+	params.kind			= Operation::Matching;
+	params.values["threshold"]	= 0.8;
+	params.values["matches"]	= 10;
+	params.values["pyramid"]	= pyramid;
+
+	imageDerived		(&scoreMap, newName, parents, tr("Template match"), params);
+
+	log					(ActivityLog::Image, report, ms, img.numBytes());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP two image arithmetic
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP two image arithmetic
+//! \details combines the active frame's image with the next frame's image; both are recorded as parents
+//! \param[in] op	BinaryOp::Op to apply
+// combines the active frame's image with the next frame's image; both are recorded as parents
+void MainWindow::ipCombine(int op)
+{
+	QImage first		= m_lay1->activeImage();
+	QImage second		= m_lay1->nextImage();
+	if (first.isNull() || second.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: Open one image in the active frame and one in the next frame"), 2000);
+		return;
+	}
+
+	int weight			= 128;
+	if (op == BinaryOp::Blend)
+	{
+		bool ok;
+		int percent		= QInputDialog::getInteger(this, tr("Blend"), tr("Weight of the next frame (%):"), 50, 0, 100, 1, &ok);
+		if (!ok)
+			return;
+		weight			= (percent * 256 + 50) / 100;
+	}
+
+	QLinkedList<imageInfo*> parents;
+	imageInfo *info		= m_thumbnailManager->findInfo(first);
+	if (info)
+		parents			<< info;
+	info				= m_thumbnailManager->findInfo(second);
+	if (info)
+		parents			<< info;
+
+	QTime timer;
+	timer				.start();
+	QImage result		= BinaryOp::apply((BinaryOp::Op)op, first, second, weight);
+	log					(ActivityLog::Image, BinaryOp::name((BinaryOp::Op)op), timer.elapsed(), (qint64)first.numBytes() + second.numBytes());
+	QString newName		= m_lay1->deriveName();
+	m_lay1 				->open(newName, result);
+	OpParams params;
+	params.kind			= Operation::Arithmetic;
+	params.values["op"]	= op;
+	params.values["weight"]	= weight;
+
+	imageDerived		(&result, newName, parents, BinaryOp::name((BinaryOp::Op)op), params);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for IP warp
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief slot for IP warp
+//! \details Construct a WarpDialog box and resample the active image with the retrieved matrix
+// Construct a WarpDialog box and resample the active image with the retrieved matrix
+void MainWindow::ipWarp()
+{
+	QImage temp			= m_lay1->activeImage();
+	if (temp.isNull())
+	{
+		statusBar()		->showMessage(tr("Error: There is no image to process"), 2000);
+		return;
+	}
+
+	WarpDialog *dial	= new WarpDialog(m_dialog);
+	m_lay1				->releaseKeyboard();
+
+	if (dial->exec() == 1)
+	{
+		double matrix[9];
+		Warp::Interp interp;
+		dial			->retVal(matrix, interp);
+
+		QApplication::setOverrideCursor(Qt::WaitCursor);
+		QTime timer;
+		timer			.start();
+		QImage result	= Warp::apply(temp, matrix, interp);
+		int ms			= timer.elapsed();
+		QApplication::restoreOverrideCursor();
+
+		if (result.isNull())
+			statusBar()	->showMessage(tr("Error: The matrix is singular or the result is too large"), 2000);
+		else
+		{
+			log			(ActivityLog::Image, tr("Warp"), ms, result.numBytes());
+			QLinkedList<imageInfo*> parents;
+			imageInfo *info	= m_thumbnailManager->findInfo(temp);
+			if (info)
+				parents		<< info;
+
+			QString op		= tr("Warp [%1 %2 %3; %4 %5 %6; %7 %8 %9]").arg(matrix[0]).arg(matrix[1]).arg(matrix[2])
+								.arg(matrix[3]).arg(matrix[4]).arg(matrix[5]).arg(matrix[6]).arg(matrix[7]).arg(matrix[8]);
+			QString newName	= m_lay1->deriveName();
+			m_lay1 			->open(newName, result);
+			OpParams params;
+			params.kind		= Operation::Resample;
+			for (int i = 0; i < 9; i++)
+				params.values[QString("m%1").arg(i)]	= matrix[i];
+			params.values["interp"]	= interp;
+
+			imageDerived	(&result, newName, parents, op, params);
+		}
+	}
+
+	m_lay1				->grabKeyboard();
+	delete dial;
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Slot for when IP dialog is done
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -721,10 +1527,26 @@ void MainWindow::ipDone(int val)
 		m_tabWidget			->removeTab(m_ipTabWidIndex);		// remove the dialog box from tab widget (not destroyed)
 		m_tabWidget			->setCurrentIndex(0);				// change view to 1st widget in the tab
 
+		QTime timer;
+		timer				.start();
 		QImage derivedImg	= m_ipWidget->retrieveProcImg();	// retrieve the processed image
-		QString newName		= m_lay1->deriveName();				// always derive name from active frame
-		m_lay1 				->open(newName, derivedImg);		// display the processed image
-		imageCreated		(&derivedImg, newName);				// notify relevant classes that a new image has been created
+		log					(ActivityLog::Image, m_ipWidget->operation(), timer.elapsed(), m_lay1->activeImage().numBytes());
+		if (m_ipWidget		->isOverlay())
+			m_lay1			->setActiveOverlay(m_ipWidget->overlay());	// results are drawn over the active image
+		else
+		{
+			QLinkedList<imageInfo*> parents;					// the dialog works on the active image
+			imageInfo *info	= m_thumbnailManager->findInfo(m_lay1->activeImage());
+			if (info)
+				parents		<< info;
+
+			QString newName	= m_lay1->deriveName();				// always derive name from active frame
+			m_lay1 			->open(newName, derivedImg);		// display the processed image
+			imageDerived	(&derivedImg, newName, parents, m_ipWidget->operation(), m_ipWidget->params());	// notify relevant classes that a new image has been created
+		}
+
+		if (!m_ipWidget		->report().isEmpty())	// measurements made by the operation
+			log				(ActivityLog::Image, m_ipWidget->report());
 	}
 	else if (val == 2)
 	{ // cancel button
@@ -736,10 +1558,26 @@ void MainWindow::ipDone(int val)
 	else if (val == 3)
 	{ // apply button
 	  // similar to ok button, but without closing the dialog box; allowing user to make more configurations
+		QTime timer;
+		timer				.start();
 		QImage derivedImg	= m_ipWidget->retrieveProcImg();
-		QString newName		= m_lay1->deriveName();
-		m_lay1 				->open(newName, derivedImg);
-		imageCreated		(&derivedImg, newName);
+		log					(ActivityLog::Image, m_ipWidget->operation(), timer.elapsed(), m_lay1->activeImage().numBytes());
+		if (m_ipWidget		->isOverlay())
+			m_lay1			->setActiveOverlay(m_ipWidget->overlay());
+		else
+		{
+			QLinkedList<imageInfo*> parents;
+			imageInfo *info	= m_thumbnailManager->findInfo(m_lay1->activeImage());
+			if (info)
+				parents		<< info;
+
+			QString newName	= m_lay1->deriveName();
+			m_lay1 			->open(newName, derivedImg);
+			imageDerived	(&derivedImg, newName, parents, m_ipWidget->operation(), m_ipWidget->params());
+		}
+
+		if (!m_ipWidget		->report().isEmpty())
+			log				(ActivityLog::Image, m_ipWidget->report());
 	}
 }
 
@@ -805,7 +1643,14 @@ void MainWindow::getClouds(int p, int q)
 	Vertex *modelp			= m_lay1->getVertexFromID(p, success1);
 	Vertex *modelq			= m_lay1->getVertexFromID(q, success2);
 
+	QTime timer;
+	timer					.start();
 	m_pcsWidget				->storeClouds(modelp, modelq, success1, success2);
+	if (success1 && success2)
+		log					(ActivityLog::Registration, tr("4PCS registration of frames %1 and %2").arg(p).arg(q), timer.elapsed());
+
+	delete [] modelp;		// the 4PCS handler keeps its own copy of the points
+	delete [] modelq;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -835,93 +1680,354 @@ void MainWindow::drawCloud(Vertex* r, int pid, int qid)
 	m_lay1					->drawCloud(r, pid, qid);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for the image store budget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set the memory budget of the image store
+//! \details images over the budget that are not on screen are cached on disk, least recently used first
+// images over the budget that are not on screen are cached on disk, least recently used first
+void MainWindow::memoryBudget()
+{
+	ImageStore *store	= ImageStore::instance();
+	bool ok;
+
+	m_lay1				->releaseKeyboard();
+	int mb				= QInputDialog::getInteger(this, tr("Memory budget"),
+							tr("Images in memory: %1 MB, on disk: %2 MB\nMemory budget (MB):")
+								.arg(store->residentBytes() >> 20).arg(store->cachedBytes() >> 20),
+							(int)(store->budget() >> 20), 64, 1 << 20, 64, &ok);
+	m_lay1				->grabKeyboard();
+	if (!ok)
+		return;
+
+	store				->setBudget(qint64(mb) << 20);
+	statusBar()			->showMessage(tr("Image memory budget set to %1 MB").arg(mb), 2000);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for the texture cache budget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set the budget of the texture cache
+//! \details over the budget, textures no view shows are deleted least recently used first; textures on screen
+//!	are always kept
+// over the budget, textures no view shows are deleted least recently used first
+void MainWindow::textureBudget()
+{
+	TextureCache *cache	= TextureCache::instance();
+	bool ok;
+
+	m_lay1				->releaseKeyboard();
+	int mb				= QInputDialog::getInteger(this, tr("Texture budget"),
+							tr("Textures: %1 MB\nTexture budget (MB):").arg(cache->bytes() >> 20),
+							(int)(cache->budget() >> 20), 0, 1 << 16, 16, &ok);
+	m_lay1				->grabKeyboard();
+	if (!ok)
+		return;
+
+	cache				->setBudget(qint64(mb) << 20);
+	statusBar()			->showMessage(tr("Texture budget set to %1 MB").arg(mb), 2000);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for recording a trace
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief start recording a trace, or stop and save it
+//! \details while recording, every TRACE span of every thread is kept; stopping asks for a file and writes
+//!	the spans as Chrome trace JSON, which opens in chrome://tracing or Perfetto
+//! \param[in] on	true to start recording
+// stopping asks for a file and writes the spans as Chrome trace JSON
+void MainWindow::trace(bool on)
+{
+	if (on)
+	{
+		Trace::setEnabled	(true);
+		statusBar()		->showMessage(tr("Recording a trace"), 2000);
+		return;
+	}
+
+	Trace::setEnabled	(false);
+	qint64 events, dropped;
+	Trace::count		(events, dropped);
+
+	m_lay1				->releaseKeyboard();
+	QString path		= QFileDialog::getSaveFileName(this, tr("Save Trace"), QDir::currentPath(), tr("Chrome trace (*.json)"));
+	m_lay1				->grabKeyboard();
+	if (path.isEmpty())
+		return;
+
+	if (!Trace::save(path))
+	{
+		QMessageBox::information(this, tr("Save Trace"), tr("Cannot write %1.").arg(path));
+		return;
+	}
+	log					(ActivityLog::General, tr("Saved trace %1: %2 span(s), %3 dropped").arg(path).arg(events).arg(dropped));
+	statusBar()			->showMessage(tr("%1 has been saved").arg(QFileInfo(path).fileName()), 2000);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Slot for re-run from here
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief run the operation of the active image again with new parameters
+//! \details the parameters recorded with the image are edited in a RerunDialog. Only the image and what was
+//!	derived from it are recomputed (see Operation::rerun()); every other image is reused as it is. The
+//!	records and thumbnails of the recomputed images are updated in place and the new active image is opened
+// the parameters recorded with the image are edited; only the image and what was derived from it are recomputed
+void MainWindow::rerun()
+{
+	QImage temp			= m_lay1->activeImage();
+	imageInfo *info		= temp.isNull() ? 0 : m_thumbnailManager->findInfo(temp);
+	if (!info || info->getParams().kind == Operation::None)
+	{
+		statusBar()		->showMessage(tr("Error: The active image was not made by an operation that can be run again"), 2000);
+		return;
+	}
+
+	RerunDialog *dial	= new RerunDialog(info->getParams(), m_dialog);
+	m_lay1				->releaseKeyboard();
+
+	if (dial->exec() == 1)
+	{
+		OpParams params	= dial->retVal();
+		int id			= info->getId();
+
+		QMap<int, QImage> results;
+		QVector<int> order;
+		QTime timer;
+		timer			.start();
+		QApplication::setOverrideCursor(Qt::WaitCursor);
+		int skipped		= Operation::rerun(*m_thumbnailManager, id, params, results, order);
+		QApplication::restoreOverrideCursor();
+
+		if (results.contains(id))
+		{
+			info		->setParams(params);
+			info		->setOperation(Operation::describe(params));
+		}
+
+		for (int i = 0; i < order.size(); i++)
+		{
+			imageInfo *record	= m_thumbnailManager->find(order[i]);
+			QImage img	= results.value(order[i]);
+			ImageHandle handle	= replaceImage(record->getImageName(), record->getHandle(), img);
+			m_thumbnailManager	->replaceImage(order[i], handle, img);
+			m_imageHistoryTabTextEdit	->append(tr("re-run: %1").arg(m_thumbnailManager->summary(order[i])));
+		}
+
+		log				(ActivityLog::Image, tr("Re-ran %1 image(s); %2 could not be run again")
+							.arg(order.size()).arg(skipped), timer.elapsed());
+
+		if (results.contains(id))
+		{
+			QImage img	= results.value(id);
+			m_lay1		->open(info->getImageName(), img);
+			m_OpenGLWidget	->storeImage(info->getImageName(), img);
+			setInformationTabWidgetLabels(info);
+		}
+		else
+			statusBar()	->showMessage(tr("Error: The operation failed with the new parameters"), 2000);
+	}
+
+	m_lay1				->grabKeyboard();
+	delete dial;
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Slot for dragging from thumbnail view
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief slot for dragging from thumbnail view
-//! \details click on any row to drag
-//! \param[in] row	signal value emited from thumnail view; which row is clicked
-//! \param[in] col	signal value emited from thumnail view; which column is clicked
-void MainWindow::thumbCell(int row, int col)
+//! \details click on any row to drag. The drag holds a reference to the stored image; it is read back from
+//!	the disk cache only when it is dropped, and encoded only when it is dropped on another application
+//! \param[in] index	signal value emited from thumnail view; which row is clicked
+void MainWindow::thumbPressed(const QModelIndex &index)
 { // click on any row to drag
-	QImage dragImg			= m_imgDB[row];
-	QTableWidgetItem *item	= m_tableImages->item(row, 1);
-	QString dragImgName		= qvariant_cast<QString>((*item).data(Qt::DisplayRole));
-
-	QMimeData *mData		= new QMimeData;
-	mData					->setImageData(dragImg);
-	mData					->setText(tr("%1 @ 100% %2x%3").arg(dragImgName).arg(dragImg.width()).arg(dragImg.height()));
-	mData					->setData("text", dragImgName.toAscii());
+	ImageHandle handle		= m_thumbModel->handle(index.row());
+	if (!handle)
+		return;
 
 	QDrag *drag				= new QDrag(this);
-	drag					->setMimeData(mData);
+	drag					->setMimeData(new ImageMime(handle, m_thumbModel->name(index.row())));
 	drag					->setPixmap(QPixmap(":/images/drag_image.xpm"));
 	drag					->start();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//Creates a qtablewidget on the left part of the window for displaying
-//thumbnails
+// Slot for scrolling the thumbnail view
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief Creates the list of icons with names
-//! \details Initializes the group box and table and sets properties
-void MainWindow::createGroupBoxImages()
+//! \brief the thumbnail view has scrolled or rows were added
+//! \details the rows on screen are passed to the model, which fetches their thumbnails and a page around
+// the rows on screen are passed to the model, which fetches their thumbnails and a page around
+void MainWindow::thumbScrolled()
 {
-	m_groupBoxImages					= new QGroupBox(tr("Thumbnail View"));
-	m_groupBoxImages					->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+	QRect area				= m_listImages->viewport()->rect();
+	QModelIndex first		= m_listImages->indexAt(area.topLeft());
+	QModelIndex last		= m_listImages->indexAt(area.bottomLeft());
+	if (!first.isValid())
+		return;
+	m_thumbModel			->prefetch(first.row(), last.isValid() ? last.row() : m_thumbModel->rowCount() - 1);
+}
 
-	QStringList labels;
-	labels << tr("Image") << tr("Name");
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for the log filter
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the category or the text of the log filter has changed
+//! \details the view is filled once from the records kept in the ring
+// the view is filled once from the records kept in the ring
+void MainWindow::logFilterChanged()
+{
+	int category			= m_logCategory->currentIndex() - 1;	// "All" comes first
+	QString text			= m_logFilter->text();
+
+	QStringList lines;
+	if (m_log.dropped())
+		lines				<< tr("(%1 older record(s) dropped)").arg(m_log.dropped());
+	for (int i = 0; i < m_log.count(); i++)
+		if (ActivityLog::matches(m_log.at(i), category, text))
+			lines			<< ActivityLog::format(m_log.at(i));
+	m_logView				->setPlainText(lines.join("\n"));
+	m_logView				->moveCursor(QTextCursor::End);
+}
 
-	m_tableImages						= new QTableWidget;
-	m_tableImages						->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Ignored);
-	m_tableImages						->setSelectionMode(QAbstractItemView::NoSelection);
-	m_tableImages						->setColumnCount(2);
-	m_tableImages						->setHorizontalHeaderLabels(labels);
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for exporting the log
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief write the log to a file
+//! \details the records that pass the filter of the log tab are written as JSON lines
+// the records that pass the filter of the log tab are written as JSON lines
+void MainWindow::exportLog()
+{
+	QString path			= QFileDialog::getSaveFileName(this, tr("Export Log"), QDir::currentPath(), tr("JSON lines (*.jsonl)"));
+	if (path.isEmpty())
+		return;
 
-	connect(m_tableImages, SIGNAL(cellPressed(int, int)), this, SLOT(thumbCell(int, int)));
+	if (!m_log.exportJson(path, m_logCategory->currentIndex() - 1, m_logFilter->text()))
+	{
+		QMessageBox::information(this, tr("Export Log"), tr("Cannot write %1.").arg(path));
+		return;
+	}
+	statusBar()				->showMessage(tr("%1 has been saved").arg(QFileInfo(path).fileName()), 2000);
+}
 
-	QHeaderView *headerHorizontalView	= new QHeaderView(Qt::Horizontal, m_tableImages);
-	m_tableImages						->setHorizontalHeader(headerHorizontalView);
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	Slot for refreshing the memory tab
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief show the memory ledger
+//! \details does nothing unless the memory tab is shown. The ledger counts pixels held by several allocations
+//!	(the same QImage::cacheKey) once and shows the others as shared, so implicit copies are not mistaken for
+//!	real ones. Expanded categories stay expanded
+// does nothing unless the memory tab is shown; the ledger counts shared pixels once
+void MainWindow::memoryRefresh()
+{
+	if (m_tabWidget->currentWidget() != m_memoryTabWidget)
+		return;
 
-	headerHorizontalView				->setResizeMode(0, QHeaderView::ResizeToContents);
-	headerHorizontalView				->setResizeMode(1, QHeaderView::Stretch);
+	MemoryLedger *ledger		= MemoryLedger::instance();
+	QList<MemoryEntry> entries	= ledger->entries();
 
-	QVBoxLayout *layout					= new QVBoxLayout;
-	layout								->addWidget(m_tableImages);
-	m_groupBoxImages					->setLayout(layout);
+	QSet<int> expanded;
+	for (int i = 0; i < m_memoryTree->topLevelItemCount(); i++)
+		if (m_memoryTree->topLevelItem(i)->isExpanded())
+			expanded			.insert(i);
+	m_memoryTree				->clear();
+
+	QList<QTreeWidgetItem*> categories;
+	for (int i = 0; i < MemoryLedger::NumCategories; i++)
+		categories				.append(new QTreeWidgetItem(QStringList(MemoryLedger::categoryName(i))));
+
+	for (int i = 0; i < entries.size(); i++)
+	{
+		const MemoryEntry &e	= entries[i];
+		QTreeWidgetItem *item	= new QTreeWidgetItem(categories[e.category]);
+		item					->setText(0, e.name.isEmpty() ? tr("(unnamed)") : e.name);
+		item					->setText(e.shared ? 3 : 1, QString::number(e.bytes / 1024));
+	}
 
-	m_tableImages						->verticalHeader()->hide();
+	for (int i = 0; i < MemoryLedger::NumCategories; i++)
+	{
+		categories[i]			->setText(1, QString::number(ledger->total(i) / 1024));
+		categories[i]			->setText(2, QString::number(ledger->peak(i) / 1024));
+		categories[i]			->setText(3, QString::number(ledger->shared(i) / 1024));
+	}
+	m_memoryTree				->addTopLevelItems(categories);
+	foreach (int i, expanded)
+		categories[i]			->setExpanded(true);
+	for (int i = 0; i < 4; i++)
+		m_memoryTree			->resizeColumnToContents(i);
+
+	m_memoryTotal				->setText(tr("Live %1 MB (%2 MB shared), peak %3 MB")
+								  .arg(ledger->total() >> 20).arg(ledger->shared() >> 20).arg(ledger->peak() >> 20));
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// Adds a thumbnail view to the qtablewidget
+// Creates a list view on the left part of the window for displaying
+// thumbnails
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//! \brief Adds icon to the list
-//! \details Adds thumbnail and its name to the table
-void MainWindow::addImage(QString name, QImage img)
+//! \brief Creates the list of icons with names
+//! \details Initializes the group box and the view. The view only creates what it paints: every row has the
+//!	same size, so it is laid out without asking the model for each row, and thumbnails are made on demand
+// The view only creates what it paints; every row has the same size and thumbnails are made on demand
+void MainWindow::createGroupBoxImages()
 {
-	m_imgDB			<< img;
-	QImage thumbnail					= img.scaled(64, 64, Qt::KeepAspectRatio, Qt::FastTransformation );
+	m_groupBoxImages					= new QGroupBox(tr("Thumbnail View"));
+	m_groupBoxImages					->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
-	int row								= m_tableImages->rowCount();
-	m_tableImages						->setRowCount(row + 1);
+	m_thumbModel						= new ThumbnailModel(m_thumbnailer, this);
 
-	QTableWidgetItem *item0				= new QTableWidgetItem;
-	(*item0).setData(Qt::DecorationRole, thumbnail);
+	m_listImages						= new QListView;
+	m_listImages						->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Ignored);
+	m_listImages						->setSelectionMode(QAbstractItemView::NoSelection);
+	m_listImages						->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	m_listImages						->setUniformItemSizes(true);
+	m_listImages						->setIconSize(QSize(THUMB_SIZE, THUMB_SIZE));
+	m_listImages						->setModel(m_thumbModel);
 
-	QString *imageName					= new QString(name.toAscii());
+	connect(m_listImages, SIGNAL(pressed(const QModelIndex&)), this, SLOT(thumbPressed(const QModelIndex&)));
+	connect(m_listImages->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(thumbScrolled()));
+	connect(m_listImages->verticalScrollBar(), SIGNAL(rangeChanged(int, int)), this, SLOT(thumbScrolled()));
 
-	QTableWidgetItem *item1				= new QTableWidgetItem;
-	(*item1).setData(Qt::DisplayRole, (*imageName));
+	QVBoxLayout *layout					= new QVBoxLayout;
+	layout								->addWidget(m_listImages);
+	m_groupBoxImages					->setLayout(layout);
+}
 
-	//sets the flags that disable editing of image name
-	item0								->setFlags(item0->flags() & (~Qt::ItemIsEditable));
-	item1								->setFlags(item1->flags() & (~Qt::ItemIsEditable));
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Adds a thumbnail view to the list
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Adds icon to the list
+//! \details Adds the image to the list; the pixels go to the image store, the list keeps the handle.
+//!	The thumbnail is made when the row comes into view
+//! \param[in] name	the image name
+//! \param[in] img	the image
+//! \param[in] path	file of the image; the disk cache of thumbnails knows opened files by it
+//! \return	store handle of the image; the list owns one reference
+// Adds the image to the list; the pixels go to the image store, the list keeps the handle
+ImageHandle MainWindow::addImage(QString name, QImage img, QString path)
+{
+	ImageHandle handle					= ImageStore::instance()->insert(img);
+	m_thumbModel						->addImage(name, handle, path);
+	return handle;
+}
 
-	m_tableImages						->setItem(row , 0, item0);
-	m_tableImages						->setItem(row , 1, item1);
-	m_tableImages						->setRowHeight(row , 64);
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Replaces a thumbnail in the list
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Puts a recomputed image in place of an old one
+//! \details The row of the old image shows the new thumbnail and the list drops its reference to the old image;
+//!	an image that is not in the list is added
+//! \param[in] name	the image name
+//! \param[in] old		store handle of the old image
+//! \param[in] img		the new image
+//! \return	store handle of the new image; the list owns one reference
+// The row of the old image shows the new thumbnail and the list drops its reference to the old image
+ImageHandle MainWindow::replaceImage(QString name, ImageHandle old, QImage img)
+{
+	int row								= m_thumbModel->find(old);
+	if (row < 0)
+		return addImage(name, img);
+
+	ImageHandle handle					= ImageStore::instance()->insert(img);
+	m_thumbModel						->setHandle(row, handle);
+	ImageStore::instance()				->unref(old);
+	return handle;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -934,13 +2040,16 @@ void MainWindow::createTabWidget()
 	createNavigatorTabWidget	();
 	createInformationTabWidget	();
 	createLogTabWidget			();
+	createMemoryTabWidget		();
 	createImageHistoryTabWidget	();
 
 	m_tabWidget 					= new QTabWidget();
 	m_tabWidget						->addTab(m_navigatorTabWidget , QString(tr("Navigator")) );
 	m_tabWidget						->addTab(m_informationTabWidget , QString(tr("Image Info")) );
-	//m_tabWidget						->addTab(m_imageHistoryTabWidget , QString(tr("Image History")) );
+	m_tabWidget						->addTab(m_imageHistoryTabWidget , QString(tr("Image History")) );
 	m_tabWidget						->addTab(m_logTabWidget , QString(tr("Log")) );
+	m_tabWidget						->addTab(m_memoryTabWidget , QString(tr("Memory")) );
+	connect(m_tabWidget, SIGNAL(currentChanged(int)),			this, SLOT(memoryRefresh()));
 
 	m_ipWidget						= new IPDialog();
 	connect(m_ipWidget, SIGNAL(done(int)), 						this, SLOT(ipDone(int)));
@@ -1008,6 +2117,8 @@ void MainWindow::createInformationTabWidget ()
 	QLabel *imageFormatLabel			= new QLabel(tr("Image format:"));
 	QLabel *alphaChannelLabel			= new QLabel(tr("Has alpha\nchannel:"));
 	QLabel *isGrayscaleLabel			= new QLabel(tr("Is grayscale:"));
+	QLabel *alphaUsedLabel				= new QLabel(tr("Alpha in use:"));
+	QLabel *statisticsLabel				= new QLabel(tr("Channel\nstatistics:"));
 
 	m_informationTabGrid				->addWidget(imagePathLabel, 0, 0);
 	m_informationTabGrid				->addWidget(fileSizeLabel, 1, 0);
@@ -1021,6 +2132,8 @@ void MainWindow::createInformationTabWidget ()
 	m_informationTabGrid				->addWidget(imageFormatLabel, 9, 0);
 	m_informationTabGrid				->addWidget(alphaChannelLabel, 10, 0);
 	m_informationTabGrid				->addWidget(isGrayscaleLabel, 11, 0);
+	m_informationTabGrid				->addWidget(alphaUsedLabel, 12, 0);
+	m_informationTabGrid				->addWidget(statisticsLabel, 13, 0);
 
 	//Right side
 	m_imagePathLabel2					= new QLabel(tr("Unknown"));
@@ -1035,6 +2148,8 @@ void MainWindow::createInformationTabWidget ()
 	m_imageFormatLabel2					= new QLabel(tr("Unknown"));
 	m_alphaChannelLabel2				= new QLabel(tr("Unknown"));
 	m_isGrayscaleLabel2					= new QLabel(tr("Unknown"));
+	m_alphaUsedLabel2					= new QLabel(tr("Unknown"));
+	m_statisticsLabel2					= new QLabel(tr("Unknown"));
 
 	m_informationTabGrid				->addWidget(m_imagePathLabel2, 0, 1);
 	m_informationTabGrid				->addWidget(m_fileSizeLabel2, 1, 1);
@@ -1048,6 +2163,8 @@ void MainWindow::createInformationTabWidget ()
 	m_informationTabGrid				->addWidget(m_imageFormatLabel2, 9, 1);
 	m_informationTabGrid				->addWidget(m_alphaChannelLabel2, 10, 1);
 	m_informationTabGrid				->addWidget(m_isGrayscaleLabel2, 11, 1);
+	m_informationTabGrid				->addWidget(m_alphaUsedLabel2, 12, 1);
+	m_informationTabGrid				->addWidget(m_statisticsLabel2, 13, 1);
 
 	m_informationTabWidget				->setLayout(m_informationTabGrid);
 }
@@ -1132,6 +2249,23 @@ void MainWindow::setInformationTabWidgetLabels (imageInfo *m_imageManager)
 	m_alphaChannelLabel2		->setText(m_imageManager->getAlphaChannel());
 	m_isGrayscaleLabel2			->setText(m_imageManager->getGrayScale());
 
+	// statistics were measured once when the record was created
+	const ImageStatistics &stats	= m_imageManager->getStatistics();
+	const char *channelName[]	= {"R", "G", "B", "A", "Gray"};
+	QString statText;
+	for (int ch = 0; ch < ImageStatistics::Channels; ch++)
+	{
+		const ChannelStats &c	= stats.channel[ch];
+		if (ch == ImageStatistics::Alpha && !stats.usesAlpha)
+			continue;
+		if (!statText.isEmpty())
+			statText			+= "\n";
+		statText				+= tr("%1: %2-%3 mean %4 sd %5").arg(channelName[ch]).arg(c.min).arg(c.max)
+									.arg(c.mean, 0, 'f', 1).arg(sqrt(c.variance), 0, 'f', 1);
+	}
+	m_alphaUsedLabel2			->setText(stats.usesAlpha ? tr("Yes") : tr("No"));
+	m_statisticsLabel2			->setText(statText);
+
 	m_informationTabWidget		->update();
 }
 
@@ -1139,20 +2273,63 @@ void MainWindow::setInformationTabWidgetLabels (imageInfo *m_imageManager)
 //Creates the tab with the log
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //! \brief Creates the tab with log
-//! \details Simple text edit
+//! \details category and text filters over a plain text view; the view holds at most as many lines as the
+//!	log keeps records, so appending stays cheap however long the session runs
 void MainWindow::createLogTabWidget ()
 {
 	m_logTabWidget				= new QWidget();
 	m_logTabGrid				= new QGridLayout();
-	m_logTabTextEdit			= new QTextEdit();
-	m_logTabText				= new QString(); // to store all text in textedit in the future
-
-	m_logTabTextEdit			->setReadOnly(true);
-
-	m_logTabGrid				->addWidget(m_logTabTextEdit);
+	m_logView					= new QPlainTextEdit();
+	m_logCategory				= new QComboBox();
+	m_logFilter					= new QLineEdit();
+	QPushButton *exportButton	= new QPushButton(tr("Export..."));
+
+	m_logView					->setReadOnly(true);
+	m_logView					->setMaximumBlockCount(LOG_CAPACITY);
+	m_logCategory				->addItem(tr("All"));
+	for (int i = 0; i < ActivityLog::NumCategories; i++)
+		m_logCategory			->addItem(ActivityLog::categoryName(i));
+	m_logFilter					->setToolTip(tr("Show only messages containing this text"));
+
+	connect(m_logCategory,	SIGNAL(currentIndexChanged(int)),	this, SLOT(logFilterChanged()));
+	connect(m_logFilter,	SIGNAL(textChanged(QString)),		this, SLOT(logFilterChanged()));
+	connect(exportButton,	SIGNAL(clicked()),					this, SLOT(exportLog()));
+
+	m_logTabGrid				->addWidget(m_logCategory, 0, 0);
+	m_logTabGrid				->addWidget(m_logFilter, 0, 1);
+	m_logTabGrid				->addWidget(exportButton, 0, 2);
+	m_logTabGrid				->addWidget(m_logView, 1, 0, 1, 3);
+	m_logTabGrid				->setColumnStretch(1, 1);
 	m_logTabWidget				->setLayout(m_logTabGrid);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//Creates the tab with the memory ledger
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Creates the tab with the memory ledger
+//! \details a tree of categories with their allocations under them; a timer refreshes it once a second, and
+//!	only while the tab is shown
+void MainWindow::createMemoryTabWidget ()
+{
+	m_memoryTabWidget			= new QWidget();
+	QGridLayout *grid			= new QGridLayout();
+	m_memoryTree				= new QTreeWidget();
+	m_memoryTotal				= new QLabel();
+	QTimer *timer				= new QTimer(this);
+
+	m_memoryTree				->setColumnCount(4);
+	m_memoryTree				->setHeaderLabels(QStringList() << tr("Owner") << tr("Live (KB)") << tr("Peak (KB)") << tr("Shared (KB)"));
+	m_memoryTree				->setToolTip(tr("Shared memory is held by an image whose pixels are already counted above it"));
+	m_memoryTree				->setRootIsDecorated(true);
+
+	connect(timer, SIGNAL(timeout()),							this, SLOT(memoryRefresh()));
+	timer						->start(1000);
+
+	grid						->addWidget(m_memoryTotal, 0, 0);
+	grid						->addWidget(m_memoryTree, 1, 0);
+	m_memoryTabWidget			->setLayout(grid);
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //Creates the tab with the image history
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
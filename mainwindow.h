@@ -21,11 +21,23 @@
 #include					<QtGui/QtGui>
 #include					"layoutdialog.h"
 #include					"imageInfo.h"
+#include					"imagestore.h"
 #include					"historyManager.h"
 #include					"OpenGLWidget.h"
 #include 					"layoutwindow.h"
 #include					"ipdialog.h"
+#include					"templatematch.h"
+#include					"binaryop.h"
+#include					"warpdialog.h"
 #include					"pcsdialog.h"
+#include					"rerundialog.h"
+#include					"operation.h"
+#include					"project.h"
+#include					"thumbnailmodel.h"
+#include					"imageloader.h"
+#include					"activitylog.h"
+#include					"memoryledger.h"
+#include					"texturecache.h"
 
 class MainWindow : public QMainWindow
 {
@@ -42,10 +54,22 @@ signals:
 private slots:
 	//! \brief Generate layout from the recently customized layout list with the given id.
 	void					recentLay						(int);
-	//! \brief Open image
+	//! \brief Open images
 	void					open							();
+	//! \brief Open every image of a folder
+	void					openFolder						();
+	//! \brief an image file has been decoded in the background
+	void					imageLoaded						(QString, QImage);
+	//! \brief an image file could not be decoded
+	void					imageFailed						(QString, QString);
+	//! \brief every requested image file is done
+	void					imagesOpened					(int, int, qint64, int);
 	//! \brief Open depth file
 	void					openDepth						();
+	//! \brief save images, history and layout to a project file
+	void					saveProject						();
+	//! \brief add the images, history and layout of a project file to the session
+	void					openProject						();
 	//! \brief Open customize dialog box
 	void					customize						();
 	//! \brief 1x1 layout, pre-fixed.
@@ -60,6 +84,14 @@ private slots:
 	void					layout4							();
 	//! \brief receive messages from any class.
 	void					message							(QString);
+	//! \brief set the memory budget of the image store
+	void					memoryBudget					();
+	//! \brief set the budget of textures no view shows
+	void					textureBudget					();
+	//! \brief start recording a trace, or stop and save it
+	void					trace							(bool);
+	//! \brief run the operation of the active image again with new parameters, and everything derived from it
+	void					rerun							();
 	//! \brief let navigator knows that a new image is created.
 	void					imageCreated					(QImage*, QString);
 	//! \brief let navigator knows that current frame changed.
@@ -70,6 +102,22 @@ private slots:
 	void					ipThreshold						();
 	//! \brief slot for IP edge detection
 	void					ipEdgeDet						();
+	//! \brief slot for IP frequency domain filter
+	void					ipFrequency						();
+	//! \brief slot for IP edge preserving smoothing
+	void					ipSmooth						();
+	//! \brief slot for IP connected regions
+	void					ipRegions						();
+	//! \brief slot for IP hough transform
+	void					ipHough							();
+	//! \brief slot for IP distance transform
+	void					ipDistance						();
+	//! \brief slot for IP template matching
+	void					ipMatch							();
+	//! \brief slot for IP two image arithmetic
+	void					ipCombine						(int);
+	//! \brief slot for IP warp
+	void					ipWarp							();
 	//! \brief slot for when IP dialog is done
 	void					ipDone							(int);
 	//! \brief slot for registering one pair of point cloud
@@ -85,7 +133,15 @@ private slots:
 	//! \brief slot for receiving the cloud and drawing the cloud
 	void					drawCloud						(Vertex*, int, int);
 	//! \brief slot for dragging from thumbnail view
-	void					thumbCell						(int, int);
+	void					thumbPressed					(const QModelIndex&);
+	//! \brief the thumbnail view has scrolled or grown; fetch thumbnails around what is on screen
+	void					thumbScrolled					();
+	//! \brief the log filter has changed; show the records that pass it
+	void					logFilterChanged				();
+	//! \brief write the records that pass the log filter to a JSON lines file
+	void					exportLog						();
+	//! \brief show the memory ledger in the memory tab if it is the current tab
+	void					memoryRefresh					();
 
 private:
 	//! \brief add recent layout parameter to recent list
@@ -110,20 +166,43 @@ private:
 	void					createNavigatorTabWidget		();
 	//! \brief create log tab
 	void					createLogTabWidget				();
+	//! \brief create memory tab
+	void					createMemoryTabWidget			();
 	//! \brief create labels for information tab
 	void					setInformationTabWidgetLabels	(imageInfo*);
+	//! \brief decode image files in the background and add them to the session
+	void					openFiles						(const QStringList&);
 	//! \brief add thumbnail to the list
-	void					addImage						(QString, QImage);
+	ImageHandle				addImage						(QString, QImage, QString = QString());
+	//! \brief record an image created by an operation on other images
+	void					imageDerived					(QImage*, QString, QLinkedList<imageInfo*>, QString, const OpParams& = OpParams());
+	//! \brief put a recomputed image in place of an old one in the list
+	ImageHandle				replaceImage					(QString, ImageHandle, QImage);
+	//! \brief add a record to the history table and its summary to the history tab
+	void					recordHistory					(imageInfo*);
+	//! \brief add a record to the activity log and show it if it passes the filter
+	void					log								(int, const QString&, int = -1, qint64 = -1);
 
 	// Member variables
 	QMenu 					*m_menuFile;					// file menu
+	QMenu					*m_menuEdit;					// edit menu
 	QMenu 					*m_menuLayout; 					// layout menu
 	QMenu 					*m_recentLayout;				// recent layout menu
 	QMenu 					*m_menuIP;						// image processing menu
+	QMenu					*m_menuCombine;					// two image arithmetic menu
 	QMenu					*m_menu4PCS;					// 4PCS menu
 
 	QAction					*m_actOpen;						// open action
+	QAction					*m_actOpenFolder;				// open folder action
+	QAction					*m_actOpenProject;				// open project action
+	QAction					*m_actSaveProject;				// save project action
 	QAction					*m_actExit;						// exit action
+	QAction					*m_actUndo;						// undo the active frame
+	QAction					*m_actRedo;						// redo the active frame
+	QAction					*m_actBudget;					// image store memory budget
+	QAction					*m_actTexBudget;				// texture cache budget
+	QAction					*m_actTrace;					// start / stop recording a trace
+	QAction					*m_actRerun;					// re-run from the active image
 	QAction					*m_actLay0;						// 1x1 layout action
 	QAction					*m_actLay1;						// 1T_1B layout action
 	QAction					*m_actLay2;						// 1T_2B layout action
@@ -133,6 +212,15 @@ private:
 	QAction					*m_IPColor;						// color band
 	QAction					*m_IPThres;						// thresholding
 	QAction					*m_IPEdge;						// edge detection
+	QAction					*m_IPFreq;						// frequency domain filter
+	QAction					*m_IPSmooth;					// edge preserving smoothing
+	QAction					*m_IPRegions;					// connected regions
+	QAction					*m_IPHough;						// hough transform
+	QAction					*m_IPDistance;					// distance transform
+	QAction					*m_IPMatch;						// template matching
+	QAction					*m_IPWarp;						// affine / perspective warp
+	QAction					*m_IPCombine[BinaryOp::NumOps];	// two image arithmetic, one per operation
+	QSignalMapper			*m_combineMap;					// maps the arithmetic actions to their operation
 	QAction					*m_actOpenDepth;				// open depth file
 	QAction					*m_act4PCSsingle;				// single registration
 	QAction					*m_act4PCSmultiple;				// multiple registration
@@ -150,14 +238,16 @@ private:
 	QList<int>				m_recentCol;					// a list of recent layout for col
 	QList<QChar>			m_recentOrient;					// a list of recent layout for orientation
 	QList< QList<int> > 	m_recentSpec;					// a list of spec for recent layouts
-	QList<QImage>			m_imgDB;						// a list of all images that have been opened
+	Thumbnailer				*m_thumbnailer;					// makes thumbnails on worker threads, cached on disk
+	ImageLoader				*m_loader;						// decodes opened files on worker threads
 
 	QSignalMapper 			*m_signalMapper;				// a signal mapper that maps recent layout to the proper parameters
 
 	historyManager			*m_thumbnailManager;			// Stores ImageInfo of all images
 	imageInfo 				*m_imageManager;				// Information about an image
 	QGroupBox 				*m_groupBoxImages;				// Grouo Bix for displaying icons and names
-	QTableWidget 			*m_tableImages;					// Table that holds icon and name of the image
+	QListView				*m_listImages;					// virtualized list of icons and names of the images
+	ThumbnailModel			*m_thumbModel;					// images of the list; owns one store reference per row
 
 	//Tab widget data
 	QTabWidget				*m_tabWidget;					// Tab widget containing navigator, image info, history, log, 4pcs
@@ -165,6 +255,7 @@ private:
 	QWidget					*m_informationTabWidget;		// displays info about image
 	QWidget					*m_imageHistoryTabWidget;		// displays history
 	QWidget					*m_logTabWidget;				// displays activity log
+	QWidget					*m_memoryTabWidget;				// displays the memory ledger
 	IPDialog				*m_ipWidget;					// tab widget to prompt user input for ip
 	PCSDialog				*m_pcsWidget;					// tab widget to prompt user input for 4pcs
 
@@ -173,10 +264,14 @@ private:
 	QGridLayout				*m_logTabGrid;					// grid layout for log tab
 	QGridLayout				*m_imageHistoryTabGrid;			// grid layout for history tab
 
-	QTextEdit 				*m_logTabTextEdit;				// stores text in log tab
+	QPlainTextEdit			*m_logView;						// records of the activity log that pass the filter
+	QComboBox				*m_logCategory;					// category filter of the log tab
+	QLineEdit				*m_logFilter;					// text filter of the log tab
+	ActivityLog				m_log;							// bounded ring of log records
+	QTreeWidget				*m_memoryTree;					// memory by category, and by owner under each category
+	QLabel					*m_memoryTotal;					// live and peak memory of the session
 	QTextEdit 				*m_imageHistoryTabTextEdit;		// stores text in hostory tab
 	QString					*m_imageHistoryTabText;			// holds the text for text edit on image history tab
-	QString					*m_logTabText;					// stores a line in log tab
 	QSlider					*m_SliderNavigator;				// slider for the navigator window
 	OpenGLWidget 			*m_OpenGLWidget;				// OpenGL navigator
 
@@ -193,5 +288,7 @@ private:
 	QLabel					*m_imageFormatLabel2;			// the label for the format of the image
 	QLabel					*m_alphaChannelLabel2;			// the label stating if it has alpha channel
 	QLabel					*m_isGrayscaleLabel2;			// the label stating if it is a greyscale image
+	QLabel					*m_alphaUsedLabel2;				// the label stating if some pixel is not opaque
+	QLabel					*m_statisticsLabel2;			// the label listing per channel range, mean and deviation
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,284 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class MemoryLedger
+//! \brief MemoryLedger implementation
+//!
+//! \file memoryledger.cpp
+//! \brief MemoryLedger implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QMutexLocker>
+#include			<QtAlgorithms>
+
+#include			"memoryledger.h"
+
+// category first, then the largest allocation
+static bool entryLess(const MemoryEntry &a, const MemoryEntry &b)
+{
+	if (a.category != b.category)
+		return a.category < b.category;
+	return a.bytes > b.bytes;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the ledger shared by the whole application
+//! \return		the ledger
+MemoryLedger* MemoryLedger::instance()
+{
+	static MemoryLedger ledger;
+	return &ledger;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+MemoryLedger::MemoryLedger()
+{
+	for (int i = 0; i < NumCategories; i++)
+		m_total[i]		= m_peak[i]	= m_shared[i]	= 0;
+	m_sum				= 0;
+	m_sumPeak			= 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set the size of one allocation of an owner
+//! \details owners call this whenever the allocation changes; the category totals move by the difference, so
+//!	reporting the same size again costs nothing. An owner with several allocations tells them apart by slot
+//! \param[in] owner	object holding the memory
+//! \param[in] slot		which of the owner's allocations
+//! \param[in] category	MemoryLedger::Category
+//! \param[in] bytes	size now; 0 removes the allocation
+//! \param[in] name		shown in the breakdown
+//! \param[in] key		QImage::cacheKey() when the memory is the pixels of an image, so shared copies can be told
+//!						from real ones; 0 otherwise
+// owners call this whenever the allocation changes; the category totals move by the difference
+void MemoryLedger::set(const void *owner, int slot, int category, qint64 bytes, const QString &name, qint64 key)
+{
+	QMutexLocker lock(&m_mutex);
+	QPair<const void*, int> id(owner, slot);
+	QHash<QPair<const void*, int>, MemoryEntry>::iterator it	= m_entries.find(id);
+	if (it != m_entries.end() && bytes > 0 && it->category == category && it->key == key)
+	{	// same pixels, new size: moved in place so a counted allocation stays counted
+		if (it->shared)
+			m_shared[category]	+= bytes - it->bytes;
+		else
+			adjust		(category, bytes - it->bytes);
+		it->bytes		= bytes;
+		it->name		= name;
+		return;
+	}
+
+	if (it != m_entries.end())
+	{
+		MemoryEntry old	= *it;
+		m_entries		.erase(it);
+		drop			(old);
+	}
+	if (bytes <= 0)
+		return;
+
+	MemoryEntry e;
+	e.owner				= owner;
+	e.slot				= slot;
+	e.category			= category;
+	e.name				= name;
+	e.bytes				= bytes;
+	e.key				= key;
+	add					(e);
+	m_entries			.insert(id, e);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Remove
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief remove every allocation of an owner
+//! \details called by owners when they are destroyed
+//! \param[in] owner	object holding the memory
+// called by owners when they are destroyed
+void MemoryLedger::remove(const void *owner)
+{
+	QMutexLocker lock(&m_mutex);
+	QHash<QPair<const void*, int>, MemoryEntry>::iterator it	= m_entries.begin();
+	while (it != m_entries.end())
+	{
+		if (it->owner == owner)
+		{
+			MemoryEntry old	= *it;
+			it			= m_entries.erase(it);
+			drop		(old);
+		}
+		else
+			++it;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Totals
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief bytes held now in a category
+//! \param[in] category	MemoryLedger::Category
+//! \return		live bytes, without those shared with an allocation counted elsewhere
+qint64 MemoryLedger::total(int category)
+{
+	QMutexLocker lock(&m_mutex);
+	return m_total[category];
+}
+
+//! \brief most bytes held at once in a category
+//! \param[in] category	MemoryLedger::Category
+//! \return		peak bytes since the start of the session
+qint64 MemoryLedger::peak(int category)
+{
+	QMutexLocker lock(&m_mutex);
+	return m_peak[category];
+}
+
+//! \brief bytes of a category that share pixels counted elsewhere
+//! \param[in] category	MemoryLedger::Category
+//! \return		live shared bytes
+qint64 MemoryLedger::shared(int category)
+{
+	QMutexLocker lock(&m_mutex);
+	return m_shared[category];
+}
+
+//! \brief bytes held now in all categories
+//! \return		live bytes
+qint64 MemoryLedger::total()
+{
+	QMutexLocker lock(&m_mutex);
+	return m_sum;
+}
+
+//! \brief most bytes held at once in all categories
+//! \return		peak bytes since the start of the session
+qint64 MemoryLedger::peak()
+{
+	QMutexLocker lock(&m_mutex);
+	return m_sumPeak;
+}
+
+//! \brief bytes of all categories that share pixels counted elsewhere
+//! \return		live shared bytes
+qint64 MemoryLedger::shared()
+{
+	QMutexLocker lock(&m_mutex);
+	qint64 sum			= 0;
+	for (int i = 0; i < NumCategories; i++)
+		sum				+= m_shared[i];
+	return sum;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Entries
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief every allocation
+//! \return		a copy, by category then largest first
+QList<MemoryEntry> MemoryLedger::entries()
+{
+	QMutexLocker lock(&m_mutex);
+	QList<MemoryEntry> list	= m_entries.values();
+	lock				.unlock();
+
+	qSort				(list.begin(), list.end(), entryLess);
+	return list;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Category name
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief display name of a category
+//! \param[in] category	MemoryLedger::Category
+//! \return		the name
+QString MemoryLedger::categoryName(int category)
+{
+	static const char *names[]	= {"Stored images", "Undo history", "Frames", "Clipboard", "Dialogs",
+								   "Thumbnails", "Point clouds", "Textures (GPU)", "Display lists (GPU)"};
+	return (category >= 0 && category < NumCategories) ? names[category] : "";
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Add
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief count a new allocation
+//! \details pixels are counted once by cache key: the first allocation holding them moves its category total
+//!	and the peaks, later ones only count as shared. The caller holds the lock
+//! \param[in,out] e	the allocation; its shared flag is set
+// pixels are counted once by cache key; later allocations holding them only count as shared
+void MemoryLedger::add(MemoryEntry &e)
+{
+	e.shared			= e.key && m_keys.value(e.key) > 0;
+	if (e.key)
+		m_keys[e.key]	++;
+	if (e.shared)
+		m_shared[e.category]	+= e.bytes;
+	else
+		adjust			(e.category, e.bytes);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Drop
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief uncount an allocation already taken out of m_entries
+//! \details when the counted holder of some pixels goes while others still hold them, one of those is
+//!	counted in its place, so the pixels stay in the totals of a category that really holds them. The
+//!	caller holds the lock
+//! \param[in] e	the allocation
+// when the counted holder of some pixels goes, another holder is counted in its place
+void MemoryLedger::drop(const MemoryEntry &e)
+{
+	if (e.shared)
+		m_shared[e.category]	-= e.bytes;
+	else
+		adjust			(e.category, -e.bytes);
+	if (!e.key)
+		return;
+
+	QHash<qint64, int>::iterator k	= m_keys.find(e.key);
+	if (--*k == 0)
+	{
+		m_keys			.erase(k);
+		return;
+	}
+	if (e.shared)
+		return;
+
+	QHash<QPair<const void*, int>, MemoryEntry>::iterator it	= m_entries.begin();
+	for (; it != m_entries.end(); ++it)
+	{
+		if (it->key == e.key && it->shared)
+		{
+			it->shared	= false;
+			m_shared[it->category]	-= it->bytes;
+			adjust		(it->category, it->bytes);
+			return;
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Adjust
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief move a category total and update the peaks
+//! \details the totals hold each image's pixels once, so a copy that only shares them does not raise a
+//!	peak. The caller holds the lock
+//! \param[in] category	MemoryLedger::Category
+//! \param[in] delta	bytes added; negative when freed
+void MemoryLedger::adjust(int category, qint64 delta)
+{
+	m_total[category]	+= delta;
+	m_sum				+= delta;
+	m_peak[category]	= qMax(m_peak[category], m_total[category]);
+	m_sumPeak			= qMax(m_sumPeak, m_sum);
+}
@@ -0,0 +1,89 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class MemoryLedger
+//! \brief Live and peak memory of the session, by category and by owner
+//!
+//! \file memoryledger.h
+//! \brief MemoryLedger class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				MEMORYLEDGER_H
+#define				MEMORYLEDGER_H
+
+#include			<QHash>
+#include			<QList>
+#include			<QMutex>
+#include			<QPair>
+#include			<QString>
+
+// one allocation of an owner
+struct MemoryEntry
+{
+	const void		*owner;			// object holding the memory
+	int				slot;			// which of the owner's allocations
+	int				category;		// MemoryLedger::Category
+	QString			name;			// shown in the breakdown
+	qint64			bytes;			// size
+	qint64			key;			// QImage::cacheKey() of shared pixels; 0 if not an image
+	bool			shared;			// another allocation with the same key is counted instead
+};
+
+// MemoryLedger class
+class MemoryLedger
+{
+public:
+	//! \brief enum for MemoryLedger; what the memory holds
+	enum			Category		{StoredImages, UndoHistory, Frames, Clipboard, Dialogs, Thumbnails,
+									 PointClouds, Textures, DisplayLists, NumCategories};
+
+	//! \brief the ledger of the application
+	static MemoryLedger*	instance	();
+
+	//! \brief set the size of one allocation of an owner; 0 bytes removes it
+	void			set				(const void *owner, int slot, int category, qint64 bytes,
+									 const QString &name = QString(), qint64 key = 0);
+	//! \brief remove every allocation of an owner
+	void			remove			(const void *owner);
+	//! \brief bytes held now in a category, each image's pixels counted once
+	qint64			total			(int category);
+	//! \brief most bytes held at once in a category, each image's pixels counted once
+	qint64			peak			(int category);
+	//! \brief bytes of a category that share pixels counted elsewhere
+	qint64			shared			(int category);
+	//! \brief bytes held now in all categories, each image's pixels counted once
+	qint64			total			();
+	//! \brief most bytes held at once in all categories, each image's pixels counted once
+	qint64			peak			();
+	//! \brief bytes of all categories that share pixels counted elsewhere
+	qint64			shared			();
+	//! \brief every allocation, by category then largest first
+	QList<MemoryEntry>	entries		();
+	//! \brief display name of a category
+	static QString	categoryName	(int);
+
+private:
+	//! \brief Constructor
+					MemoryLedger	();
+	//! \brief count a new allocation, or mark it shared if its pixels are counted already
+	void			add				(MemoryEntry&);
+	//! \brief uncount an allocation; another one with the same pixels is counted in its place
+	void			drop			(const MemoryEntry&);
+	//! \brief move a category total and update the peaks
+	void			adjust			(int category, qint64 delta);
+
+	QHash<QPair<const void*, int>, MemoryEntry>	m_entries;	// (owner, slot) -> allocation
+	QHash<qint64, int>	m_keys;					// image cache key -> allocations holding it
+	qint64			m_total[NumCategories];		// live bytes per category, shared ones not included
+	qint64			m_shared[NumCategories];	// live bytes per category that are counted elsewhere
+	qint64			m_peak[NumCategories];		// peak bytes per category
+	qint64			m_sum;						// live bytes of all categories
+	qint64			m_sumPeak;					// peak of m_sum
+	QMutex			m_mutex;					// owners report from worker threads too
+};
+#endif
@@ -0,0 +1,286 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Operation
+//! \brief Operation implementation
+//!
+//! \file operation.cpp
+//! \brief Operation implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QSet>
+#include			<QStringList>
+
+#include			"operation.h"
+#include			"historyManager.h"
+#include			"imagestore.h"
+#include			"parallel.h"
+#include			"ip.h"
+#include			"labeling.h"
+#include			"binaryop.h"
+#include			"warp.h"
+#include			"templatematch.h"
+
+// one image to recompute
+struct RerunTask
+{
+	OpParams			params;			// operation of the image
+	QVector<QImage>		inputs;			// source images in operand order
+	QImage				result;			// null if the operation failed
+};
+
+// recompute a range of independent images
+static void runTasks(void *ctx, int begin, int end)
+{
+	QVector<RerunTask> &tasks	= *(QVector<RerunTask>*)ctx;
+	for (int i = begin; i < end; i++)
+		tasks[i].result			= Operation::run(tasks[i].params, tasks[i].inputs);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Run
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief run an operation on its source images
+//! \details the calls are the ones IPDialog and MainWindow make on full size images, so a replay gives
+//!	the same pixels as the original run. Parameters by kind:
+//!	Color: channel (IP::IP_FUNCT); Threshold: level, all; Edge: mask (0 prewitt, 1 sobel, 2 LoG), level;
+//!	Frequency: filter (IP::IP_FREQ, 6 spectrum, 7 gaussian blur), level; Smooth: method (0 bilateral, 1 guided), level;
+//!	Regions: connectivity (4, 8), level; Distance: level, inside; Arithmetic: op (BinaryOp::Op), weight;
+//!	Resample: m0 - m8 (row major), interp (Warp::Interp); Matching: threshold, matches, pyramid
+//! \param[in] params	the operation
+//! \param[in] inputs	source images; one, or two for Arithmetic and Matching
+//! \return		the result; null if the kind cannot be run or the inputs do not fit
+// the calls are the ones IPDialog and MainWindow make on full size images, so a replay gives the same pixels
+QImage Operation::run(const OpParams &params, const QVector<QImage> &inputs)
+{
+	int needed			= (params.kind == Arithmetic || params.kind == Matching) ? 2 : 1;
+	if (params.kind == None || inputs.size() != needed)
+		return QImage();
+	for (int i = 0; i < inputs.size(); i++)
+		if (inputs[i].isNull())
+			return QImage();
+
+	const QMap<QString, double> &v	= params.values;
+	int level			= (int)v.value("level");
+	QImage img			= inputs[0];
+	IP ip;
+
+	switch (params.kind)
+	{
+		case Color:
+			ip			.processImg((IP::IP_FUNCT)(int)v.value("channel"), img);
+			break;
+		case Threshold:
+			ip			.lookUpTable(level);
+			ip			.processImg(v.value("all") ? IP::AllThres : IP::IndThres, img);
+			break;
+		case Edge:
+		{
+			QImage refImg(img);
+			int mask	= (int)v.value("mask");
+			if (mask == 0)
+				ip		.prewittMask(img, refImg, level);
+			else if (mask == 1)
+				ip		.sobelMask(img, refImg, level);
+			else
+				ip		.LoGMask(img, refImg, level);
+		}
+			break;
+		case Frequency:
+		{
+			int filter	= (int)v.value("filter");
+			if (filter == 6)
+				ip		.spectrum(img);
+			else if (filter == 7)
+				ip		.gaussianBlur(img, level / 255.0 * 32.0);
+			else
+				ip		.freqFilter((IP::IP_FREQ)filter, img, level / 255.0 * 0.5);
+		}
+			break;
+		case Smooth:
+			if (v.value("method") == 0)
+				ip		.bilateral(img, 8.0, level);
+			else
+				ip		.guidedFilter(img, 8, (level / 255.0) * (level / 255.0));
+			break;
+		case Regions:
+		{
+			QVector<int> labels;
+			QVector<RegionInfo> regions;
+			Labeling::label(img, level, v.value("connectivity") == 4 ? Labeling::Four : Labeling::Eight, labels, regions);
+			img			= Labeling::colorize(labels, img.width(), img.height());
+		}
+			break;
+		case Distance:
+			ip			.distanceTransform(img, level, v.value("inside") != 0);
+			break;
+		case Arithmetic:
+			img			= BinaryOp::apply((BinaryOp::Op)(int)v.value("op"), inputs[0], inputs[1], (int)v.value("weight", 128));
+			break;
+		case Resample:
+		{
+			double matrix[9];
+			for (int i = 0; i < 9; i++)
+				matrix[i]	= v.value(QString("m%1").arg(i));
+			img			= Warp::apply(inputs[0], matrix, (Warp::Interp)(int)v.value("interp"));
+		}
+			break;
+		case Matching:
+		{
+			QVector<MatchResult> result;
+			if (inputs[1].width() > inputs[0].width() || inputs[1].height() > inputs[0].height())
+				return QImage();
+			img			= TemplateMatch::match(inputs[0], inputs[1], v.value("threshold", 0.8),
+											   (int)v.value("matches", 10), v.value("pyramid") != 0, result);
+		}
+			break;
+		default:
+			return QImage();
+	}
+
+	return img;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Describe
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief display name of an operation with its parameters
+//! \param[in] params	the operation
+//! \return		e.g. "Threshold [all 1, level 128]"
+QString Operation::describe(const OpParams &params)
+{
+	static const char *names[]	= {"", "Color", "Threshold", "Edge detection", "Frequency filter",
+								   "Edge preserving smoothing", "Connected regions", "Distance transform",
+								   "Arithmetic", "Warp", "Template match"};
+	if (params.kind <= None || params.kind > Matching)
+		return QString();
+
+	QString name		= names[params.kind];
+	if (params.kind == Arithmetic)
+		name			= BinaryOp::name((BinaryOp::Op)(int)params.values.value("op"));
+
+	QStringList values;
+	for (QMap<QString, double>::const_iterator i = params.values.constBegin(); i != params.values.constEnd(); i++)
+		values			<< QString("%1 %2").arg(i.key()).arg(i.value());
+
+	return QString("%1 [%2]").arg(name).arg(values.join(", "));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Re-run from an image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief recompute an image with new parameters and every image derived from it
+//! \details only the image and its descendants are dirty. They are run level by level in topological
+//!	order; the images of one level do not depend on each other, so independent branches run in parallel.
+//!	Sources outside the dirty set are read from the image store as they are. An image that cannot be
+//!	run again (or whose source failed) is skipped together with everything below it
+//! \param[in] history	derivation graph
+//! \param[in] id		history id of the image to start from
+//! \param[in] params	new parameters of that image
+//! \param[out] results	new image of every recomputed history id
+//! \param[out] order	recomputed history ids in the order they were finished
+//! \return		number of images that were skipped
+// only the image and its descendants are dirty; each level of the dirty subgraph runs in parallel
+int Operation::rerun(historyManager &history, int id, const OpParams &params, QMap<int, QImage> &results, QVector<int> &order)
+{
+	results				.clear();
+	order				.clear();
+	if (!history.find(id))
+		return 0;
+
+	// dirty subgraph: the image and everything derived from it
+	QSet<int> dirty;
+	QVector<int> pending;
+	pending				.append(id);
+	dirty				.insert(id);
+	for (int i = 0; i < pending.size(); i++)
+	{
+		QVector<int> children	= history.children(pending[i]);
+		for (int j = 0; j < children.size(); j++)
+			if (!dirty.contains(children[j]) && history.find(children[j]))
+			{
+				dirty	.insert(children[j]);
+				pending	.append(children[j]);
+			}
+	}
+
+	// edges from dirty parents still to be satisfied
+	QMap<int, int> waiting;
+	for (int i = 0; i < pending.size(); i++)
+	{
+		QVector<int> parents	= history.parents(pending[i]);
+		int count		= 0;
+		for (int j = 0; j < parents.size(); j++)
+			if (dirty.contains(parents[j]))
+				count++;
+		waiting			.insert(pending[i], count);
+	}
+
+	int skipped			= 0;
+	QVector<int> level;
+	level				.append(id);
+	while (!level.isEmpty())
+	{
+		QVector<RerunTask> tasks(level.size());
+		for (int i = 0; i < level.size(); i++)
+		{
+			imageInfo *info		= history.find(level[i]);
+			tasks[i].params		= level[i] == id ? params : info->getParams();
+
+			bool runnable		= tasks[i].params.kind != None;
+			QVector<int> parents	= history.parents(level[i]);
+			for (int j = 0; j < parents.size() && runnable; j++)
+			{
+				if (dirty.contains(parents[j]))
+				{
+					if (results.contains(parents[j]))
+						tasks[i].inputs	<< results.value(parents[j]);
+					else
+						runnable		= false;		// the source was skipped
+				}
+				else
+				{	// unchanged source; reuse its stored image
+					imageInfo *parent	= history.find(parents[j]);
+					if (parent)
+						tasks[i].inputs	<< ImageStore::instance()->image(parent->getHandle());
+					else
+						runnable		= false;
+				}
+			}
+			if (!runnable)
+				tasks[i].inputs	.clear();		// run() returns a null image right away
+		}
+
+		Parallel::forRange(tasks.size(), runTasks, &tasks, 1);
+
+		QVector<int> next;
+		for (int i = 0; i < level.size(); i++)
+		{
+			if (tasks[i].result.isNull())
+				skipped++;
+			else
+			{
+				results	.insert(level[i], tasks[i].result);
+				order	.append(level[i]);
+			}
+
+			QVector<int> children	= history.children(level[i]);
+			for (int j = 0; j < children.size(); j++)
+			{
+				if (!dirty.contains(children[j]))
+					continue;
+				int &count		= waiting[children[j]];
+				if (--count == 0)
+					next		.append(children[j]);
+			}
+		}
+		level			= next;
+	}
+
+	return skipped;
+}
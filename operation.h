@@ -0,0 +1,50 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Operation
+//! \brief Replayable image operations and recomputation of derived images
+//!
+//! \file operation.h
+//! \brief Operation class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				OPERATION_H
+#define				OPERATION_H
+
+#include			<QImage>
+#include			<QMap>
+#include			<QString>
+#include			<QVector>
+
+class				historyManager;
+
+// everything needed to run an operation again on its source images
+struct OpParams
+{
+	int						kind;			// Operation::Kind
+	QMap<QString, double>	values;			// named parameters, see Operation::run()
+
+	OpParams		() : kind(0) {}
+};
+
+// Operation class
+class Operation
+{
+public:
+	//! \brief enum for Operation; None cannot be run again (opened files, depth renders...)
+	enum			Kind			{None, Color, Threshold, Edge, Frequency, Smooth, Regions, Distance,
+									 Arithmetic, Resample, Matching};
+
+	//! \brief run an operation on its source images (in operand order); null if the inputs do not fit
+	static QImage	run				(const OpParams&, const QVector<QImage>&);
+	//! \brief display name of an operation with its parameters
+	static QString	describe		(const OpParams&);
+	//! \brief recompute an image with new parameters and every image derived from it
+	static int		rerun			(historyManager&, int, const OpParams&, QMap<int, QImage>&, QVector<int>&);
+};
+#endif
@@ -0,0 +1,92 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Parallel
+//! \brief Parallel range helper implementation
+//!
+//! \file parallel.cpp
+//! \brief Parallel range helper implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QVector>
+#include			<QThread>
+#include			<QtConcurrentMap>
+
+#include			"parallel.h"
+#include			"trace.h"
+
+// one chunk of work handed to the thread pool
+struct RangeJob
+{
+	int				begin;			// first item (inclusive)
+	int				end;			// last item (exclusive)
+	RangeFunct		funct;			// function to run on the chunk
+	void			*ctx;			// caller's context
+};
+
+// run a single chunk; used by QtConcurrent::blockingMap
+static void runRangeJob(RangeJob &job)
+{
+	TRACE("Parallel::forRange chunk");
+	job.funct(job.ctx, job.begin, job.end);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Run over a range
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief run funct over [0, count) in chunks of at least grain items
+//! \details the calling thread takes part in the work and returns when every chunk is done
+//! \param[in] count	number of items (rows, columns, tiles...)
+//! \param[in] funct	function called once per chunk
+//! \param[in] ctx		context passed through to funct
+//! \param[in] grain	minimum chunk size; small ranges run on the calling thread
+// the calling thread takes part in the work and returns when every chunk is done
+void Parallel::forRange(int count, RangeFunct funct, void *ctx, int grain)
+{
+	if (count <= 0)
+		return;
+
+	int threads			= numThreads();
+	if (grain < 1)
+		grain			= 1;
+
+	if (threads <= 1 || count <= grain)
+	{	// not worth the hand off
+		funct(ctx, 0, count);
+		return;
+	}
+
+	// a few chunks per thread keeps the pool busy when rows differ in cost
+	int chunks			= qMin(threads * 4, (count + grain - 1) / grain);
+	int size			= (count + chunks - 1) / chunks;
+
+	QVector<RangeJob> jobs;
+	jobs.reserve		(chunks);
+	for (int begin = 0; begin < count; begin += size)
+	{
+		RangeJob job;
+		job.begin		= begin;
+		job.end			= qMin(begin + size, count);
+		job.funct		= funct;
+		job.ctx			= ctx;
+		jobs.append		(job);
+	}
+
+	QtConcurrent::blockingMap(jobs, runRangeJob);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Number of threads
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief number of threads used by forRange
+//! \return	ideal thread count of this machine (at least 1)
+int Parallel::numThreads()
+{
+	int n				= QThread::idealThreadCount();
+	return n < 1 ? 1 : n;
+}
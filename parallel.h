@@ -0,0 +1,31 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Parallel
+//! \brief Split a range of rows (or columns) across the global thread pool
+//!
+//! \file parallel.h
+//! \brief Parallel range helper
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				PARALLEL_H
+#define				PARALLEL_H
+
+//! \brief function called for every chunk [begin, end) of a range
+typedef void		(*RangeFunct)	(void *ctx, int begin, int end);
+
+// Parallel class
+class Parallel
+{
+public:
+	//! \brief run funct over [0, count) in chunks of at least grain items
+	static void		forRange		(int count, RangeFunct funct, void *ctx, int grain = 16);
+	//! \brief number of threads used by forRange
+	static int		numThreads		();
+};
+#endif
@@ -13,6 +13,7 @@
 //! \brief 4PCS class
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 #include			"pcs4.h"
+#include			"trace.h"
 
 #include			<QMessageBox>
 #include			<QObject>
@@ -43,6 +44,7 @@ PCS4::PCS4()
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool PCS4::compute(QVector<Point3D> &v1, QVector<Point3D> &v2, float delta, float overlapEst, double mat[4][4])
 {
+	TRACE("PCS4::compute");
 	m_estFrac		= overlapEst;
 
 	double xc1 = 0.0;
@@ -269,6 +271,7 @@ bool PCS4::compute(QVector<Point3D> &v1, QVector<Point3D> &v2, float delta, floa
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool PCS4::align(QVector<Point3D> &v1, QVector<Point3D> &v2, float eps, LA_Fmat &rMat)
 {
+	TRACE("PCS4::align");
 	QVector<Point3D> listOut, cpyOut, tt, tt1, m1, m2;
 	float f;
 	float bestf	= 0.0;
@@ -298,6 +301,7 @@ bool PCS4::align(QVector<Point3D> &v1, QVector<Point3D> &v2, float eps, LA_Fmat
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool PCS4::tryOne(QVector<Point3D> &m1, QVector<Point3D> &m2, QVector<Point3D> &list1, QVector<Point3D> &list2, QVector<Point3D> &trList, QVector<Point3D> &trCpy, float &bestf, float eps, LA_Fmat &rMat)
 {
+	TRACE("PCS4::tryOne");
 	double tx, ty, tz, f1, f2;
 	int id1, id2, id3, id4;
 	QVector<QPair<Point3D, Point3D> > pr(4);
@@ -410,6 +414,7 @@ void PCS4::bruteForcePairs(const QVector<Point3D> &v, double d, double dd, doubl
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 double PCS4::verify(const QVector<Point3D> &v1, double eps, LA_Fmat &R, double bestf, double cx, double cy, double cz, double tx, double ty, double tz, float scale)
 {
+	TRACE("PCS4::verify");
 	int 			s, a;
 	float 			rnd;
 	Point3D 		p;
@@ -656,6 +661,7 @@ bool PCS4::tryQuad(const QVector<Point3D> &v, QVector<Point3D> &quad, double &f1
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool PCS4::findQuads(const QVector<Point3D> &v, QVector<Point3D> &quad, QVector<QPair<int, int> > &r1, QVector<QPair<int, int> > &r2, double f1, double f2, double e, double e1, QVector<QuadIndex> &ret)
 {
+	TRACE("PCS4::findQuads");
 	int n_pts			= 2 * r1.size();
 	int n				= n_pts;
 	ANNkd_tree			*tree;
@@ -752,6 +758,7 @@ bool PCS4::findQuads(const QVector<Point3D> &v, QVector<Point3D> &quad, QVector<
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void PCS4::doICP(const QVector<Point3D> &v1, QVector<Point3D> &v2, xform &m)
 {
+	TRACE("PCS4::doICP");
 	TriMesh *mesh1			= new TriMesh();
 	TriMesh *mesh2			= new TriMesh();
 
@@ -0,0 +1,319 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ProjectFile
+//! \brief Project file implementation
+//!
+//! \file project.cpp
+//! \brief Project file implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QFile>
+
+#include			"project.h"
+
+// The file starts with a header: "IMPJ", the version (4 bytes), the offset of the
+// table of contents (8 bytes) and the number of its entries (4 bytes). Chunk payloads
+// follow back to back; the table of contents is written last, so a project is saved
+// in one pass. Every entry is tag (4), id (4), offset (8) and size (8). All numbers
+// are little endian.
+
+#define				MAGIC			"IMPJ"
+#define				VERSION			1
+#define				HEADER_SIZE		20
+#define				ENTRY_SIZE		24
+
+// append a little endian number of n bytes
+static void putNumber(QByteArray &out, quint64 v, int n)
+{
+	for (int i = 0; i < n; i++)
+		out.append((char)(v >> (8 * i)));
+}
+
+// read a little endian number of n bytes
+static quint64 getNumber(const char *p, int n)
+{
+	quint64 v		= 0;
+	for (int i = n - 1; i >= 0; i--)
+		v			= (v << 8) | (uchar)p[i];
+	return v;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+ProjectFile::ProjectFile()
+{
+	m_file			= 0;
+	m_writing		= false;
+}
+
+//! \brief Destructor
+//! \details a project that was created but not finished is removed; the old file at its path is left alone
+// a project that was created but not finished is removed; the old file at its path is left alone
+ProjectFile::~ProjectFile()
+{
+	close			();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Create
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief start writing a project
+//! \details the chunks go to path.tmp; images of the project being replaced can still be read from path meanwhile
+//! \param[in] path	where the project goes
+//! \return		false if the file could not be created
+// the chunks go to path.tmp; images of the project being replaced can still be read from path meanwhile
+bool ProjectFile::create(const QString &path)
+{
+	close			();
+	m_path			= path;
+	m_file			= new QFile(path + ".tmp");
+	if (!m_file->open(QIODevice::ReadWrite | QIODevice::Truncate))
+	{
+		m_error		= m_file->errorString();
+		delete m_file;
+		m_file		= 0;
+		return false;
+	}
+	m_writing		= true;
+
+	QByteArray header(HEADER_SIZE, 0);	// filled in by finish()
+	if (m_file->write(header) != HEADER_SIZE)
+	{
+		m_error		= m_file->errorString();
+		close		();
+		return false;
+	}
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Write a chunk
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief append a chunk
+//! \param[in] tag	chunk type
+//! \param[in] id	number among chunks of the same type
+//! \param[in] data	payload
+//! \return		offset of the payload in the finished file; -1 on error
+qint64 ProjectFile::write(quint32 tag, int id, const QByteArray &data)
+{
+	if (!m_file || !m_writing)
+		return -1;
+
+	Chunk c;
+	c.tag			= tag;
+	c.id			= id;
+	c.pos			= m_file->size();
+	c.len			= data.size();
+	if (!m_file->seek(c.pos) || m_file->write(data) != data.size())
+	{
+		m_error		= m_file->errorString();
+		return -1;
+	}
+
+	m_index.insert	(key(tag, id), m_chunks.size());
+	m_chunks.append	(c);
+	return c.pos;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Finish
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief write the table of contents and the header, then put the file in place
+//! \details the temporary file replaces the old project only once it is complete
+//! \return		false if the project could not be written; the old project is unchanged
+// the temporary file replaces the old project only once it is complete
+bool ProjectFile::finish()
+{
+	if (!m_file || !m_writing)
+		return false;
+
+	qint64 tocPos	= m_file->size();
+	QByteArray toc;
+	for (int i = 0; i < m_chunks.size(); i++)
+	{
+		putNumber	(toc, m_chunks[i].tag, 4);
+		putNumber	(toc, (quint32)m_chunks[i].id, 4);
+		putNumber	(toc, m_chunks[i].pos, 8);
+		putNumber	(toc, m_chunks[i].len, 8);
+	}
+
+	QByteArray header(MAGIC);
+	putNumber		(header, VERSION, 4);
+	putNumber		(header, tocPos, 8);
+	putNumber		(header, m_chunks.size(), 4);
+
+	if (!m_file->seek(tocPos) || m_file->write(toc) != toc.size()
+		|| !m_file->seek(0) || m_file->write(header) != HEADER_SIZE || !m_file->flush())
+	{
+		m_error		= m_file->errorString();
+		close		();
+		return false;
+	}
+	m_file			->close();
+
+	QString tmp		= m_path + ".tmp";
+	if (QFile::exists(m_path) && !QFile::remove(m_path))
+	{
+		m_error		= QString("Cannot replace %1").arg(m_path);
+		close		();
+		return false;
+	}
+	if (!QFile::rename(tmp, m_path))
+	{
+		m_error		= QString("Cannot rename %1").arg(tmp);
+		close		();
+		return false;
+	}
+
+	m_writing		= false;
+	delete m_file;
+	m_file			= 0;
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Open
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief open a project
+//! \details only the header and the table of contents are read; chunks are read by read() when needed
+//! \param[in] path	the project
+//! \return		false if the file is missing or is not a project
+// only the header and the table of contents are read; chunks are read by read() when needed
+bool ProjectFile::open(const QString &path)
+{
+	close			();
+	m_path			= path;
+	m_file			= new QFile(path);
+	if (!m_file->open(QIODevice::ReadOnly))
+	{
+		m_error		= m_file->errorString();
+		close		();
+		return false;
+	}
+
+	qint64 size		= m_file->size();
+	QByteArray header	= m_file->read(HEADER_SIZE);
+	if (header.size() != HEADER_SIZE || !header.startsWith(MAGIC))
+	{
+		m_error		= QString("%1 is not a project").arg(path);
+		close		();
+		return false;
+	}
+	if (getNumber(header.constData() + 4, 4) != VERSION)
+	{
+		m_error		= QString("%1 was saved by another version").arg(path);
+		close		();
+		return false;
+	}
+
+	qint64 tocPos	= (qint64)getNumber(header.constData() + 8, 8);
+	qint64 count	= (qint64)getNumber(header.constData() + 16, 4);
+	if (tocPos < HEADER_SIZE || tocPos + count * ENTRY_SIZE > size || !m_file->seek(tocPos))
+	{
+		m_error		= QString("%1 is damaged").arg(path);
+		close		();
+		return false;
+	}
+
+	QByteArray toc	= m_file->read(count * ENTRY_SIZE);
+	if (toc.size() != count * ENTRY_SIZE)
+	{
+		m_error		= QString("%1 is damaged").arg(path);
+		close		();
+		return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		const char *p	= toc.constData() + i * ENTRY_SIZE;
+		Chunk c;
+		c.tag		= (quint32)getNumber(p, 4);
+		c.id		= (qint32)getNumber(p + 4, 4);
+		c.pos		= (qint64)getNumber(p + 8, 8);
+		c.len		= (qint64)getNumber(p + 16, 8);
+		if (c.pos < HEADER_SIZE || c.len < 0 || c.pos + c.len > tocPos)
+		{
+			m_error	= QString("%1 is damaged").arg(path);
+			close	();
+			return false;
+		}
+		m_index.insert	(key(c.tag, c.id), m_chunks.size());
+		m_chunks.append	(c);
+	}
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Read a chunk
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief payload of a chunk
+//! \param[in] tag	chunk type
+//! \param[in] id	number among chunks of the same type
+//! \return		the payload; empty if there is no such chunk or it could not be read
+QByteArray ProjectFile::read(quint32 tag, int id)
+{
+	int i			= m_index.value(key(tag, id), -1);
+	if (!m_file || i < 0 || !m_file->seek(m_chunks[i].pos))
+		return QByteArray();
+
+	QByteArray data	= m_file->read(m_chunks[i].len);
+	return data.size() == m_chunks[i].len ? data : QByteArray();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Offset of a chunk
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief offset of the payload of a chunk
+//! \details image bands are left in the file; the image store reads them from this offset when they are shown
+//! \param[in] tag	chunk type
+//! \param[in] id	number among chunks of the same type
+//! \return		offset in the file; -1 if there is no such chunk
+// image bands are left in the file; the image store reads them from this offset when they are shown
+qint64 ProjectFile::offset(quint32 tag, int id)
+{
+	int i			= m_index.value(key(tag, id), -1);
+	return i < 0 ? -1 : m_chunks[i].pos;
+}
+
+//! \brief path of the project
+//! \return		the path given to create() or open()
+QString ProjectFile::path()
+{
+	return m_path;
+}
+
+//! \brief why the last call failed
+//! \return		a message for the user
+QString ProjectFile::errorString()
+{
+	return m_error;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Close
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief close the file
+//! \details an unfinished project is removed
+// an unfinished project is removed
+void ProjectFile::close()
+{
+	if (m_file)
+	{
+		m_file		->close();
+		if (m_writing)
+			QFile::remove(m_path + ".tmp");
+		delete m_file;
+		m_file		= 0;
+	}
+	m_writing		= false;
+	m_chunks		.clear();
+	m_index			.clear();
+}
@@ -0,0 +1,81 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ProjectFile
+//! \brief Chunked container with a table of contents; the file format of a saved session
+//!
+//! \file project.h
+//! \brief Project file class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				PROJECT_H
+#define				PROJECT_H
+
+#include			<QByteArray>
+#include			<QString>
+#include			<QVector>
+#include			<QHash>
+
+class				QFile;
+
+// ProjectFile class
+class ProjectFile
+{
+public:
+	//! \brief enum for ProjectFile; chunk types (four characters, big endian)
+	enum			Tag				{Images		= 0x494D4753,	// "IMGS" image table and thumbnail list
+									 Bands		= 0x42414E44,	// "BAND" compressed bands of one image; id is the image index
+									 History	= 0x48495354,	// "HIST" derivation graph with parameters
+									 Layout		= 0x4C415954};	// "LAYT" layout spec and frame contents
+
+	//! \brief Constructor
+					ProjectFile		();
+	//! \brief Destructor; an unfinished file is discarded
+					~ProjectFile	();
+
+	//! \brief start writing a project; the file only replaces path when finish() succeeds
+	bool			create			(const QString &path);
+	//! \brief append a chunk; returns the offset of its payload, -1 on error
+	qint64			write			(quint32 tag, int id, const QByteArray&);
+	//! \brief write the table of contents and put the file in place
+	bool			finish			();
+
+	//! \brief open a project; only the header and the table of contents are read
+	bool			open			(const QString &path);
+	//! \brief payload of a chunk; empty if there is none
+	QByteArray		read			(quint32 tag, int id = 0);
+	//! \brief offset of the payload of a chunk, for readers that load it later; -1 if there is none
+	qint64			offset			(quint32 tag, int id = 0);
+	//! \brief path of the project
+	QString			path			();
+	//! \brief why the last call failed
+	QString			errorString		();
+
+private:
+	//! \brief one entry of the table of contents
+	struct Chunk
+	{
+		quint32		tag;			// Tag
+		qint32		id;				// number among chunks of the same tag
+		qint64		pos;			// offset of the payload
+		qint64		len;			// size of the payload
+	};
+
+	//! \brief key of a chunk in the index
+	static quint64	key				(quint32 tag, int id)		{ return (quint64(tag) << 32) | quint32(id); }
+	//! \brief close the file
+	void			close			();
+
+	QFile					*m_file;		// the open file; 0 if none
+	QString					m_path;			// path of the project
+	bool					m_writing;		// the file is a temporary one being written
+	QVector<Chunk>			m_chunks;		// table of contents in file order
+	QHash<quint64, int>		m_index;		// (tag, id) -> entry of m_chunks
+	QString					m_error;		// why the last call failed
+};
+#endif
@@ -0,0 +1,172 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class RerunDialog
+//!
+//! \file rerundialog.cpp
+//! \brief Re-run dialog implementation.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include	"rerundialog.h"
+#include	"ip.h"
+#include	"binaryop.h"
+
+// choices of an enumeration or flag parameter, as value and label; empty if the parameter is a number
+static QList< QPair<int, QString> > choices(const QString &key)
+{
+	QList< QPair<int, QString> > list;
+	if (key == "channel")
+		list << qMakePair((int)IP::Red, QString("Red")) << qMakePair((int)IP::Green, QString("Green"))
+			 << qMakePair((int)IP::Blue, QString("Blue")) << qMakePair((int)IP::Gray, QString("Gray"));
+	else if (key == "mask")
+		list << qMakePair(0, QString("Prewitt")) << qMakePair(1, QString("Sobel")) << qMakePair(2, QString("LoG"));
+	else if (key == "filter")
+		list << qMakePair((int)IP::IdealLow, QString("Ideal low pass")) << qMakePair((int)IP::ButterLow, QString("Butterworth low pass"))
+			 << qMakePair((int)IP::GaussLow, QString("Gaussian low pass")) << qMakePair((int)IP::IdealHigh, QString("Ideal high pass"))
+			 << qMakePair((int)IP::ButterHigh, QString("Butterworth high pass")) << qMakePair((int)IP::GaussHigh, QString("Gaussian high pass"))
+			 << qMakePair(6, QString("Spectrum")) << qMakePair(7, QString("Gaussian blur"));
+	else if (key == "method")
+		list << qMakePair(0, QString("Bilateral")) << qMakePair(1, QString("Guided"));
+	else if (key == "connectivity")
+		list << qMakePair(4, QString("4")) << qMakePair(8, QString("8"));
+	else if (key == "op")
+		for (int i = 0; i < BinaryOp::NumOps; i++)
+			list << qMakePair(i, BinaryOp::name((BinaryOp::Op)i));
+	else if (key == "interp")
+		list << qMakePair(0, QString("Bilinear")) << qMakePair(1, QString("Bicubic"));
+	else if (key == "all" || key == "inside" || key == "pyramid")
+		list << qMakePair(0, QString("No")) << qMakePair(1, QString("Yes"));
+	return list;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+//! \details the parameters are listed by name with their current values. Enumerations and flags get a combo
+//!	box, integers a spin box, and real numbers a line edit showing every digit, so an unedited value is
+//!	passed back exactly
+//! \param[in] params	parameters recorded with the image
+//! \param[in] parent	parent widget
+// enumerations get a combo box, integers a spin box, real numbers a line edit showing every digit
+RerunDialog::RerunDialog(const OpParams &params, QDialog *parent)
+	: QDialog (parent)
+{
+	m_params			= params;
+
+	// init one editor per parameter
+	QGroupBox	*boxParams			= new QGroupBox(Operation::describe(params).section(" [", 0, 0), this);
+	QGridLayout	*gridParams			= new QGridLayout;
+	int row				= 0;
+	for (QMap<QString, double>::const_iterator i = params.values.constBegin(); i != params.values.constEnd(); i++, row++)
+	{
+		QLabel *label	= new QLabel(tr("%1: ").arg(i.key()), this);
+		QWidget *editor;
+		QList< QPair<int, QString> > list	= choices(i.key());
+		if (!list.isEmpty())
+		{
+			QComboBox *combo	= new QComboBox(this);
+			for (int j = 0; j < list.size(); j++)
+			{
+				combo	->addItem(list[j].second, list[j].first);
+				if (list[j].first == (int)i.value())
+					combo	->setCurrentIndex(j);
+			}
+			if (combo->findData((int)i.value()) < 0)
+			{	// a value no choice has; offer it as it is so the box does not change it
+				combo	->addItem(QString::number(i.value()), (int)i.value());
+				combo	->setCurrentIndex(combo->count() - 1);
+			}
+			m_choices	.insert(i.key(), combo);
+			m_shown		.insert(i.key(), combo->currentIndex());
+			editor		= combo;
+		}
+		else if (i.key() == "level" || i.key() == "weight" || i.key() == "matches")
+		{	// blend weights run to 256 (all of the second image); the recorded value is always in range
+			int low		= i.key() == "matches" ? 1 : 0;
+			int high	= i.key() == "matches" ? 1000 : (i.key() == "weight" ? 256 : 255);
+			QSpinBox *spin	= new QSpinBox(this);
+			spin		->setRange(qMin(low, (int)i.value()), qMax(high, (int)i.value()));
+			spin		->setValue((int)i.value());
+			m_ints		.insert(i.key(), spin);
+			m_shown		.insert(i.key(), spin->value());
+			editor		= spin;
+		}
+		else
+		{
+			QLineEdit *edit	= new QLineEdit(QString::number(i.value(), 'g', 17), this);
+			edit		->setValidator(new QDoubleValidator(edit));
+			m_reals		.insert(i.key(), edit);
+			editor		= edit;
+		}
+		gridParams		->addWidget(label,	row, 0, Qt::AlignRight);
+		gridParams		->addWidget(editor,	row, 1);
+	}
+	boxParams			->setLayout(gridParams);
+
+	// init push button
+	QPushButton	*okBut				= new QPushButton(tr("Re-run"));
+	QPushButton	*cancelBut			= new QPushButton(tr("Cancel"));
+
+	QHBoxLayout	*hButBox			= new QHBoxLayout;
+	hButBox				->addStretch(1);
+	hButBox				->addWidget(okBut);
+	hButBox				->addWidget(cancelBut);
+
+	// init layout for this dialog box
+	QGridLayout	*grid	= new QGridLayout(this);
+	grid				->addWidget(boxParams,	0, 0);
+	grid				->addLayout(hButBox,	1, 0);
+
+	connect (okBut,			SIGNAL(clicked()),			this, SLOT(ok()) );
+	connect (cancelBut,		SIGNAL(clicked()),			this, SLOT(close()) );
+
+	setWindowTitle (tr("Re-run from here"));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Retrieval function
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Retrieve values function
+//! \return	the parameters with the edited values
+OpParams RerunDialog::retVal()
+{
+	return m_params;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// ========================== Below are private functions ===============================
+//
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Ok
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Private slot when Ok is clicked
+//! \details Store the edited values for retVal(); only fields the user changed are written back, so a value
+//!	the user did not touch is kept exactly as it was recorded
+// Store the edited values for retVal(); only fields the user changed are written back
+void RerunDialog::ok()
+{
+	QMap<QString, double> &v	= m_params.values;
+	for (QMap<QString, QComboBox*>::const_iterator i = m_choices.constBegin(); i != m_choices.constEnd(); i++)
+		if (i.value()->currentIndex() != m_shown.value(i.key()))
+			v[i.key()]	= i.value()->itemData(i.value()->currentIndex()).toInt();
+	for (QMap<QString, QSpinBox*>::const_iterator i = m_ints.constBegin(); i != m_ints.constEnd(); i++)
+		if (i.value()->value() != m_shown.value(i.key()))
+			v[i.key()]	= i.value()->value();
+	for (QMap<QString, QLineEdit*>::const_iterator i = m_reals.constBegin(); i != m_reals.constEnd(); i++)
+	{
+		bool valid;
+		double value	= i.value()->text().toDouble(&valid);
+		if (valid && i.value()->isModified() && i.value()->text() != QString::number(v.value(i.key()), 'g', 17))
+			v[i.key()]	= value;
+	}
+	done(1);
+}
@@ -0,0 +1,43 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class RerunDialog
+//! \brief Dialog box to edit the parameters of an operation before running it again
+//!
+//! \file rerundialog.h
+//! \brief Re-run dialog class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef			RERUNDIALOG_H
+#define			RERUNDIALOG_H
+
+#include		<QtGui>
+#include		"operation.h"
+
+class RerunDialog : public QDialog
+{
+			Q_OBJECT
+
+public:
+	//! \brief Constructor; one editor per parameter
+			RerunDialog			(const OpParams&, QDialog *parent = 0);
+	//! \brief Retrival function
+	OpParams	retVal			();		// Call this function to retrieve the edited parameters
+
+private slots:
+	//! \brief Ok slot
+	void		ok				();
+
+private:
+	QMap<QString, QComboBox*>	m_choices;	// Combo boxes for enumerations and flags, by name
+	QMap<QString, QSpinBox*>	m_ints;		// Spinboxes for integer parameters, by name
+	QMap<QString, QLineEdit*>	m_reals;	// Line edits for real parameters at full precision, by name
+	QMap<QString, int>			m_shown;	// Index or value each combo box and spinbox started with, by name
+	OpParams					m_params;	// Holds the parameters
+};
+#endif
@@ -0,0 +1,380 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class TemplateMatch
+//! \brief Template matching implementation
+//!
+//! \file templatematch.cpp
+//! \brief Template matching implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cmath>
+#include			<cstdlib>
+#include			<QtAlgorithms>
+
+#include			"templatematch.h"
+#include			"fft.h"
+#include			"parallel.h"
+
+static const int	DIRECT_AREA		= 121;		// templates up to 11x11 are correlated without the FFT
+static const int	MIN_PYR_SIDE	= 16;		// the template is never shrunk below this
+static const int	MAX_LEVELS		= 4;		// pyramid levels including full size
+
+// gray plane
+struct MatchPlane
+{
+	QVector<float>	d;
+	int				w;
+	int				h;
+};
+
+// state shared by the worker threads for one pyramid level
+struct NCCContext
+{
+	const MatchPlane	*img;
+	const MatchPlane	*tpl;
+	QVector<float>	tz;				// zero mean template
+	double			tNorm;			// sqrt(sum(tz^2))
+	QVector<double>	sum;			// integral image of the image, (w+1) x (h+1)
+	QVector<double>	sum2;			// integral image of the squared image
+	QVector<float>	num;			// correlation numerator from the FFT (pw wide), empty when direct
+	int				pw;				// row length of num
+	QVector<float>	*score;			// output scores, ow x oh
+	int				ow;
+	int				oh;
+};
+
+// gray levels of img
+static void toGray(const QImage &img, MatchPlane &p)
+{
+	p.w			= img.width();
+	p.h			= img.height();
+	p.d.resize	(p.w * p.h);
+
+	for (int y = 0; y < p.h; y++)
+	{
+		const unsigned char *pixData	= img.scanLine(y);
+		for (int x = 0; x < p.w; x++, pixData += 4)
+			p.d[y * p.w + x]	= (float)(0.3 * pixData[2] + 0.59 * pixData[1] + 0.11 * pixData[0]);
+	}
+}
+
+// half size plane by 2x2 box averaging
+static void halve(const MatchPlane &src, MatchPlane &dst)
+{
+	dst.w		= src.w / 2;
+	dst.h		= src.h / 2;
+	dst.d.resize(dst.w * dst.h);
+
+	for (int y = 0; y < dst.h; y++)
+	{
+		const float *r0	= src.d.data() + 2 * y * src.w;
+		const float *r1	= r0 + src.w;
+		for (int x = 0; x < dst.w; x++)
+			dst.d[y * dst.w + x]	= 0.25f * (r0[2*x] + r0[2*x+1] + r1[2*x] + r1[2*x+1]);
+	}
+}
+
+// template statistics and integral images; the base of every score computation
+static void prepare(NCCContext &c, const MatchPlane &img, const MatchPlane &tpl)
+{
+	c.img			= &img;
+	c.tpl			= &tpl;
+	c.ow			= img.w - tpl.w + 1;
+	c.oh			= img.h - tpl.h + 1;
+
+	int n			= tpl.w * tpl.h;
+	double mean		= 0.0;
+	for (int i = 0; i < n; i++)
+		mean		+= tpl.d[i];
+	mean			/= n;
+
+	c.tz.resize		(n);
+	double norm		= 0.0;
+	for (int i = 0; i < n; i++)
+	{
+		c.tz[i]		= (float)(tpl.d[i] - mean);
+		norm		+= c.tz[i] * c.tz[i];
+	}
+	c.tNorm			= sqrt(norm);
+
+	int sw			= img.w + 1;
+	c.sum.fill		(0.0, sw * (img.h + 1));
+	c.sum2.fill		(0.0, sw * (img.h + 1));
+	for (int y = 0; y < img.h; y++)
+	{
+		double row = 0.0, row2 = 0.0;
+		for (int x = 0; x < img.w; x++)
+		{
+			double v	= img.d[y * img.w + x];
+			row			+= v;
+			row2		+= v * v;
+			c.sum [(y + 1) * sw + x + 1]	= c.sum [y * sw + x + 1] + row;
+			c.sum2[(y + 1) * sw + x + 1]	= c.sum2[y * sw + x + 1] + row2;
+		}
+	}
+}
+
+// sum(image * zero mean template) at (u, v)
+static double directNum(const NCCContext &c, int u, int v)
+{
+	double acc		= 0.0;
+	for (int y = 0; y < c.tpl->h; y++)
+	{
+		const float *row	= c.img->d.data() + (v + y) * c.img->w + u;
+		const float *t		= c.tz.data() + y * c.tpl->w;
+		for (int x = 0; x < c.tpl->w; x++)
+			acc		+= row[x] * t[x];
+	}
+	return acc;
+}
+
+// NCC at (u, v); the image variance under the template comes from the integral images in O(1)
+static float nccAt(const NCCContext &c, int u, int v, double num)
+{
+	int sw			= c.img->w + 1;
+	int tw			= c.tpl->w;
+	int th			= c.tpl->h;
+	double n		= tw * th;
+
+	double s		= c.sum [(v + th) * sw + u + tw] - c.sum [v * sw + u + tw] - c.sum [(v + th) * sw + u] + c.sum [v * sw + u];
+	double s2		= c.sum2[(v + th) * sw + u + tw] - c.sum2[v * sw + u + tw] - c.sum2[(v + th) * sw + u] + c.sum2[v * sw + u];
+	double var		= s2 - s * s / n;
+
+	if (var < 1e-6 * n || c.tNorm < 1e-6)
+		return 0.0f;	// flat image area or flat template
+	return (float)(num / (sqrt(var) * c.tNorm));
+}
+
+// scores of rows [begin, end)
+static void scoreRows(void *p, int begin, int end)
+{
+	NCCContext *c		= (NCCContext*)p;
+
+	for (int v = begin; v < end; v++)
+	{
+		float *out		= c->score->data() + v * c->ow;
+		for (int u = 0; u < c->ow; u++)
+		{
+			double num	= c->num.isEmpty() ? directNum(*c, u, v) : c->num[v * c->pw + u];
+			out[u]		= nccAt(*c, u, v, num);
+		}
+	}
+}
+
+// full score map of one level
+static void scoreMap(NCCContext &c, QVector<float> &score)
+{
+	score.resize		(c.ow * c.oh);
+	c.score				= &score;
+	c.num.clear			();
+
+	if (c.tpl->w * c.tpl->h > DIRECT_AREA)
+	{	// numerator for every position at once: IFFT(F(image) * conj(F(template)))
+		int pw			= FFT::goodSize(c.img->w);
+		int ph			= FFT::goodSize(c.img->h);
+		int half		= pw / 2 + 1;
+
+		QVector<float> plane(pw * ph, 0.0f);
+		QVector<FFTComplex> fi(ph * half), ft(ph * half);
+
+		for (int y = 0; y < c.img->h; y++)
+			for (int x = 0; x < c.img->w; x++)
+				plane[y * pw + x]	= c.img->d[y * c.img->w + x];
+		FFT::forward2D	(plane.data(), pw, ph, fi.data());
+
+		plane.fill		(0.0f);
+		for (int y = 0; y < c.tpl->h; y++)
+			for (int x = 0; x < c.tpl->w; x++)
+				plane[y * pw + x]	= c.tz[y * c.tpl->w + x];
+		FFT::forward2D	(plane.data(), pw, ph, ft.data());
+
+		for (int i = 0; i < ph * half; i++)
+		{
+			float re	= fi[i].re * ft[i].re + fi[i].im * ft[i].im;
+			float im	= fi[i].im * ft[i].re - fi[i].re * ft[i].im;
+			fi[i].re	= re;
+			fi[i].im	= im;
+		}
+
+		FFT::inverse2D	(fi.data(), pw, ph, plane.data());
+		c.num			= plane;
+		c.pw			= pw;
+	}
+
+	Parallel::forRange	(c.oh, scoreRows, &c, 4);
+}
+
+// sort helper; best first
+static bool matchGreater(const MatchResult &a, const MatchResult &b)
+{
+	return a.score > b.score;
+}
+
+// local maxima of a score map at or above minScore, best first, with overlapping matches removed
+static void peaks(const QVector<float> &score, int ow, int oh, int tw, int th, double minScore, int maxResults, QVector<MatchResult> &result)
+{
+	QVector<MatchResult> cand;
+	for (int v = 0; v < oh; v++)
+	{
+		for (int u = 0; u < ow; u++)
+		{
+			float s		= score[v * ow + u];
+			if (s < minScore)
+				continue;
+
+			bool peak	= true;
+			for (int dy = -1; dy <= 1 && peak; dy++)
+				for (int dx = -1; dx <= 1 && peak; dx++)
+				{
+					int x	= u + dx;
+					int y	= v + dy;
+					if ((dx == 0 && dy == 0) || x < 0 || y < 0 || x >= ow || y >= oh)
+						continue;
+					float n	= score[y * ow + x];
+					if (n > s || (n == s && (dy < 0 || (dy == 0 && dx < 0))))
+						peak	= false;
+				}
+			if (!peak)
+				continue;
+
+			MatchResult m;
+			m.rect		= QRect(u, v, tw, th);
+			m.score		= s;
+			cand.append	(m);
+		}
+	}
+
+	qSort				(cand.begin(), cand.end(), matchGreater);
+
+	result.clear		();
+	for (int i = 0; i < cand.size() && result.size() < maxResults; i++)
+	{
+		bool overlap	= false;
+		for (int j = 0; j < result.size() && !overlap; j++)
+			overlap		= abs(cand[i].rect.x() - result[j].rect.x()) < tw / 2
+						  && abs(cand[i].rect.y() - result[j].rect.y()) < th / 2;
+		if (!overlap)
+			result.append(cand[i]);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Match
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief find the template in the image
+//! \details zero mean normalized cross correlation on gray levels. The numerator is computed with the FFT
+//!	for templates larger than 11x11 and directly otherwise; the image variance under the template comes
+//!	from integral images. With pyramid on, the full search runs on a reduced image and only the
+//!	candidates are refined at each finer level within +-2 pixels
+//! \param[in] img			image to search
+//! \param[in] templ		template; must fit in the image
+//! \param[in] minScore		smallest score reported
+//! \param[in] maxResults	maximum number of matches
+//! \param[in] pyramid		coarse to fine search
+//! \param[out] result		matches, best first
+//! \return					score map ((w - tw + 1) x (h - th + 1)); -1 is black and 1 is white
+// zero mean normalized cross correlation; FFT numerator for large templates and integral image variance
+QImage TemplateMatch::match(const QImage &img, const QImage &templ, double minScore, int maxResults, bool pyramid, QVector<MatchResult> &result)
+{
+	result.clear		();
+	if (templ.isNull() || img.isNull() || templ.width() > img.width() || templ.height() > img.height())
+		return QImage();
+
+	// level 0 is full size
+	QVector<MatchPlane> imgPyr(1), tplPyr(1);
+	toGray				(img, imgPyr[0]);
+	toGray				(templ, tplPyr[0]);
+
+	while (pyramid && imgPyr.size() < MAX_LEVELS
+		   && tplPyr.last().w / 2 >= MIN_PYR_SIDE && tplPyr.last().h / 2 >= MIN_PYR_SIDE)
+	{
+		MatchPlane pi, pt;
+		halve			(imgPyr.last(), pi);
+		halve			(tplPyr.last(), pt);
+		imgPyr.append	(pi);
+		tplPyr.append	(pt);
+	}
+
+	int top				= imgPyr.size() - 1;
+
+	// full search on the coarsest level; looser threshold and more candidates there since detail is lost
+	NCCContext c;
+	QVector<float> score;
+	prepare				(c, imgPyr[top], tplPyr[top]);
+	scoreMap			(c, score);
+
+	double coarseMin	= top > 0 ? 0.5 * minScore : minScore;
+	peaks				(score, c.ow, c.oh, tplPyr[top].w, tplPyr[top].h, coarseMin, top > 0 ? 8 * maxResults : maxResults, result);
+
+	int mapW			= c.ow;
+	int mapH			= c.oh;
+	QVector<float> map	= score;
+
+	// refine the candidates one level at a time
+	for (int level = top - 1; level >= 0; level--)
+	{
+		NCCContext f;
+		prepare			(f, imgPyr[level], tplPyr[level]);
+
+		for (int i = 0; i < result.size(); i++)
+		{
+			int bu		= 2 * result[i].rect.x();
+			int bv		= 2 * result[i].rect.y();
+			double best	= -2.0;
+
+			for (int v = qMax(0, bv - 2); v <= qMin(f.oh - 1, bv + 2); v++)
+				for (int u = qMax(0, bu - 2); u <= qMin(f.ow - 1, bu + 2); u++)
+				{
+					double s	= nccAt(f, u, v, directNum(f, u, v));
+					if (s > best)
+					{
+						best			= s;
+						result[i].rect	= QRect(u, v, tplPyr[level].w, tplPyr[level].h);
+					}
+				}
+			result[i].score	= best;
+		}
+
+		qSort			(result.begin(), result.end(), matchGreater);
+	}
+
+	if (top > 0)
+	{	// final threshold and count at full size; refined candidates may have converged on one spot
+		QVector<MatchResult> kept;
+		for (int i = 0; i < result.size() && kept.size() < maxResults; i++)
+		{
+			bool overlap	= result[i].score < minScore;
+			for (int j = 0; j < kept.size() && !overlap; j++)
+				overlap		= abs(result[i].rect.x() - kept[j].rect.x()) < templ.width() / 2
+							  && abs(result[i].rect.y() - kept[j].rect.y()) < templ.height() / 2;
+			if (!overlap)
+				kept.append	(result[i]);
+		}
+		result			= kept;
+	}
+
+	// score map at full size; scaled up from the coarsest level when the pyramid is used
+	int ow				= img.width() - templ.width() + 1;
+	int oh				= img.height() - templ.height() + 1;
+	QImage scoreImg(ow, oh, QImage::Format_RGB32);
+	for (int y = 0; y < oh; y++)
+	{
+		QRgb *line		= (QRgb*)scoreImg.scanLine(y);
+		int my			= qMin(mapH - 1, y * mapH / oh);
+		for (int x = 0; x < ow; x++)
+		{
+			int mx		= qMin(mapW - 1, x * mapW / ow);
+			int g		= (int)((map[my * mapW + mx] + 1.0f) * 127.5f);
+			g			= g < 0 ? 0 : (g > 255 ? 255 : g);
+			line[x]		= qRgb(g, g, g);
+		}
+	}
+
+	return scoreImg;
+}
@@ -0,0 +1,37 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class TemplateMatch
+//! \brief Normalized cross correlation template matching
+//!
+//! \file templatematch.h
+//! \brief Template matching class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				TEMPLATEMATCH_H
+#define				TEMPLATEMATCH_H
+
+#include			<QImage>
+#include			<QRect>
+#include			<QVector>
+
+// one match of the template
+struct MatchResult
+{
+	QRect			rect;			// matched area in the image
+	double			score;			// normalized cross correlation (-1 - 1)
+};
+
+// TemplateMatch class
+class TemplateMatch
+{
+public:
+	//! \brief find the template in the image; returns the score map
+	static QImage	match			(const QImage&, const QImage&, double, int, bool, QVector<MatchResult>&);
+};
+#endif
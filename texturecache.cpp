@@ -0,0 +1,165 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class TextureCache
+//! \brief TextureCache implementation
+//!
+//! \file texturecache.cpp
+//! \brief TextureCache implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			"texturecache.h"
+#include			"memoryledger.h"
+#include			"trace.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the cache shared by the whole application
+//! \return		the cache
+TextureCache* TextureCache::instance()
+{
+	static TextureCache cache;
+	return &cache;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Share widget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief widget whose context every GL widget shares
+//! \details a hidden widget made on first use. It is never deleted: the context group must outlive every
+//!	widget in it, and a GL widget cannot be deleted after the application object
+//! \return		the widget
+// a hidden widget made on first use; never deleted, the context group must outlive every widget in it
+QGLWidget* TextureCache::shareWidget()
+{
+	static QGLWidget *widget	= 0;
+	if (!widget)
+		widget				= new QGLWidget;
+	return widget;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+TextureCache::TextureCache()
+{
+	m_budget				= TEXTURE_BUDGET;
+	m_bytes					= 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Ref
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief texture of an image at a resolution level
+//! \details textures are keyed by QImage::cacheKey(), so every widget showing the same pixels gets the same
+//!	texture. Level n is the image halved n times. A texture is only uploaded if no widget has asked for it
+//!	before or it was evicted. A context of the shared group must be current
+//! \param[in] img		image
+//! \param[in] level	resolution level; 0 is full size
+//! \return		texture name; the caller owns one reference
+// textures are keyed by QImage::cacheKey(), so every widget showing the same pixels gets the same texture
+GLuint TextureCache::ref(const QImage &img, int level)
+{
+	Key key(img.cacheKey(), level);
+	QHash<Key, Texture>::iterator it	= m_textures.find(key);
+	if (it != m_textures.end())
+	{
+		if (it->refs++ == 0)
+			m_unused		.removeOne(key);
+		return it->id;
+	}
+
+	TRACE("TextureCache::upload");
+	QImage src				= img;
+	if (level > 0)
+		src					= img.scaled(qMax(img.width() >> level, 1), qMax(img.height() >> level, 1),
+										 Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	QImage gl				= QGLWidget::convertToGLFormat(src);
+
+	Texture tex;
+	tex.refs				= 1;
+	tex.bytes				= (qint64)gl.width() * gl.height() * 4;
+	glGenTextures			(1, &tex.id);
+	glBindTexture			(GL_TEXTURE_2D, tex.id);
+	glTexParameteri			(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri			(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D			(GL_TEXTURE_2D, 0, GL_RGBA, gl.width(), gl.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, gl.bits());
+
+	m_textures				.insert(key, tex);
+	m_bytes					+= tex.bytes;
+	MemoryLedger::instance()->set(this, (int)tex.id, MemoryLedger::Textures, tex.bytes,
+								  QString("texture %1x%2 (level %3)").arg(gl.width()).arg(gl.height()).arg(level));
+	evict					();
+	return tex.id;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Unref
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief drop a reference
+//! \details a texture no widget shows is kept, so showing the image again costs nothing, until the budget
+//!	needs the memory. A context of the shared group must be current
+//! \param[in] key		QImage::cacheKey() of the image
+//! \param[in] level	resolution level
+// a texture no widget shows is kept until the budget needs the memory
+void TextureCache::unref(qint64 key, int level)
+{
+	QHash<Key, Texture>::iterator it	= m_textures.find(Key(key, level));
+	if (it == m_textures.end() || --it->refs > 0)
+		return;
+
+	m_unused				.append(Key(key, level));
+	evict					();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Budget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief set the bytes of textures the cache may hold
+//! \details unused textures over the new budget are deleted at once
+//! \param[in] bytes	budget
+void TextureCache::setBudget(qint64 bytes)
+{
+	m_budget				= bytes;
+	shareWidget()			->makeCurrent();
+	evict					();
+}
+
+//! \brief bytes of textures the cache may hold
+//! \return		the budget
+qint64 TextureCache::budget()
+{
+	return m_budget;
+}
+
+//! \brief bytes of all textures
+//! \return		bytes of textures, shown or not
+qint64 TextureCache::bytes()
+{
+	return m_bytes;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Evict
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief delete unused textures until under budget
+//! \details least recently used first. Textures on screen are never deleted, so the widgets showing
+//!	images can hold more than the budget
+// least recently used first; textures on screen are never deleted
+void TextureCache::evict()
+{
+	while (m_bytes > m_budget && !m_unused.isEmpty())
+	{
+		Texture tex			= m_textures.take(m_unused.takeFirst());
+		glDeleteTextures	(1, &tex.id);
+		m_bytes				-= tex.bytes;
+		MemoryLedger::instance()->set(this, (int)tex.id, MemoryLedger::Textures, 0);
+	}
+}
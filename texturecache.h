@@ -0,0 +1,69 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class TextureCache
+//! \brief Textures of images shared by every GL widget, kept under a memory budget
+//!
+//! \file texturecache.h
+//! \brief TextureCache class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				TEXTURECACHE_H
+#define				TEXTURECACHE_H
+
+#define				TEXTURE_BUDGET	(256 << 20)		// default bytes of textures; textures on screen may go over it
+
+#include			<QGLWidget>
+#include			<QHash>
+#include			<QList>
+#include			<QPair>
+
+// TextureCache class
+class TextureCache
+{
+public:
+	//! \brief the cache shared by the whole application
+	static TextureCache*	instance	();
+	//! \brief widget whose context every GL widget shares, so a texture is uploaded once for all of them
+	static QGLWidget*	shareWidget		();
+
+	//! \brief texture of an image at a resolution level, uploaded if needed; the caller owns one reference
+	GLuint			ref				(const QImage&, int level);
+	//! \brief drop a reference; the texture stays cached until the budget needs the memory
+	void			unref			(qint64 key, int level);
+
+	//! \brief bytes of textures the cache may hold
+	void			setBudget		(qint64);
+	//! \brief bytes of textures the cache may hold
+	qint64			budget			();
+	//! \brief bytes of all textures
+	qint64			bytes			();
+
+private:
+	//! \brief Constructor
+					TextureCache	();
+	//! \brief delete unused textures, least recently used first, until under budget
+	void			evict			();
+
+	//! \brief (QImage::cacheKey(), level)
+	typedef QPair<qint64, int>	Key;
+
+	//! \brief one texture
+	struct Texture
+	{
+		GLuint			id;				// texture name in the shared context group
+		int				refs;			// widgets showing it
+		qint64			bytes;			// RGBA bytes of the level
+	};
+
+	QHash<Key, Texture>	m_textures;		// every texture
+	QList<Key>			m_unused;		// textures no widget shows, least recently used first
+	qint64				m_budget;		// bytes of textures the cache may hold
+	qint64				m_bytes;		// bytes of all textures
+};
+#endif
@@ -0,0 +1,418 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Thumbnailer
+//! \brief Thumbnailer implementation
+//!
+//! \file thumbnailer.cpp
+//! \brief Thumbnailer implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QDir>
+#include			<QFile>
+#include			<QFileInfo>
+#include			<QDateTime>
+#include			<QImageReader>
+#include			<QRunnable>
+#include			<QThread>
+#include			<QVector>
+#include			<QCryptographicHash>
+
+#include			"thumbnailer.h"
+
+#ifdef				Q_OS_WIN
+#include			<sys/utime.h>
+#define				utime			_utime
+#else
+#include			<utime.h>
+#endif
+
+// read an image file for a thumbnail; decoders that support it (JPEG) skip most of the pixels
+static QImage readReduced(const QString &path)
+{
+	QImageReader reader(path);
+	QSize size			= reader.size();
+	int big				= qMax(size.width(), size.height());
+	if (size.isValid() && big > THUMB_SIZE * 4 && reader.supportsOption(QImageIOHandler::ScaledSize))
+		reader			.setScaledSize(size * (THUMB_SIZE * 4.0 / big));	// headroom for the box filter
+	return reader.read();
+}
+
+// one thumbnail: from the disk cache file if it holds the key, else made from the image and written to it
+static QImage makeThumbnail(Thumbnailer *owner, ImageHandle handle, QImage img, const QString &path, const QString &key, const QString &file)
+{
+	QImage thumb;
+	if (!file.isEmpty() && thumb.load(file))
+	{
+		if (thumb.text("key") != key)
+			thumb		= QImage();		// another key with the same file name
+		else
+			Thumbnailer::touch(file);
+	}
+	if (!thumb.isNull())
+		return thumb;
+
+	// pixels in memory first, then the file (decoded only as far as needed), then the store's disk copy
+	ImageStore *store	= ImageStore::instance();
+	if (img.isNull() && store->isResident(handle))
+		img				= store->image(handle);
+	if (img.isNull() && !path.isEmpty())
+		img				= readReduced(path);
+	if (img.isNull())
+		img				= store->image(handle);
+	thumb				= Thumbnailer::downsample(img);
+	if (!thumb.isNull() && !file.isEmpty())
+	{	// written aside and renamed so that no reader sees half a file; the name is per thread, as a worker and
+		// the user interface thread may make the same thumbnail at once
+		thumb			.setText("key", key);
+		QString temp	= QString("%1.%2.tmp").arg(file).arg((quintptr)QThread::currentThreadId(), 0, 16);
+		if (thumb.save(temp, "PNG"))
+		{
+			QFile::remove	(file);
+			QFile::rename	(temp, file);
+			owner		->written(QFileInfo(file).size());
+		}
+	}
+	return thumb;
+}
+
+// one thumbnail: from the disk cache if it is there, else made and written to it
+class ThumbnailJob : public QRunnable
+{
+public:
+	ThumbnailJob(Thumbnailer *owner, int handle, const QImage &img, const QString &path, const QString &key, const QString &file)
+		: m_owner(owner), m_handle(handle), m_img(img), m_path(path), m_key(key), m_file(file), m_epoch(owner->epoch()) {}
+
+	void run()
+	{
+		if (m_owner->epoch() != m_epoch)
+			return;				// retired before it started
+
+		QImage thumb	= makeThumbnail(m_owner, m_handle, m_img, m_path, m_key, m_file);
+		m_img			= QImage();
+		QMetaObject::invokeMethod(m_owner, "finished", Qt::QueuedConnection,
+								  Q_ARG(int, m_handle), Q_ARG(QImage, thumb), Q_ARG(int, m_epoch));
+	}
+
+private:
+	Thumbnailer		*m_owner;		// gets the result
+	int				m_handle;		// store handle of the image
+	QImage			m_img;			// the image; null to read it from m_path
+	QString			m_path;			// file of the image; may be empty
+	QString			m_key;			// cache key
+	QString			m_file;			// disk cache file; empty to not cache
+	int				m_epoch;		// generation of the request
+};
+
+// prunes the disk cache on a worker thread
+class CachePruneJob : public QRunnable
+{
+public:
+	CachePruneJob(const QString &dir) : m_dir(dir) {}
+
+	void run()
+	{
+		Thumbnailer::prune(m_dir, THUMB_CACHE);
+	}
+
+private:
+	QString			m_dir;			// disk cache directory
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+//! \details the disk cache lives in ~/.imanip/thumbnails; without it thumbnails are only made, not kept.
+//!	It is pruned to THUMB_CACHE in the background at startup. One core is left to the user interface
+//! \param[in] parent	parent object
+// the disk cache lives in ~/.imanip/thumbnails; one core is left to the user interface
+Thumbnailer::Thumbnailer(QObject *parent) : QObject(parent)
+{
+	m_dir				= QDir::homePath() + "/.imanip/thumbnails";
+	if (!QDir().mkpath(m_dir))
+		m_dir			.clear();
+	m_written			= 0;
+	m_pool				.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+	if (!m_dir.isEmpty())
+		m_pool			.start(new CachePruneJob(m_dir));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DESTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+//! \details jobs refer to the thumbnailer, so they are finished first; their results are dropped
+// jobs refer to the thumbnailer, so they are finished first; their results are dropped
+Thumbnailer::~Thumbnailer()
+{
+	m_pool				.waitForDone();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Request a thumbnail
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief make the thumbnail of an image in the background
+//! \details an image opened from a file is cached by path, modification time and size; any other image
+//!	by its content. A request for a handle that is already in flight is dropped
+//! \param[in] handle	store handle of the image; passed back with ready()
+//! \param[in] img		the image; null to take it from the store, or the file (only as far as the decoder needs)
+//! \param[in] path		file of the image; empty for images made in the session
+// an opened file is cached by path, modification time and size; any other image by its content
+void Thumbnailer::request(ImageHandle handle, const QImage &img, const QString &path)
+{
+	if (m_pending.contains(handle))
+		return;
+
+	QString key			= path.isEmpty() ? contentKey(ImageStore::instance()->hash(handle)) : fileKey(path);
+	QString file		= (m_dir.isEmpty() || key.isEmpty()) ? QString() : cacheFile(m_dir, key);
+	m_pending			.insert(handle);
+	m_pool				.start(new ThumbnailJob(this, handle, img, path, key, file));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Retire requests
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief drop the requests that have not started
+//! \details a view that scrolls far retires what it asked for on the way, so the workers do not make
+//!	thumbnails that are no longer on screen. Jobs already running still deliver their result
+// a view that scrolls far retires what it asked for on the way
+void Thumbnailer::retire()
+{
+	m_epoch				.ref();
+	m_pending			.clear();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Epoch
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief current generation of requests
+//! \return	the generation; retire() starts a new one
+int Thumbnailer::epoch()
+{
+	return (int)m_epoch;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Cached thumbnail of a file
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief thumbnail of a file from the disk cache
+//! \details only the small cache file is read, so a known file shows its thumbnail without decoding it
+//! \param[in] path	file of the image
+//! \return	the thumbnail; null if it is not cached or the file has changed since
+// only the small cache file is read, so a known file shows its thumbnail without decoding it
+QImage Thumbnailer::cached(const QString &path)
+{
+	QString key			= fileKey(path);
+	if (m_dir.isEmpty() || key.isEmpty())
+		return QImage();
+
+	QImage thumb;
+	QString file		= cacheFile(m_dir, key);
+	if (!thumb.load(file) || thumb.text("key") != key)
+		return QImage();
+	touch				(file);
+	return thumb;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Thumbnail
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief thumbnail of an image, made on the calling thread
+//! \details for callers that need every thumbnail now, such as saving a project: the disk cache is read
+//!	first, and a thumbnail that has to be made is written to it as a job would
+//! \param[in] handle	store handle of the image
+//! \param[in] path		file of the image; empty for images made in the session
+//! \return	the thumbnail; null if the image cannot be read
+// the disk cache is read first; a thumbnail that has to be made is written to it
+QImage Thumbnailer::thumbnail(ImageHandle handle, const QString &path)
+{
+	QString key			= path.isEmpty() ? contentKey(ImageStore::instance()->hash(handle)) : fileKey(path);
+	QString file		= (m_dir.isEmpty() || key.isEmpty()) ? QString() : cacheFile(m_dir, key);
+	return makeThumbnail(this, handle, QImage(), path, key, file);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pending requests
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief number of requests not finished yet
+//! \return	number of handles with a job in flight
+int Thumbnailer::pending()
+{
+	return m_pending.size();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Bytes written
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a job has written to the disk cache
+//! \details called by the jobs; once an eighth of THUMB_CACHE has been added since the last prune, the cache is
+//!	pruned on a worker, so a long session does not grow it far past the limit
+//! \param[in] bytes	size of the file written
+// once an eighth of THUMB_CACHE has been added since the last prune, the cache is pruned on a worker
+void Thumbnailer::written(int bytes)
+{
+	if (m_written.fetchAndAddOrdered(bytes) + bytes >= THUMB_CACHE / 8 && m_written.fetchAndStoreOrdered(0) > 0)
+		m_pool			.start(new CachePruneJob(m_dir));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Job finished
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a job has finished
+//! \details queued from the worker, so this runs on the thread of the thumbnailer
+//! \param[in] handle	store handle of the image
+//! \param[in] thumb	the thumbnail; null if the image could not be read
+//! \param[in] epoch	generation of the request; an older one no longer holds the pending slot
+// queued from the worker, so this runs on the thread of the thumbnailer
+void Thumbnailer::finished(int handle, QImage thumb, int epoch)
+{
+	if (epoch == (int)m_epoch)
+		m_pending		.remove(handle);
+	emit ready			(handle, thumb);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Box downsample
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief box filtered thumbnail
+//! \details every thumbnail pixel is the mean of the source pixels it covers, so each source pixel is
+//!	read once; much cheaper than a smooth scale and without the aliasing of a fast one
+//! \param[in] img	the image
+//! \param[in] size	longest side of the thumbnail
+//! \return		the thumbnail; the image itself if it is not larger than size
+// every thumbnail pixel is the mean of the source pixels it covers, so each source pixel is read once
+QImage Thumbnailer::downsample(const QImage &img, int size)
+{
+	int w				= img.width();
+	int h				= img.height();
+	int big				= qMax(w, h);
+	if (img.isNull() || big <= size)
+		return img;
+
+	int tw				= qMax(1, w * size / big);
+	int th				= qMax(1, h * size / big);
+	const QImage src	= (img.format() == QImage::Format_RGB32 || img.format() == QImage::Format_ARGB32)
+							? img : img.convertToFormat(QImage::Format_ARGB32);
+	QImage dst(tw, th, src.format());
+
+	QVector<int> x0(tw + 1);				// source columns of thumbnail column i: [x0[i], x0[i + 1])
+	for (int i = 0; i <= tw; i++)
+		x0[i]			= i * w / tw;
+
+	QVector<quint64> sum(tw * 4);
+	for (int j = 0; j < th; j++)
+	{
+		int y0			= j * h / th;
+		int y1			= (j + 1) * h / th;
+		sum				.fill(0);
+		for (int y = y0; y < y1; y++)
+		{
+			const QRgb *line	= (const QRgb*)src.scanLine(y);
+			quint64 *s	= sum.data();
+			for (int i = 0; i < tw; i++, s += 4)
+				for (int x = x0[i]; x < x0[i + 1]; x++)
+				{
+					QRgb p	= line[x];
+					s[0]	+= qRed(p);
+					s[1]	+= qGreen(p);
+					s[2]	+= qBlue(p);
+					s[3]	+= qAlpha(p);
+				}
+		}
+
+		QRgb *out		= (QRgb*)dst.scanLine(j);
+		const quint64 *s	= sum.constData();
+		for (int i = 0; i < tw; i++, s += 4)
+		{
+			quint64 n	= quint64(x0[i + 1] - x0[i]) * (y1 - y0);
+			out[i]		= qRgba(int(s[0] / n), int(s[1] / n), int(s[2] / n), int(s[3] / n));
+		}
+	}
+	return dst;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Cache key of a file
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief cache key of a file
+//! \details a file that is edited gets a new key, so a stale thumbnail is never shown
+//! \param[in] path	file of the image
+//! \return	absolute path, modification time and size; empty if the file does not exist
+// a file that is edited gets a new key, so a stale thumbnail is never shown
+QString Thumbnailer::fileKey(const QString &path)
+{
+	QFileInfo info(path);
+	if (!info.exists())
+		return QString();
+	return QString("file|%1|%2|%3").arg(info.absoluteFilePath()).arg(info.lastModified().toTime_t()).arg(info.size());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Cache key of an image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief cache key of an image by its content
+//! \param[in] hash	content hash of the image
+//! \return	the key; empty for a null hash
+QString Thumbnailer::contentKey(const ImageHash &hash)
+{
+	return hash.isNull() ? QString() : QString("content|%1").arg(hash.toString());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Cache file
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief file of the disk cache for a key
+//! \details the name is a digest of the key; the key itself is kept in the PNG to tell collisions apart
+//! \param[in] dir	disk cache directory
+//! \param[in] key	cache key
+//! \return	path of the cache file
+// the name is a digest of the key; the key itself is kept in the PNG to tell collisions apart
+QString Thumbnailer::cacheFile(const QString &dir, const QString &key)
+{
+	return QString("%1/%2.png").arg(dir).arg(QString(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex()));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Touch
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief mark a disk cache file as just used
+//! \details the modification time is the time of last use, so prune() drops the thumbnails not seen for longest
+//! \param[in] file	disk cache file
+// the modification time is the time of last use
+void Thumbnailer::touch(const QString &file)
+{
+	utime				(QFile::encodeName(file).constData(), 0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Prune
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief delete the least recently used files of the disk cache
+//! \details files are kept newest first while they fit in limit; the rest are deleted, along with temporary
+//!	files left by a crash. A file deleted under a running job is simply made again
+//! \param[in] dir		disk cache directory
+//! \param[in] limit	bytes the cache may hold
+// files are kept newest first while they fit in limit; the rest are deleted
+void Thumbnailer::prune(const QString &dir, qint64 limit)
+{
+	QFileInfoList files	= QDir(dir).entryInfoList(QStringList() << "*.png", QDir::Files, QDir::Time);
+	qint64 total		= 0;
+	for (int i = 0; i < files.size(); i++)
+	{
+		total			+= files[i].size();
+		if (total > limit)
+			QFile::remove	(files[i].absoluteFilePath());
+	}
+
+	QDateTime stale		= QDateTime::currentDateTime().addSecs(-3600);
+	QFileInfoList temps	= QDir(dir).entryInfoList(QStringList() << "*.tmp", QDir::Files);
+	for (int i = 0; i < temps.size(); i++)
+		if (temps[i].lastModified() < stale)
+			QFile::remove	(temps[i].absoluteFilePath());
+}
@@ -0,0 +1,84 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Thumbnailer
+//! \brief Makes thumbnails on worker threads and keeps them in a cache on disk
+//!
+//! \file thumbnailer.h
+//! \brief Thumbnailer class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				THUMBNAILER_H
+#define				THUMBNAILER_H
+
+#define				THUMB_SIZE		64		// longest side of a thumbnail
+#define				THUMB_CACHE		(64 << 20)	// bytes of the disk cache; least recently used files are pruned over it
+
+#include			<QObject>
+#include			<QImage>
+#include			<QString>
+#include			<QSet>
+#include			<QThreadPool>
+#include			<QAtomicInt>
+#include			"imagestore.h"
+
+// Thumbnailer class
+class Thumbnailer : public QObject
+{
+			Q_OBJECT
+
+public:
+	//! \brief Constructor
+					Thumbnailer		(QObject *parent = 0);
+	//! \brief Destructor; waits for the running jobs
+					~Thumbnailer	();
+
+	//! \brief make the thumbnail of an image in the background; ready() is emitted with it
+	void			request			(ImageHandle, const QImage&, const QString &path = QString());
+	//! \brief drop the requests that have not started; whoever still needs them asks again
+	void			retire			();
+	//! \brief current generation of requests; jobs of an older one are dropped
+	int				epoch			();
+	//! \brief thumbnail of a file from the disk cache; null if it is not cached or the file changed
+	QImage			cached			(const QString &path);
+	//! \brief thumbnail of an image from the disk cache, or made on the calling thread
+	QImage			thumbnail		(ImageHandle, const QString &path = QString());
+	//! \brief number of requests not finished yet
+	int				pending			();
+	//! \brief a job has written bytes to the disk cache; prunes it in the background once enough were added
+	void			written			(int bytes);
+
+	//! \brief box filtered thumbnail; the longest side becomes size, smaller images are kept as they are
+	static QImage	downsample		(const QImage&, int size = THUMB_SIZE);
+	//! \brief cache key of a file: path, modification time and size
+	static QString	fileKey			(const QString &path);
+	//! \brief cache key of an image by its content
+	static QString	contentKey		(const ImageHash&);
+	//! \brief file of the disk cache that holds the thumbnail with the given key
+	static QString	cacheFile		(const QString &dir, const QString &key);
+	//! \brief mark a disk cache file as just used
+	static void		touch			(const QString &file);
+	//! \brief delete the least recently used files of the disk cache until it holds at most limit bytes
+	static void		prune			(const QString &dir, qint64 limit);
+
+signals:
+	//! \brief the thumbnail of a requested image is ready
+	void			ready			(int, QImage);
+
+private slots:
+	//! \brief a job has finished; called on the thread of the thumbnailer
+	void			finished		(int, QImage, int);
+
+private:
+	QThreadPool		m_pool;			// worker threads of the thumbnail jobs
+	QString			m_dir;			// disk cache directory; empty if it cannot be created
+	QSet<int>		m_pending;		// handles with a job in flight
+	QAtomicInt		m_epoch;		// generation of requests; read by the jobs
+	QAtomicInt		m_written;		// bytes written to the disk cache since it was last pruned
+};
+#endif
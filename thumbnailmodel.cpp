@@ -0,0 +1,260 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ThumbnailModel
+//! \brief ThumbnailModel implementation
+//!
+//! \file thumbnailmodel.cpp
+//! \brief ThumbnailModel implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			"thumbnailmodel.h"
+#include			"memoryledger.h"
+
+// report the thumbnails held in memory to the memory ledger; every thumbnail is counted at full size
+static void accountCache(const ThumbnailModel *model, int thumbnails)
+{
+	MemoryLedger::instance()->set(model, 0, MemoryLedger::Thumbnails, (qint64)thumbnails * THUMB_SIZE * THUMB_SIZE * 4,
+								  QString("%1 thumbnail(s) on screen and around").arg(thumbnails));
+}
+
+#define				MIN_CACHED		256		// thumbnails kept in memory however small the view
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+//! \param[in] thumbnailer	makes the thumbnails; shared with the rest of the window
+//! \param[in] parent		parent object
+ThumbnailModel::ThumbnailModel(Thumbnailer *thumbnailer, QObject *parent) : QAbstractListModel(parent)
+{
+	m_thumbnailer		= thumbnailer;
+	m_cache				.setMaxCost(MIN_CACHED);
+	m_placeholder		= QPixmap(THUMB_SIZE, THUMB_SIZE);
+	m_placeholder		.fill(Qt::transparent);
+
+	connect(m_thumbnailer, SIGNAL(ready(int, QImage)), this, SLOT(ready(int, QImage)));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Row count
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief number of images
+//! \param[in] parent	the root; a list has no children
+//! \return		# of rows
+int ThumbnailModel::rowCount(const QModelIndex &parent) const
+{
+	return parent.isValid() ? 0 : m_rows.size();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Data
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief name and thumbnail of a row
+//! \details the view only asks for the rows it paints, so this is where thumbnails are requested.
+//!	Until one is ready the row shows a blank of the same size, which keeps every row alike
+//! \param[in] index	the row
+//! \param[in] role	Qt::DisplayRole or Qt::DecorationRole
+//! \return		the name or the thumbnail
+// the view only asks for the rows it paints, so this is where thumbnails are requested
+QVariant ThumbnailModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_rows.size())
+		return QVariant();
+
+	const Row &row		= m_rows[index.row()];
+	if (role == Qt::DisplayRole)
+		return row.name;
+	if (role == Qt::DecorationRole)
+	{
+		QPixmap *thumb	= m_cache.object(row.handle);
+		if (thumb)
+			return *thumb;
+		request			(index.row());
+		return m_placeholder;
+	}
+	return QVariant();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Flags
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief rows can be pressed to drag them, not edited or selected
+//! \return		Qt::ItemIsEnabled
+Qt::ItemFlags ThumbnailModel::flags(const QModelIndex&) const
+{
+	return Qt::ItemIsEnabled;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Add an image
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add a row
+//! \details nothing is made here; the thumbnail is requested when the row is painted
+//! \param[in] name	the image name
+//! \param[in] handle	store handle of the image
+//! \param[in] path	file of the image; empty for images made in the session
+//! \param[in] thumb	thumbnail if it is known (e.g. saved in a project)
+// nothing is made here; the thumbnail is requested when the row is painted
+void ThumbnailModel::addImage(const QString &name, ImageHandle handle, const QString &path, const QImage &thumb)
+{
+	int n				= m_rows.size();
+	Row row;
+	row.handle			= handle;
+	row.name			= name;
+	row.path			= path;
+
+	beginInsertRows		(QModelIndex(), n, n);
+	m_rows				.append(row);
+	m_byHandle			.insert(handle, n);
+	if (!thumb.isNull())
+		m_cache			.insert(handle, new QPixmap(QPixmap::fromImage(thumb)));
+	endInsertRows		();
+	accountCache		(this, m_cache.size());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set handle
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief point a row at another image
+//! \details the row no longer shows its file, so it is keyed by content from now on
+//! \param[in] row		the row
+//! \param[in] handle	store handle of the new image
+// the row no longer shows its file, so it is keyed by content from now on
+void ThumbnailModel::setHandle(int row, ImageHandle handle)
+{
+	if (row < 0 || row >= m_rows.size())
+		return;
+
+	m_byHandle			.remove(m_rows[row].handle, row);
+	m_byHandle			.insert(handle, row);
+	m_rows[row].handle	= handle;
+	m_rows[row].path	.clear();
+	emit dataChanged	(index(row), index(row));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Find
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief first row of an image
+//! \param[in] handle	store handle of the image
+//! \return		the row; -1 if no row shows it
+int ThumbnailModel::find(ImageHandle handle)
+{
+	int first			= -1;
+	QMultiHash<ImageHandle, int>::const_iterator i	= m_byHandle.constFind(handle);
+	for (; i != m_byHandle.constEnd() && i.key() == handle; ++i)
+		if (first < 0 || i.value() < first)
+			first		= i.value();
+	return first;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Handle
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief store handle of a row
+//! \param[in] row	the row
+//! \return		the handle; 0 for a row out of range
+ImageHandle ThumbnailModel::handle(int row)
+{
+	return (row < 0 || row >= m_rows.size()) ? 0 : m_rows[row].handle;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Name
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief name of a row
+//! \param[in] row	the row
+//! \return		the image name
+QString ThumbnailModel::name(int row)
+{
+	return (row < 0 || row >= m_rows.size()) ? QString() : m_rows[row].name;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Thumbnail
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief thumbnail of a row
+//! \details the memory cache only holds the rows around the view; any other row is read from the disk cache
+//!	or made on the spot, without entering the memory cache so the rows on screen stay in it
+//! \param[in] row	the row
+//! \return		the thumbnail; null if the row does not exist or its image cannot be read
+// a row not in memory is read from the disk cache or made on the spot
+QImage ThumbnailModel::thumbnail(int row)
+{
+	if (row < 0 || row >= m_rows.size())
+		return QImage();
+	const Row &r		= m_rows[row];
+	QPixmap *thumb		= m_cache.object(r.handle);
+	return thumb ? thumb->toImage() : m_thumbnailer->thumbnail(r.handle, r.path);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Prefetch
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief the view has scrolled
+//! \details requests that have not started are retired, then the rows on screen are asked for, then one
+//!	page below and above. The cache holds four pages, so memory follows the size of the view and not the
+//!	length of the list
+//! \param[in] first	first row on screen
+//! \param[in] last	last row on screen
+// the rows on screen are asked for first, then one page below and above; the cache holds four pages
+void ThumbnailModel::prefetch(int first, int last)
+{
+	if (first < 0 || last < first)
+		return;
+
+	int page			= last - first + 1;
+	m_cache				.setMaxCost(qMax(MIN_CACHED, 4 * page));
+	accountCache		(this, m_cache.size());
+	m_thumbnailer		->retire();
+
+	for (int row = first; row <= last && row < m_rows.size(); row++)
+		request			(row);
+	for (int i = 1; i <= page; i++)
+	{
+		if (last + i < m_rows.size())
+			request		(last + i);
+		if (first - i >= 0)
+			request		(first - i);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Request
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief ask for the thumbnail of a row unless it is in memory
+//! \details the thumbnailer takes the pixels from the store on its worker, so nothing is read here
+//! \param[in] row	the row
+// the thumbnailer takes the pixels from the store on its worker, so nothing is read here
+void ThumbnailModel::request(int row) const
+{
+	const Row &r		= m_rows[row];
+	if (!m_cache.contains(r.handle))
+		m_thumbnailer	->request(r.handle, QImage(), r.path);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Thumbnail ready
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief a thumbnail is ready
+//! \details every row of the image is repainted; a thumbnail of an image no longer listed is dropped
+//! \param[in] handle	store handle of the image
+//! \param[in] thumb	the thumbnail
+// every row of the image is repainted; a thumbnail of an image no longer listed is dropped
+void ThumbnailModel::ready(int handle, QImage thumb)
+{
+	if (thumb.isNull() || !m_byHandle.contains(handle))
+		return;
+
+	m_cache				.insert(handle, new QPixmap(QPixmap::fromImage(thumb)));
+	accountCache		(this, m_cache.size());
+	QMultiHash<ImageHandle, int>::const_iterator i	= m_byHandle.constFind(handle);
+	for (; i != m_byHandle.constEnd() && i.key() == handle; ++i)
+		emit dataChanged	(index(i.value()), index(i.value()));
+}
@@ -0,0 +1,79 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class ThumbnailModel
+//! \brief List model of the session images; thumbnails are made only for the rows on screen
+//!
+//! \file thumbnailmodel.h
+//! \brief ThumbnailModel class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				THUMBNAILMODEL_H
+#define				THUMBNAILMODEL_H
+
+#include			<QAbstractListModel>
+#include			<QCache>
+#include			<QMultiHash>
+#include			<QPixmap>
+#include			<QVector>
+#include			"thumbnailer.h"
+
+// ThumbnailModel class
+class ThumbnailModel : public QAbstractListModel
+{
+			Q_OBJECT
+
+public:
+	//! \brief Constructor
+					ThumbnailModel	(Thumbnailer*, QObject *parent = 0);
+
+	//! \brief number of images
+	int				rowCount		(const QModelIndex &parent = QModelIndex()) const;
+	//! \brief name, thumbnail and size of a row; a thumbnail not in memory is requested
+	QVariant		data			(const QModelIndex&, int role = Qt::DisplayRole) const;
+	//! \brief rows can be pressed, not edited or selected
+	Qt::ItemFlags	flags			(const QModelIndex&) const;
+
+	//! \brief add a row; the thumbnail, if known, goes to the cache
+	void			addImage		(const QString &name, ImageHandle, const QString &path = QString(), const QImage &thumb = QImage());
+	//! \brief point a row at another image
+	void			setHandle		(int row, ImageHandle);
+	//! \brief first row of an image; -1 if there is none
+	int				find			(ImageHandle);
+	//! \brief store handle of a row
+	ImageHandle		handle			(int row);
+	//! \brief name of a row
+	QString			name			(int row);
+	//! \brief thumbnail of a row; one not in memory is read from the disk cache or made
+	QImage			thumbnail		(int row);
+	//! \brief rows first to last are on screen; request them and a page around, retire the rest
+	void			prefetch		(int first, int last);
+
+private slots:
+	//! \brief a thumbnail is ready
+	void			ready			(int, QImage);
+
+private:
+	//! \brief one image of the list
+	struct Row
+	{
+		ImageHandle	handle;			// store handle; the list owns one reference
+		QString		name;			// image name
+		QString		path;			// file of the image; empty for images made in the session
+	};
+
+	//! \brief ask for the thumbnail of a row unless it is in memory
+	void			request			(int row) const;
+
+	QVector<Row>					m_rows;			// every image, in list order
+	QMultiHash<ImageHandle, int>	m_byHandle;		// handle -> rows showing it
+	mutable QCache<ImageHandle, QPixmap>	m_cache;	// thumbnails of rows on screen and around
+	Thumbnailer						*m_thumbnailer;	// makes thumbnails on worker threads
+	QPixmap							m_placeholder;	// shown until a thumbnail is ready; keeps rows the same size
+};
+#endif
@@ -0,0 +1,245 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Trace
+//! \brief Trace implementation
+//!
+//! \file trace.cpp
+//! \brief Trace implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<QCoreApplication>
+#include			<QElapsedTimer>
+#include			<QFile>
+#include			<QList>
+#include			<QMutex>
+#include			<QMutexLocker>
+#include			<QTextStream>
+#include			<QThread>
+#include			<QThreadStorage>
+
+#include			"trace.h"
+#include			"activitylog.h"
+
+// one finished span
+struct TraceEvent
+{
+	const char		*name;			// string literal given to the span
+	qint64			begin;			// start in microseconds
+	qint64			end;			// end in microseconds
+};
+
+// spans of one thread. Only the owning thread writes; save() reads the events below the published count,
+// so recording never takes a lock
+struct TraceBuffer
+{
+	int				tid;			// thread number in the trace
+	QString			thread;			// thread name in the trace
+	QAtomicInt		session;		// recording the events belong to
+	QAtomicInt		count;			// events published
+	QAtomicInt		dropped;		// events lost because the buffer was full
+	TraceEvent		events[TRACE_EVENTS];
+};
+
+// thread local handle of a buffer; deleting it at thread exit hands the buffer to the free list, where it
+// keeps its spans until a later thread takes it, so the spans of finished workers can still be saved
+struct TraceSlot
+{
+	TraceBuffer		*buffer;
+	bool			main;			// buffer of the main thread; never freed, its storage outlives the lock
+	~TraceSlot		();
+};
+
+QAtomicInt						Trace::s_enabled;
+QAtomicInt						Trace::s_session;
+static QThreadStorage<TraceSlot*>	traceSlot;		// buffer of the calling thread
+static QList<TraceBuffer*>		traceBuffers;		// every buffer made, in order of the first span of its thread
+static QList<TraceBuffer*>		traceFree;			// buffers of finished threads
+static QMutex					traceLock;			// guards traceBuffers, traceFree and the thread names
+static QElapsedTimer			traceClock;			// started with the first recording
+
+// the thread is gone; its buffer may be taken by the next new thread
+TraceSlot::~TraceSlot()
+{
+	if (main)
+		return;
+	QMutexLocker lock(&traceLock);
+	traceFree				.append(buffer);
+}
+
+// buffer of the calling thread; taken on the first span of the thread from the free list, or made and
+// registered. A free buffer holding spans of the running recording is left alone, so they are saved
+static TraceBuffer* localBuffer()
+{
+	if (!traceSlot.hasLocalData())
+	{
+		QThread *thread		= QThread::currentThread();
+		bool main			= QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+		QMutexLocker lock(&traceLock);
+
+		TraceBuffer *buffer	= 0;
+		int session			= Trace::session();
+		for (int i = 0; i < traceFree.size() && !buffer; i++)
+			if (traceFree[i]->session.fetchAndAddAcquire(0) != session || traceFree[i]->count.fetchAndAddAcquire(0) == 0)
+				buffer		= traceFree.takeAt(i);
+		if (!buffer)
+		{
+			buffer			= new TraceBuffer;
+			buffer->tid		= traceBuffers.size() + 1;
+			traceBuffers	.append(buffer);
+		}
+		buffer->count		= 0;
+		buffer->dropped		= 0;
+		buffer->session		= -1;
+
+		if (main)
+			buffer->thread	= "main";
+		else if (!thread->objectName().isEmpty())
+			buffer->thread	= thread->objectName();
+		else
+			buffer->thread	= QString("worker %1").arg(buffer->tid);
+
+		TraceSlot *slot		= new TraceSlot;
+		slot->buffer		= buffer;
+		slot->main			= main;
+		traceSlot			.setLocalData(slot);
+	}
+	return traceSlot.localData()->buffer;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Enable
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief start or stop recording
+//! \details starting a recording drops the spans of the last one; every thread resets its own buffer on its
+//!	next span, so no thread is stopped
+//! \param[in] on	true to start a new recording
+// every thread resets its own buffer on its next span, so no thread is stopped
+void Trace::setEnabled(bool on)
+{
+	QMutexLocker lock(&traceLock);
+	if (on)
+	{
+		if (!traceClock.isValid())
+			traceClock		.start();
+		s_session			.ref();
+	}
+	s_enabled				= on ? 1 : 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Now
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief current time
+//! \return	microseconds since the first recording started
+qint64 Trace::now()
+{
+	return traceClock.isValid() ? traceClock.nsecsElapsed() / 1000 : 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Record
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief add a span to the buffer of the calling thread
+//! \details the event is written first and published by a release store of the count, so save() never sees
+//!	a half written event. A full buffer drops the span and counts it
+//! \param[in] name		string literal naming the span
+//! \param[in] begin	start in microseconds
+//! \param[in] end		end in microseconds
+// the event is written first and published by a release store of the count
+void Trace::record(const char *name, qint64 begin, qint64 end)
+{
+	TraceBuffer *buffer		= localBuffer();
+	int session				= s_session;
+	if (buffer->session != session)
+	{	// first span of this recording on this thread
+		buffer->count		.fetchAndStoreRelease(0);
+		buffer->dropped		= 0;
+		buffer->session		.fetchAndStoreRelease(session);
+	}
+
+	int n					= buffer->count;
+	if (n >= TRACE_EVENTS)
+	{
+		buffer->dropped		.ref();
+		return;
+	}
+	buffer->events[n].name	= name;
+	buffer->events[n].begin	= begin;
+	buffer->events[n].end	= end;
+	buffer->count			.fetchAndStoreRelease(n + 1);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Count
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief size of the current recording
+//! \param[out] events	spans recorded
+//! \param[out] dropped	spans lost because a buffer was full
+void Trace::count(qint64 &events, qint64 &dropped)
+{
+	events					= 0;
+	dropped					= 0;
+
+	QMutexLocker lock(&traceLock);
+	int session				= s_session;
+	for (int i = 0; i < traceBuffers.size(); i++)
+	{
+		if (traceBuffers[i]->session.fetchAndAddAcquire(0) != session)
+			continue;
+		events				+= traceBuffers[i]->count.fetchAndAddAcquire(0);
+		dropped				+= traceBuffers[i]->dropped;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Save
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief write the current recording as Chrome trace event JSON
+//! \details every span is a complete ("X") event on the track of its thread, and every thread is named by a
+//!	metadata event; the file opens in chrome://tracing and Perfetto. Spans published while the file is
+//!	written may or may not be in it
+//! \param[in] path	file to write
+//! \return		false if the file could not be written
+// every span is a complete ("X") event on the track of its thread; the file opens in Perfetto
+bool Trace::save(const QString &path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+		return false;
+
+	QTextStream out(&file);
+	out						.setCodec("UTF-8");
+	out						<< "{\"traceEvents\":[";
+
+	qint64 pid				= QCoreApplication::applicationPid();
+	QString separator		= "\n";
+	QMutexLocker lock(&traceLock);
+	int session				= s_session;
+	for (int i = 0; i < traceBuffers.size(); i++)
+	{
+		TraceBuffer *buffer	= traceBuffers[i];
+		if (buffer->session.fetchAndAddAcquire(0) != session)
+			continue;
+
+		out					<< separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+							<< ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":" << ActivityLog::jsonString(buffer->thread) << "}}";
+		separator			= ",\n";
+
+		int n				= buffer->count.fetchAndAddAcquire(0);
+		for (int j = 0; j < n; j++)
+		{
+			const TraceEvent &e	= buffer->events[j];
+			out				<< separator << "{\"name\":\"" << e.name << "\",\"cat\":\"imanip\",\"ph\":\"X\",\"ts\":"
+							<< e.begin << ",\"dur\":" << e.end - e.begin << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid << "}";
+		}
+	}
+	out						<< "\n],\"displayTimeUnit\":\"ms\"}\n";
+	out						.flush();
+	return file.error() == QFile::NoError;
+}
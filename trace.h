@@ -0,0 +1,64 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Trace
+//! \brief Scoped timing spans recorded per thread and saved as a Chrome trace
+//!
+//! \file trace.h
+//! \brief Trace and TraceSpan classes
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				TRACE_H
+#define				TRACE_H
+
+#define				TRACE_EVENTS	65536	// spans kept per thread and recording; later ones are dropped
+
+#include			<QAtomicInt>
+#include			<QString>
+
+//! \brief time the enclosing scope under a name; the name must be a string literal
+#define				TRACE(name)		TraceSpan traceSpan(name)
+
+// Trace class
+class Trace
+{
+public:
+	//! \brief is a recording running; a plain read, cheap enough to test in every span
+	static bool		enabled			()	{return s_enabled;}
+	//! \brief number of the current recording
+	static int		session			()	{return s_session;}
+	//! \brief start a new recording, dropping the last one, or stop recording
+	static void		setEnabled		(bool);
+	//! \brief microseconds on a monotonic clock
+	static qint64	now				();
+	//! \brief add a span to the buffer of the calling thread
+	static void		record			(const char *name, qint64 begin, qint64 end);
+	//! \brief spans recorded, and dropped because a buffer was full, in the current recording
+	static void		count			(qint64 &events, qint64 &dropped);
+	//! \brief write the current recording as Chrome trace event JSON
+	static bool		save			(const QString &path);
+
+private:
+	static QAtomicInt	s_enabled;	// non-zero while recording
+	static QAtomicInt	s_session;	// number of the current recording; buffers of older ones are reset
+};
+
+// TraceSpan class
+class TraceSpan
+{
+public:
+	//! \brief Constructor; starts the span if a recording is running
+					TraceSpan		(const char *name) : m_name(Trace::enabled() ? name : 0), m_begin(m_name ? Trace::now() : 0) {}
+	//! \brief Destructor; records the span
+					~TraceSpan		()	{if (m_name) Trace::record(m_name, m_begin, Trace::now());}
+
+private:
+	const char		*m_name;		// span name; 0 if nothing is recorded
+	qint64			m_begin;		// start time in microseconds
+};
+#endif
@@ -0,0 +1,620 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class UndoStack
+//! \brief Undo stack implementation
+//!
+//! \file undostack.cpp
+//! \brief Undo stack implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cstring>
+#include			<QTemporaryFile>
+
+#include			"undostack.h"
+#include			"lzcodec.h"
+#include			"parallel.h"
+#include			"memoryledger.h"
+
+#define				TILE_BYTES		256				// tile width in bytes (64 pixels of a 32 bit image)
+#define				TILE_ROWS		64				// tile height
+#define				UNDO_DEPTH		256				// steps kept per frame
+
+QList<UndoStack*>	UndoStack::s_stacks;
+QTemporaryFile		*UndoStack::s_scratch	= 0;
+QList< QPair<qint64, qint64> >	UndoStack::s_holes;
+qint64				UndoStack::s_budget		= 64 << 20;
+qint64				UndoStack::s_resident	= 0;
+int					UndoStack::s_spilled	= 0;
+int					UndoStack::s_stamp		= 0;
+
+static const int	ledgerOwner		= 0;			// identifies the undo history in the memory ledger
+
+// report the deltas kept in memory by all stacks to the memory ledger
+static void accountResident(qint64 bytes)
+{
+	MemoryLedger::instance()->set(&ledgerOwner, 0, MemoryLedger::UndoHistory, bytes, "undo history of all frames");
+}
+
+// tile grid of an image, in bytes
+struct TileGrid
+{
+	int				rowBytes;		// used bytes per scan line
+	int				tilesX;
+	int				tilesY;
+
+	TileGrid(const QImage &img)
+	{
+		rowBytes	= (img.width() * img.depth() + 7) / 8;
+		tilesX		= (rowBytes + TILE_BYTES - 1) / TILE_BYTES;
+		tilesY		= (img.height() + TILE_ROWS - 1) / TILE_ROWS;
+	}
+
+	int count() const { return tilesX * tilesY; }
+};
+
+// state shared by the encode workers
+struct EncodeContext
+{
+	const uchar		*stored;		// bits of the stored image
+	int				storedBpl;
+	const uchar		*current;		// bits of the current image; 0 stores raw tiles
+	int				currentBpl;
+	int				height;
+	TileGrid		*grid;
+	QVector<QByteArray>	*out;		// one stream per tile; empty if the tile did not change
+};
+
+// state shared by the decode workers
+struct DecodeContext
+{
+	uchar			*dst;			// bits of the image being rebuilt
+	int				bpl;
+	int				height;
+	TileGrid		*grid;
+	bool			xorTiles;
+	const UndoDelta	*delta;
+	QVector<int>	offsets;		// start of every tile stream in delta->data
+	int				failed;			// a tile did not decompress
+};
+
+// byte span of tile t: first row, row count, first byte and bytes per row
+static inline void tileSpan(const TileGrid &g, int height, int t, int &y0, int &rows, int &x0, int &cols)
+{
+	y0		= (t / g.tilesX) * TILE_ROWS;
+	x0		= (t % g.tilesX) * TILE_BYTES;
+	rows	= qMin(TILE_ROWS, height - y0);
+	cols	= qMin(TILE_BYTES, g.rowBytes - x0);
+}
+
+// gather, diff and compress a range of tiles
+static void encodeTiles(void *ctx, int begin, int end)
+{
+	EncodeContext *c	= (EncodeContext*)ctx;
+	uchar buf[TILE_BYTES * TILE_ROWS];
+
+	for (int t = begin; t < end; t++)
+	{
+		int y0, rows, x0, cols;
+		tileSpan(*c->grid, c->height, t, y0, rows, x0, cols);
+
+		uchar changed	= 0;
+		for (int r = 0; r < rows; r++)
+		{
+			const uchar *s	= c->stored + (y0 + r) * c->storedBpl + x0;
+			uchar *d		= buf + r * cols;
+			if (c->current)
+			{	// unchanged bytes become zero runs, which compress to almost nothing
+				const uchar *q	= c->current + (y0 + r) * c->currentBpl + x0;
+				for (int x = 0; x < cols; x++)
+				{
+					d[x]	= s[x] ^ q[x];
+					changed	|= d[x];
+				}
+			}
+			else
+				memcpy(d, s, cols);
+		}
+
+		if (c->current && !changed)
+			continue;
+		(*c->out)[t]	= LZ::compress((const char*)buf, rows * cols);
+	}
+}
+
+// decompress a range of stored tiles into the destination image
+static void decodeTiles(void *ctx, int begin, int end)
+{
+	DecodeContext *c	= (DecodeContext*)ctx;
+	uchar buf[TILE_BYTES * TILE_ROWS];
+
+	for (int i = begin; i < end; i++)
+	{
+		int y0, rows, x0, cols;
+		tileSpan(*c->grid, c->height, c->delta->tiles[i], y0, rows, x0, cols);
+
+		if (!LZ::decompress(c->delta->data.constData() + c->offsets[i], c->delta->sizes[i], (char*)buf, rows * cols))
+		{
+			c->failed	= 1;
+			continue;
+		}
+
+		for (int r = 0; r < rows; r++)
+		{
+			uchar *d		= c->dst + (y0 + r) * c->bpl + x0;
+			const uchar *s	= buf + r * cols;
+			if (c->xorTiles)
+			{
+				for (int x = 0; x < cols; x++)
+					d[x]	^= s[x];
+			}
+			else
+				memcpy(d, s, cols);
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+UndoStack::UndoStack()
+{
+	s_stacks.append(this);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DESTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Destructor
+UndoStack::~UndoStack()
+{
+	clear();
+	s_stacks.removeAll(this);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Record
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief remember the state before a change
+//! \details only the tiles that differ between before and after are kept; any new change drops the redo history
+//! \param[in] before		image before the change
+//! \param[in] beforeName	its name
+//! \param[in] after		image after the change
+// only the tiles that differ between before and after are kept; any new change drops the redo history
+void UndoStack::record(const QImage &before, const QString &beforeName, const QImage &after)
+{
+	if (before.isNull() && after.isNull())
+		return;
+
+	while (!m_redo.isEmpty())
+	{
+		release(m_redo.last());
+		m_redo.removeLast();
+	}
+
+	UndoDelta delta		= encode(before, beforeName, after);
+	m_undo.append(delta);
+	admit(m_undo.last());
+
+	if (m_undo.size() > UNDO_DEPTH)
+	{
+		release(m_undo.first());
+		m_undo.removeFirst();
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Undo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief step back
+//! \param[in, out] img		current image; receives the restored image
+//! \param[in, out] name	current name; receives the restored name
+//! \return		false if there is nothing to undo or the history could not be read
+bool UndoStack::undo(QImage &img, QString &name)
+{
+	return step(m_undo, m_redo, img, name);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Redo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief step forward
+//! \param[in, out] img		current image; receives the restored image
+//! \param[in, out] name	current name; receives the restored name
+//! \return		false if there is nothing to redo or the history could not be read
+bool UndoStack::redo(QImage &img, QString &name)
+{
+	return step(m_redo, m_undo, img, name);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Step
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief move one delta between the undo and redo lists
+//! \details an xor delta is its own inverse, so it moves across unchanged; a raw delta is re-encoded from the current image
+//! \param[in, out] from	list to take the newest delta from
+//! \param[in, out] to		list that receives the inverse delta
+//! \param[in, out] img		current image; receives the restored image
+//! \param[in, out] name	current name; receives the restored name
+//! \return		false if from is empty or the delta could not be read
+// an xor delta is its own inverse, so it moves across unchanged; a raw delta is re-encoded from the current image
+bool UndoStack::step(QList<UndoDelta> &from, QList<UndoDelta> &to, QImage &img, QString &name)
+{
+	if (from.isEmpty())
+		return false;
+
+	UndoDelta delta		= from.takeLast();
+	QImage restored;
+	if (!decode(delta, img, restored))
+	{	// the history behind a broken delta cannot be rebuilt either
+		release(delta);
+		clear();
+		return false;
+	}
+
+	UndoDelta inverse;
+	if (delta.xorTiles)
+	{
+		release(delta);
+		inverse			= delta;
+		inverse.name	= name;
+	}
+	else
+	{
+		release(delta);
+		inverse			= encode(img, name, restored);
+	}
+	to.append(inverse);
+	admit(to.last());
+
+	img					= restored;
+	name				= delta.name;
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Can undo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief is there anything to undo
+//! \return		true if undo() would change the image
+bool UndoStack::canUndo() const
+{
+	return !m_undo.isEmpty();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Can redo
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief is there anything to redo
+//! \return		true if redo() would change the image
+bool UndoStack::canRedo() const
+{
+	return !m_redo.isEmpty();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Clear
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief forget all history
+void UndoStack::clear()
+{
+	for (int i = 0; i < m_undo.size(); i++)
+		release(m_undo[i]);
+	for (int i = 0; i < m_redo.size(); i++)
+		release(m_redo[i]);
+	m_undo.clear();
+	m_redo.clear();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Budget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief bytes all stacks may keep in memory before spilling to the scratch file
+//! \param[in] bytes	new budget
+void UndoStack::setBudget(qint64 bytes)
+{
+	s_budget	= bytes;
+	enforceBudget();
+	accountResident(s_resident);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Resident bytes
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief bytes all stacks currently keep in memory
+//! \return		compressed bytes not spilled
+qint64 UndoStack::residentBytes()
+{
+	return s_resident;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Encode
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief delta that turns current into stored
+//! \details images of the same size and format are diffed tile by tile; otherwise every tile of stored is kept
+//! \param[in] stored	image the delta restores
+//! \param[in] name		its name
+//! \param[in] current	image the delta is applied to
+//! \return		the delta
+// images of the same size and format are diffed tile by tile; otherwise every tile of stored is kept
+UndoDelta UndoStack::encode(const QImage &stored, const QString &name, const QImage &current)
+{
+	UndoDelta delta;
+	delta.name		= name;
+	delta.width		= stored.isNull() ? 0 : stored.width();
+	delta.height	= stored.isNull() ? 0 : stored.height();
+	delta.format	= stored.format();
+	delta.colors	= stored.colorTable();
+	delta.xorTiles	= !stored.isNull() && !current.isNull() && stored.size() == current.size()
+					&& stored.format() == current.format() && stored.colorTable() == current.colorTable();
+	delta.filePos	= -1;
+	delta.fileLen	= 0;
+	delta.stamp		= 0;
+
+	if (stored.isNull())
+		return delta;
+
+	TileGrid grid		(stored);
+	QVector<QByteArray> out(grid.count());
+
+	EncodeContext c;
+	c.stored		= stored.bits();
+	c.storedBpl		= stored.bytesPerLine();
+	c.current		= delta.xorTiles ? current.bits() : 0;
+	c.currentBpl	= delta.xorTiles ? current.bytesPerLine() : 0;
+	c.height		= stored.height();
+	c.grid			= &grid;
+	c.out			= &out;
+	Parallel::forRange(grid.count(), encodeTiles, &c, 4);
+
+	int total		= 0;
+	for (int t = 0; t < out.size(); t++)
+		total		+= out[t].size();
+
+	delta.data.reserve(total);
+	for (int t = 0; t < out.size(); t++)
+	{
+		if (out[t].isEmpty())
+			continue;
+		delta.tiles	.append(t);
+		delta.sizes	.append(out[t].size());
+		delta.data	.append(out[t]);
+	}
+	return delta;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Decode
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief rebuild the stored image of a delta
+//! \details spilled deltas are read back first; xor tiles are applied to a copy of current
+//! \param[in, out] delta	delta to apply
+//! \param[in] current		image the delta was encoded against
+//! \param[out] stored		rebuilt image
+//! \return		false if the delta could not be read
+// spilled deltas are read back first; xor tiles are applied to a copy of current
+bool UndoStack::decode(UndoDelta &delta, const QImage &current, QImage &stored)
+{
+	if (delta.width == 0)
+	{
+		stored			= QImage();
+		return true;
+	}
+	if (!load(delta))
+		return false;
+
+	if (delta.xorTiles)
+		stored			= current.copy();
+	else
+	{
+		stored			= QImage(delta.width, delta.height, (QImage::Format)delta.format);
+		stored			.setColorTable(delta.colors);
+	}
+	if (stored.isNull())
+		return false;
+
+	TileGrid grid		(stored);
+	DecodeContext c;
+	c.dst			= stored.bits();
+	c.bpl			= stored.bytesPerLine();
+	c.height		= stored.height();
+	c.grid			= &grid;
+	c.xorTiles		= delta.xorTiles;
+	c.delta			= &delta;
+	c.failed		= 0;
+	c.offsets		.resize(delta.tiles.size());
+
+	int offset		= 0;
+	for (int i = 0; i < delta.tiles.size(); i++)
+	{
+		if (delta.tiles[i] >= grid.count())
+			return false;
+		c.offsets[i]	= offset;
+		offset			+= delta.sizes[i];
+	}
+	if (offset != delta.data.size())
+		return false;
+
+	Parallel::forRange(delta.tiles.size(), decodeTiles, &c, 4);
+	return !c.failed;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Admit
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief account for a delta that just entered a list
+//! \param[in, out] delta	the new delta; it becomes the youngest
+void UndoStack::admit(UndoDelta &delta)
+{
+	delta.stamp		= ++s_stamp;
+	if (delta.filePos < 0)
+		s_resident	+= delta.data.size();
+	else
+		s_spilled++;
+	enforceBudget();
+	accountResident(s_resident);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Release
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief account for a delta that left its list
+//! \details the range of a spilled delta is given back to the scratch file; the file is emptied once nothing
+//!	refers to it any more
+//! \param[in] delta	the delta
+// the range of a spilled delta is given back; the scratch file is emptied once nothing refers to it any more
+void UndoStack::release(UndoDelta &delta)
+{
+	if (delta.filePos < 0)
+		s_resident	-= delta.data.size();
+	else if (--s_spilled == 0 && s_scratch)
+	{
+		s_holes		.clear();
+		s_scratch	->resize(0);
+	}
+	else
+		scratchRelease(delta.filePos, delta.fileLen);
+	accountResident(s_resident);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Enforce budget
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief spill the oldest resident deltas of all stacks until under budget
+//! \details the newest delta of every stack stays in memory so a single undo never waits on the disk
+// the newest delta of every stack stays in memory so a single undo never waits on the disk
+void UndoStack::enforceBudget()
+{
+	while (s_resident > s_budget)
+	{
+		UndoDelta *oldest	= 0;
+		for (int s = 0; s < s_stacks.size(); s++)
+		{
+			QList<UndoDelta> *lists[2]	= {&s_stacks[s]->m_undo, &s_stacks[s]->m_redo};
+			for (int l = 0; l < 2; l++)
+			{
+				for (int i = 0; i < lists[l]->size() - 1; i++)
+				{
+					UndoDelta &d	= (*lists[l])[i];
+					if (d.filePos < 0 && !d.data.isEmpty() && (!oldest || d.stamp < oldest->stamp))
+						oldest		= &d;
+				}
+			}
+		}
+		if (!oldest)
+			return;
+
+		if (!s_scratch)
+		{
+			s_scratch	= new QTemporaryFile;
+			if (!s_scratch->open())
+			{
+				delete s_scratch;
+				s_scratch	= 0;
+				return;
+			}
+		}
+
+		qint64 pos		= scratchAllocate(oldest->data.size());
+		if (!s_scratch->seek(pos) || s_scratch->write(oldest->data) != oldest->data.size())
+		{
+			scratchRelease	(pos, oldest->data.size());
+			return;		// disk full; keep the history in memory
+		}
+
+		s_resident		-= oldest->data.size();
+		s_spilled++;
+		oldest->filePos	= pos;
+		oldest->fileLen	= oldest->data.size();
+		oldest->data	= QByteArray();
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Load
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief bring a spilled delta back into memory
+//! \details the delta must already be out of its list, so the counters move with it only when it is admitted again
+//! \param[in, out] delta	the delta
+//! \return		false if the scratch file could not be read
+// the delta must already be out of its list, so the counters move with it only when it is admitted again
+bool UndoStack::load(UndoDelta &delta)
+{
+	if (delta.filePos < 0)
+		return true;
+	if (!s_scratch || !s_scratch->seek(delta.filePos))
+		return false;
+
+	QByteArray data	= s_scratch->read(delta.fileLen);
+	if (data.size() != delta.fileLen)
+		return false;
+
+	release(delta);			// no longer refers to the scratch file
+	delta.data		= data;
+	delta.filePos	= -1;
+	s_resident		+= delta.data.size();	// balanced by the release in step()
+	accountResident	(s_resident);
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Scratch file space
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief reserve len bytes of the scratch file
+//! \details first fit in the holes left by dropped and reloaded deltas; otherwise the file grows
+//! \param[in] len	bytes needed
+//! \return		offset of the range
+// first fit in the holes left by dropped and reloaded deltas; otherwise the file grows
+qint64 UndoStack::scratchAllocate(qint64 len)
+{
+	for (int i = 0; i < s_holes.size(); i++)
+	{
+		if (s_holes[i].second < len)
+			continue;
+		qint64 pos			= s_holes[i].first;
+		s_holes[i].first	+= len;
+		s_holes[i].second	-= len;
+		if (s_holes[i].second == 0)
+			s_holes.removeAt(i);
+		return pos;
+	}
+	return s_scratch->size();
+}
+
+//! \brief give a range of the scratch file back
+//! \details holes are kept sorted and merged with their neighbours; a hole that reaches the end of the file is
+//!	cut off it, so the file shrinks as the oldest history is dropped
+//! \param[in] pos	offset of the range
+//! \param[in] len	its length
+// holes are kept sorted and merged with their neighbours; a hole at the end of the file is cut off it
+void UndoStack::scratchRelease(qint64 pos, qint64 len)
+{
+	int i			= 0;
+	while (i < s_holes.size() && s_holes[i].first < pos)
+		i++;
+	s_holes.insert(i, qMakePair(pos, len));
+
+	if (i + 1 < s_holes.size() && s_holes[i].first + s_holes[i].second == s_holes[i + 1].first)
+	{
+		s_holes[i].second	+= s_holes[i + 1].second;
+		s_holes.removeAt(i + 1);
+	}
+	if (i > 0 && s_holes[i - 1].first + s_holes[i - 1].second == s_holes[i].first)
+	{
+		s_holes[i - 1].second	+= s_holes[i].second;
+		s_holes.removeAt(i);
+	}
+
+	if (s_scratch && s_holes.last().first + s_holes.last().second >= s_scratch->size())
+	{
+		s_scratch	->resize(s_holes.last().first);
+		s_holes		.removeLast();
+	}
+}
@@ -0,0 +1,102 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class UndoStack
+//! \brief Undo/redo history of one frame stored as compressed tile deltas
+//!
+//! \file undostack.h
+//! \brief Undo stack class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				UNDOSTACK_H
+#define				UNDOSTACK_H
+
+#include			<QImage>
+#include			<QString>
+#include			<QList>
+#include			<QVector>
+#include			<QByteArray>
+#include			<QPair>
+
+class				QTemporaryFile;
+
+//! \brief one step of history: what is needed to go from the current image to the stored one
+struct UndoDelta
+{
+	QString			name;			// image name of the stored state
+	int				width;			// stored size; 0 for an empty frame
+	int				height;
+	int				format;			// QImage::Format of the stored state
+	QVector<QRgb>	colors;			// color table of indexed images
+	bool			xorTiles;		// tiles hold stored ^ current; otherwise the raw stored bytes
+	QVector<int>	tiles;			// index of every stored tile
+	QVector<int>	sizes;			// compressed size of every stored tile
+	QByteArray		data;			// compressed tiles back to back; empty while spilled
+	qint64			filePos;		// offset in the scratch file; -1 while resident
+	int				fileLen;		// bytes in the scratch file
+	int				stamp;			// age; the oldest resident delta is spilled first
+};
+
+// UndoStack class
+class UndoStack
+{
+public:
+	//! \brief Constructor
+					UndoStack		();
+	//! \brief Destructor
+					~UndoStack		();
+	//! \brief remember the state before a change; clears the redo history
+	void			record			(const QImage &before, const QString &beforeName, const QImage &after);
+	//! \brief step back; img and name hold the current state and receive the restored one
+	bool			undo			(QImage &img, QString &name);
+	//! \brief step forward; img and name hold the current state and receive the restored one
+	bool			redo			(QImage &img, QString &name);
+	//! \brief is there anything to undo
+	bool			canUndo			() const;
+	//! \brief is there anything to redo
+	bool			canRedo			() const;
+	//! \brief forget all history
+	void			clear			();
+
+	//! \brief bytes all stacks may keep in memory before spilling to the scratch file
+	static void		setBudget		(qint64);
+	//! \brief bytes all stacks currently keep in memory
+	static qint64	residentBytes	();
+
+private:
+	//! \brief move one delta between the undo and redo lists
+	bool			step			(QList<UndoDelta>&, QList<UndoDelta>&, QImage&, QString&);
+	//! \brief delta that turns current into stored
+	static UndoDelta	encode		(const QImage &stored, const QString&, const QImage &current);
+	//! \brief rebuild the stored image of a delta
+	static bool		decode			(UndoDelta&, const QImage &current, QImage &stored);
+	//! \brief account for a new delta and spill if over budget
+	static void		admit			(UndoDelta&);
+	//! \brief forget the memory of a delta that is being dropped
+	static void		release			(UndoDelta&);
+	//! \brief write the oldest resident deltas to the scratch file until under budget
+	static void		enforceBudget	();
+	//! \brief bring a spilled delta back into memory
+	static bool		load			(UndoDelta&);
+	//! \brief reserve a range of the scratch file
+	static qint64	scratchAllocate	(qint64 len);
+	//! \brief give a range of the scratch file back
+	static void		scratchRelease	(qint64 pos, qint64 len);
+
+	QList<UndoDelta>		m_undo;			// oldest first
+	QList<UndoDelta>		m_redo;			// oldest first
+
+	static QList<UndoStack*>	s_stacks;		// every live stack, for budget enforcement
+	static QTemporaryFile		*s_scratch;		// spilled deltas
+	static QList< QPair<qint64, qint64> >	s_holes;	// free ranges of the scratch file (offset, length)
+	static qint64				s_budget;		// memory budget for all stacks
+	static qint64				s_resident;		// compressed bytes in memory
+	static int					s_spilled;		// deltas in the scratch file
+	static int					s_stamp;		// age counter
+};
+#endif
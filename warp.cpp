@@ -0,0 +1,303 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Warp
+//! \brief Warp implementation
+//!
+//! \file warp.cpp
+//! \brief Warp implementation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include			<cmath>
+
+#ifdef __SSE2__
+#include			<emmintrin.h>
+#endif
+
+#include			"warp.h"
+#include			"parallel.h"
+
+static const int	WARP_TILE		= 64;			// tiles keep the source footprint of a rotated block in cache
+static const int	MAX_WARP_SIDE	= 16384;		// larger outputs are refused
+
+// state shared by the worker threads
+struct WarpContext
+{
+	const QImage	*src;
+	QImage			*dst;
+	double			inv[9];			// destination pixel to source pixel
+	Warp::Interp	interp;
+	unsigned int	background;		// value of pixels that fall outside the source
+	int				tilesX;			// tiles per row
+};
+
+// Catmull-Rom weights for the four taps around a sample with fractional offset t
+static inline void cubicWeights(float t, float *w)
+{
+	float t2	= t * t;
+	float t3	= t2 * t;
+	w[0]		= 0.5f * (-t3 + 2.0f * t2 - t);
+	w[1]		= 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f);
+	w[2]		= 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+	w[3]		= 0.5f * (t3 - t2);
+}
+
+// pixel at (x, y) with the coordinates clamped to the image
+static inline unsigned int clampedPixel(const QImage &img, int x, int y)
+{
+	x			= x < 0 ? 0 : (x >= img.width() ? img.width() - 1 : x);
+	y			= y < 0 ? 0 : (y >= img.height() ? img.height() - 1 : y);
+	return ((const unsigned int*)img.scanLine(y))[x];
+}
+
+// bilinear sample; (fx, fy) in pixel units with pixel centers on integers
+static inline unsigned int sampleBilinear(const QImage &img, float fx, float fy)
+{
+	int x0			= (int)floorf(fx);
+	int y0			= (int)floorf(fy);
+	int wx			= (int)((fx - x0) * 128.0f + 0.5f);		// 7 bit weights keep (b - a) * w inside 16 bits
+	int wy			= (int)((fy - y0) * 128.0f + 0.5f);
+
+	unsigned int p00, p01, p10, p11;
+	if (x0 >= 0 && y0 >= 0 && x0 + 1 < img.width() && y0 + 1 < img.height())
+	{
+		const unsigned int *r0	= (const unsigned int*)img.scanLine(y0) + x0;
+		const unsigned int *r1	= (const unsigned int*)img.scanLine(y0 + 1) + x0;
+		p00			= r0[0];
+		p01			= r0[1];
+		p10			= r1[0];
+		p11			= r1[1];
+	}
+	else
+	{	// border; repeat the edge pixels
+		p00			= clampedPixel(img, x0, y0);
+		p01			= clampedPixel(img, x0 + 1, y0);
+		p10			= clampedPixel(img, x0, y0 + 1);
+		p11			= clampedPixel(img, x0 + 1, y0 + 1);
+	}
+
+#ifdef __SSE2__
+	const __m128i zero	= _mm_setzero_si128();
+	__m128i left		= _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)p10, (int)p00), zero);	// top left, bottom left
+	__m128i right		= _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)p11, (int)p01), zero);	// top right, bottom right
+	__m128i col			= _mm_add_epi16(left, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(right, left), _mm_set1_epi16((short)wx)), 7));
+	__m128i bottom		= _mm_unpackhi_epi64(col, col);
+	__m128i r			= _mm_add_epi16(col, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(bottom, col), _mm_set1_epi16((short)wy)), 7));
+	return (unsigned int)_mm_cvtsi128_si32(_mm_packus_epi16(r, zero));
+#else
+	unsigned int out	= 0;
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		int a			= (p00 >> shift) & 0xff;
+		int b			= (p01 >> shift) & 0xff;
+		int c			= (p10 >> shift) & 0xff;
+		int d			= (p11 >> shift) & 0xff;
+		int top			= a + (((b - a) * wx) >> 7);
+		int bot			= c + (((d - c) * wx) >> 7);
+		out				|= (unsigned int)(top + (((bot - top) * wy) >> 7)) << shift;
+	}
+	return out;
+#endif
+}
+
+// bicubic (Catmull-Rom) sample; (fx, fy) in pixel units with pixel centers on integers
+static inline unsigned int sampleBicubic(const QImage &img, float fx, float fy)
+{
+	int x0			= (int)floorf(fx);
+	int y0			= (int)floorf(fy);
+	float wx[4], wy[4];
+	cubicWeights	(fx - x0, wx);
+	cubicWeights	(fy - y0, wy);
+
+	bool inside		= x0 >= 1 && y0 >= 1 && x0 + 2 < img.width() && y0 + 2 < img.height();
+
+#ifdef __SSE2__
+	const __m128i zero	= _mm_setzero_si128();
+	__m128 acc			= _mm_setzero_ps();
+	for (int j = 0; j < 4; j++)
+	{
+		__m128 row		= _mm_setzero_ps();
+		const unsigned int *line	= inside ? (const unsigned int*)img.scanLine(y0 - 1 + j) + x0 - 1 : 0;
+		for (int i = 0; i < 4; i++)
+		{
+			unsigned int p	= inside ? line[i] : clampedPixel(img, x0 - 1 + i, y0 - 1 + j);
+			__m128 v		= _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p), zero), zero));
+			row				= _mm_add_ps(row, _mm_mul_ps(v, _mm_set1_ps(wx[i])));
+		}
+		acc				= _mm_add_ps(acc, _mm_mul_ps(row, _mm_set1_ps(wy[j])));
+	}
+	__m128i r			= _mm_cvtps_epi32(acc);							// rounds to nearest
+	r					= _mm_packs_epi32(r, zero);
+	return (unsigned int)_mm_cvtsi128_si32(_mm_packus_epi16(r, zero));	// saturates the overshoot
+#else
+	float acc[4]		= {0.0f, 0.0f, 0.0f, 0.0f};
+	for (int j = 0; j < 4; j++)
+		for (int i = 0; i < 4; i++)
+		{
+			unsigned int p	= clampedPixel(img, x0 - 1 + i, y0 - 1 + j);
+			float w			= wx[i] * wy[j];
+			for (int k = 0; k < 4; k++)
+				acc[k]		+= w * ((p >> (8 * k)) & 0xff);
+		}
+	unsigned int out	= 0;
+	for (int k = 0; k < 4; k++)
+	{
+		int v			= (int)floorf(acc[k] + 0.5f);
+		out				|= (unsigned int)(v < 0 ? 0 : (v > 255 ? 255 : v)) << (8 * k);
+	}
+	return out;
+#endif
+}
+
+// warp tiles [begin, end); source coordinates are stepped incrementally along every tile row
+static void warpTiles(void *p, int begin, int end)
+{
+	WarpContext *c		= (WarpContext*)p;
+	const double *m		= c->inv;
+	int sw				= c->src->width();
+	int sh				= c->src->height();
+
+	for (int tile = begin; tile < end; tile++)
+	{
+		int x0			= (tile % c->tilesX) * WARP_TILE;
+		int y0			= (tile / c->tilesX) * WARP_TILE;
+		int x1			= qMin(x0 + WARP_TILE, c->dst->width());
+		int y1			= qMin(y0 + WARP_TILE, c->dst->height());
+
+		for (int y = y0; y < y1; y++)
+		{
+			unsigned int *line	= (unsigned int*)c->dst->scanLine(y);
+
+			// homogeneous source position of the first pixel center; one column step is the first matrix column
+			double cx	= x0 + 0.5;
+			double cy	= y + 0.5;
+			double X	= m[0] * cx + m[1] * cy + m[2];
+			double Y	= m[3] * cx + m[4] * cy + m[5];
+			double W	= m[6] * cx + m[7] * cy + m[8];
+
+			for (int x = x0; x < x1; x++, X += m[0], Y += m[3], W += m[6])
+			{
+				if (W <= 1e-12)
+				{	// behind the viewer
+					line[x]	= c->background;
+					continue;
+				}
+
+				float sx	= (float)(X / W);
+				float sy	= (float)(Y / W);
+				if (sx < 0.0f || sy < 0.0f || sx >= sw || sy >= sh)
+				{
+					line[x]	= c->background;
+					continue;
+				}
+
+				line[x]	= c->interp == Warp::Bicubic ? sampleBicubic(*c->src, sx - 0.5f, sy - 0.5f)
+														: sampleBilinear(*c->src, sx - 0.5f, sy - 0.5f);
+			}
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Apply
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief resample img through a 3x3 matrix
+//! \details the output covers the warped image's bounding box. Every destination pixel is mapped back with
+//!	the inverse matrix; along a row the homogeneous source position only needs three additions per pixel.
+//!	The output is split into 64x64 tiles spread over the threads, so a rotated block reads a compact
+//!	source area. Bilinear uses 7 bit fixed point and bicubic (Catmull-Rom) single precision, both SSE2.
+//! \param[in] img		source image
+//! \param[in] matrix	row major 3x3 matrix mapping source (x, y, 1) to destination
+//! \param[in] interp	resampling filter
+//! \return				warped image; null if the matrix is singular or the result would be too large
+// every destination pixel is mapped back with the inverse matrix, stepping incrementally along tile rows
+QImage Warp::apply(const QImage &img, const double *matrix, Interp interp)
+{
+	if (img.isNull())
+		return QImage();
+
+	// bounding box of the warped corners
+	double corner[4][2]	= {{0, 0}, {(double)img.width(), 0}, {0, (double)img.height()}, {(double)img.width(), (double)img.height()}};
+	double minX = 1e300, minY = 1e300, maxX = -1e300, maxY = -1e300;
+	for (int i = 0; i < 4; i++)
+	{
+		double w		= matrix[6] * corner[i][0] + matrix[7] * corner[i][1] + matrix[8];
+		if (w <= 1e-12)
+			return QImage();	// a corner goes to infinity
+		double x		= (matrix[0] * corner[i][0] + matrix[1] * corner[i][1] + matrix[2]) / w;
+		double y		= (matrix[3] * corner[i][0] + matrix[4] * corner[i][1] + matrix[5]) / w;
+		minX			= qMin(minX, x);
+		minY			= qMin(minY, y);
+		maxX			= qMax(maxX, x);
+		maxY			= qMax(maxY, y);
+	}
+
+	double left			= floor(minX + 1e-6);
+	double top			= floor(minY + 1e-6);
+	double width		= ceil(maxX - 1e-6) - left;
+	double height		= ceil(maxY - 1e-6) - top;
+	if (width < 1.0 || height < 1.0 || width > MAX_WARP_SIDE || height > MAX_WARP_SIDE)
+		return QImage();
+
+	// shift the output so the bounding box starts at the origin, then invert
+	double shifted[9];
+	for (int i = 0; i < 3; i++)
+	{
+		shifted[i]		= matrix[i] - left * matrix[6 + i];
+		shifted[3 + i]	= matrix[3 + i] - top * matrix[6 + i];
+		shifted[6 + i]	= matrix[6 + i];
+	}
+
+	WarpContext c;
+	if (!invert(shifted, c.inv))
+		return QImage();
+
+	QImage src			= img.depth() == 32 ? img : img.convertToFormat(QImage::Format_ARGB32);
+	QImage dst			((int)width, (int)height, src.format());
+
+	c.src				= &src;
+	c.dst				= &dst;
+	c.interp			= interp;
+	c.background		= src.hasAlphaChannel() ? 0 : 0xff000000;
+	c.tilesX			= (dst.width() + WARP_TILE - 1) / WARP_TILE;
+	int tilesY			= (dst.height() + WARP_TILE - 1) / WARP_TILE;
+
+	Parallel::forRange	(c.tilesX * tilesY, warpTiles, &c, 1);
+	return dst;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Invert
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief inverse of a 3x3 matrix
+//! \param[in] m		row major matrix
+//! \param[out] inv		row major inverse
+//! \return				false when m is singular
+bool Warp::invert(const double *m, double *inv)
+{
+	double c0	= m[4] * m[8] - m[5] * m[7];
+	double c1	= m[5] * m[6] - m[3] * m[8];
+	double c2	= m[3] * m[7] - m[4] * m[6];
+	double det	= m[0] * c0 + m[1] * c1 + m[2] * c2;
+
+	double scale	= fabs(m[0]) + fabs(m[1]) + fabs(m[3]) + fabs(m[4]);
+	if (fabs(det) <= 1e-12 * scale * scale)
+		return false;
+
+	double r	= 1.0 / det;
+	inv[0]		= c0 * r;
+	inv[1]		= (m[2] * m[7] - m[1] * m[8]) * r;
+	inv[2]		= (m[1] * m[5] - m[2] * m[4]) * r;
+	inv[3]		= c1 * r;
+	inv[4]		= (m[0] * m[8] - m[2] * m[6]) * r;
+	inv[5]		= (m[2] * m[3] - m[0] * m[5]) * r;
+	inv[6]		= c2 * r;
+	inv[7]		= (m[1] * m[6] - m[0] * m[7]) * r;
+	inv[8]		= (m[0] * m[4] - m[1] * m[3]) * r;
+	return true;
+}
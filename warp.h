@@ -0,0 +1,33 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class Warp
+//! \brief Affine and perspective resampling of an image
+//!
+//! \file warp.h
+//! \brief Warp class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef				WARP_H
+#define				WARP_H
+
+#include			<QImage>
+
+// Warp class
+class Warp
+{
+public:
+	//! \brief enum for Warp; resampling filter
+	enum			Interp			{Bilinear, Bicubic};
+
+	//! \brief resample img through a 3x3 matrix (row major, source to destination)
+	static QImage	apply			(const QImage&, const double*, Interp);
+	//! \brief inverse of a 3x3 matrix; false when it is singular
+	static bool		invert			(const double*, double*);
+};
+#endif
@@ -0,0 +1,152 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class WarpDialog
+//!
+//! \file warpdialog.cpp
+//! \brief Warp dialog implementation.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include	<cmath>
+
+#include	"warpdialog.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONSTRUCTOR
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Constructor
+WarpDialog::WarpDialog(QDialog *parent)
+	: QDialog (parent)
+{
+	// init matrix spinboxes; identity by default
+	QGroupBox	*boxMatrix			= new QGroupBox(tr("Matrix (source to result)"), this);
+	QGridLayout	*gridMatrix			= new QGridLayout;
+	for (int i = 0; i < 9; i++)
+	{
+		m_matrix[i]		= new QDoubleSpinBox(this);
+		m_matrix[i]		->setRange(-10000.0, 10000.0);
+		m_matrix[i]		->setDecimals(6);
+		m_matrix[i]		->setSingleStep(0.01);
+		m_matrix[i]		->setValue(i % 4 == 0 ? 1.0 : 0.0);
+		gridMatrix		->addWidget(m_matrix[i], i / 3, i % 3);
+
+		m_val[i]		= i % 4 == 0 ? 1.0 : 0.0;
+	}
+	boxMatrix			->setLayout(gridMatrix);
+
+	// init rotation helper
+	QGroupBox	*boxRot				= new QGroupBox(tr("Rotate and scale"), this);
+	QLabel		*angleLabel			= new QLabel(tr("Angle: "), this);
+	QLabel		*scaleLabel			= new QLabel(tr("Scale: "), this);
+	QPushButton	*setBut				= new QPushButton(tr("Set matrix"));
+
+	m_angle				= new QDoubleSpinBox(this);
+	m_angle				->setRange(-360.0, 360.0);
+	m_angle				->setSuffix(tr(" deg"));
+	m_scale				= new QDoubleSpinBox(this);
+	m_scale				->setRange(0.01, 100.0);
+	m_scale				->setSingleStep(0.1);
+	m_scale				->setValue(1.0);
+
+	QGridLayout	*gridRot			= new QGridLayout;
+	gridRot				->addWidget(angleLabel,	0, 0, Qt::AlignRight);
+	gridRot				->addWidget(m_angle,	0, 1);
+	gridRot				->addWidget(scaleLabel,	0, 2, Qt::AlignRight);
+	gridRot				->addWidget(m_scale,	0, 3);
+	gridRot				->addWidget(setBut,		0, 4);
+	boxRot				->setLayout(gridRot);
+
+	// init resampling buttons
+	QGroupBox	*boxInterp			= new QGroupBox(tr("Resampling"), this);
+	m_buttonBilinear	= new QRadioButton(tr("Bilinear"), this);
+	m_buttonBicubic		= new QRadioButton(tr("Bicubic"), this);
+	m_buttonBicubic		->setChecked(true);
+	m_interp			= Warp::Bicubic;
+
+	QHBoxLayout	*hInterp			= new QHBoxLayout;
+	hInterp				->addWidget(m_buttonBilinear);
+	hInterp				->addWidget(m_buttonBicubic);
+	boxInterp			->setLayout(hInterp);
+
+	// init push button
+	QPushButton	*okBut				= new QPushButton(tr("Ok"));
+	QPushButton	*cancelBut			= new QPushButton(tr("Cancel"));
+
+	QHBoxLayout	*hButBox			= new QHBoxLayout;
+	hButBox				->addStretch(1);
+	hButBox				->addWidget(okBut);
+	hButBox				->addWidget(cancelBut);
+
+	// init layout for this dialog box
+	QGridLayout	*grid	= new QGridLayout(this);
+	grid				->addWidget(boxMatrix,	0, 0);
+	grid				->addWidget(boxRot,		1, 0);
+	grid				->addWidget(boxInterp,	2, 0);
+	grid				->addLayout(hButBox,	3, 0);
+
+	connect (setBut,		SIGNAL(clicked()),			this, SLOT(setRotation()) );
+	connect (okBut,			SIGNAL(clicked()),			this, SLOT(ok()) );
+	connect (cancelBut,		SIGNAL(clicked()),			this, SLOT(close()) );
+
+	setWindowTitle (tr("Warp"));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Retrieval function
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Retrieve values function
+//! \param[out] matrix	Holds the 3x3 matrix, row major
+//! \param[out] interp	Holds the resampling filter
+void WarpDialog::retVal(double *matrix, Warp::Interp &interp)
+{
+	for (int i = 0; i < 9; i++)
+		matrix[i]	= m_val[i];
+	interp			= m_interp;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// ========================== Below are private functions ===============================
+//
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Set rotation
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Private slot to fill the matrix from the rotation and scale
+//! \details no translation is needed; the result always covers the whole warped image
+// no translation is needed; the result always covers the whole warped image
+void WarpDialog::setRotation()
+{
+	double a		= m_angle->value() * 3.14159265358979 / 180.0;
+	double s		= m_scale->value();
+
+	m_matrix[0]		->setValue(s * cos(a));
+	m_matrix[1]		->setValue(-s * sin(a));
+	m_matrix[2]		->setValue(0.0);
+	m_matrix[3]		->setValue(s * sin(a));
+	m_matrix[4]		->setValue(s * cos(a));
+	m_matrix[5]		->setValue(0.0);
+	m_matrix[6]		->setValue(0.0);
+	m_matrix[7]		->setValue(0.0);
+	m_matrix[8]		->setValue(1.0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Ok
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//! \brief Private slot when Ok is clicked
+//! \details Store the matrix and the filter for retVal()
+// Store the matrix and the filter for retVal()
+void WarpDialog::ok()
+{
+	for (int i = 0; i < 9; i++)
+		m_val[i]	= m_matrix[i]->value();
+	m_interp		= m_buttonBilinear->isChecked() ? Warp::Bilinear : Warp::Bicubic;
+	done(1);
+}
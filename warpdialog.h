@@ -0,0 +1,49 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IManip: Image Manipulator
+//
+//! \author Wai Khoo
+//! \author Tadeusz Jordan
+//! \version 2.0
+//! \date December 11, 2008
+//!
+//! \class WarpDialog
+//! \brief Dialog box for the warp matrix and resampling filter
+//!
+//! \file warpdialog.h
+//! \brief Warp dialog class
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef			WARPDIALOG_H
+#define			WARPDIALOG_H
+
+#include		<QtGui>
+#include		"warp.h"
+
+class WarpDialog : public QDialog
+{
+			Q_OBJECT
+
+public:
+	//! \brief Constructor
+			WarpDialog			(QDialog *parent = 0);
+	//! \brief Retrival function
+	void		retVal			(double*, Warp::Interp&);	// Call this function to retrieve the warp parameters
+
+private slots:
+	//! \brief Ok slot
+	void		ok				();
+	//! \brief fill the matrix from the rotation and scale
+	void		setRotation		();
+
+private:
+	QDoubleSpinBox	*m_matrix[9];		// Spinboxes for the matrix (row major)
+	QDoubleSpinBox	*m_angle;			// Spinbox for the rotation angle in degrees
+	QDoubleSpinBox	*m_scale;			// Spinbox for the scale factor
+
+	QRadioButton	*m_buttonBilinear;	// Button for bilinear resampling
+	QRadioButton	*m_buttonBicubic;	// Button for bicubic resampling
+
+	double			m_val[9];			// Holds the matrix
+	Warp::Interp	m_interp;			// Holds the resampling filter
+};
+#endif